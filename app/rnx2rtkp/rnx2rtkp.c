@@ -46,6 +46,7 @@ static const char *help[]={
 " -ts ds ts start day/time (ds=y/m/d ts=h:m:s) [obs start time]",
 " -te de te end day/time   (de=y/m/d te=h:m:s) [obs end time]",
 " -ti tint  time interval (sec) [all]",
+" -tu tunit processing unit time (sec) [all]",
 " -p mode   mode (0:single,1:dgps,2:kinematic,3:static,4:moving-base,",
 "                 5:fixed,6:ppp-kinematic,7:ppp-static) [2]",
 " -m mask   elevation mask angle (deg) [15]",
@@ -66,7 +67,29 @@ static const char *help[]={
 " -r x y z  reference (base) receiver ecef pos (m) [average of single pos]",
 " -l lat lon hgt reference (base) receiver latitude/longitude/height (deg/m)",
 " -y level  output soltion status (0:off,1:states,2:residuals) [0]",
-" -x level  debug trace level (0:off) [0]"
+" -x level  debug trace level (0:off) [0]",
+" -kfu mode kalman filter update (0:standard,1:cholesky) [0]",
+" -arc      initialize ppp phase-biases by ambiguity arcs of rover [off]",
+" -ofm fmt  output files format (0:text,1:binary) [0]",
+" -od dir   directory of output files and logs (keywords and relative to",
+"           output file allowed, see reppath()) [current]",
+" -dbg level debug log level of solution_log.txt and KalmanFiltering.txt",
+"           (0:off,1:epoch,2:satellite,3:matrix) [0]",
+" -snap     output kalman filter snapshots to filter_snapshot.bin [off]",
+" -rov list rover list separated by spaces for keyword %r in paths [\"\"]",
+" -base list base station list separated by spaces for keyword %b [\"\"]",
+" -nt n     number of threads of processing sessions (sessions of rovers,",
+"           base stations or processing units run in parallel if their",
+"           output files and -od dirs differ, e.g. -od %r_%b_%Y%m%d) [1]",
+" -ns n     number of time slices of forward solutions processed in parallel",
+"           (output files and logs of slices in slice_NN of -od dir) [1]",
+" -tw sec   warm-up interval of time slices (s) [600]",
+" -sm       stream obs epoch by epoch for forward solutions instead of loading",
+"           all obs (obs files of a receiver in time order) [off]",
+" -nl n     number of threads of loading input files (files parsed in parallel",
+"           and merged in order of input files) [1]",
+" -rc dir   directory of rinex cache files of parsed obs and nav data (\"*\":",
+"           directory of rinex files) [off]"
 };
 /* show message --------------------------------------------------------------*/
 extern int showmsg(char *format, ...)
@@ -93,14 +116,15 @@ int main(int argc, char **argv)
     solopt_t solopt=solopt_default;
     filopt_t filopt={""};
     gtime_t ts={0},te={0};
-    double tint=0.0,es[]={2000,1,1,0,0,0},ee[]={2000,12,31,23,59,59},pos[3];
+    double tint=0.0,tunit=0.0,es[]={2000,1,1,0,0,0},ee[]={2000,12,31,23,59,59},pos[3];
     int i,j,n,ret;
-    char *infile[MAXFILE],*outfile="";
+    char *infile[MAXFILE],*outfile="",*rov="",*base="";
     
     prcopt.mode  =PMODE_KINEMA;
     prcopt.navsys=SYS_GPS|SYS_GLO;
     prcopt.refpos=1;
     prcopt.glomodear=1;
+    prcopt.slicewarm=600.0;
     solopt.timef=0;
     sprintf(solopt.prog ,"%s ver.%s",PROGNAME,VER_RTKLIB);
     sprintf(filopt.trace,"%s.trace",PROGNAME);
@@ -126,6 +150,7 @@ int main(int argc, char **argv)
             te=epoch2time(ee);
         }
         else if (!strcmp(argv[i],"-ti")&&i+1<argc) tint=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-tu")&&i+1<argc) tunit=atof(argv[++i]);
         else if (!strcmp(argv[i],"-k")&&i+1<argc) {++i; continue;}
         else if (!strcmp(argv[i],"-p")&&i+1<argc) prcopt.mode=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-f")&&i+1<argc) prcopt.nf=atoi(argv[++i]);
@@ -155,6 +180,24 @@ int main(int argc, char **argv)
         }
         else if (!strcmp(argv[i],"-y")&&i+1<argc) solopt.sstat=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-x")&&i+1<argc) solopt.trace=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-kfu")&&i+1<argc) prcopt.kfupd=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-arc")) prcopt.ambarc=1;
+        else if (!strcmp(argv[i],"-ofm")&&i+1<argc) prcopt.outformat=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-dbg")&&i+1<argc) prcopt.dbglevel=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-snap")) prcopt.dbgsnap=1;
+        else if (!strcmp(argv[i],"-rov")&&i+1<argc) rov=argv[++i];
+        else if (!strcmp(argv[i],"-base")&&i+1<argc) base=argv[++i];
+        else if (!strcmp(argv[i],"-nt")&&i+1<argc) prcopt.nthread=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-ns")&&i+1<argc) prcopt.nslice=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-tw")&&i+1<argc) prcopt.slicewarm=atof(argv[++i]);
+        else if (!strcmp(argv[i],"-sm")) prcopt.streamobs=1;
+        else if (!strcmp(argv[i],"-nl")&&i+1<argc) prcopt.nload=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-rc")&&i+1<argc) {
+            strncpy(prcopt.rnxcache,argv[++i],sizeof(prcopt.rnxcache)-1);
+        }
+        else if (!strcmp(argv[i],"-od")&&i+1<argc) {
+            strncpy(prcopt.outdir,argv[++i],sizeof(prcopt.outdir)-1);
+        }
         else if (!strcmp(argv[i],"-ant")&&i+1<argc) strcpy(filopt.rcvantp,argv[++i]);
         else if (!strcmp(argv[i],"-ang")&&i+1<argc) strcpy(filopt.tmiangles,argv[++i]);
         else if (*argv[i]=='-') printhelp();
@@ -174,8 +217,13 @@ int main(int argc, char **argv)
         showmsg("error : no input file");
         return -2;
     }
-    remove("solution_log.txt");
-    ret=postpos(ts,te,tint,0.0,&prcopt,&solopt,&filopt,infile,n,outfile,"","");
+    if (!*prcopt.outdir&&prcopt.dbglevel>0) {
+        remove("solution_log.txt");
+        remove("KalmanFiltering.txt");
+    }
+    if (!*prcopt.outdir&&prcopt.dbgsnap) remove(SNAP_FILE);
+    ret=postpos(ts,te,tint,tunit,&prcopt,&solopt,&filopt,infile,n,outfile,rov,
+                base);
     
     if (!ret) fprintf(stderr,"%40s\r","");
     return ret;
@@ -361,6 +361,7 @@ void __fastcall TMonitorDialog::ShowRtk(void)
 	AnsiString freq[]={"-","L1","L1+L2","L1+L2+L5","L1+L2+L5+L6","L1+L2+L5+L6+L7","L1+L2+L5+L6+L7+L8",""};
 	double *del,*off1,*off2,runtime,rt[3]={0},dop[4]={0};
 	double azel[MAXSAT*2],pos[3],vel[3];
+	double x[3]={0},Px[3]={0},xa[3]={0},Pxa[3]={0};
 	int i,j,k,thread,cycle,state,rtkstat,nsat0,nsat1,prcout;
 	int cputime,nb[3]={0},nmsg[3][10]={{0}},ne;
 	char tstr[64],*ant,id[32],s1[64]="-",s2[64]="-",s3[64]="-";
@@ -372,6 +373,11 @@ void __fastcall TMonitorDialog::ShowRtk(void)
 	rtksvrlock(&rtksvr); // lock
 	
 	rtk=rtksvr.rtk;
+	for (i=0;i<3;i++) { // states reallocated by server thread
+		if (rtk.x &&i<rtk.nx) {x [i]=rtk.x [i]; Px [i]=rtk.P [i+i*rtk.nx];}
+		if (rtk.xa&&i<rtk.na) {xa[i]=rtk.xa[i]; Pxa[i]=rtk.Pa[i+i*rtk.na];}
+	}
+	rtk.x=rtk.P=rtk.xa=rtk.Pa=NULL;
 	thread=(int)rtksvr.thread;
 	cycle=rtksvr.cycle;
 	state=rtksvr.state;
@@ -559,19 +565,19 @@ void __fastcall TMonitorDialog::ShowRtk(void)
 	
 	Tbl->Cells[0][i  ]="Pos X/Y/Z Float (m) Rover";
 	Tbl->Cells[1][i++]=s.sprintf("%.3f,%.3f,%.3f",
-		rtk.x?rtk.x[0]:0,rtk.x?rtk.x[1]:0,rtk.x?rtk.x[2]:0);
+		x[0],x[1],x[2]);
 	
 	Tbl->Cells[0][i  ]="Pos X/Y/Z Float Std (m) Rover";
 	Tbl->Cells[1][i++]=s.sprintf("%.3f,%.3f,%.3f",
-		rtk.P?SQRT(rtk.P[0]):0,rtk.P?SQRT(rtk.P[1+1*rtk.nx]):0,rtk.P?SQRT(rtk.P[2+2*rtk.nx]):0);
+		SQRT(Px[0]),SQRT(Px[1]),SQRT(Px[2]));
 	
 	Tbl->Cells[0][i  ]="Pos X/Y/Z Fixed (m) Rover";
 	Tbl->Cells[1][i++]=s.sprintf("%.3f,%.3f,%.3f",
-		rtk.xa?rtk.xa[0]:0,rtk.xa?rtk.xa[1]:0,rtk.xa?rtk.xa[2]:0);
+		xa[0],xa[1],xa[2]);
 	
 	Tbl->Cells[0][i  ]="Pos X/Y/Z Fixed Std (m) Rover";
 	Tbl->Cells[1][i++]=s.sprintf("%.3f,%.3f,%.3f",
-		rtk.Pa?SQRT(rtk.Pa[0]):0,rtk.Pa?SQRT(rtk.Pa[1+1*rtk.na]):0,rtk.Pa?SQRT(rtk.Pa[2+2*rtk.na]):0);
+		SQRT(Pxa[0]),SQRT(Pxa[1]),SQRT(Pxa[2]));
 	
 	Tbl->Cells[0][i  ]="Pos X/Y/Z (m) Base/NRTK Station";
 	Tbl->Cells[1][i++]=s.sprintf("%.3f,%.3f,%.3f",rtk.rb[0],rtk.rb[1],rtk.rb[2]);
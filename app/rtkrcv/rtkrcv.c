@@ -563,11 +563,17 @@ static void prstatus(vt_t *vt)
     char tstr[64],s[1024],*p;
     double runtime,rt[3]={0},dop[4]={0},rr[3],bl1=0.0,bl2=0.0;
     double azel[MAXSAT*2],pos[3],vel[3],*del;
+    double x[3]={0},Px[3]={0},xa[3]={0},Pxa[3]={0};
     
     trace(4,"prstatus:\n");
     
     rtksvrlock(&svr);
     rtk=svr.rtk;
+    for (i=0;i<3;i++) { /* states reallocated by server thread */
+        if (rtk.x &&i<rtk.nx) {x [i]=rtk.x [i]; Px [i]=rtk.P [i+i*rtk.nx];}
+        if (rtk.xa&&i<rtk.na) {xa[i]=rtk.xa[i]; Pxa[i]=rtk.Pa[i+i*rtk.na];}
+    }
+    rtk.x=rtk.P=rtk.xa=rtk.Pa=NULL;
     thread=(int)svr.thread;
     cycle=svr.cycle;
     state=svr.state;
@@ -653,13 +659,13 @@ static void prstatus(vt_t *vt)
     ecef2enu(pos,rtk.sol.rr+3,vel);
     vt_printf(vt,"%-28s: %.3f,%.3f,%.3f\n","vel enu (m/s) rover",vel[0],vel[1],vel[2]);
     vt_printf(vt,"%-28s: %.3f,%.3f,%.3f\n","pos xyz float (m) rover",
-            rtk.x?rtk.x[0]:0,rtk.x?rtk.x[1]:0,rtk.x?rtk.x[2]:0);
+            x[0],x[1],x[2]);
     vt_printf(vt,"%-28s: %.3f,%.3f,%.3f\n","pos xyz float std (m) rover",
-            rtk.P?SQRT(rtk.P[0]):0,rtk.P?SQRT(rtk.P[1+1*rtk.nx]):0,rtk.P?SQRT(rtk.P[2+2*rtk.nx]):0);
+            SQRT(Px[0]),SQRT(Px[1]),SQRT(Px[2]));
     vt_printf(vt,"%-28s: %.3f,%.3f,%.3f\n","pos xyz fixed (m) rover",
-            rtk.xa?rtk.xa[0]:0,rtk.xa?rtk.xa[1]:0,rtk.xa?rtk.xa[2]:0);
+            xa[0],xa[1],xa[2]);
     vt_printf(vt,"%-28s: %.3f,%.3f,%.3f\n","pos xyz fixed std (m) rover",
-            rtk.Pa?SQRT(rtk.Pa[0]):0,rtk.Pa?SQRT(rtk.Pa[1+1*rtk.na]):0,rtk.Pa?SQRT(rtk.Pa[2+2*rtk.na]):0);
+            SQRT(Pxa[0]),SQRT(Pxa[1]),SQRT(Pxa[2]));
     vt_printf(vt,"%-28s: %.3f,%.3f,%.3f\n","pos xyz (m) base",
             rtk.rb[0],rtk.rb[1],rtk.rb[2]);
     vt_printf(vt,"%-28s: %s\n","ant type rover",rtk.opt.pcvr[0].type);
@@ -674,11 +680,11 @@ static void prstatus(vt_t *vt)
     ecef2enu(pos,rtk.rb+3,vel);
     vt_printf(vt,"%-28s: %.3f,%.3f,%.3f\n","vel enu (m/s) base",
             vel[0],vel[1],vel[2]);
-    if (rtk.opt.mode>0&&rtk.x&&norm(rtk.x,3)>0.0) {
-        for (i=0;i<3;i++) rr[i]=rtk.x[i]-rtk.rb[i]; bl1=norm(rr,3);
+    if (rtk.opt.mode>0&&norm(x,3)>0.0) {
+        for (i=0;i<3;i++) rr[i]=x[i]-rtk.rb[i]; bl1=norm(rr,3);
     }
-    if (rtk.opt.mode>0&&rtk.xa&&norm(rtk.xa,3)>0.0) {
-        for (i=0;i<3;i++) rr[i]=rtk.xa[i]-rtk.rb[i]; bl2=norm(rr,3);
+    if (rtk.opt.mode>0&&norm(xa,3)>0.0) {
+        for (i=0;i<3;i++) rr[i]=xa[i]-rtk.rb[i]; bl2=norm(rr,3);
     }
     vt_printf(vt,"%-28s: %.3f\n","baseline length float (m)",bl1);
     vt_printf(vt,"%-28s: %.3f\n","baseline length fixed (m)",bl2);
@@ -1263,7 +1269,7 @@ static void cmdshell(vt_t *vt)
 }
 /* rtkrcv main -----------------------------------------------------------------
 * sysnopsis
-*     rtkrcv [-s][-p port|-d dev][-o file][-t level]
+*     rtkrcv [-s][-p port|-d dev][-o file][-t level][-b]
 *
 * description
 *     A command line version of the real-time positioning AP by rtklib. To start
@@ -1285,6 +1291,7 @@ static void cmdshell(vt_t *vt)
 *     -o file    processing options file       
 *     -r level   output solution status file (0:off,1:states,2:residuals)
 *     -t level   debug trace level (0:off,1-5:on)
+*     -b         debug trace in binary format (convert by util/convtrace)
 *
 * command
 *     start
@@ -1366,7 +1373,7 @@ static void cmdshell(vt_t *vt)
 int main(int argc, char **argv)
 {
     vt_t vt={0};
-    int i,start=0,port=0,outstat=0,trace=0;
+    int i,start=0,port=0,outstat=0,trace=0,tracebin=0;
     char *dev="",file[MAXSTR]="";
     
     for (i=1;i<argc;i++) {
@@ -1377,10 +1384,11 @@ int main(int argc, char **argv)
         else if (!strcmp(argv[i],"-o")&&i+1<argc) strcpy(file,argv[++i]);
         else if (!strcmp(argv[i],"-r")&&i+1<argc) outstat=atoi(argv[++i]);
         else if (!strcmp(argv[i],"-t")&&i+1<argc) trace=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-b")) tracebin=1;
         else fprintf(stderr,"Unknown option: %s\n",argv[i]);
     }
     if (trace>0) {
-        traceopen(TRACEFILE);
+        if (tracebin) traceopenb(TRACEFILE); else traceopen(TRACEFILE);
         tracelevel(trace);
     }
     /* initialize rtk server and monitor port */
@@ -21,6 +21,8 @@ static const double range[4];       /* embedded geoid area range {W,E,S,N} (deg)
 static const float geoid[361][181]; /* embedded geoid heights (m) (lon x lat) */
 static FILE *fp_geoid=NULL;         /* geoid file pointer */
 static int model_geoid=GEOID_EMBEDDED; /* geoid model */
+static lock_t lock_geoid;           /* lock of geoid file access */
+static int init_lock=0;             /* lock initialized flag */
 
 /* bilinear interpolation ----------------------------------------------------*/
 static double interpb(const double *y, double a, double b)
@@ -200,6 +202,10 @@ extern int opengeoid(int model, const char *file)
 {
     trace(3,"opengeoid: model=%d file=%s\n",model,file);
     
+    if (!init_lock) {
+        initlock(&lock_geoid);
+        init_lock=1;
+    }
     closegeoid();
     if (model==GEOID_EMBEDDED) {
         return 1;
@@ -236,6 +242,8 @@ extern void closegeoid(void)
 * notes  : to use external geoid model, call function opengeoid() to open
 *          geoid model before calling the function. If the external geoid model
 *          is not open, the function uses embedded geoid model.
+*          reading the external geoid model file is serialized by a lock, so
+*          the function may be called by multiple threads
 *-----------------------------------------------------------------------------*/
 extern double geoidh(const double *pos)
 {
@@ -247,13 +255,19 @@ extern double geoidh(const double *pos)
         trace(2,"out of range for geoid model: lat=%.3f lon=%.3f\n",posd[0],posd[1]);
         return 0.0;
     }
-    switch (model_geoid) {
-        case GEOID_EMBEDDED   : h=geoidh_emb  (posd); break;
-        case GEOID_EGM96_M150 : h=geoidh_egm96(posd); break;
-        case GEOID_EGM2008_M25: h=geoidh_egm08(posd,model_geoid); break;
-        case GEOID_EGM2008_M10: h=geoidh_egm08(posd,model_geoid); break;
-        case GEOID_GSI2000_M15: h=geoidh_gsi  (posd); break;
-        default: return 0.0;
+    if (model_geoid==GEOID_EMBEDDED) {
+        h=geoidh_emb(posd);
+    }
+    else {
+        lock(&lock_geoid);
+        switch (model_geoid) {
+            case GEOID_EGM96_M150 : h=geoidh_egm96(posd); break;
+            case GEOID_EGM2008_M25: h=geoidh_egm08(posd,model_geoid); break;
+            case GEOID_EGM2008_M10: h=geoidh_egm08(posd,model_geoid); break;
+            case GEOID_GSI2000_M15: h=geoidh_gsi  (posd); break;
+            default: h=0.0;
+        }
+        unlock(&lock_geoid);
     }
     if (fabs(h)>200.0) {
         trace(2,"invalid geoid model: lat=%.3f lon=%.3f h=%.3f\n",posd[0],posd[1],h);
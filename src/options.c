@@ -52,6 +52,8 @@ static char snrmask_[NFREQ][1024];
 #define ARMOPT  "0:off,1:continuous,2:instantaneous,3:fix-and-hold"
 #define POSOPT  "0:llh,1:xyz,2:single,3:posfile,4:rinexhead,5:rtcm"
 #define TIDEOPT "0:off,1:on,2:otl"
+#define KFUOPT  "0:standard,1:cholesky"
+#define OFMOPT  "0:text,1:binary"
 
 opt_t sysopts[]={
     {"pos1-posmode",    3,  (void *)&prcopt_.mode,       MODOPT },
@@ -91,6 +93,8 @@ opt_t sysopts[]={
     {"pos2-rejionno",   1,  (void *)&prcopt_.maxinno,    "m"    },
     {"pos2-rejgdop",    1,  (void *)&prcopt_.maxgdop,    ""     },
     {"pos2-niter",      0,  (void *)&prcopt_.niter,      ""     },
+    {"pos2-kfupdate",   3,  (void *)&prcopt_.kfupd,      KFUOPT },
+    {"pos2-ambarc",     3,  (void *)&prcopt_.ambarc,     SWTOPT },
     {"pos2-baselen",    1,  (void *)&prcopt_.baseline[0],"m"    },
     {"pos2-basesig",    1,  (void *)&prcopt_.baseline[1],"m"    },
     
@@ -147,6 +151,16 @@ opt_t sysopts[]={
     {"misc-sbasatsel",  0,  (void *)&prcopt_.sbassatsel, "0:all"},
     {"misc-rnxopt1",    2,  (void *)prcopt_.rnxopt[0],   ""     },
     {"misc-rnxopt2",    2,  (void *)prcopt_.rnxopt[1],   ""     },
+    {"misc-outformat",  3,  (void *)&prcopt_.outformat,  OFMOPT },
+    {"misc-outdir",     2,  (void *)prcopt_.outdir,      ""     },
+    {"misc-dbglevel",   0,  (void *)&prcopt_.dbglevel,   ""     },
+    {"misc-dbgsnap",    3,  (void *)&prcopt_.dbgsnap,    SWTOPT },
+    {"misc-nthread",    0,  (void *)&prcopt_.nthread,    ""     },
+    {"misc-nslice",     0,  (void *)&prcopt_.nslice,     ""     },
+    {"misc-slicewarm",  1,  (void *)&prcopt_.slicewarm,  "s"    },
+    {"misc-streamobs",  3,  (void *)&prcopt_.streamobs,  SWTOPT },
+    {"misc-nload",      0,  (void *)&prcopt_.nload,      ""     },
+    {"misc-rnxcache",   2,  (void *)prcopt_.rnxcache,    ""     },
     
     {"file-satantfile", 2,  (void *)&filopt_.satantp,    ""     },
     {"file-rcvantfile", 2,  (void *)&filopt_.rcvantp,    ""     },
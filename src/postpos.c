@@ -33,43 +33,145 @@
 static const char rcsid[]="$Id: postpos.c,v 1.1 2008/07/17 21:48:06 ttaka Exp $";
 
 #define MIN(x,y)    ((x)<(y)?(x):(y))
+#define MAX(x,y)    ((x)>(y)?(x):(y))
 #define SQRT(x)     ((x)<=0.0?0.0:sqrt(x))
 
 #define MAXPRCDAYS  100          /* max days of continuous processing */
 #define MAXINFILE   1000         /* max number of input files */
+#define MAXPRCTHREAD 64          /* max number of session worker threads */
+
+/* type definitions ----------------------------------------------------------*/
+
+typedef struct {        /* precise ephemeris and corrections of time unit */
+    nav_t nav;          /* navigation data (precise ephemeris/clock) */
+    sbs_t sbs;          /* sbas messages */
+    lex_t lex;          /* lex messages */
+    char rtcm_file[1024]; /* rtcm data file */
+    int nref;           /* number of references */
+} precdata_t;
+
+typedef struct {        /* observation epoch type */
+    gtime_t time;       /* epoch time */
+    int i;              /* index of first observation data */
+    int n;              /* number of observation data */
+} obsep_t;
+
+typedef struct {        /* observation epoch index of receiver type */
+    int n,nmax;         /* number of epochs/allocated */
+    obsep_t *ep;        /* epochs */
+} obsidx_t;
+
+typedef struct {        /* observation epoch stream of receiver type */
+    rnxobs_t rnx;       /* rinex obs stream */
+    obsd_t data[2][MAXOBS]; /* observation data of current/next epoch */
+    int n[2];           /* number of data of current/next epoch (-1: end) */
+    int cur;            /* index of current epoch */
+    gtime_t tlast;      /* time of last epoch read */
+} obsstrm_t;
+
+typedef struct postses_tag { /* processing session type */
+    gtime_t ts,te;      /* processing start/end time */
+    double ti;          /* processing interval (s) */
+    prcopt_t popt;      /* processing options */
+    const solopt_t *sopt; /* solution options */
+    const filopt_t *fopt; /* file options */
+    int flag;           /* write header flag */
+    char *infile[MAXINFILE]; /* input files */
+    int index[MAXINFILE]; /* index of input files */
+    int n;              /* number of input files */
+    char outfile[1024]; /* output file */
+    char outdir[1024];  /* directory of output files (keywords replaced) */
+    char proc_rov [64]; /* rover for processing */
+    char proc_base[64]; /* base station for processing */
+    precdata_t *prec;   /* precise ephemeris and corrections (shared) */
+    obs_t obss;         /* observation data */
+    obsidx_t oidx[2];   /* epoch index of rover and base observation data */
+    obsstrm_t *strm;    /* rover and base obs streams (NULL: batch input) */
+    gtime_t t0;         /* first observation time */
+    gtime_t tr[2];      /* first/last rover epoch time (time==0: none) */
+    nav_t navs;         /* navigation data */
+    sta_t stas[MAXRCV]; /* station infomation */
+    antDataSet_t antData; /* antenna data */
+    ambinfo_t *ambinfo; /* ambiguity arcs of rover (NULL: none) */
+    int nepoch;         /* number of observation epochs */
+    int aborts;         /* abort status */
+    sol_t *solf;        /* forward solutions */
+    sol_t *solb;        /* backward solutions */
+    double *rbf;        /* forward base positions */
+    double *rbb;        /* backward base positions */
+    int isolf;          /* current forward solutions index */
+    int isolb;          /* current backward solutions index */
+    outtime_t outtime;  /* time bases of output files */
+    int tready;         /* time bases published by forward pass */
+    lock_t lock;        /* lock flag of time bases */
+    char rtcm_path[1024]; /* rtcm data path */
+    rtcm_t *rtcm;       /* rtcm control struct */
+    FILE *fp_rtcm;      /* rtcm data file pointer */
+    int state;          /* state (0:waiting,1:running) */
+    struct postses_tag *next; /* next pending session */
+} postses_t;
+
+typedef struct {        /* processing pass type */
+    postses_t *ses;     /* processing session */
+    const prcopt_t *popt; /* processing options */
+    int revs;           /* analysis direction (0:forward,1:backward) */
+    int iepu;           /* current rover epoch index */
+    int iepr;           /* current reference epoch index */
+    int isbs;           /* current sbas message index */
+    int ilex;           /* current lex message index */
+    int aborts;         /* abort status */
+    int conc;           /* concurrent with other pass (0:off,1:on) */
+    int slice;          /* time slice number (0:off) */
+    gtime_t ts;         /* start time of slice solutions (ts.time==0: no limit) */
+    gtime_t te;         /* end time of slice (te.time==0: no limit) */
+    sol_t solw;         /* last warm-up solution of slice */
+    sol_t *sol;         /* combined or slice solutions */
+    double *rb;         /* combined or slice base positions */
+    int isol;           /* current combined or slice solutions index */
+    int nsol;           /* size of solutions buffer */
+} pospass_t;
+
+typedef struct {        /* processing session worker pool type */
+    int nthread;        /* number of worker threads */
+    int state;          /* state (0:stop,1:running) */
+    int npend;          /* number of pending sessions */
+    int aborts;         /* abort status */
+    postses_t *head;    /* pending sessions in order of submission */
+    thread_t thread[MAXPRCTHREAD]; /* worker threads */
+    lock_t lock;        /* lock flag */
+} sespool_t;
+
+typedef struct {        /* input file of parallel loading type */
+    const char *file;   /* file path */
+    int rcv;            /* receiver number */
+    int state;          /* state (0:waiting,1:loading,2:loaded) */
+    int stat;           /* status of readrnxt() (1:ok,0:no data,-1:error) */
+    obs_t obs;          /* observation data */
+    nav_t *nav;         /* navigation data */
+    sta_t sta;          /* station parameters (deltype<0: not read) */
+} loadfile_t;
+
+typedef struct {        /* parallel loading of input files type */
+    loadfile_t *file;   /* input files */
+    int n;              /* number of input files */
+    int next;           /* index of next file to be loaded */
+    int nmrg;           /* number of merged files */
+    int nwin;           /* max number of files loaded ahead of merging */
+    int state;          /* state (0:stop,1:running) */
+    gtime_t ts,te;      /* time start/end */
+    double ti;          /* time interval */
+    const prcopt_t *popt; /* processing options */
+    lock_t lock;        /* lock flag */
+} loadpool_t;
 
 /* constants/global variables ------------------------------------------------*/
 
 static pcvs_t pcvss={0};        /* receiver antenna parameters */
 static pcvs_t pcvsr={0};        /* satellite antenna parameters */
-static obs_t obss={0};          /* observation data */
-static nav_t navs={0};          /* navigation data */
-static sbs_t sbss={0};          /* sbas messages */
-static lex_t lexs={0};          /* lex messages */
-static sta_t stas[MAXRCV];      /* station infomation */
-static antDataSet_t antData={0};    /* antenna data */
-static int nepoch=0;            /* number of observation epochs */
-static int iobsu =0;            /* current rover observation data index */
-static int iobsr =0;            /* current reference observation data index */
-static int isbs  =0;            /* current sbas message index */
-static int ilex  =0;            /* current lex message index */
-static int revs  =0;            /* analysis direction (0:forward,1:backward) */
-static int aborts=0;            /* abort status */
-static sol_t *solf;             /* forward solutions */
-static sol_t *solb;             /* backward solutions */
-static double *rbf;             /* forward base positions */
-static double *rbb;             /* backward base positions */
-static int isolf=0;             /* current forward solutions index */
-static int isolb=0;             /* current backward solutions index */
-static char proc_rov [64]="";   /* rover for current processing */
-static char proc_base[64]="";   /* base station for current processing */
-static char rtcm_file[1024]=""; /* rtcm data file */
-static char rtcm_path[1024]=""; /* rtcm data path */
-static rtcm_t rtcm;             /* rtcm control struct */
-static FILE *fp_rtcm=NULL;      /* rtcm data file pointer */
+static nav_t navs={0};          /* navigation data of all sessions */
 
 /* show message and check break ----------------------------------------------*/
-static int checkbrk(const char *format, ...)
+static int checkbrk(const char *rov, const char *base, const char *format, ...)
 {
     va_list arg;
     char buff[1024],*p=buff;
@@ -77,9 +179,9 @@ static int checkbrk(const char *format, ...)
     va_start(arg,format);
     p+=vsprintf(p,format,arg);
     va_end(arg);
-    if (*proc_rov&&*proc_base) sprintf(p," (%s-%s)",proc_rov,proc_base);
-    else if (*proc_rov ) sprintf(p," (%s)",proc_rov );
-    else if (*proc_base) sprintf(p," (%s)",proc_base);
+    if (*rov&&*base) sprintf(p," (%s-%s)",rov,base);
+    else if (*rov ) sprintf(p," (%s)",rov );
+    else if (*base) sprintf(p," (%s)",base);
     return showmsg(buff);
 }
 /* output reference position -------------------------------------------------*/
@@ -109,13 +211,13 @@ static void outrpos(FILE *fp, const double *r, const solopt_t *opt)
     }
 }
 /* output header -------------------------------------------------------------*/
-static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
-                      const solopt_t *sopt)
+static void outheader(FILE *fp, char **file, int n, const gtime_t *tr,
+                      const prcopt_t *popt, const solopt_t *sopt)
 {
     const char *s1[]={"GPST","UTC","JST"};
     gtime_t ts,te;
     double t1,t2;
-    int i,j,w1,w2;
+    int i,w1,w2;
     char s2[32],s3[32];
     
     trace(3,"outheader: n=%d\n",n);
@@ -132,11 +234,9 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
         for (i=0;i<n;i++) {
             fprintf(fp,"%s inp file  : %s\n",COMMENTH,file[i]);
         }
-        for (i=0;i<obss.n;i++)    if (obss.data[i].rcv==1) break;
-        for (j=obss.n-1;j>=0;j--) if (obss.data[j].rcv==1) break;
-        if (j<i) {fprintf(fp,"\n%s no rover obs data\n",COMMENTH); return;}
-        ts=obss.data[i].time;
-        te=obss.data[j].time;
+        if (!tr[0].time) {fprintf(fp,"\n%s no rover obs data\n",COMMENTH); return;}
+        ts=tr[0];
+        te=tr[1];
         t1=time2gpst(ts,&w1);
         t2=time2gpst(te,&w2);
         if (sopt->times>=1) ts=gpst2utc(ts);
@@ -160,201 +260,394 @@ static void outheader(FILE *fp, char **file, int n, const prcopt_t *popt,
     
     outsolhead(fp,sopt);
 }
-/* search next observation data index ----------------------------------------*/
-static int nextobsf(const obs_t *obs, int *i, int rcv)
+/* add observation epoch to epoch index ------------------------------------*/
+static int addobsep(obsidx_t *idx, gtime_t time, int i, int n)
 {
-    double tt;
-    int n;
+    obsep_t *ep;
     
-    for (;*i<obs->n;(*i)++) if (obs->data[*i].rcv==rcv) break;
-    for (n=0;*i+n<obs->n;n++) {
-        tt=timediff(obs->data[*i+n].time,obs->data[*i].time);
-        if (obs->data[*i+n].rcv!=rcv||tt>DTTOL) break;
+    if (idx->n>=idx->nmax) {
+        idx->nmax=idx->nmax<=0?1024:idx->nmax*2;
+        if (!(ep=(obsep_t *)realloc(idx->ep,sizeof(obsep_t)*idx->nmax))) {
+            free(idx->ep); idx->ep=NULL; idx->n=idx->nmax=0;
+            return 0;
+        }
+        idx->ep=ep;
     }
-    return n;
+    idx->ep[idx->n].time=time;
+    idx->ep[idx->n].i=i;
+    idx->ep[idx->n++].n=n;
+    return 1;
 }
-static int nextobsb(const obs_t *obs, int *i, int rcv)
+/* index observation epochs of rover and base ----------------------------------
+* index the runs of observation data of the same receiver within DTTOL from the
+* first data of the run as the epochs of the receiver. call after sortobs()
+*-----------------------------------------------------------------------------*/
+static int indexobs(const obs_t *obs, obsidx_t *oidx)
 {
-    double tt;
-    int n;
+    int i,j,rcv;
+    
+    trace(3,"indexobs: n=%d\n",obs->n);
+    
+    for (i=0;i<obs->n;i=j) {
+        rcv=obs->data[i].rcv;
+        for (j=i+1;j<obs->n;j++) {
+            if (obs->data[j].rcv!=rcv||
+                timediff(obs->data[j].time,obs->data[i].time)>DTTOL) break;
+        }
+        if (rcv<1||rcv>2) continue;
+        if (!addobsep(oidx+rcv-1,obs->data[i].time,i,j-i)) return 0;
+    }
+    return 1;
+}
+/* free observation epoch index ----------------------------------------------*/
+static void freeobsidx(obsidx_t *oidx)
+{
+    int i;
     
-    for (;*i>=0;(*i)--) if (obs->data[*i].rcv==rcv) break;
-    for (n=0;*i-n>=0;n++) {
-        tt=timediff(obs->data[*i-n].time,obs->data[*i].time);
-        if (obs->data[*i-n].rcv!=rcv||tt<-DTTOL) break;
+    for (i=0;i<2;i++) {
+        free(oidx[i].ep); oidx[i].ep=NULL; oidx[i].n=oidx[i].nmax=0;
     }
+}
+/* rover and base observation data of epochs ----------------------------------
+* the data are handed out in place if the base epoch follows the rover epoch in
+* the observation data, and copied to the buffer otherwise
+*-----------------------------------------------------------------------------*/
+static int epochobs(const obs_t *obss, const obsep_t *epu, const obsep_t *epr,
+                    obsd_t *buff, const obsd_t **obs)
+{
+    int i,n=0,nr=epr?epr->n:0;
+    
+    if (!epr||epr->i==epu->i+epu->n) {
+        if (epu->n+nr<=MAXOBS*2) {
+            *obs=obss->data+epu->i;
+            return epu->n+nr;
+        }
+    }
+    for (i=0;i<epu->n&&n<MAXOBS*2;i++) buff[n++]=obss->data[epu->i+i];
+    for (i=0;i<nr&&n<MAXOBS*2;i++) buff[n++]=obss->data[epr->i+i];
+    *obs=buff;
     return n;
 }
-/* input obs data, navigation messages and sbas correction -------------------*/
-static int inputobs(obsd_t *obs, int solq, const prcopt_t *popt)
+/* read next epoch of observation stream ---------------------------------------
+* the data of the epoch are sorted by satellite and the duplicated data deleted.
+* the epochs not after the last epoch read are skipped
+*-----------------------------------------------------------------------------*/
+static void readstrm(obsstrm_t *strm)
+{
+    obsd_t *data=strm->data[strm->cur^1],tmp;
+    char tstr[32];
+    int i,j,n;
+    
+    while ((n=input_rnxobs(&strm->rnx,data))>=0) {
+        if (strm->tlast.time&&timediff(data[0].time,strm->tlast)<=DTTOL) {
+            trace(2,"obs epoch out of order: rcv=%d time=%s\n",strm->rnx.rcv,
+                  time_str_r(data[0].time,0,tstr));
+            continue;
+        }
+        for (i=1;i<n;i++) {
+            tmp=data[i];
+            for (j=i;j>0&&data[j-1].sat>tmp.sat;j--) data[j]=data[j-1];
+            data[j]=tmp;
+        }
+        for (i=1,j=0;i<n;i++) {
+            if (data[i].sat!=data[j].sat) data[++j]=data[i];
+        }
+        n=j+1;
+        strm->tlast=data[0].time;
+        break;
+    }
+    strm->n[strm->cur^1]=n;
+}
+/* advance observation stream to next epoch ----------------------------------*/
+static int advstrm(obsstrm_t *strm)
 {
+    if (strm->n[strm->cur]<0) return 0;
+    strm->cur^=1;
+    if (strm->n[strm->cur]<0) return 0;
+    readstrm(strm);
+    return 1;
+}
+/* rewind observation stream to first epoch ----------------------------------*/
+static void rewindstrm(obsstrm_t *strm)
+{
+    rewind_rnxobs(&strm->rnx);
+    strm->tlast.time=0; strm->tlast.sec=0.0;
+    strm->cur=1;
+    readstrm(strm);
+    strm->cur=0;
+    if (strm->n[0]>=0) readstrm(strm); else strm->n[1]=-1;
+}
+/* update sbas, lex and rtcm corrections to observation time forward ---------*/
+static void updcorr(pospass_t *pass, gtime_t tobs)
+{
+    postses_t *ses=pass->ses;
+    const sbs_t *sbss=&ses->prec->sbs;
+    const lex_t *lexs=&ses->prec->lex;
+    nav_t *navs=&ses->navs;
     gtime_t time={0};
     char path[1024];
-    int i,nu,nr,n=0;
-    
-    trace(3,"infunc  : revs=%d iobsu=%d iobsr=%d isbs=%d\n",revs,iobsu,iobsr,isbs);
+    int i;
     
-    if (0<=iobsu&&iobsu<obss.n) {
-        settime((time=obss.data[iobsu].time));
-        if (checkbrk("processing : %s Q=%d",time_str(time,0),solq)) {
-            aborts=1; showmsg("aborted"); return -1;
+    /* update sbas corrections */
+    while (pass->isbs<sbss->n) {
+        time=gpst2time(sbss->msgs[pass->isbs].week,sbss->msgs[pass->isbs].tow);
+        
+        if (getbitu(sbss->msgs[pass->isbs].msg,8,6)!=9) { /* except for geo nav */
+            sbsupdatecorr(sbss->msgs+pass->isbs,navs);
         }
+        if (timediff(time,tobs)>-1.0-DTTOL) break;
+        pass->isbs++;
     }
-    if (!revs) { /* input forward data */
-        if ((nu=nextobsf(&obss,&iobsu,1))<=0) return -1;
-        if (popt->intpref) {
-            for (;(nr=nextobsf(&obss,&iobsr,2))>0;iobsr+=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)>-DTTOL) break;
-        }
-        else {
-            for (i=iobsr;(nr=nextobsf(&obss,&i,2))>0;iobsr=i,i+=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)>DTTOL) break;
+    /* update lex corrections */
+    while (pass->ilex<lexs->n) {
+        if (lexupdatecorr(lexs->msgs+pass->ilex,navs,&time)) {
+            if (timediff(time,tobs)>-1.0-DTTOL) break;
         }
-        nr=nextobsf(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr+i];
-        iobsu+=nu;
+        pass->ilex++;
+    }
+    /* update rtcm corrections */
+    if (ses->rtcm) {
         
-        /* update sbas corrections */
-        while (isbs<sbss.n) {
-            time=gpst2time(sbss.msgs[isbs].week,sbss.msgs[isbs].tow);
+        /* open or swap rtcm file */
+        reppath(ses->prec->rtcm_file,path,tobs,"","");
+        
+        if (strcmp(path,ses->rtcm_path)) {
+            strcpy(ses->rtcm_path,path);
             
-            if (getbitu(sbss.msgs[isbs].msg,8,6)!=9) { /* except for geo nav */
-                sbsupdatecorr(sbss.msgs+isbs,&navs);
+            if (ses->fp_rtcm) fclose(ses->fp_rtcm);
+            ses->fp_rtcm=fopen(path,"rb");
+            if (ses->fp_rtcm) {
+                ses->rtcm->time=tobs;
+                input_rtcm3f(ses->rtcm,ses->fp_rtcm);
+                trace(2,"rtcm file open: %s\n",path);
             }
-            if (timediff(time,obs[0].time)>-1.0-DTTOL) break;
-            isbs++;
         }
-        /* update lex corrections */
-        while (ilex<lexs.n) {
-            if (lexupdatecorr(lexs.msgs+ilex,&navs,&time)) {
-                if (timediff(time,obs[0].time)>-1.0-DTTOL) break;
+        if (ses->fp_rtcm) {
+            while (timediff(ses->rtcm->time,tobs)<0.0) {
+                if (input_rtcm3f(ses->rtcm,ses->fp_rtcm)<-1) break;
             }
-            ilex++;
+            for (i=0;i<MAXSAT;i++) navs->ssr[i]=ses->rtcm->ssr[i];
         }
-        /* update rtcm corrections */
-        if (*rtcm_file) {
-            
-            /* open or swap rtcm file */
-            reppath(rtcm_file,path,obs[0].time,"","");
-            
-            if (strcmp(path,rtcm_path)) {
-                strcpy(rtcm_path,path);
-                
-                if (fp_rtcm) fclose(fp_rtcm);
-                fp_rtcm=fopen(path,"rb");
-                if (fp_rtcm) {
-                    rtcm.time=obs[0].time;
-                    input_rtcm3f(&rtcm,fp_rtcm);
-                    trace(2,"rtcm file open: %s\n",path);
-                }
-            }
-            if (fp_rtcm) {
-                while (timediff(rtcm.time,obs[0].time)<0.0) {
-                    if (input_rtcm3f(&rtcm,fp_rtcm)<-1) break;
-                }
-                for (i=0;i<MAXSAT;i++) navs.ssr[i]=rtcm.ssr[i];
-            }
+    }
+}
+/* input obs data of rover and base streams forward --------------------------*/
+static int inputstrm(pospass_t *pass, obsd_t *buff, const obsd_t **pobs,
+                     int solq, const prcopt_t *popt)
+{
+    postses_t *ses=pass->ses;
+    obsstrm_t *su=ses->strm,*sr=ses->strm+1;
+    gtime_t time;
+    char tstr[32];
+    int i,n=0;
+    
+    trace(3,"infunc  : strm n=%d\n",su->n[su->cur]);
+    
+    if (su->n[su->cur]<0) return -1;
+    
+    settime((time=su->data[su->cur][0].time));
+    if (checkbrk(ses->proc_rov,ses->proc_base,"processing : %s Q=%d",
+                 time_str_r(time,0,tstr),solq)) {
+        pass->aborts=1; showmsg("aborted"); return -1;
+    }
+    if (popt->intpref) { /* first base epoch after rover epoch */
+        while (sr->n[sr->cur]>=0&&
+               timediff(sr->data[sr->cur][0].time,time)<=-DTTOL) advstrm(sr);
+    }
+    else { /* last base epoch before rover epoch */
+        while (sr->n[sr->cur^1]>=0&&
+               timediff(sr->data[sr->cur^1][0].time,time)<=DTTOL) advstrm(sr);
+    }
+    for (i=0;i<su->n[su->cur];i++) buff[n++]=su->data[su->cur][i];
+    for (i=0;i<sr->n[sr->cur]&&n<MAXOBS*2;i++) buff[n++]=sr->data[sr->cur][i];
+    advstrm(su);
+    
+    updcorr(pass,buff[0].time);
+    
+    *pobs=buff;
+    return n;
+}
+/* input obs data, navigation messages and sbas correction -------------------*/
+static int inputobs(pospass_t *pass, obsd_t *buff, const obsd_t **pobs,
+                    int solq, const prcopt_t *popt)
+{
+    postses_t *ses=pass->ses;
+    const obs_t *obss=&ses->obss;
+    const obsidx_t *iu=ses->oidx,*ir=ses->oidx+1;
+    const obsd_t *obs;
+    const sbs_t *sbss=&ses->prec->sbs;
+    const lex_t *lexs=&ses->prec->lex;
+    nav_t *navs=&ses->navs;
+    gtime_t time={0};
+    char tstr[32];
+    int n;
+    
+    if (ses->strm) return inputstrm(pass,buff,pobs,solq,popt);
+    
+    trace(3,"infunc  : revs=%d iepu=%d iepr=%d isbs=%d\n",pass->revs,
+          pass->iepu,pass->iepr,pass->isbs);
+    
+    if (0<=pass->iepu&&pass->iepu<iu->n) {
+        settime((time=iu->ep[pass->iepu].time));
+        if (checkbrk(ses->proc_rov,ses->proc_base,"processing : %s Q=%d",
+                     time_str_r(time,0,tstr),solq)) {
+            pass->aborts=1; showmsg("aborted"); return -1;
         }
     }
+    if (!pass->revs) { /* input forward data */
+        if (pass->iepu>=iu->n) return -1;
+        time=iu->ep[pass->iepu].time;
+        if (pass->te.time&&timediff(time,pass->te)>-DTTOL) return -1;
+        if (popt->intpref) { /* first base epoch after rover epoch */
+            while (pass->iepr<ir->n&&
+                   timediff(ir->ep[pass->iepr].time,time)<=-DTTOL) pass->iepr++;
+        }
+        else { /* last base epoch before rover epoch */
+            while (pass->iepr+1<ir->n&&
+                   timediff(ir->ep[pass->iepr+1].time,time)<=DTTOL) pass->iepr++;
+        }
+        n=epochobs(obss,iu->ep+pass->iepu,
+                   pass->iepr<ir->n?ir->ep+pass->iepr:NULL,buff,&obs);
+        pass->iepu++;
+        
+        /* update sbas, lex and rtcm corrections */
+        updcorr(pass,obs[0].time);
+    }
     else { /* input backward data */
-        if ((nu=nextobsb(&obss,&iobsu,1))<=0) return -1;
-        if (popt->intpref) {
-            for (;(nr=nextobsb(&obss,&iobsr,2))>0;iobsr-=nr)
-                if (timediff(obss.data[iobsr].time,obss.data[iobsu].time)<DTTOL) break;
+        if (pass->iepu<0) return -1;
+        time=iu->ep[pass->iepu].time;
+        if (popt->intpref) { /* first base epoch before rover epoch */
+            while (pass->iepr>=0&&
+                   timediff(ir->ep[pass->iepr].time,time)>=DTTOL) pass->iepr--;
         }
-        else {
-            for (i=iobsr;(nr=nextobsb(&obss,&i,2))>0;iobsr=i,i-=nr)
-                if (timediff(obss.data[i].time,obss.data[iobsu].time)<-DTTOL) break;
+        else { /* last base epoch after rover epoch */
+            while (pass->iepr-1>=0&&
+                   timediff(ir->ep[pass->iepr-1].time,time)>=-DTTOL) pass->iepr--;
         }
-        nr=nextobsb(&obss,&iobsr,2);
-        for (i=0;i<nu&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsu-nu+1+i];
-        for (i=0;i<nr&&n<MAXOBS*2;i++) obs[n++]=obss.data[iobsr-nr+1+i];
-        iobsu-=nu;
+        n=epochobs(obss,iu->ep+pass->iepu,
+                   pass->iepr>=0?ir->ep+pass->iepr:NULL,buff,&obs);
+        pass->iepu--;
         
         /* update sbas corrections */
-        while (isbs>=0) {
-            time=gpst2time(sbss.msgs[isbs].week,sbss.msgs[isbs].tow);
+        while (pass->isbs>=0) {
+            time=gpst2time(sbss->msgs[pass->isbs].week,sbss->msgs[pass->isbs].tow);
             
-            if (getbitu(sbss.msgs[isbs].msg,8,6)!=9) { /* except for geo nav */
-                sbsupdatecorr(sbss.msgs+isbs,&navs);
+            if (getbitu(sbss->msgs[pass->isbs].msg,8,6)!=9) { /* except for geo nav */
+                sbsupdatecorr(sbss->msgs+pass->isbs,navs);
             }
             if (timediff(time,obs[0].time)<1.0+DTTOL) break;
-            isbs--;
+            pass->isbs--;
         }
         /* update lex corrections */
-        while (ilex>=0) {
-            if (lexupdatecorr(lexs.msgs+ilex,&navs,&time)) {
+        while (pass->ilex>=0) {
+            if (lexupdatecorr(lexs->msgs+pass->ilex,navs,&time)) {
                 if (timediff(time,obs[0].time)<1.0+DTTOL) break;
             }
-            ilex--;
+            pass->ilex--;
         }
     }
+    *pobs=obs;
     return n;
 }
-/* process positioning -------------------------------------------------------*/
-static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
-                    int mode, char **infile, int nfile)
+/* publish time bases of output files to backward pass ----------------------*/
+static void pubtime(postses_t *ses, const outtime_t *time)
+{
+    lock(&ses->lock);
+    ses->outtime=*time;
+    ses->tready=1;
+    unlock(&ses->lock);
+}
+/* wait for time bases of output files published by forward pass ------------*/
+static void waittime(postses_t *ses, outtime_t *time)
+{
+    int tready=0;
+    
+    for (;;) {
+        lock(&ses->lock);
+        if ((tready=ses->tready)) *time=ses->outtime;
+        unlock(&ses->lock);
+        if (tready) break;
+        sleepms(1);
+    }
+}
+/* process positioning ---------------------------------------------------------
+* the forward pass running concurrently with the backward pass does not write
+* the diagnostic output files, which are written by the backward pass after the
+* forward pass. it publishes the time bases of the files at the first solution
+* and the backward pass waits for them before the first epoch
+*-----------------------------------------------------------------------------*/
+static void procpos(pospass_t *pass, FILE *fp, const prcopt_t *popt,
+                    const solopt_t *sopt, int mode)
 {
+    postses_t *ses=pass->ses;
     gtime_t time={0};
     sol_t sol={{0}};
     rtk_t rtk;
-    obsd_t obs[MAXOBS*2]; /* for rover and base */
-    obs_t inp_obs;
-    nav_t inp_nav;
-    sta_t inp_sta;
+    obsd_t buff[MAXOBS*2]; /* for rover and base */
+    const obsd_t *obs;
     double rb[3]={0};
     int i,nobs,n,solstatic,pri[]={0,1,2,3,4,5,1,6};
     
     outputFiles_t outputFiles;
-    static int timeStatus = 0;
-    static gtime_t firstTime = {0};
+    gtime_t firstTime;
 
-    trace(3,"procpos : mode=%d\n",mode);
+    trace(3,"procpos : mode=%d revs=%d\n",mode,pass->revs);
     
-    prepareOutputFiles(&outputFiles, popt);
+    if (pass->conc&&!pass->revs) {
+        memset(&outputFiles,0,sizeof(outputFiles_t));
+        outputFiles.format=popt->outformat;
+    }
+    else {
+        if (!prepareOutputFiles(&outputFiles, popt)) {
+            showmsg("error : open output files in %s",*popt->outdir?popt->outdir:".");
+        }
+        startOutputWriter(&outputFiles, 0);
+    }
+    if (pass->conc&&pass->revs) waittime(ses,&outputFiles.time);
+    else if (!pass->slice) outputFiles.time = ses->outtime;
 
     solstatic=sopt->solstatic&&
               (popt->mode==PMODE_STATIC||popt->mode==PMODE_PPP_STATIC);
     
     rtkinit(&rtk,popt);
-    rtcm_path[0]='\0';
+    if (!pass->revs&&!pass->slice) ses->rtcm_path[0]='\0';
     
-    rtk.ant_dataset[0] = antData;
-
-    memset(&inp_obs,0,sizeof(obs_t));
-    memset(&inp_nav,0,sizeof(nav_t));
-    memset(&inp_sta,0,sizeof(sta_t));
-    for(i=0; i<nfile; i++)
-        readrnxt(infile[i],1,time,time,0,popt->rnxopt[0],&inp_obs,&inp_nav,&inp_sta);
-
-    getambinfo(&rtk,&inp_obs, &inp_nav);
-
-    freeobs(&inp_obs);
-    freenav(&inp_nav,0xFF);
+    rtk.ant_dataset[0] = ses->antData;
 
-    while ((nobs=inputobs(obs,rtk.sol.stat,popt))>=0) {
+    if (ses->ambinfo) {
+        memcpy(rtk.ambinfo,ses->ambinfo,sizeof(ambinfo_t)*MAXSAT);
+    }
+    while ((nobs=inputobs(pass,buff,&obs,rtk.sol.stat,popt))>=0) {
         
         /* exclude satellites */
-        for (i=n=0;i<nobs;i++) {
-            if ((satsys(obs[i].sat,NULL)&popt->navsys)&&
-                popt->exsats[obs[i].sat-1]!=1) obs[n++]=obs[i];
+        for (n=0;n<nobs;n++) {
+            if (!(satsys(obs[n].sat,NULL)&popt->navsys)||
+                popt->exsats[obs[n].sat-1]==1) break;
+        }
+        if (n<nobs) {
+            if (obs!=buff) memcpy(buff,obs,sizeof(obsd_t)*n);
+            for (i=n;i<nobs;i++) {
+                if ((satsys(obs[i].sat,NULL)&popt->navsys)&&
+                    popt->exsats[obs[i].sat-1]!=1) buff[n++]=obs[i];
+            }
+            obs=buff;
         }
         if (n<=0) continue;
         
-        if (!rtkpos(&rtk,obs,n,&navs,&outputFiles)) continue;
+        if (!rtkpos(&rtk,obs,n,&ses->navs,&outputFiles)) continue;
         
-        if(!timeStatus)
+        if(!outputFiles.time.tset[OUTT_SOL])
         {
-          writeTimeToFile(outputFiles.trajectory, rtk.sol.time);
-          writeTimeToFile(outputFiles.matrix, rtk.sol.time);
-          writeTimeToFile(outputFiles.clock, obs[0].time);
-          timeStatus = 1;
-          firstTime = rtk.sol.time;
-        }
-        writeTrajectory(outputFiles.trajectory, timediff(rtk.sol.time, firstTime), rtk.sol.rr);
-        writeCovariationMatrix(outputFiles.matrix, timediff(rtk.sol.time, firstTime), rtk.sol.qr, rtk.sol.qvr);
-        writeClock(outputFiles.clock, timediff(rtk.sol.time, firstTime), 1000000000 * timediff(rtk.sol.time, obs[0].time), 0);
+          writeOutputTime(&outputFiles, OUTF_TRAJECTORY, rtk.sol.time);
+          writeOutputTime(&outputFiles, OUTF_MATRIX, rtk.sol.time);
+          writeOutputTime(&outputFiles, OUTF_CLOCK, obs[0].time);
+          outputFiles.time.tset[OUTT_SOL] = 1;
+          outputFiles.time.t0[OUTT_SOL] = rtk.sol.time;
+          if (pass->conc&&!pass->revs) pubtime(ses,&outputFiles.time);
+        }
+        firstTime = outputFiles.time.t0[OUTT_SOL];
+        writeTrajectory(&outputFiles, timediff(rtk.sol.time, firstTime), rtk.sol.rr);
+        writeCovariationMatrix(&outputFiles, timediff(rtk.sol.time, firstTime), rtk.sol.qr, rtk.sol.qvr);
+        writeClock(&outputFiles, timediff(rtk.sol.time, firstTime), 1000000000 * timediff(rtk.sol.time, obs[0].time), 0);
 
         if (mode==0) { /* forward/backward */
             if (!solstatic) {
@@ -368,25 +661,15 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
                 }
             }
         }
-        else if (!revs) { /* combined-forward */
-            if (isolf>=nepoch)
-            {
-              closeOutputFiles(&outputFiles);
-              return;
-            }
-            solf[isolf]=rtk.sol;
-            for (i=0;i<3;i++) rbf[i+isolf*3]=rtk.rb[i];
-            isolf++;
-        }
-        else { /* combined-backward */
-            if (isolb>=nepoch)
-            {
-              closeOutputFiles(&outputFiles);
-              return;
+        else { /* combined-forward/backward or time slice */
+            if (pass->ts.time&&timediff(obs[0].time,pass->ts)<-DTTOL) {
+                pass->solw=rtk.sol; /* warm-up */
+                continue;
             }
-            solb[isolb]=rtk.sol;
-            for (i=0;i<3;i++) rbb[i+isolb*3]=rtk.rb[i];
-            isolb++;
+            if (pass->isol>=pass->nsol) break;
+            pass->sol[pass->isol]=rtk.sol;
+            for (i=0;i<3;i++) pass->rb[i+pass->isol*3]=rtk.rb[i];
+            pass->isol++;
         }
     }
     if (mode==0&&solstatic&&time.time!=0.0) {
@@ -394,6 +677,8 @@ static void procpos(FILE *fp, const prcopt_t *popt, const solopt_t *sopt,
         outsol(fp,&sol,rb,sopt);
     }
     rtkfree(&rtk);
+    if (pass->conc&&!pass->revs) pubtime(ses,&outputFiles.time);
+    else if (!pass->slice) ses->outtime = outputFiles.time;
     closeOutputFiles(&outputFiles);
 }
 /* validation of combined solutions ------------------------------------------*/
@@ -421,8 +706,12 @@ static int valcomb(const sol_t *solf, const sol_t *solb)
     return 1;
 }
 /* combine forward/backward solutions and output results ---------------------*/
-static void combres(FILE *fp, const prcopt_t *popt, const solopt_t *sopt)
+static void combres(const postses_t *ses, FILE *fp, const prcopt_t *popt,
+                    const solopt_t *sopt)
 {
+    const sol_t *solf=ses->solf,*solb=ses->solb;
+    const double *rbf=ses->rbf,*rbb=ses->rbb;
+    int isolf=ses->isolf,isolb=ses->isolb;
     gtime_t time={0};
     sol_t sols={{0}},sol={{0}};
     double tt,Qf[9],Qb[9],Qs[9],rbs[3]={0},rb[3]={0},rr_f[3],rr_b[3],rr_s[3];
@@ -506,10 +795,13 @@ static void combres(FILE *fp, const prcopt_t *popt, const solopt_t *sopt)
         outsol(fp,&sol,rb,sopt);
     }
 }
-/* read prec ephemeris, sbas data, lex data, tec grid and open rtcm ----------*/
+/* read prec ephemeris, sbas data, lex data and set rtcm file ----------------*/
 static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
-                        nav_t *nav, sbs_t *sbs, lex_t *lex)
+                        precdata_t *prec)
 {
+    nav_t *nav=&prec->nav;
+    sbs_t *sbs=&prec->sbs;
+    lex_t *lex=&prec->lex;
     seph_t seph0={0};
     int i;
     char *ext;
@@ -550,49 +842,327 @@ static void readpreceph(char **infile, int n, const prcopt_t *prcopt,
     }
     for (i=0;i<nav->ns;i++) nav->seph[i]=seph0;
     
-    /* set rtcm file and initialize rtcm struct */
-    rtcm_file[0]=rtcm_path[0]='\0'; fp_rtcm=NULL;
+    /* set rtcm file */
+    prec->rtcm_file[0]='\0';
     
     for (i=0;i<n;i++) {
         if ((ext=strrchr(infile[i],'.'))&&
             (!strcmp(ext,".rtcm3")||!strcmp(ext,".RTCM3"))) {
-            strcpy(rtcm_file,infile[i]);
-            init_rtcm(&rtcm);
+            strcpy(prec->rtcm_file,infile[i]);
             break;
         }
     }
 }
 /* free prec ephemeris and sbas data -----------------------------------------*/
-static void freepreceph(nav_t *nav, sbs_t *sbs, lex_t *lex)
+static void freepreceph(precdata_t *prec)
 {
-    int i;
+    nav_t *nav=&prec->nav;
     
     trace(3,"freepreceph:\n");
     
     free(nav->peph); nav->peph=NULL; nav->ne=nav->nemax=0;
     free(nav->pclk); nav->pclk=NULL; nav->nc=nav->ncmax=0;
     free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
-    free(sbs->msgs); sbs->msgs=NULL; sbs->n =sbs->nmax =0;
-    free(lex->msgs); lex->msgs=NULL; lex->n =lex->nmax =0;
-    for (i=0;i<nav->nt;i++) {
-        free(nav->tec[i].data);
-        free(nav->tec[i].rms );
+    free(prec->sbs.msgs); prec->sbs.msgs=NULL; prec->sbs.n=prec->sbs.nmax=0;
+    free(prec->lex.msgs); prec->lex.msgs=NULL; prec->lex.n=prec->lex.nmax=0;
+}
+/* mark/merge navigation parameters of header --------------------------------
+* the parameters of the header are marked by all-one bytes before loading and
+* merged if they are read as the sequential loading overwrites them
+*-----------------------------------------------------------------------------*/
+static void mergeprm(void *dst, const void *src, size_t size, int n)
+{
+    static const unsigned char mark[8]={
+        0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF
+    };
+    int i;
+    
+    for (i=0;i<n;i++) {
+        if (!memcmp((const char *)src+size*i,mark,size)) continue;
+        memcpy((char *)dst+size*i,(const char *)src+size*i,size);
     }
-    free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;
+}
+#define NPRM(x)     (int)(sizeof(x)/sizeof(*(x)))
+
+static void marknavprm(nav_t *nav)
+{
+    memset(nav->utc_gps,0xFF,sizeof(nav->utc_gps));
+    memset(nav->utc_glo,0xFF,sizeof(nav->utc_glo));
+    memset(nav->utc_gal,0xFF,sizeof(nav->utc_gal));
+    memset(nav->utc_qzs,0xFF,sizeof(nav->utc_qzs));
+    memset(nav->utc_cmp,0xFF,sizeof(nav->utc_cmp));
+    memset(nav->utc_sbs,0xFF,sizeof(nav->utc_sbs));
+    memset(nav->ion_gps,0xFF,sizeof(nav->ion_gps));
+    memset(nav->ion_gal,0xFF,sizeof(nav->ion_gal));
+    memset(nav->ion_qzs,0xFF,sizeof(nav->ion_qzs));
+    memset(nav->ion_cmp,0xFF,sizeof(nav->ion_cmp));
+    memset(&nav->leaps ,0xFF,sizeof(nav->leaps));
+    memset(nav->wlbias ,0xFF,sizeof(nav->wlbias));
+    memset(nav->glo_cpbias,0xFF,sizeof(nav->glo_cpbias));
+    memset(nav->glo_fcn,0xFF,sizeof(nav->glo_fcn));
+}
+static void mergenavprm(nav_t *nav, const nav_t *src)
+{
+    mergeprm(nav->utc_gps,src->utc_gps,sizeof(double),NPRM(nav->utc_gps));
+    mergeprm(nav->utc_glo,src->utc_glo,sizeof(double),NPRM(nav->utc_glo));
+    mergeprm(nav->utc_gal,src->utc_gal,sizeof(double),NPRM(nav->utc_gal));
+    mergeprm(nav->utc_qzs,src->utc_qzs,sizeof(double),NPRM(nav->utc_qzs));
+    mergeprm(nav->utc_cmp,src->utc_cmp,sizeof(double),NPRM(nav->utc_cmp));
+    mergeprm(nav->utc_sbs,src->utc_sbs,sizeof(double),NPRM(nav->utc_sbs));
+    mergeprm(nav->ion_gps,src->ion_gps,sizeof(double),NPRM(nav->ion_gps));
+    mergeprm(nav->ion_gal,src->ion_gal,sizeof(double),NPRM(nav->ion_gal));
+    mergeprm(nav->ion_qzs,src->ion_qzs,sizeof(double),NPRM(nav->ion_qzs));
+    mergeprm(nav->ion_cmp,src->ion_cmp,sizeof(double),NPRM(nav->ion_cmp));
+    mergeprm(&nav->leaps ,&src->leaps ,sizeof(int),1);
+    mergeprm(nav->wlbias ,src->wlbias ,sizeof(double),NPRM(nav->wlbias));
+    mergeprm(nav->glo_cpbias,src->glo_cpbias,sizeof(double),
+             NPRM(nav->glo_cpbias));
+    mergeprm(nav->glo_fcn,src->glo_fcn,sizeof(char),NPRM(nav->glo_fcn));
+}
+/* append data to buffer -----------------------------------------------------*/
+static void *appendbuf(void *buff, int *n, int *nmax, const void *data, int m,
+                       size_t size)
+{
+    void *p=buff;
+    int nm;
+    
+    if (m<=0) return buff;
+    if (*n+m>*nmax) {
+        nm=MAX(*n+m,*nmax*2);
+        if (!(p=realloc(buff,size*nm))) return NULL;
+        *nmax=nm;
+    }
+    memcpy((char *)p+size*(*n),data,size*m);
+    *n+=m;
+    return p;
+}
+/* merge obs and nav data of loaded file -------------------------------------*/
+static int mergefile(loadfile_t *f, obs_t *obs, nav_t *nav, sta_t *sta)
+{
+    obsd_t *data;
+    eph_t *eph;
+    geph_t *geph;
+    seph_t *seph;
+    int i;
     
-#ifdef EXTSTEC
-    stec_free(nav);
+    trace(3,"mergefile: file=%s rcv=%d nobs=%d\n",f->file,f->rcv,f->obs.n);
+    
+    for (i=0;i<f->obs.n;i++) f->obs.data[i].rcv=(unsigned char)f->rcv;
+    
+    if (!obs->data) {
+        *obs=f->obs;
+        f->obs.data=NULL; f->obs.n=f->obs.nmax=0;
+    }
+    else if (!(data=(obsd_t *)appendbuf(obs->data,&obs->n,&obs->nmax,
+                                        f->obs.data,f->obs.n,sizeof(obsd_t)))) {
+        return 0;
+    }
+    else obs->data=data;
+    
+    if (!(eph=(eph_t *)appendbuf(nav->eph,&nav->n,&nav->nmax,f->nav->eph,
+                                 f->nav->n,sizeof(eph_t)))&&f->nav->n>0) {
+        return 0;
+    }
+    nav->eph=eph;
+    if (!(geph=(geph_t *)appendbuf(nav->geph,&nav->ng,&nav->ngmax,f->nav->geph,
+                                   f->nav->ng,sizeof(geph_t)))&&f->nav->ng>0) {
+        return 0;
+    }
+    nav->geph=geph;
+    if (!(seph=(seph_t *)appendbuf(nav->seph,&nav->ns,&nav->nsmax,f->nav->seph,
+                                   f->nav->ns,sizeof(seph_t)))&&f->nav->ns>0) {
+        return 0;
+    }
+    nav->seph=seph;
+    mergenavprm(nav,f->nav);
+    
+    if (f->rcv<=2&&f->sta.deltype>=0) sta[f->rcv-1]=f->sta;
+    return 1;
+}
+/* load input file to buffers of file ----------------------------------------*/
+static void loadfile(const loadpool_t *pool, loadfile_t *f)
+{
+    const prcopt_t *popt=pool->popt;
+    
+    f->stat=-1;
+    if (!(f->nav=(nav_t *)calloc(1,sizeof(nav_t)))) return;
+    marknavprm(f->nav);
+    memset(&f->sta,0,sizeof(sta_t));
+    f->sta.deltype=-1;
+    
+    f->stat=readrnxt(f->file,f->rcv,pool->ts,pool->te,pool->ti,
+                     popt->rnxopt[f->rcv<=1?0:1],&f->obs,f->nav,
+                     f->rcv<=2?&f->sta:NULL);
+}
+/* free buffers of loaded file -----------------------------------------------*/
+static void freefile(loadfile_t *f)
+{
+    free(f->obs.data); f->obs.data=NULL; f->obs.n=f->obs.nmax=0;
+    if (f->nav) {
+        free(f->nav->eph);
+        free(f->nav->geph);
+        free(f->nav->seph);
+        free(f->nav); f->nav=NULL;
+    }
+}
+/* file loading thread -------------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI loadthread(void *arg)
+#else
+static void *loadthread(void *arg)
+#endif
+{
+    loadpool_t *pool=(loadpool_t *)arg;
+    loadfile_t *f;
+    
+    for (;;) {
+        lock(&pool->lock);
+        if (!pool->state||pool->next>=pool->n) {
+            unlock(&pool->lock);
+            break;
+        }
+        if (pool->next>=pool->nmrg+pool->nwin) {
+            unlock(&pool->lock);
+            sleepms(1);
+            continue;
+        }
+        f=pool->file+pool->next++;
+        f->state=1;
+        unlock(&pool->lock);
+        
+        loadfile(pool,f);
+        
+        lock(&pool->lock);
+        f->state=2;
+        unlock(&pool->lock);
+    }
+    return 0;
+}
+/* load obs and nav data in parallel -------------------------------------------
+* the input files are loaded to the buffers of files by popt->nload threads and
+* the buffers are merged in order of the input files. the receiver number of a
+* file is assumed as the obs data are in all preceding receivers. if it differs
+* in the merging, the file is reloaded only if the rinex options or the station
+* parameters differ. the merged data are identical to the sequential loading.
+* return : status (1:ok,0:error,-1:not loaded)
+*-----------------------------------------------------------------------------*/
+static int loadobsnav(postses_t *ses, gtime_t ts, gtime_t te, double ti,
+                      char **infile, const int *index, int n,
+                      const prcopt_t *prcopt, obs_t *obs, nav_t *nav,
+                      sta_t *sta)
+{
+    loadpool_t pool={0};
+    loadfile_t *f;
+    thread_t thread[MAXPRCTHREAD];
+    int i,k,nthread=MIN(prcopt->nload,MAXPRCTHREAD),ind=0,nobs=0,rcv=1,stat=1;
+    
+    if (nthread<=1||n<=1||ses->sopt->trace>0) return -1;
+    for (i=0;i<n;i++) {
+        if (!*infile[i]) return -1; /* stdin */
+    }
+    trace(3,"loadobsnav: n=%d nthread=%d\n",n,nthread);
+    
+    if (!(pool.file=(loadfile_t *)calloc(n,sizeof(loadfile_t)))) return -1;
+    
+    for (i=0;i<n;i++) {
+        if (index[i]!=ind) {
+            if (i>0) rcv++;
+            ind=index[i];
+        }
+        pool.file[i].file=infile[i];
+        pool.file[i].rcv=rcv;
+    }
+    pool.n=n;
+    pool.nwin=nthread*2;
+    pool.state=1;
+    pool.ts=ts; pool.te=te; pool.ti=ti;
+    pool.popt=prcopt;
+    initlock(&pool.lock);
+    
+    /* leap seconds table read by the threads */
+    set_default_leaps();
+    
+    for (i=0;i<nthread-1;i++) {
+#ifdef WIN32
+        if (!(thread[i]=CreateThread(NULL,0,loadthread,&pool,0,NULL))) break;
+#else
+        if (pthread_create(thread+i,NULL,loadthread,&pool)) break;
 #endif
+    }
+    nthread=i;
     
-    if (fp_rtcm) fclose(fp_rtcm);
-    free_rtcm(&rtcm);
+    for (k=0,ind=0,rcv=1;k<n&&stat;k++) {
+        f=pool.file+k;
+        
+        /* wait for the file loaded or load it */
+        for (;;) {
+            if (checkbrk(ses->proc_rov,ses->proc_base,"")) {
+                stat=0;
+                break;
+            }
+            lock(&pool.lock);
+            if (f->state==2) {
+                unlock(&pool.lock);
+                break;
+            }
+            if (pool.next==k) {
+                pool.next++;
+                unlock(&pool.lock);
+                loadfile(&pool,f);
+                break;
+            }
+            unlock(&pool.lock);
+            sleepms(1);
+        }
+        if (!stat) break;
+        
+        /* receiver number as sequential loading */
+        if (index[k]!=ind) {
+            if (obs->n>nobs) rcv++;
+            ind=index[k]; nobs=obs->n;
+        }
+        if (rcv!=f->rcv&&(MIN(rcv,3)!=MIN(f->rcv,3)||
+            (rcv>MAXRCV)!=(f->rcv>MAXRCV))) {
+            freefile(f);
+            f->rcv=rcv;
+            loadfile(&pool,f);
+        }
+        f->rcv=rcv;
+        
+        if (f->stat<0||!mergefile(f,obs,nav,sta)) {
+            checkbrk(ses->proc_rov,ses->proc_base,"error : insufficient memory");
+            trace(1,"insufficient memory\n");
+            stat=0;
+        }
+        freefile(f);
+        
+        lock(&pool.lock);
+        pool.nmrg=k+1;
+        unlock(&pool.lock);
+    }
+    lock(&pool.lock);
+    pool.state=0;
+    unlock(&pool.lock);
+    
+    for (i=0;i<nthread;i++) {
+#ifdef WIN32
+        WaitForSingleObject(thread[i],INFINITE);
+        CloseHandle(thread[i]);
+#else
+        pthread_join(thread[i],NULL);
+#endif
+    }
+    for (k=0;k<n;k++) freefile(pool.file+k);
+    free(pool.file);
+    return stat;
 }
 /* read obs and nav data -----------------------------------------------------*/
-static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
-                      const int *index, int n, const prcopt_t *prcopt,
-                      obs_t *obs, nav_t *nav, sta_t *sta)
+static int readobsnav(postses_t *ses, gtime_t ts, gtime_t te, double ti,
+                      char **infile, const int *index, int n,
+                      const prcopt_t *prcopt, obs_t *obs, nav_t *nav,
+                      sta_t *sta)
 {
-    int i,j,ind=0,nobs=0,rcv=1;
+    int i,j,ind=0,nobs=0,rcv=1,stat;
     
     trace(3,"readobsnav: ts=%s n=%d\n",time_str(ts,0),n);
     
@@ -600,10 +1170,14 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
     nav->eph =NULL; nav->n =nav->nmax =0;
     nav->geph=NULL; nav->ng=nav->ngmax=0;
     nav->seph=NULL; nav->ns=nav->nsmax=0;
-    nepoch=0;
+    ses->nepoch=0;
     
-    for (i=0;i<n;i++) {
-        if (checkbrk("")) return 0;
+    /* load files in parallel */
+    if (!(stat=loadobsnav(ses,ts,te,ti,infile,index,n,prcopt,obs,nav,sta))) {
+        return 0;
+    }
+    for (i=0;i<n&&stat<0;i++) {
+        if (checkbrk(ses->proc_rov,ses->proc_base,"")) return 0;
         
         if (index[i]!=ind) {
             if (obs->n>nobs) rcv++;
@@ -612,27 +1186,41 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
         /* read rinex obs and nav file */
         if (readrnxt(infile[i],rcv,ts,te,ti,prcopt->rnxopt[rcv<=1?0:1],obs,nav,
                      rcv<=2?sta+rcv-1:NULL)<0) {
-            checkbrk("error : insufficient memory");
+            checkbrk(ses->proc_rov,ses->proc_base,"error : insufficient memory");
             trace(1,"insufficient memory\n");
             return 0;
         }
     }
     if (obs->n<=0) {
-        checkbrk("error : no obs data");
+        checkbrk(ses->proc_rov,ses->proc_base,"error : no obs data");
         trace(1,"no obs data\n");
         return 0;
     }
     if (nav->n<=0&&nav->ng<=0&&nav->ns<=0) {
-        checkbrk("error : no nav data");
+        checkbrk(ses->proc_rov,ses->proc_base,"error : no nav data");
         trace(1,"no nav data\n");
         return 0;
     }
     /* sort observation data */
-    nepoch=sortobs(obs);
+    ses->nepoch=sortobs(obs);
+    
+    /* index epochs of rover and base */
+    if (!indexobs(obs,ses->oidx)) {
+        checkbrk(ses->proc_rov,ses->proc_base,"error : insufficient memory");
+        trace(1,"insufficient memory\n");
+        freeobsidx(ses->oidx);
+        return 0;
+    }
     
     /* delete duplicated ephemeris */
     uniqnav(nav);
     
+    /* first observation time and first/last rover epoch time */
+    ses->t0=obs->data[0].time;
+    if (ses->oidx[0].n>0) {
+        ses->tr[0]=ses->oidx[0].ep[0].time;
+        ses->tr[1]=ses->oidx[0].ep[ses->oidx[0].n-1].time;
+    }
     /* set time span for progress display */
     if (ts.time==0||te.time==0) {
         for (i=0;   i<obs->n;i++) if (obs->data[i].rcv==1) break;
@@ -645,34 +1233,150 @@ static int readobsnav(gtime_t ts, gtime_t te, double ti, char **infile,
     }
     return 1;
 }
+/* read nav data and open obs streams -----------------------------------------
+* the nav data and the station parameters are read as readobsnav(). the obs
+* data of rover and base are input by the streams epoch by epoch. the obs files
+* of a receiver should be given in time order. the epochs out of order and the
+* receivers other than rover and base are skipped
+*-----------------------------------------------------------------------------*/
+static int readobsstrm(postses_t *ses, gtime_t ts, gtime_t te, double ti,
+                       char **infile, const int *index, int n,
+                       const prcopt_t *prcopt, nav_t *nav, sta_t *sta)
+{
+    obsstrm_t *strm;
+    gtime_t time;
+    int i,j,k,nobs=0,rcv=1;
+    
+    trace(3,"readobsstrm: ts=%s n=%d\n",time_str(ts,0),n);
+    
+    nav->eph =NULL; nav->n =nav->nmax =0;
+    nav->geph=NULL; nav->ng=nav->ngmax=0;
+    nav->seph=NULL; nav->ns=nav->nsmax=0;
+    ses->nepoch=0;
+    
+    if (!(ses->strm=strm=(obsstrm_t *)calloc(2,sizeof(obsstrm_t)))) {
+        checkbrk(ses->proc_rov,ses->proc_base,"error : insufficient memory");
+        trace(1,"insufficient memory\n");
+        return 0;
+    }
+    for (i=0;i<n;i=j) {
+        if (checkbrk(ses->proc_rov,ses->proc_base,"")) return 0;
+        
+        for (j=i+1;j<n&&index[j]==index[i];j++) ;
+        
+        /* read rinex nav file and station parameters */
+        for (k=i;k<j;k++) {
+            if (readrnxt(infile[k],rcv,ts,te,ti,prcopt->rnxopt[rcv<=1?0:1],NULL,
+                         nav,rcv<=2?sta+rcv-1:NULL)<0) break;
+        }
+        /* open rinex obs stream */
+        if (k<j||(rcv<=2&&(nobs=open_rnxobs(&strm[rcv-1].rnx,infile+i,j-i,rcv,
+                 ts,te,ti,prcopt->rnxopt[rcv<=1?0:1]))<0)) {
+            checkbrk(ses->proc_rov,ses->proc_base,"error : insufficient memory");
+            trace(1,"insufficient memory\n");
+            return 0;
+        }
+        if (rcv<=2&&nobs>0) rcv++;
+    }
+    rewindstrm(strm);
+    rewindstrm(strm+1);
+    
+    if (strm[0].n[0]<0) {
+        checkbrk(ses->proc_rov,ses->proc_base,"error : no obs data");
+        trace(1,"no obs data\n");
+        return 0;
+    }
+    if (nav->n<=0&&nav->ng<=0&&nav->ns<=0) {
+        checkbrk(ses->proc_rov,ses->proc_base,"error : no nav data");
+        trace(1,"no nav data\n");
+        return 0;
+    }
+    /* delete duplicated ephemeris */
+    uniqnav(nav);
+    
+    /* first observation time and first/last rover epoch time */
+    ses->t0=ses->tr[0]=strm[0].data[0][0].time;
+    if (strm[1].n[0]>=0&&timediff(strm[1].data[0][0].time,ses->t0)<0.0) {
+        ses->t0=strm[1].data[0][0].time;
+    }
+    for (time=ses->tr[0];advstrm(strm);) {
+        time=strm[0].data[strm[0].cur][0].time;
+        ses->nepoch++;
+    }
+    ses->tr[1]=time;
+    ses->nepoch++;
+    rewindstrm(strm);
+    
+    /* set time span for progress display */
+    if ((ts.time==0||te.time==0)&&timediff(ses->tr[1],ses->tr[0])>0.0) {
+        settspan(ts.time?ts:ses->tr[0],te.time?te:ses->tr[1]);
+    }
+    return 1;
+}
+/* observation data of next epoch of receiver ----------------------------------
+* input the epochs of the receiver in order from the epoch index or the stream.
+* the stream is rewound at the end of the epochs
+*-----------------------------------------------------------------------------*/
+static int nextepoch(postses_t *ses, int rcv, int *k, obsd_t *data)
+{
+    const obsidx_t *idx=ses->oidx+rcv-1;
+    obsstrm_t *strm;
+    int i,n;
+    
+    if (ses->strm) {
+        strm=ses->strm+rcv-1;
+        if ((n=strm->n[strm->cur])<0) {
+            rewindstrm(strm);
+            return -1;
+        }
+        memcpy(data,strm->data[strm->cur],sizeof(obsd_t)*n);
+        advstrm(strm);
+        return n;
+    }
+    if (*k>=idx->n) return -1;
+    for (i=0;i<idx->ep[*k].n&&i<MAXOBS;i++) {
+        data[i]=ses->obss.data[idx->ep[*k].i+i];
+    }
+    (*k)++;
+    return i;
+}
 /* free obs and nav data -----------------------------------------------------*/
-static void freeobsnav(obs_t *obs, nav_t *nav)
+static void freeobsnav(postses_t *ses)
 {
+    obs_t *obs=&ses->obss;
+    nav_t *nav=&ses->navs;
+    
     trace(3,"freeobsnav:\n");
     
+    if (ses->strm) {
+        close_rnxobs(&ses->strm[0].rnx);
+        close_rnxobs(&ses->strm[1].rnx);
+        free(ses->strm); ses->strm=NULL;
+    }
+    freeobsidx(ses->oidx);
     free(obs->data); obs->data=NULL; obs->n =obs->nmax =0;
     free(nav->eph ); nav->eph =NULL; nav->n =nav->nmax =0;
     free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;
     free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
 }
 /* average of single position ------------------------------------------------*/
-static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
+static int avepos(double *ra, int rcv, postses_t *ses, const nav_t *nav,
                   const prcopt_t *opt)
 {
     obsd_t data[MAXOBS];
     gtime_t ts={0};
     sol_t sol={{0}};
-    int i,j,n=0,m,iobs;
+    int i,j,k=0,m,n=0;
     char msg[128];
     
-    trace(3,"avepos: rcv=%d obs.n=%d\n",rcv,obs->n);
+    trace(3,"avepos: rcv=%d obs.n=%d\n",rcv,ses->obss.n);
     
     for (i=0;i<3;i++) ra[i]=0.0;
     
-    for (iobs=0;(m=nextobsf(obs,&iobs,rcv))>0;iobs+=m) {
+    while ((m=nextepoch(ses,rcv,&k,data))>=0) {
         
-        for (i=j=0;i<m&&i<MAXOBS;i++) {
-            data[j]=obs->data[iobs+i];
+        for (i=j=0;i<m;i++) {
+            data[j]=data[i];
             if ((satsys(data[j].sat,NULL)&opt->navsys)&&
                 opt->exsats[data[j].sat-1]!=1) j++;
         }
@@ -691,10 +1395,11 @@ static int avepos(double *ra, int rcv, const obs_t *obs, const nav_t *nav,
     return 1;
 }
 /* station position from file ------------------------------------------------*/
-static int getstapos(const char *file, char *name, double *r)
+static int getstapos(const char *file, const char *name, double *r)
 {
     FILE *fp;
-    char buff[256],sname[256],*p,*q;
+    char buff[256],sname[256],*p;
+    const char *q;
     double pos[3];
     
     trace(3,"getstapos: file=%s name=%s\n",file,name);
@@ -724,17 +1429,17 @@ static int getstapos(const char *file, char *name, double *r)
     return 0;
 }
 /* antenna phase center position ---------------------------------------------*/
-static int antpos(prcopt_t *opt, int rcvno, const obs_t *obs, const nav_t *nav,
-                  const sta_t *sta, const char *posfile)
+static int antpos(prcopt_t *opt, int rcvno, postses_t *ses, const nav_t *nav,
+                  const sta_t *stas, const char *posfile)
 {
     double *rr=rcvno==1?opt->ru:opt->rb,del[3],pos[3],dr[3]={0};
     int i,postype=rcvno==1?opt->rovpos:opt->refpos;
-    char *name;
+    const char *name;
     
     trace(3,"antpos  : rcvno=%d\n",rcvno);
     
     if (postype==1) { /* average of single position */
-        if (!avepos(rr,rcvno,obs,nav,opt)) {
+        if (!avepos(rr,rcvno,ses,nav,opt)) {
             showmsg("error : station pos computation");
             return 0;
         }
@@ -774,6 +1479,9 @@ static int openses(const prcopt_t *popt, const solopt_t *sopt,
     
     trace(3,"openses :\n");
     
+    /* set directory of rinex cache files */
+    setrnxcache(popt->rnxcache);
+    
     /* read satellite antenna parameters */
     if (*fopt->satantp&&!(readpcv(fopt->satantp,pcvs))) {
         showmsg("error : no sat ant pcv in %s",fopt->satantp);
@@ -820,6 +1528,8 @@ static int openses(const prcopt_t *popt, const solopt_t *sopt,
 /* close procssing session ---------------------------------------------------*/
 static void closeses(nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr)
 {
+    int i;
+    
     trace(3,"closeses:\n");
     
     /* free antenna parameters */
@@ -832,6 +1542,20 @@ static void closeses(nav_t *nav, pcvs_t *pcvs, pcvs_t *pcvr)
     /* free erp data */
     free(nav->erp.data); nav->erp.data=NULL; nav->erp.n=nav->erp.nmax=0;
     
+    /* free tec grid data */
+    for (i=0;i<nav->nt;i++) {
+        free(nav->tec[i].data);
+        free(nav->tec[i].rms );
+    }
+    free(nav->tec ); nav->tec =NULL; nav->nt=nav->ntmax=0;
+    
+#ifdef EXTSTEC
+    stec_free(nav);
+#endif
+    
+    /* reset directory of rinex cache files */
+    setrnxcache("");
+    
     /* close solution statistics and debug trace */
     rtkclosestat();
     traceclose();
@@ -866,7 +1590,7 @@ static void setpcv(gtime_t time, prcopt_t *popt, nav_t *nav, const pcvs_t *pcvs,
                 }
             }
             else { /* enu */
-                for (j=0;j<3;j++) popt->antdel[i][j]=stas[i].del[j];
+                for (j=0;j<3;j++) popt->antdel[i][j]=sta[i].del[j];
             }
         }
         if (!(pcv=searchpcv(0,popt->anttype[i],time,pcvr))) {
@@ -888,7 +1612,7 @@ static void readotl(prcopt_t *popt, const char *file, const sta_t *sta)
     }
 }
 /* write header to output file -----------------------------------------------*/
-static int outhead(const char *outfile, char **infile, int n,
+static int outhead(const char *outfile, char **infile, int n, const gtime_t *tr,
                    const prcopt_t *popt, const solopt_t *sopt)
 {
     FILE *fp=stdout;
@@ -904,7 +1628,7 @@ static int outhead(const char *outfile, char **infile, int n,
         }
     }
     /* output header */
-    outheader(fp,infile,n,popt,sopt);
+    outheader(fp,infile,n,tr,popt,sopt);
     
     if (*outfile) fclose(fp);
     
@@ -964,14 +1688,322 @@ static void freeAntennaData(antDataSet_t *antData)
         free(antData->ant_data);
 }
 
+/* create directory of output files and remove logs of previous run ---------*/
+static void clearlogs(const prcopt_t *popt)
+{
+    char path[1024];
+    
+    createdir(outputPath(popt,"solution_log.txt",path));
+    remove(path);
+    remove(outputPath(popt,"KalmanFiltering.txt",path));
+    remove(outputPath(popt,"cov_matr_single.txt",path));
+    remove(outputPath(popt,SNAP_FILE,path));
+}
+/* set directory of output files for session ---------------------------------
+* replace keywords in the directory by the session time, rover and base station
+* and resolve the relative directory by the directory of the output file. the
+* directory is created and the logs appended by a previous run are removed.
+* returns 0 if the directory is too long for the paths of the output files
+*-----------------------------------------------------------------------------*/
+static int setoutdir(prcopt_t *popt, gtime_t time, const char *outfile,
+                     const char *rov, const char *base)
+{
+    char dir[1024],path[1024];
+    const char *p;
+    size_t n=0;
+    
+    if (!*popt->outdir) return 1;
+    
+    reppath(popt->outdir,dir,time,rov,base);
+    
+    if (*dir!=FILEPATHSEP&&*dir!='/'&&!(*dir&&dir[1]==':')&&
+        ((p=strrchr(outfile,FILEPATHSEP))||(p=strrchr(outfile,'/')))) {
+        n=(size_t)(p-outfile+1);
+    }
+    if (n+strlen(dir)>=sizeof(popt->outdir)-64) {
+        trace(2,"output directory too long: %.*s%s\n",(int)n,outfile,dir);
+        showmsg("error : output directory too long");
+        return 0;
+    }
+    memcpy(path,outfile,n);
+    strcpy(path+n,dir);
+    strcpy(popt->outdir,path);
+    trace(3,"setoutdir: outdir=%s\n",popt->outdir);
+    
+    clearlogs(popt);
+    return 1;
+}
+/* initialize processing pass ------------------------------------------------*/
+static void initpass(pospass_t *pass, postses_t *ses, int revs, sol_t *sol,
+                     double *rb)
+{
+    memset(pass,0,sizeof(pospass_t));
+    pass->ses=ses;
+    pass->popt=&ses->popt;
+    pass->revs=revs;
+    pass->sol=sol;
+    pass->rb=rb;
+    pass->nsol=sol?ses->nepoch:0;
+    if (revs) {
+        pass->iepu=ses->oidx[0].n-1;
+        pass->iepr=ses->oidx[1].n-1;
+        pass->isbs=ses->prec->sbs.n-1;
+        pass->ilex=ses->prec->lex.n-1;
+    }
+}
+/* processing pass thread ----------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI passthread(void *arg)
+#else
+static void *passthread(void *arg)
+#endif
+{
+    pospass_t *pass=(pospass_t *)arg;
+    
+    procpos(pass,NULL,pass->popt,pass->ses->sopt,1);
+    return 0;
+}
+/* forward and backward passes of combined solutions ---------------------------
+* the backward pass runs concurrently with the forward pass by another thread
+* if the passes share no state: the sbas, lex and ssr corrections are carried
+* over the passes and the trace, solution status and debug logs are single
+* streams. the covariance log of the backward pass is put to a temporary file
+* and appended to the log after the forward pass.
+*-----------------------------------------------------------------------------*/
+static void combpass(postses_t *ses, pospass_t *fwd, pospass_t *bwd)
+{
+    const prcopt_t *popt=&ses->popt;
+    prcopt_t bopt;
+    dbglog_t dbg={0};
+    thread_t thread;
+    char buff[4096];
+    size_t n;
+    int conc;
+    
+    trace(3,"combpass: nepoch=%d\n",ses->nepoch);
+    
+    conc=ses->sopt->trace<=0&&ses->sopt->sstat<=0&&popt->dbglevel<=0&&
+         !popt->dbgsnap&&ses->prec->sbs.n<=0&&ses->prec->lex.n<=0&&!ses->rtcm;
+    
+    if (conc&&popt->dbglog&&popt->dbglog->fpcov&&!(dbg.fpcov=tmpfile())) {
+        conc=0;
+    }
+    if (conc) {
+        bopt=*popt;
+        bopt.dbglog=&dbg;
+        bwd->popt=&bopt;
+        fwd->conc=bwd->conc=1;
+        ses->tready=0;
+        initlock(&ses->lock);
+#ifdef WIN32
+        if (!(thread=CreateThread(NULL,0,passthread,bwd,0,NULL))) conc=0;
+#else
+        if (pthread_create(&thread,NULL,passthread,bwd)) conc=0;
+#endif
+        if (!conc) {
+            bwd->popt=popt;
+            fwd->conc=bwd->conc=0;
+        }
+    }
+    procpos(fwd,NULL,popt,ses->sopt,1); /* forward */
+    
+    if (conc) {
+#ifdef WIN32
+        WaitForSingleObject(thread,INFINITE);
+        CloseHandle(thread);
+#else
+        pthread_join(thread,NULL);
+#endif
+    }
+    else {
+        procpos(bwd,NULL,popt,ses->sopt,1); /* backward */
+    }
+    /* append covariance log of backward pass */
+    if (dbg.fpcov) {
+        rewind(dbg.fpcov);
+        while ((n=fread(buff,1,sizeof(buff),dbg.fpcov))>0) {
+            fwrite(buff,1,n,popt->dbglog->fpcov);
+        }
+        fclose(dbg.fpcov);
+    }
+}
+/* output discontinuities of solutions at seams of time slices -----------------
+* compare the last solution of a slice with the last warm-up solution of the
+* next slice at the same epoch and output the differences in e/n/u
+*-----------------------------------------------------------------------------*/
+static void outseams(const prcopt_t *popt, const pospass_t *pass, int nslice)
+{
+    FILE *fp;
+    const sol_t *sol1,*sol2;
+    double pos[3],dr[3],enu[3];
+    int i,k;
+    char path[1024],tstr[32];
+    
+    trace(3,"outseams: nslice=%d\n",nslice);
+    
+    if (!(fp=fopen(outputPath(popt,"slice_seams.txt",path),"w"))) return;
+    
+    fprintf(fp,"%% seam  epoch (GPST)                de(m)      dn(m)      du(m)  Q1  Q2\n");
+    
+    for (k=1;k<nslice;k++) {
+        if (pass[k-1].isol<=0||pass[k].solw.time.time==0) {
+            fprintf(fp,"%5d  no warm-up overlap\n",k);
+            continue;
+        }
+        sol1=pass[k-1].sol+pass[k-1].isol-1;
+        sol2=&pass[k].solw;
+        time2str(sol1->time,tstr,3);
+        if (fabs(timediff(sol1->time,sol2->time))>DTTOL) {
+            fprintf(fp,"%5d  %s  no common epoch\n",k,tstr);
+            continue;
+        }
+        ecef2pos(sol1->rr,pos);
+        for (i=0;i<3;i++) dr[i]=sol2->rr[i]-sol1->rr[i];
+        ecef2enu(pos,dr,enu);
+        fprintf(fp,"%5d  %s %10.4f %10.4f %10.4f %3d %3d\n",k,tstr,enu[0],
+                enu[1],enu[2],sol1->stat,sol2->stat);
+        trace(2,"slice seam %d: %s denu=%.4f %.4f %.4f Q=%d %d\n",k,tstr,
+              enu[0],enu[1],enu[2],sol1->stat,sol2->stat);
+    }
+    fclose(fp);
+}
+/* time-sliced forward pass ----------------------------------------------------
+* the rover epochs are split into popt->nslice slices of equal time span, which
+* are processed by the threads. a slice starts the filter popt->slicewarm (s)
+* before the slice for convergence and ambiguity fix, and the solutions of the
+* slices are output in order after the passes. the output files and logs of a
+* slice, including the warm-up, are put to slice_NN in the directory of output
+* files and the seams are reported to slice_seams.txt. the slices run only if
+* they share no state (see combpass()) and for the solutions of all epochs.
+* return : status (0:not sliced,1:sliced)
+*-----------------------------------------------------------------------------*/
+static int slicepass(postses_t *ses, FILE *fp)
+{
+    const prcopt_t *popt=&ses->popt;
+    const obsidx_t *iu=ses->oidx;
+    pospass_t *pass;
+    prcopt_t *opts;
+    thread_t thread[MAXPRCTHREAD];
+    gtime_t t0,tw;
+    double span;
+    int i,k,nslice=MIN(popt->nslice,MAXPRCTHREAD),run[MAXPRCTHREAD]={0};
+    char name[32],dir[1024];
+    
+    if (nslice<=1||ses->sopt->trace>0||ses->sopt->sstat>0||
+        ses->prec->sbs.n>0||ses->prec->lex.n>0||ses->rtcm) return 0;
+    if (ses->sopt->solstatic&&
+        (popt->mode==PMODE_STATIC||popt->mode==PMODE_PPP_STATIC)) return 0;
+    
+    if (iu->n<2) return 0;
+    t0=iu->ep[0].time;
+    if ((span=timediff(iu->ep[iu->n-1].time,t0)/nslice)<=0.0) return 0;
+    
+    trace(3,"slicepass: nslice=%d span=%.0f warm=%.0f\n",nslice,span,
+          popt->slicewarm);
+    
+    pass=(pospass_t *)calloc(nslice,sizeof(pospass_t));
+    opts=(prcopt_t *)calloc(nslice,sizeof(prcopt_t));
+    if (!pass||!opts) {
+        free(pass); free(opts);
+        return 0;
+    }
+    for (k=0;k<nslice;k++) {
+        initpass(pass+k,ses,0,NULL,NULL);
+        pass[k].slice=k+1;
+        if (k>0) pass[k].ts=timeadd(t0,span*k);
+        if (k<nslice-1) pass[k].te=timeadd(t0,span*(k+1));
+    }
+    /* number of rover epochs of slices */
+    for (i=0;i<iu->n;i++) {
+        for (k=nslice-1;k>0;k--) {
+            if (timediff(iu->ep[i].time,pass[k].ts)>-DTTOL) break;
+        }
+        pass[k].nsol++;
+    }
+    for (k=0;k<nslice;k++) {
+    
+        /* start of slice with warm-up */
+        if (k>0) {
+            tw=timeadd(pass[k].ts,-popt->slicewarm);
+            for (i=0;i<iu->n;i++) {
+                if (timediff(iu->ep[i].time,tw)>-DTTOL) break;
+            }
+            pass[k].iepu=i;
+        }
+        pass[k].sol=(sol_t *)malloc(sizeof(sol_t)*(pass[k].nsol+1));
+        pass[k].rb=(double *)malloc(sizeof(double)*(pass[k].nsol+1)*3);
+    
+        /* directory of output files and logs of slice */
+        opts[k]=*popt;
+        sprintf(name,"slice_%02d%c",k+1,FILEPATHSEP);
+        outputPath(popt,name,dir);
+        if (strlen(dir)<sizeof(opts[k].outdir)-64) strcpy(opts[k].outdir,dir);
+        clearlogs(opts+k);
+        opts[k].dbglog=openDebugLog(opts+k);
+        pass[k].popt=opts+k;
+    }
+    for (k=0;k<nslice;k++) {
+        if (!pass[k].sol||!pass[k].rb) break;
+    }
+    if (k<nslice) {
+        showmsg("error : memory allocation");
+        ses->aborts=1;
+    }
+    else {
+        for (k=1;k<nslice;k++) {
+#ifdef WIN32
+            run[k]=(thread[k]=CreateThread(NULL,0,passthread,pass+k,0,NULL))!=NULL;
+#else
+            run[k]=!pthread_create(thread+k,NULL,passthread,pass+k);
+#endif
+        }
+        passthread(pass);
+    
+        for (k=1;k<nslice;k++) {
+            if (!run[k]) {
+                passthread(pass+k);
+                continue;
+            }
+#ifdef WIN32
+            WaitForSingleObject(thread[k],INFINITE);
+            CloseHandle(thread[k]);
+#else
+            pthread_join(thread[k],NULL);
+#endif
+        }
+        /* stitch solutions of slices */
+        for (k=0;k<nslice;k++) {
+            if (pass[k].aborts) ses->aborts=1;
+        }
+        for (k=0;k<nslice&&!ses->aborts;k++) {
+            for (i=0;i<pass[k].isol;i++) {
+                outsol(fp,pass[k].sol+i,pass[k].rb+i*3,ses->sopt);
+            }
+        }
+        if (!ses->aborts) outseams(popt,pass,nslice);
+    }
+    for (k=0;k<nslice;k++) {
+        closeDebugLog(opts[k].dbglog);
+        free(pass[k].sol);
+        free(pass[k].rb);
+    }
+    free(pass);
+    free(opts);
+    return 1;
+}
 /* execute processing session ------------------------------------------------*/
-static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                   const solopt_t *sopt, const filopt_t *fopt, int flag,
-                   char **infile, const int *index, int n, char *outfile)
+static int execses(postses_t *ses)
 {
     FILE *fp;
-    prcopt_t popt_=*popt;
-    char tracefile[1024],statfile[1024];
+    pospass_t fwd,bwd;
+    prcopt_t *popt_=&ses->popt;
+    const solopt_t *sopt=ses->sopt;
+    const filopt_t *fopt=ses->fopt;
+    obs_t *obss=&ses->obss,obse={0};
+    obsd_t data[MAXOBS];
+    nav_t *navs=&ses->navs;
+    char tracefile[1024],statfile[1024],*outfile=ses->outfile,**infile=ses->infile;
+    int k=0,m,n=ses->n,flag=ses->flag,stat;
     
     trace(3,"execses : n=%d outfile=%s\n",n,outfile);
     
@@ -988,35 +2020,61 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         traceopen(tracefile);
         tracelevel(sopt->trace);
     }
-    /* read obs and nav data */
-    if (!readobsnav(ts,te,ti,infile,index,n,&popt_,&obss,&navs,stas)) return 0;
+    /* navigation data with precise ephemeris and corrections of time unit */
+    *navs=ses->prec->nav;
+    
+    /* read obs and nav data or open obs streams for forward solutions */
+    if (popt_->streamobs&&popt_->nslice<=1&&
+        (popt_->mode==PMODE_SINGLE||popt_->soltype==0)) {
+        stat=readobsstrm(ses,ses->ts,ses->te,ses->ti,infile,ses->index,n,popt_,
+                         navs,ses->stas);
+    }
+    else {
+        stat=readobsnav(ses,ses->ts,ses->te,ses->ti,infile,ses->index,n,popt_,
+                        obss,navs,ses->stas);
+    }
+    if (!stat) {
+        freeobsnav(ses);
+        return 0;
+    }
+    /* set directory of output files */
+    if (!setoutdir(popt_,ses->ts.time?ses->ts:ses->t0,outfile,ses->proc_rov,
+                   ses->proc_base)) {
+        freeobsnav(ses);
+        return 0;
+    }
+    
+    /* open debug log */
+    popt_->dbglog=openDebugLog(popt_);
     
     /* set antenna paramters */
-    if (popt_.mode!=PMODE_SINGLE) {
-        setpcv(obss.n>0?obss.data[0].time:timeget(),&popt_,&navs,&pcvss,&pcvsr,
-               stas);
+    if (popt_->mode!=PMODE_SINGLE) {
+        setpcv(ses->t0.time?ses->t0:timeget(),popt_,navs,&pcvss,&pcvsr,
+               ses->stas);
     }
     /* read antenna parameters */
     if(fopt->rcvantp[0])
-        readAntennaData(fopt->rcvantp, &antData);
+        readAntennaData((char *)fopt->rcvantp, &ses->antData);
     /* read antenna angles */
     if(fopt->tmiangles[0])
-        readAntennaAngles(fopt->tmiangles, &antData);
+        readAntennaAngles((char *)fopt->tmiangles, &ses->antData);
 
     /* read ocean tide loading parameters */
-    if (popt_.mode>PMODE_SINGLE&&fopt->blq) {
-        readotl(&popt_,fopt->blq,stas);
+    if (popt_->mode>PMODE_SINGLE&&fopt->blq) {
+        readotl(popt_,fopt->blq,ses->stas);
     }
     /* rover/reference fixed position */
-    if (popt_.mode==PMODE_FIXED) {
-        if (!antpos(&popt_,1,&obss,&navs,stas,fopt->stapos)) {
-            freeobsnav(&obss,&navs);
+    if (popt_->mode==PMODE_FIXED) {
+        if (!antpos(popt_,1,ses,navs,ses->stas,fopt->stapos)) {
+            freeobsnav(ses);
+            closeDebugLog(popt_->dbglog);
             return 0;
         }
     }
-    else if (PMODE_DGPS<=popt_.mode&&popt_.mode<=PMODE_STATIC) {
-        if (!antpos(&popt_,2,&obss,&navs,stas,fopt->stapos)) {
-            freeobsnav(&obss,&navs);
+    else if (PMODE_DGPS<=popt_->mode&&popt_->mode<=PMODE_STATIC) {
+        if (!antpos(popt_,2,ses,navs,ses->stas,fopt->stapos)) {
+            freeobsnav(ses);
+            closeDebugLog(popt_->dbglog);
             return 0;
         }
     }
@@ -1028,61 +2086,294 @@ static int execses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         rtkopenstat(statfile,sopt->sstat);
     }
     /* write header to output file */
-    if (flag&&!outhead(outfile,infile,n,&popt_,sopt)) {
-        freeobsnav(&obss,&navs);
+    if (flag&&!outhead(outfile,infile,n,ses->tr,popt_,sopt)) {
+        freeobsnav(ses);
+        closeDebugLog(popt_->dbglog);
         return 0;
     }
-    iobsu=iobsr=isbs=ilex=revs=aborts=0;
+    /* initialize rtcm struct */
+    if (*ses->prec->rtcm_file&&(ses->rtcm=(rtcm_t *)malloc(sizeof(rtcm_t)))) {
+        init_rtcm(ses->rtcm);
+    }
+    /* ambiguity arcs of rover shared by the passes */
+    if (popt_->mode>=PMODE_PPP_KINEMA&&popt_->ambarc&&
+        (ses->ambinfo=(ambinfo_t *)calloc(MAXSAT,sizeof(ambinfo_t)))) {
+        for (obse.data=data;(m=nextepoch(ses,1,&k,data))>=0;) {
+            obse.n=obse.nmax=m;
+            getambinfo(popt_,&obse,navs,ses->stas[0].pos,ses->ambinfo);
+        }
+    }
+    ses->aborts=0;
     
-    if (popt_.mode==PMODE_SINGLE||popt_.soltype==0) {
+    if (popt_->mode==PMODE_SINGLE||popt_->soltype==0) {
         if ((fp=openfile(outfile))) {
-            procpos(fp,&popt_,sopt,0,infile,n); /* forward */
+            if (!slicepass(ses,fp)) { /* time-sliced forward */
+                initpass(&fwd,ses,0,NULL,NULL);
+                procpos(&fwd,fp,popt_,sopt,0); /* forward */
+                ses->aborts=fwd.aborts;
+            }
             fclose(fp);
         }
     }
-    else if (popt_.soltype==1) {
+    else if (popt_->soltype==1) {
         if ((fp=openfile(outfile))) {
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
-            procpos(fp,&popt_,sopt,0,infile,n); /* backward */
+            initpass(&bwd,ses,1,NULL,NULL);
+            procpos(&bwd,fp,popt_,sopt,0); /* backward */
+            ses->aborts=bwd.aborts;
             fclose(fp);
         }
     }
     else { /* combined */
-        solf=(sol_t *)malloc(sizeof(sol_t)*nepoch);
-        solb=(sol_t *)malloc(sizeof(sol_t)*nepoch);
-        rbf=(double *)malloc(sizeof(double)*nepoch*3);
-        rbb=(double *)malloc(sizeof(double)*nepoch*3);
+        ses->solf=(sol_t *)malloc(sizeof(sol_t)*ses->nepoch);
+        ses->solb=(sol_t *)malloc(sizeof(sol_t)*ses->nepoch);
+        ses->rbf=(double *)malloc(sizeof(double)*ses->nepoch*3);
+        ses->rbb=(double *)malloc(sizeof(double)*ses->nepoch*3);
         
-        if (solf&&solb) {
-            isolf=isolb=0;
-            procpos(NULL,&popt_,sopt,1,infile,n); /* forward */
-            revs=1; iobsu=iobsr=obss.n-1; isbs=sbss.n-1; ilex=lexs.n-1;
-            procpos(NULL,&popt_,sopt,1,infile,n); /* backward */
+        if (ses->solf&&ses->solb&&ses->rbf&&ses->rbb) {
+            initpass(&fwd,ses,0,ses->solf,ses->rbf);
+            initpass(&bwd,ses,1,ses->solb,ses->rbb);
+            combpass(ses,&fwd,&bwd); /* forward and backward */
+            ses->isolf=fwd.isol;
+            ses->isolb=bwd.isol;
+            ses->aborts=fwd.aborts||bwd.aborts;
             
             /* combine forward/backward solutions */
-            if (!aborts&&(fp=openfile(outfile))) {
-                combres(fp,&popt_,sopt);
+            if (!ses->aborts&&(fp=openfile(outfile))) {
+                combres(ses,fp,popt_,sopt);
                 fclose(fp);
             }
         }
         else showmsg("error : memory allocation");
-        free(solf);
-        free(solb);
-        free(rbf);
-        free(rbb);
+        free(ses->solf); ses->solf=NULL;
+        free(ses->solb); ses->solb=NULL;
+        free(ses->rbf); ses->rbf=NULL;
+        free(ses->rbb); ses->rbb=NULL;
+    }
+    /* free rtcm struct */
+    if (ses->fp_rtcm) fclose(ses->fp_rtcm);
+    if (ses->rtcm) {
+        free_rtcm(ses->rtcm);
+        free(ses->rtcm);
     }
+    ses->fp_rtcm=NULL; ses->rtcm=NULL;
+    
+    /* free ambiguity arcs */
+    free(ses->ambinfo); ses->ambinfo=NULL;
+    
+    /* close debug log */
+    closeDebugLog(popt_->dbglog);
+    
     /* free obs and nav data */
-    freeobsnav(&obss,&navs);
-    freeAntennaData(&antData);
+    freeobsnav(ses);
+    freeAntennaData(&ses->antData);
+    
+    return ses->aborts?1:0;
+}
+/* new processing session ----------------------------------------------------*/
+static postses_t *newses(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
+                         const solopt_t *sopt, const filopt_t *fopt, int flag,
+                         char **infile, const int *index, int n,
+                         const char *outfile, const char *rov, const char *base,
+                         precdata_t *prec)
+{
+    postses_t *ses;
+    int i;
+    
+    trace(3,"newses  : n=%d outfile=%s\n",n,outfile);
+    
+    if (!(ses=(postses_t *)calloc(1,sizeof(postses_t)))) return NULL;
+    
+    for (i=0;i<n;i++) {
+        if (!(ses->infile[i]=(char *)malloc(strlen(infile[i])+1))) {
+            for (;i>=0;i--) free(ses->infile[i]);
+            free(ses);
+            return NULL;
+        }
+        strcpy(ses->infile[i],infile[i]);
+        ses->index[i]=index[i];
+    }
+    ses->ts=ts; ses->te=te; ses->ti=ti;
+    ses->popt=*popt; ses->sopt=sopt; ses->fopt=fopt;
+    ses->flag=flag; ses->n=n;
+    strcpy(ses->outfile,outfile);
+    if (*popt->outdir) reppath(popt->outdir,ses->outdir,ts,rov,base);
+    strcpy(ses->proc_rov,rov);
+    strcpy(ses->proc_base,base);
+    ses->prec=prec;
+    prec->nref++;
+    return ses;
+}
+/* release precise ephemeris and corrections ---------------------------------*/
+static void releaseprec(sespool_t *pool, precdata_t *prec)
+{
+    int nref;
+    
+    if (pool) lock(&pool->lock);
+    nref=--prec->nref;
+    if (pool) unlock(&pool->lock);
+    if (nref>0) return;
+    freepreceph(prec);
+    free(prec);
+}
+/* free processing session ---------------------------------------------------*/
+static void freeses(postses_t *ses)
+{
+    int i;
+    
+    for (i=0;i<ses->n;i++) free(ses->infile[i]);
+    free(ses);
+}
+/* next session to run in worker pool ------------------------------------------
+* the first waiting session in order of submission which does not share the
+* output file or the directory of output files with an earlier pending session
+*-----------------------------------------------------------------------------*/
+static postses_t *nextses(sespool_t *pool)
+{
+    postses_t *ses,*p;
+    
+    for (ses=pool->head;ses;ses=ses->next) {
+        if (ses->state) continue;
+        for (p=pool->head;p!=ses;p=p->next) {
+            if (!strcmp(p->outfile,ses->outfile)||
+                !strcmp(p->outdir,ses->outdir)) break;
+        }
+        if (p==ses) {
+            ses->state=1;
+            return ses;
+        }
+    }
+    return NULL;
+}
+/* session worker thread -----------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI sesthread(void *arg)
+#else
+static void *sesthread(void *arg)
+#endif
+{
+    sespool_t *pool=(sespool_t *)arg;
+    postses_t *ses,**p;
+    int stat;
+    
+    for (;;) {
+        lock(&pool->lock);
+        if (!(ses=nextses(pool))&&!pool->state&&!pool->head) {
+            unlock(&pool->lock);
+            break;
+        }
+        stat=pool->aborts;
+        unlock(&pool->lock);
+        
+        if (!ses) {
+            sleepms(1);
+            continue;
+        }
+        if (!stat) stat=execses(ses);
+        
+        lock(&pool->lock);
+        for (p=&pool->head;*p!=ses;p=&(*p)->next) ;
+        *p=ses->next;
+        pool->npend--;
+        if (stat==1) pool->aborts=1;
+        unlock(&pool->lock);
+        
+        releaseprec(pool,ses->prec);
+        freeses(ses);
+    }
+    return 0;
+}
+/* start session worker pool -------------------------------------------------*/
+static int startpool(sespool_t *pool, int nthread)
+{
+    int i;
+    
+    trace(3,"startpool: nthread=%d\n",nthread);
+    
+    memset(pool,0,sizeof(sespool_t));
+    initlock(&pool->lock);
+    pool->state=1;
+    
+    for (i=0;i<nthread&&i<MAXPRCTHREAD;i++) {
+#ifdef WIN32
+        if (!(pool->thread[i]=CreateThread(NULL,0,sesthread,pool,0,NULL))) break;
+#else
+        if (pthread_create(pool->thread+i,NULL,sesthread,pool)) break;
+#endif
+    }
+    pool->nthread=i;
+    return i>0;
+}
+/* stop session worker pool after the pending sessions -----------------------*/
+static int stoppool(sespool_t *pool)
+{
+    int i;
+    
+    trace(3,"stoppool: npend=%d\n",pool->npend);
     
-    return aborts?1:0;
+    lock(&pool->lock);
+    pool->state=0;
+    unlock(&pool->lock);
+    
+    for (i=0;i<pool->nthread;i++) {
+#ifdef WIN32
+        WaitForSingleObject(pool->thread[i],INFINITE);
+        CloseHandle(pool->thread[i]);
+#else
+        pthread_join(pool->thread[i],NULL);
+#endif
+    }
+    return pool->aborts;
+}
+/* wait for pending sessions of worker pool ----------------------------------*/
+static int waitpool(sespool_t *pool)
+{
+    int npend=1;
+    
+    while (npend>0) {
+        lock(&pool->lock);
+        npend=pool->npend;
+        unlock(&pool->lock);
+        if (npend>0) sleepms(1);
+    }
+    return pool->aborts;
+}
+/* run processing session ------------------------------------------------------
+* run the session in the worker pool or in place if pool is NULL. the session is
+* submitted after the number of pending sessions is less than twice the number
+* of threads. return : status (0:ok,1:aborted)
+*-----------------------------------------------------------------------------*/
+static int runses(sespool_t *pool, postses_t *ses)
+{
+    postses_t **p;
+    int stat;
+    
+    if (!pool) {
+        stat=execses(ses);
+        releaseprec(NULL,ses->prec);
+        freeses(ses);
+        return stat;
+    }
+    lock(&pool->lock);
+    while (pool->npend>=pool->nthread*2&&!pool->aborts) {
+        unlock(&pool->lock);
+        sleepms(1);
+        lock(&pool->lock);
+    }
+    for (p=&pool->head;*p;p=&(*p)->next) ;
+    *p=ses;
+    pool->npend++;
+    stat=pool->aborts;
+    unlock(&pool->lock);
+    return stat;
 }
 /* execute processing session for each rover ---------------------------------*/
-static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                     const solopt_t *sopt, const filopt_t *fopt, int flag,
-                     char **infile, const int *index, int n, char *outfile,
-                     const char *rov)
+static int execses_r(sespool_t *pool, gtime_t ts, gtime_t te, double ti,
+                     const prcopt_t *popt, const solopt_t *sopt,
+                     const filopt_t *fopt, int flag, char **infile,
+                     const int *index, int n, char *outfile, const char *rov,
+                     const char *base, precdata_t *prec)
 {
+    postses_t *ses;
     gtime_t t0={0};
     int i,stat=0;
     char *ifile[MAXINFILE],ofile[1024],*rov_,*p,*q,s[64]="";
@@ -1105,9 +2396,8 @@ static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
             if ((q=strchr(p,' '))) *q='\0';
             
             if (*p) {
-                strcpy(proc_rov,p);
                 if (ts.time) time2str(ts,s,0); else *s='\0';
-                if (checkbrk("reading    : %s",s)) {
+                if (checkbrk(p,base,"reading    : %s",s)) {
                     stat=1;
                     break;
                 }
@@ -1115,7 +2405,10 @@ static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
                 reppath(outfile,ofile,t0,p,"");
                 
                 /* execute processing session */
-                stat=execses(ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile);
+                if ((ses=newses(ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile,
+                                p,base,prec))) {
+                    stat=runses(pool,ses);
+                }
             }
             if (stat==1||!q) break;
         }
@@ -1123,30 +2416,46 @@ static int execses_r(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
     }
     else {
         /* execute processing session */
-        stat=execses(ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile);
+        if ((ses=newses(ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile,
+                        "",base,prec))) {
+            stat=runses(pool,ses);
+        }
     }
     return stat;
 }
 /* execute processing session for each base station --------------------------*/
-static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
-                     const solopt_t *sopt, const filopt_t *fopt, int flag,
-                     char **infile, const int *index, int n, char *outfile,
-                     const char *rov, const char *base)
+static int execses_b(sespool_t *pool, gtime_t ts, gtime_t te, double ti,
+                     const prcopt_t *popt, const solopt_t *sopt,
+                     const filopt_t *fopt, int flag, char **infile,
+                     const int *index, int n, char *outfile, const char *rov,
+                     const char *base)
 {
+    precdata_t *prec;
     gtime_t t0={0};
     int i,stat=0;
     char *ifile[MAXINFILE],ofile[1024],*base_,*p,*q,s[64];
     
     trace(3,"execses_b: n=%d outfile=%s\n",n,outfile);
     
-    /* read prec ephemeris and sbas data */
-    readpreceph(infile,n,popt,&navs,&sbss,&lexs);
+    /* read prec ephemeris and sbas data shared by the sessions */
+    if (!(prec=(precdata_t *)calloc(1,sizeof(precdata_t)))) return 0;
+    prec->nav=navs;
+    prec->nref=1;
+    readpreceph(infile,n,popt,prec);
     
+    /* lex corrections are processed in place */
+    if (pool&&prec->lex.n>0) {
+        if (waitpool(pool)) {
+            releaseprec(NULL,prec);
+            return 1;
+        }
+        pool=NULL;
+    }
     for (i=0;i<n;i++) if (strstr(infile[i],"%b")) break;
     
     if (i<n) { /* include base station keywords */
         if (!(base_=(char *)malloc(strlen(base)+1))) {
-            freepreceph(&navs,&sbss,&lexs);
+            releaseprec(pool,prec);
             return 0;
         }
         strcpy(base_,base);
@@ -1154,7 +2463,7 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
         for (i=0;i<n;i++) {
             if (!(ifile[i]=(char *)malloc(1024))) {
                 free(base_); for (;i>=0;i--) free(ifile[i]);
-                freepreceph(&navs,&sbss,&lexs);
+                releaseprec(pool,prec);
                 return 0;
             }
         }
@@ -1162,26 +2471,27 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
             if ((q=strchr(p,' '))) *q='\0';
             
             if (*p) {
-                strcpy(proc_base,p);
                 if (ts.time) time2str(ts,s,0); else *s='\0';
-                if (checkbrk("reading    : %s",s)) {
+                if (checkbrk("",p,"reading    : %s",s)) {
                     stat=1;
                     break;
                 }
                 for (i=0;i<n;i++) reppath(infile[i],ifile[i],t0,"",p);
                 reppath(outfile,ofile,t0,"",p);
                 
-                stat=execses_r(ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,ofile,rov);
+                stat=execses_r(pool,ts,te,ti,popt,sopt,fopt,flag,ifile,index,n,
+                               ofile,rov,p,prec);
             }
             if (stat==1||!q) break;
         }
         free(base_); for (i=0;i<n;i++) free(ifile[i]);
     }
     else {
-        stat=execses_r(ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile,rov);
+        stat=execses_r(pool,ts,te,ti,popt,sopt,fopt,flag,infile,index,n,outfile,
+                       rov,"",prec);
     }
-    /* free prec ephemeris and sbas data */
-    freepreceph(&navs,&sbss,&lexs);
+    /* release prec ephemeris and sbas data */
+    releaseprec(pool,prec);
     
     return stat;
 }
@@ -1228,31 +2538,47 @@ static int execses_b(gtime_t ts, gtime_t te, double ti, const prcopt_t *popt,
 *          are output to a single output file.
 *
 *          ssr corrections are valid only for forward estimation.
+*
+*          with popt->nthread>1, the sessions run in parallel by the worker
+*          threads. sessions with the same output file or the same directory
+*          of output files (popt->outdir) run in order of submission. debug
+*          trace, solution status and lex corrections disable the parallel
+*          processing.
 *-----------------------------------------------------------------------------*/
 extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
                    const prcopt_t *popt, const solopt_t *sopt,
                    const filopt_t *fopt, char **infile, int n, char *outfile,
                    const char *rov, const char *base)
 {
+    sespool_t *pool=NULL;
     gtime_t tts,tte,ttte;
     double tunit,tss;
-    int i,j,k,nf,stat=0,week,flag=1,index[MAXINFILE]={0};
-    char *ifile[MAXINFILE],ofile[1024],*ext;
+    int i,j,k,nf,stat=0,week,flag=1,nthread,index[MAXINFILE]={0};
+    char *ifile[MAXINFILE],ofile[1024],*ext,s[64];
     
     trace(3,"postpos : ti=%.0f tu=%.0f n=%d outfile=%s\n",ti,tu,n,outfile);
     
     /* open processing session */
     if (!openses(popt,sopt,fopt,&navs,&pcvss,&pcvsr)) return -1;
     
+    /* start worker pool (trace and solution status are single streams) */
+    nthread=sopt->trace>0||sopt->sstat>0?1:popt->nthread;
+    if (nthread>1&&(pool=(sespool_t *)malloc(sizeof(sespool_t)))&&
+        !startpool(pool,nthread)) {
+        free(pool); pool=NULL;
+    }
+
     if (ts.time!=0&&te.time!=0&&tu>=0.0) {
         if (timediff(te,ts)<0.0) {
             showmsg("error : no period");
+            if (pool) {stoppool(pool); free(pool);}
             closeses(&navs,&pcvss,&pcvsr);
             return 0;
         }
         for (i=0;i<MAXINFILE;i++) {
             if (!(ifile[i]=(char *)malloc(1024))) {
                 for (;i>=0;i--) free(ifile[i]);
+                if (pool) {stoppool(pool); free(pool);}
                 closeses(&navs,&pcvss,&pcvsr);
                 return -1;
             }
@@ -1269,9 +2595,7 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
             if (timediff(tts,ts)<0.0) tts=ts;
             if (timediff(tte,te)>0.0) tte=te;
             
-            strcpy(proc_rov ,"");
-            strcpy(proc_base,"");
-            if (checkbrk("reading    : %s",time_str(tts,0))) {
+            if (checkbrk("","","reading    : %s",time_str_r(tts,0,s))) {
                 stat=1;
                 break;
             }
@@ -1304,8 +2628,8 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
             if (!reppath(outfile,ofile,tts,"","")&&i>0) flag=0;
             
             /* execute processing session */
-            stat=execses_b(tts,tte,ti,popt,sopt,fopt,flag,ifile,index,nf,ofile,
-                           rov,base);
+            stat=execses_b(pool,tts,tte,ti,popt,sopt,fopt,flag,ifile,index,nf,
+                           ofile,rov,base);
             
             if (stat==1) break;
         }
@@ -1314,7 +2638,10 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
     else if (ts.time!=0) {
         for (i=0;i<n&&i<MAXINFILE;i++) {
             if (!(ifile[i]=(char *)malloc(1024))) {
-                for (;i>=0;i--) free(ifile[i]); return -1;
+                for (;i>=0;i--) free(ifile[i]);
+                if (pool) {stoppool(pool); free(pool);}
+                closeses(&navs,&pcvss,&pcvsr);
+                return -1;
             }
             reppath(infile[i],ifile[i],ts,"","");
             index[i]=i;
@@ -1322,7 +2649,7 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
         reppath(outfile,ofile,ts,"","");
         
         /* execute processing session */
-        stat=execses_b(ts,te,ti,popt,sopt,fopt,1,ifile,index,n,ofile,rov,
+        stat=execses_b(pool,ts,te,ti,popt,sopt,fopt,1,ifile,index,n,ofile,rov,
                        base);
         
         for (i=0;i<n&&i<MAXINFILE;i++) free(ifile[i]);
@@ -1331,8 +2658,13 @@ extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
         for (i=0;i<n;i++) index[i]=i;
         
         /* execute processing session */
-        stat=execses_b(ts,te,ti,popt,sopt,fopt,1,infile,index,n,outfile,rov,
-                       base);
+        stat=execses_b(pool,ts,te,ti,popt,sopt,fopt,1,infile,index,n,outfile,
+                       rov,base);
+    }
+    /* wait for sessions and stop worker pool */
+    if (pool) {
+        if (stoppool(pool)) stat=1;
+        free(pool);
     }
     /* close processing session */
     closeses(&navs,&pcvss,&pcvsr);
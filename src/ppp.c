@@ -69,8 +69,7 @@ static const char rcsid[]="$Id:$";
 #define IT(opt)     (IC(0,opt)+NSYS)   /* state index of tropos */
 #define NR(opt)     (IT(opt)+((opt)->tropopt<TROPOPT_EST?0:((opt)->tropopt==TROPOPT_EST?1:3)))
                                        /* number of solutions */
-#define IB(s,opt)   (NR(opt)+(s)-1)    /* state index of phase bias */
-#define NX(opt)     (IB(MAXSAT,opt)+1) /* number of estimated states */
+#define IB(s,rtk)   ((rtk)->ib[(s)-1][0]) /* state index of phase bias (0:none) */
 
 /* function prototypes -------------------------------------------------------*/
 #ifdef IERS_MODEL
@@ -79,7 +78,6 @@ extern int dehanttideinel_(double *xsta, int *year, int *mon, int *day,
                            double *dxtide);
 #endif
 
-FILE* output;
 
 /* output solution status for PPP --------------------------------------------*/
 extern void pppoutsolstat(rtk_t *rtk, int level, FILE *fp)
@@ -475,6 +473,7 @@ static int ifmeas(const obsd_t *obs, const nav_t *nav, const double *azel,
     const double *lam=nav->lam[obs->sat-1];
     double c1,c2,L1,L2,P1,P2,P1_C1,P2_C2,gamma;
     int i=0,j=1,k;
+    FILE *fp=DBGLOG(opt,2);
     
     trace(4,"ifmeas  :\n");
     
@@ -523,8 +522,8 @@ static int ifmeas(const obsd_t *obs, const nav_t *nav, const double *azel,
         if (dants) meas[k]-=c1*dants[i]+c2*dants[j];
         if (dantr) meas[k]-=c1*dantr[i]+c2*dantr[j];
     }
-    fprintf(output, "        Phase and code pseudoranges are iono-free\n");
-    fprintf(output, "        phase pseudorange = %f, code pseudorange = %f\n", meas[0], meas[1]);
+    if (fp) fprintf(fp, "        Phase and code pseudoranges are iono-free\n");
+    if (fp) fprintf(fp, "        phase pseudorange = %f, code pseudorange = %f\n", meas[0], meas[1]);
 
     return 1;
 }
@@ -580,9 +579,7 @@ static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
     const double *lam=nav->lam[obs->sat-1];
     double ion=0.0,L1,P1,PC,P1_P2,P1_C1,vari,gamma;
     int i;
-    
-    static int timeStatus = 0;
-    static gtime_t firstTime = {0};
+    FILE *fp=DBGLOG(opt,2);
 
     trace(4,"corrmeas:\n");
     
@@ -617,14 +614,14 @@ static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
         return 0;
     }
 
-    if(files && files->ionosphere && !timeStatus)
+    if(files && !files->time.tset[OUTT_ION])
     {
-      timeStatus = 1;
-      firstTime = obs->time;
-      writeTimeToFile(files->ionosphere, firstTime);
+      files->time.tset[OUTT_ION] = 1;
+      files->time.t0[OUTT_ION] = obs->time;
+      writeOutputTime(files, OUTF_IONOSPHERE, obs->time);
     }
     if(files && files->ionosphere)
-      writeIonosphere(files->ionosphere, timediff(obs[i].time, firstTime), obs->sat, azel[0], azel[1], pos[0], pos[1], pos[2], ion, 0.0);
+      writeIonosphere(files, timediff(obs->time, files->time.t0[OUTT_ION]), obs->sat, azel[0], azel[1], pos[0], pos[1], pos[2], ion, 0.0);
 
     /* ionosphere and windup corrected phase and code */
     meas[0]=L1+ion-lam[0]*phw;
@@ -638,8 +635,8 @@ static int corrmeas(const obsd_t *obs, const nav_t *nav, const double *pos,
         if (dants) meas[i]-=dants[0];
         if (dantr) meas[i]-=dantr[0];
     }
-    fprintf(output, "        Phase and code pseudoranges are NOT iono-free\n");
-    fprintf(output, "        phase pseudorange = %f, code pseudorange = %f, ionospheric corr = %f\n", meas[0], meas[1], ion);
+    if (fp) fprintf(fp, "        Phase and code pseudoranges are NOT iono-free\n");
+    if (fp) fprintf(fp, "        phase pseudorange = %f, code pseudorange = %f, ionospheric corr = %f\n", meas[0], meas[1], ion);
 
     return 1;
 }
@@ -784,14 +781,14 @@ static void udbias_ppp(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     /* reset phase-bias if expire obs outage counter */
     for (i=0;i<MAXSAT;i++) {
         if (++rtk->ssat[i].outc[0]>(unsigned int)rtk->opt.maxout) {
-            initx(rtk,0.0,0.0,IB(i+1,&rtk->opt));
+            releasebias(rtk,i+1,0);
         }
     }
     ecef2pos(rtk->sol.rr,pos);
     
     for (i=k=0;i<n&&i<MAXOBS;i++) {
         sat=obs[i].sat;
-        j=IB(sat,&rtk->opt);
+        j=IB(sat,rtk);
         if (!corrmeas(obs+i,nav,pos,rtk->ssat[sat-1].azel,&rtk->opt,NULL,NULL,
                       0.0,meas,var,&brk,NULL)) continue;
         
@@ -800,7 +797,7 @@ static void udbias_ppp(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
             trace(2,"%s: sat=%2d correction break\n",time_str(obs[i].time,0),sat);
         }
         bias[i]=meas[0]-meas[1];
-        if (rtk->x[j]==0.0||
+        if (!j||rtk->x[j]==0.0||
             rtk->ssat[sat-1].slip[0]||rtk->ssat[sat-1].slip[1]) continue;
         offset+=bias[i]-rtk->x[j];
         k++;
@@ -808,28 +805,30 @@ static void udbias_ppp(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
     /* correct phase-code jump to enssure phase-code coherency */
     if (k>=2&&fabs(offset/k)>0.0005*CLIGHT) {
         for (i=0;i<MAXSAT;i++) {
-            j=IB(i+1,&rtk->opt);
-            if (rtk->x[j]!=0.0) rtk->x[j]+=offset/k;
+            j=IB(i+1,rtk);
+            if (j&&rtk->x[j]!=0.0) rtk->x[j]+=offset/k;
         }
         trace(2,"phase-code jump corrected: %s n=%2d dt=%12.9fs\n",
               time_str(rtk->sol.time,0),k,offset/k/CLIGHT);
     }
     for (i=0;i<n&&i<MAXOBS;i++) {
         sat=obs[i].sat;
-        j=IB(sat,&rtk->opt);
+        j=IB(sat,rtk);
         
-        rtk->P[j+j*rtk->nx]+=SQR(rtk->opt.prn[0])*fabs(rtk->tt);
+        if (j) rtk->P[j+j*rtk->nx]+=SQR(rtk->opt.prn[0])*fabs(rtk->tt);
         
-        if (rtk->x[j]!=0.0&&
+        if (j&&rtk->x[j]!=0.0&&
             !rtk->ssat[sat-1].slip[0]&&!rtk->ssat[sat-1].slip[1]) continue;
         
         if (bias[i]==0.0) continue;
         
         /* reinitialize phase-bias if detecting cycle slip */
-        initx(rtk,bias[i],VAR_BIAS,IB(sat,&rtk->opt));
+        initx(rtk,bias[i],VAR_BIAS,assignbias(rtk,sat,0));
         
         trace(5,"udbias_ppp: sat=%2d bias=%.3f\n",sat,meas[0]-meas[1]);
     }
+    /* drop released states of phase-bias */
+    packbias(rtk);
 }
 /* temporal update of states --------------------------------------------------*/
 static void udstate_ppp(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav)
@@ -981,9 +980,8 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
     double r,rr[3],disp[3],pos[3],e[3],meas[2],dtdx[3],dantr[NFREQ]={0};
     double dants[NFREQ]={0},var[MAXOBS*2],dtrp=0.0,vart=0.0,varm[2]={0};
     int i,j,k,sat,sys,nv=0,nx=rtk->nx,brk,tideopt;
+    FILE *fp=DBGLOG(opt,2);
 
-    static int timeStatus = 0;
-    static gtime_t firstTime = {0};
     int includedSats[MAXSAT], excludedSats[MAXSAT], excludeReasons[MAXSAT];
     int includedSatsCount = 0, excludedSatsCount = 0;
     double* startPosition, *angles, *antCoords, tOtp;
@@ -1005,36 +1003,36 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
     }
     ecef2pos(rr,pos);
     
-    fprintf(output, "    Begin residuals calculation\n");
+    if (fp) fprintf(fp, "    Begin residuals calculation\n");
 
     for (i=0;i<n&&i<MAXOBS;i++) {
 
-        fprintf(output, "      Satellite %i:\n", obs[i].sat);
+        if (fp) fprintf(fp, "      Satellite %i:\n", obs[i].sat);
 
         sat=obs[i].sat;
         if (!(sys=satsys(sat,NULL))||!rtk->ssat[sat-1].vs) continue;
 
-        if(files && !timeStatus)
+        if(files && !files->time.tset[OUTT_RES])
         {
-          timeStatus = 1;
-          firstTime = obs[i].time;
+          files->time.tset[OUTT_RES] = 1;
+          files->time.t0[OUTT_RES] = obs[i].time;
           if(files->residuals)
-            writeTimeToFile(files->residuals, firstTime);
+            writeOutputTime(files, OUTF_RESIDUALS, obs[i].time);
           if(files->measures)
-            writeTimeToFile(files->measures, firstTime);
+            writeOutputTime(files, OUTF_MEASURES, obs[i].time);
           if(files->troposphere)
-            writeTimeToFile(files->troposphere, firstTime);
+            writeOutputTime(files, OUTF_TROPOSPHERE, obs[i].time);
         }
         if (files && files->measures)
         {
-          writeMeasures(files->measures, timediff(obs[i].time, firstTime), &obs[i]);
+          writeMeasures(files, timediff(obs[i].time, files->time.t0[OUTT_RES]), &obs[i]);
         }
 
         /* geometric distance/azimuth/elevation angle */
         if ((r=geodist(rs+i*6,rr,e))<=0.0||
             satazel(pos,e,azel+i*2)<opt->elmin) continue;
         
-        fprintf(output, "        distance = %f, e1 = %f, e2 = %f, e3 = %f, azimuth = %f, elevation = %f\n", r, e[0], e[1], e[2], azel[0], azel[1]);
+        if (fp) fprintf(fp, "        distance = %f, e1 = %f, e2 = %f, e3 = %f, azimuth = %f, elevation = %f\n", r, e[0], e[1], e[2], azel[0], azel[1]);
 
         /* excluded satellite? */
         if (satexclude(obs[i].sat,svh[i],opt))
@@ -1060,10 +1058,10 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
             dtrp=prectrop(obs[i].time,pos,azel+i*2,opt,x,dtdx,&vart);
         }
 
-        fprintf(output, "        tropospheric corr. = %f\n", dtrp);
+        if (fp) fprintf(fp, "        tropospheric corr. = %f\n", dtrp);
 
         if(files && files->troposphere)
-          writeTroposphere(files->troposphere, timediff(obs[i].time, firstTime), obs[i].sat, dtrp, 0.0);
+          writeTroposphere(files, timediff(obs[i].time, files->time.t0[OUTT_RES]), obs[i].sat, dtrp, 0.0);
 
         /* satellite antenna model */
         if (opt->posopt[0]) {
@@ -1078,7 +1076,7 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
             dantr[1] = dantr[0];
         }
         
-        fprintf(output, "        antenna correction: d_L1 = %f\n", dantr[0]);
+        if (fp) fprintf(fp, "        antenna correction: d_L1 = %f\n", dantr[0]);
 
         /* phase windup correction */
         if (opt->posopt[2]) {
@@ -1092,7 +1090,7 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
         /* satellite clock and tropospheric delay */
         r+=-CLIGHT*dts[i*2]+dtrp;
         
-        fprintf(output, "        corrected distance = %f\n", r);
+        if (fp) fprintf(fp, "        corrected distance = %f\n", r);
 
         trace(5,"sat=%2d azel=%6.1f %5.1f dtrp=%.3f dantr=%6.3f %6.3f dants=%6.3f %6.3f phw=%6.3f\n",
               sat,azel[i*2]*R2D,azel[1+i*2]*R2D,dtrp,dantr[0],dantr[1],dants[0],
@@ -1106,10 +1104,7 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
             
             v[nv]=meas[j]-r;
 
-            if(j == 0)
-              fprintf(output, "        v_phase = %f\n", v[nv]);
-            else
-              fprintf(output, "        v_code = %f\n", v[nv]);
+            if (fp) fprintf(fp, "        %s = %f\n", j == 0 ? "v_phase" : "v_code", v[nv]);
 
             for (k=0;k<3;k++) H[k+nx*nv]=-e[k];
             
@@ -1126,9 +1121,9 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
                     H[IT(opt)+k+nx*nv]=dtdx[k];
                 }
             }
-            if (j==0) {
-                v[nv]-=x[IB(obs[i].sat,opt)];
-                H[IB(obs[i].sat,opt)+nx*nv]=1.0;
+            if (j==0&&IB(obs[i].sat,rtk)) {
+                v[nv]-=x[IB(obs[i].sat,rtk)];
+                H[IB(obs[i].sat,rtk)+nx*nv]=1.0;
             }
             var[nv]=varerr(obs[i].sat,sys,azel[1+i*2],j,opt)+varm[j]+vare[i]+vart;
             
@@ -1161,7 +1156,7 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
 
             if (files && files->residuals && j==1)
             {
-              writeResiduals(files->residuals, timediff(obs[i].time, firstTime), obs[i].sat, v[nv], v[nv - 1]);
+              writeResiduals(files, timediff(obs[i].time, files->time.t0[OUTT_RES]), obs[i].sat, v[nv], v[nv - 1]);
             }
 
             nv++;
@@ -1169,9 +1164,9 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
     }
 
     if(files && files->includedSats)
-      writeIncludedSats(files->includedSats, timediff(obs[0].time, firstTime), includedSatsCount, includedSats);
+      writeIncludedSats(files, timediff(obs[0].time, files->time.t0[OUTT_RES]), includedSatsCount, includedSats);
     if(files && files->excludedSats)
-      writeExcludedSats(files->excludedSats, timediff(obs[0].time, firstTime), excludedSatsCount, excludedSats, excludeReasons);
+      writeExcludedSats(files, timediff(obs[0].time, files->time.t0[OUTT_RES]), excludedSatsCount, excludedSats, excludeReasons);
 
     for (i=0;i<nv;i++) for (j=0;j<nv;j++) {
         R[i+j*nv]=i==j?var[i]:0.0;
@@ -1180,13 +1175,35 @@ static int res_ppp(int iter, const obsd_t *obs, int n, const double *rs,
     trace(5,"v=\n"); tracemat(5,v, 1,nv,8,3);
     trace(5,"H=\n"); tracemat(5,H,nx,nv,8,3);
     trace(5,"R=\n"); tracemat(5,R,nv,nv,8,5);
-    fprintf(output, "    End residuals calculation\n");
+    if (fp) fprintf(fp, "    End residuals calculation\n");
     return nv;
 }
-/* number of estimated states ------------------------------------------------*/
+/* number of estimated states except phase-biases ----------------------------*/
 extern int pppnx(const prcopt_t *opt)
 {
-    return NX(opt);
+    return NR(opt);
+}
+/* state number of state index (phase-bias: NR+sat-1) ------------------------*/
+static int stateno(const rtk_t *rtk, int i)
+{
+    int sat;
+    
+    if (i<NR(&rtk->opt)) return i;
+    for (sat=1;sat<=MAXSAT;sat++) {
+        if (IB(sat,rtk)==i) return NR(&rtk->opt)+sat-1;
+    }
+    return -1;
+}
+/* ambiguity arc covering time (open arcs extend to end of data) -------------*/
+static int ambarc(const rtk_t *rtk, int sat, gtime_t time)
+{
+    const ambinfo_t *arc = rtk->ambinfo + sat - 1;
+    int k;
+    
+    for(k = 0; k < arc->n; k++)
+        if(arc->start[k].time < time.time && (!arc->end[k].time || time.time < arc->end[k].time))
+          return k;
+    return -1;
 }
 /* precise point positioning -------------------------------------------------*/
 extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav, outputFiles_t *files)
@@ -1196,13 +1213,12 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav, output
     int i,j,k,nv,info,svh[MAXOBS],stat=SOLQ_SINGLE;
     double bias;
     double ep[6];
-    FILE* outputKalman;
+    FILE *fp=DBGLOG(opt,1),*fpd=DBGLOG(opt,2),*fpm=DBGLOG(opt,3);
+    FILE *fpkf=DBGLOGKF(opt),*fps=DBGSNAP(opt);
     
     trace(3,"pppos   : nx=%d n=%d\n",rtk->nx,n);
     
-    output = fopen("solution_log.txt", "a");
-
-    fprintf(output, "Begin solution in precise point positioning mode\n");
+    if (fp) fprintf(fp, "Begin solution in precise point positioning mode\n");
 
     rs=mat(6,n); dts=mat(2,n); var=mat(1,n); azel=zeros(2,n);
     
@@ -1220,17 +1236,28 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav, output
     if (rtk->opt.posopt[3]) {
         testeclipse(obs,n,nav,rs);
     }
-    xp=mat(rtk->nx,1); Pp=zeros(rtk->nx,rtk->nx);
+    /* assign phase-bias states to observed satellites with ambiguity arcs */
+    for (i=0;i<n&&i<MAXOBS;i++) {
+        if (ambarc(rtk,obs[i].sat,obs[0].time)>=0) assignbias(rtk,obs[i].sat,0);
+    }
+    
+    /* measurement update buffers in kalman filter workspace */
+    nv=n*rtk->opt.nf*2;
+    initfilterws(&rtk->ws,rtk->nx,nv);
+    xp=rtk->ws.xp; Pp=rtk->ws.Pp; v=rtk->ws.v; H=rtk->ws.H; R=rtk->ws.R;
+    for (i=0;i<rtk->nx*rtk->nx;i++) Pp[i]=0.0;
     matcpy(xp,rtk->x,rtk->nx,1);
-    nv=n*rtk->opt.nf*2; v=mat(nv,1); H=mat(rtk->nx,nv); R=mat(nv,nv);
-    fprintf(output, "  Current state of vector X:");
-    for(i = 0; i < rtk->nx; i++)
-      fprintf(output, " X[%i] = %f,", i, xp[i]);
-    fprintf(output, "\n");
+    if (fpd)
+    {
+      fprintf(fpd, "  Current state of vector X:");
+      for(i = 0; i < rtk->nx; i++)
+        fprintf(fpd, " X[%i] = %f,", i, xp[i]);
+      fprintf(fpd, "\n");
+    }
     
     for (i=0;i<rtk->opt.niter;i++) {
         
-        fprintf(output, "  Begin iteration %i\n", i);
+        if (fp) fprintf(fp, "  Begin iteration %i\n", i);
 
         /* phase and code residuals */
         if ((nv=res_ppp(i,obs,n,rs,dts,var,svh,nav,xp,rtk,v,H,R,azel,NULL))<=0) break;
@@ -1245,99 +1272,102 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav, output
         rtk->P[2] = rtk->sol.qr[5];
         rtk->P[2 * rtk->nx] = rtk->sol.qr[5];
 
-        for(j = 1; j <= MAXSAT && IB(j, &(rtk->opt)) < rtk->nx; j++)
+        for(j = 1; j <= MAXSAT; j++)
         {
-            for(k = 0; k < rtk->ambinfo[j - 1].n; k++)
-                if(rtk->ambinfo[j - 1].start[k].time < obs[0].time.time && obs[0].time.time < rtk->ambinfo[j - 1].end[k].time)
-                  break;
-            if(k < rtk->ambinfo[j - 1].n)
-            {
-                rtk->P[IB(j, &(rtk->opt)) + IB(j, &(rtk->opt)) * rtk->nx] = rtk->ambinfo[j - 1].sigma[k];
-                rtk->x[IB(j, &(rtk->opt))] = rtk->ambinfo[j - 1].amb[k];
-            }
+            if(!IB(j, rtk) || (k = ambarc(rtk, j, obs[0].time)) < 0)
+                continue;
+            rtk->P[IB(j, rtk) + IB(j, rtk) * rtk->nx] = rtk->ambinfo[j - 1].sigma[k];
+            rtk->x[IB(j, rtk)] = rtk->ambinfo[j - 1].amb[k];
         }
 
         /* measurement update */
         matcpy(Pp,rtk->P,rtk->nx,rtk->nx);
 
-        fprintf(output, "    Begin Kalman filtering:\n");
+        if (fp) fprintf(fp, "    Begin Kalman filtering:\n");
 
-        fprintf(output, "     ");
-        for(j = 0; j < rtk->nx; j++)
-          fprintf(output, " X[%i] = %f,", j, xp[j]);
-        fprintf(output, "\n\n");
-
-        for(j = 0; j < rtk->nx; j++)
+        if (fpm)
         {
-          fprintf(output, "     ");
-          for(k = 0; k < rtk->nx; k++)
-            fprintf(output, " P[%i][%i] = %f,", j, k, Pp[k + j * rtk->nx]);
-          fprintf(output, "\n");
+          fprintf(fpm, "     ");
+          for(j = 0; j < rtk->nx; j++)
+            fprintf(fpm, " X[%i] = %f,", j, xp[j]);
+          fprintf(fpm, "\n\n");
+
+          for(j = 0; j < rtk->nx; j++)
+          {
+            fprintf(fpm, "     ");
+            for(k = 0; k < rtk->nx; k++)
+              fprintf(fpm, " P[%i][%i] = %f,", j, k, Pp[k + j * rtk->nx]);
+            fprintf(fpm, "\n");
+          }
+          fprintf(fpm, "\n");
+
+          for(j = 0; j < nv; j++)
+          {
+            fprintf(fpm, "     ");
+            for(k = 0; k < nv; k++)
+              fprintf(fpm, " R[%i][%i] = %f,", j, k, R[k + j * nv]);
+            fprintf(fpm, "\n");
+          }
+
+          fprintf(fpm, "\n     ");
+          for(j = 0; j < nv; j++)
+            fprintf(fpm, " v[%i] = %f,", j, v[j]);
+          fprintf(fpm, "\n\n");
+
+          for(j = 0; j < nv; j++)
+          {
+            fprintf(fpm, "     ");
+            for(k = 0; k < rtk->nx; k++)
+              fprintf(fpm, " H[%i][%i] = %f,", j, k, H[k + j * rtk->nx]);
+            fprintf(fpm, "\n");
+          }
         }
-        fprintf(output, "\n");
 
-        for(j = 0; j < nv; j++)
+        if (fpkf)
         {
-          fprintf(output, "     ");
-          for(k = 0; k < nv; k++)
-            fprintf(output, " R[%i][%i] = %f,", j, k, R[k + j * nv]);
-          fprintf(output, "\n");
+          time2epoch(obs[0].time, ep);
+          fprintf(fpkf, "Time: %4.0f/%2.0f/%2.0f %2.0f:%2.0f:%2.4f\n\n", ep[0], ep[1], ep[2], ep[3], ep[4], ep[5]);
+
+          for(j = 0; j < rtk->nx; j++)
+            if(xp[j] != 0)
+              fprintf(fpkf, "X[%i] = %f\n", stateno(rtk, j), xp[j]);
+          fprintf(fpkf, "\n");
+
+          for(j = 0; j < 3; j++)
+          {
+            for(k = 0; k < 3; k++)
+              fprintf(fpkf, "P[%i][%i] = %f\n", j, k, Pp[k + j * rtk->nx]);
+          }
+          for(j = 5; j < rtk->nx; j++)
+            if(Pp[j + j * rtk->nx] != 0)
+              fprintf(fpkf, "P[%i][%i] = %f\n", stateno(rtk, j), stateno(rtk, j), Pp[j + j * rtk->nx]);
+          fprintf(fpkf, "\n");
         }
 
-        fprintf(output, "\n     ");
-        for(j = 0; j < nv; j++)
-          fprintf(output, " v[%i] = %f,", j, v[j]);
-        fprintf(output, "\n\n");
-
-        for(j = 0; j < nv; j++)
-        {
-          fprintf(output, "     ");
-          for(k = 0; k < rtk->nx; k++)
-            fprintf(output, " H[%i][%i] = %f,", j, k, H[k + j * rtk->nx]);
-          fprintf(output, "\n");
-        }
+        if (fps) writeSnapshot(fps,opt->mode,obs[0].time,i,xp,Pp,H,v,R,rtk->nx,nv);
         
-        outputKalman = fopen("KalmanFiltering.txt", "a");
-
-        time2epoch(obs[0].time, ep);
-        fprintf(outputKalman, "Time: %4.0f/%2.0f/%2.0f %2.0f:%2.0f:%2.4f\n\n", ep[0], ep[1], ep[2], ep[3], ep[4], ep[5]);
-
-        for(j = 0; j < rtk->nx; j++)
-          if(xp[j] != 0)
-            fprintf(outputKalman, "X[%i] = %f\n", j, xp[j]);
-        fprintf(outputKalman, "\n");
-
-        for(j = 0; j < 3; j++)
-        {
-          for(k = 0; k < 3; k++)
-            fprintf(outputKalman, "P[%i][%i] = %f\n", j, k, Pp[k + j * rtk->nx]);
-        }
-        for(j = 5; j < rtk->nx; j++)
-          if(Pp[j + j * rtk->nx] != 0)
-            fprintf(outputKalman, "P[%i][%i] = %f\n", j, j, Pp[j + j * rtk->nx]);
-        fprintf(outputKalman, "\n");
-
-        fclose(outputKalman);
-
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        if ((info=filter_ws(xp,Pp,H,v,R,rtk->nx,nv,&rtk->ws))) {
             trace(2,"ppp filter error %s info=%d\n",time_str(rtk->sol.time,0),
                   info);
             break;
         }
-        fprintf(output, "    End Kalman filtering\n");
+        if (fp) fprintf(fp, "    End Kalman filtering\n");
         trace(4,"x(%d)=",i+1); tracemat(4,xp,1,NR(opt),13,4);
         
-        fprintf(output, "    Vector X after Kalman filter:\n");
-        for(j = 0; j < rtk->nx; j++)
+        if (fpd)
         {
-          if(xp[j] == 0) continue;
-          fprintf(output, "      X[%i] = %f", j, xp[j]);
-          if(j >= 5)
-            fprintf(output, " (for satellite %i)\n", j - 4);
-          else
-            fprintf(output, "\n");
+          fprintf(fpd, "    Vector X after Kalman filter:\n");
+          for(j = 0; j < rtk->nx; j++)
+          {
+            if(xp[j] == 0) continue;
+            fprintf(fpd, "      X[%i] = %f", j, xp[j]);
+            if(j >= 5)
+              fprintf(fpd, " (for satellite %i)\n", j - 4);
+            else
+              fprintf(fpd, "\n");
+          }
+          fprintf(fpd, "\n");
         }
-        fprintf(output, "\n");
 
         stat=SOLQ_PPP;
     }
@@ -1381,49 +1411,74 @@ extern void pppos(rtk_t *rtk, const obsd_t *obs, int n, const nav_t *nav, output
         }
     }
     free(rs); free(dts); free(var); free(azel);
-    free(xp); free(Pp); free(v); free(H); free(R);
-    fprintf(output, "End calculations in precise point positioning mode\n");
-    fclose(output);
+    if (fp) fprintf(fp, "End calculations in precise point positioning mode\n");
 }
 
-extern void getambinfo(rtk_t *rtk,  const obs_t *obs, const nav_t *nav)
+/* ambiguity arcs of rover -----------------------------------------------------
+* get ambiguity arcs of rover by iono-free phase-code differences
+* args   : prcopt_t *opt    I   processing options
+*          obs_t  *obs      I   observation data sorted by sortobs()
+*          nav_t  *nav      I   navigation data after uniqnav()
+*          double *rr       I   approximate rover position ecef (m)
+*                               (NULL or {0,0,0}: no phase windup correction)
+*          ambinfo_t *ambinfo IO ambiguity arcs {sat1,sat2,...,satMAXSAT}
+* return : none
+* notes  : only the rover observations (rcv=1) are used. an arc is closed by
+*          the first epoch without iono-free measurement of the satellite. an
+*          arc not closed by the end of data has end time {0}.
+*          the arcs are continued from ambinfo, which should be zero-cleared
+*          before the first call, by the obs data input in order of time
+*-----------------------------------------------------------------------------*/
+extern void getambinfo(const prcopt_t *opt, const obs_t *obs, const nav_t *nav,
+                       const double *rr, ambinfo_t *ambinfo)
 {
-    int i, sat;
-    int status[MAXSAT] = {0};
-    double dantr[NFREQ]={0}, dants[NFREQ]={0}, meas[2]={0}, varm[2]={0};
-    double azel[2]={0};
+    ambinfo_t *arc;
+    int i, k, sat, svh, open;
+    double meas[2]={0}, varm[2]={0};
+    double dantr[NFREQ]={0}, dants[NFREQ]={0}, azel[2]={0};
+    double rs[6], dts[2], var;
+
+    trace(3,"getambinfo: n=%d\n",obs->n);
 
     for(i = 0; i < obs->n; i++)
     {
-        sat=obs->data[i].sat;
+        if(obs->data[i].rcv != 1)
+            continue;
+
+        sat = obs->data[i].sat;
+        arc = ambinfo + sat - 1;
+        k = arc->n - 1;
+        open = k >= 0 && arc->end[k].time == 0;
 
+        /* phase windup correction as the filter by approximate position */
+        if(opt->posopt[2] && rr && norm(rr, 3) > 0.0)
+        {
+            satposs(obs->data[i].time, obs->data + i, 1, nav, opt->sateph, rs, dts, &var, &svh);
+            if(norm(rs, 3) > 0.0)
+                windupcorr(obs->data[i].time, rs, rr, &arc->phw);
+        }
         meas[0] = meas[1] = varm[0] = varm[1] = 0;
 
-        if (!ifmeas(&(obs->data[i]) ,nav,azel,&rtk->opt,dantr,dants,
-                    rtk->ssat[sat-1].phw,meas,varm))
+        if (!ifmeas(obs->data + i, nav, azel, opt, dantr, dants, arc->phw, meas, varm))
         {
-            if(status[sat - 1] == 1)
-            {
-              rtk->ambinfo[sat - 1].end[rtk->ambinfo[sat-1].n++] = obs[i].data->time;
-              status[sat - 1] = 0;
-            }
+            if(open) /* close arc */
+                arc->end[k] = obs->data[i].time;
         }
-        else
+        else if(open)
         {
-            if(status[sat - 1] == 0)
-            {
-                rtk->ambinfo[sat - 1].start[rtk->ambinfo[sat-1].n] = obs->data[i].time;
-                rtk->ambinfo[sat - 1].amb[rtk->ambinfo[sat-1].n] = meas[1] - meas[0];
-                rtk->ambinfo[sat - 1].sigma[rtk->ambinfo[sat-1].n] = SIGMA0;
-                rtk->ambinfo[sat - 1].nobs[rtk->ambinfo[sat-1].n] = 1;
-                status[sat - 1] = 1;
-            }
-            else
-            {
-                rtk->ambinfo[sat - 1].amb[rtk->ambinfo[sat-1].n] = (rtk->ambinfo[sat-1].nobs[rtk->ambinfo[sat-1].n] * rtk->ambinfo[sat-1].amb[rtk->ambinfo[sat-1].n] + (meas[1] - meas[0])) / (rtk->ambinfo[sat-1].nobs[rtk->ambinfo[sat-1].n] + 1);
-                rtk->ambinfo[sat-1].nobs[rtk->ambinfo[sat-1].n]++;
-                rtk->ambinfo[sat - 1].sigma[rtk->ambinfo[sat-1].n] = SIGMA0 / sqrt(rtk->ambinfo[sat-1].nobs[rtk->ambinfo[sat-1].n]);
-            }
+            arc->amb[k] = (arc->nobs[k] * arc->amb[k] + (meas[1] - meas[0])) / (arc->nobs[k] + 1);
+            arc->nobs[k]++;
+            arc->sigma[k] = SIGMA0 / sqrt(arc->nobs[k]);
+        }
+        else if(arc->n < MAXAMB) /* open arc */
+        {
+            k = arc->n++;
+            arc->start[k] = obs->data[i].time;
+            arc->end[k].time = 0;
+            arc->end[k].sec = 0.0;
+            arc->amb[k] = meas[1] - meas[0];
+            arc->sigma[k] = SIGMA0;
+            arc->nobs[k] = 1;
         }
     }
 }
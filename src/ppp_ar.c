@@ -36,7 +36,7 @@ static const char rcsid[]="$Id:$";
 #define IT(opt)     (IC(0,opt)+NSYS)   /* state index of tropos */
 #define NR(opt)     (IT(opt)+((opt)->tropopt<TROPOPT_EST?0:((opt)->tropopt==TROPOPT_EST?1:3)))
                                        /* number of solutions */
-#define IB(s,opt)   (NR(opt)+(s)-1)    /* state index of phase bias */
+#define IB(s,rtk)   ((rtk)->ib[(s)-1][0]) /* state index of phase bias (0:none) */
 
 /* wave length of LC (m) -----------------------------------------------------*/
 static double lam_LC(int i, int j, int k)
@@ -274,15 +274,15 @@ static int fix_sol(rtk_t *rtk, const int *sat1, const int *sat2,
 
     /* constraints to fixed ambiguities */
     for (i=0;i<n;i++) {
-        j=IB(sat1[i],&rtk->opt);
-        k=IB(sat2[i],&rtk->opt);
+        j=IB(sat1[i],rtk);
+        k=IB(sat2[i],rtk);
         v[i]=NC[i]-(rtk->x[j]-rtk->x[k]);
         H[j+i*rtk->nx]= 1.0;
         H[k+i*rtk->nx]=-1.0;
         R[i+i*n]=SQR(CONST_AMB);
     }
     /* update states with constraints */
-    if ((info=filter(rtk->x,rtk->P,H,v,R,rtk->nx,n))) {
+    if ((info=filter_ws(rtk->x,rtk->P,H,v,R,rtk->nx,n,&rtk->ws))) {
         trace(1,"filter error (info=%d)\n",info);
         free(v); free(H); free(R);
         return 0;
@@ -316,8 +316,9 @@ static int fix_amb_ROUND(rtk_t *rtk, int *sat1, int *sat2, const int *NW, int n)
     NC=zeros(n,1); var=zeros(n,1);
 
     for (i=0;i<n;i++) {
-        j=IB(sat1[i],&rtk->opt);
-        k=IB(sat2[i],&rtk->opt);
+        j=IB(sat1[i],rtk);
+        k=IB(sat2[i],rtk);
+        if (!j||!k) continue;
 
         /* narrow-lane ambiguity */
         B1=(rtk->x[j]-rtk->x[k]+C2*lam2*NW[i])/lam_NL;
@@ -373,8 +374,9 @@ static int fix_amb_ILS(rtk_t *rtk, int *sat1, int *sat2, int *NW, int n)
         /* check linear independency */
         if (!is_depend(sat1[i],sat2[i],flgs,&max_flg)) continue;
 
-        j=IB(sat1[i],&rtk->opt);
-        k=IB(sat2[i],&rtk->opt);
+        j=IB(sat1[i],rtk);
+        k=IB(sat2[i],rtk);
+        if (!j||!k) continue;
 
         /* float narrow-lane ambiguity (cycle) */
         B1[m]=(rtk->x[j]-rtk->x[k]+C2*lam2*NW[i])/lam_NL;
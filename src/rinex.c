@@ -82,6 +82,13 @@
 *           2014/10/20 1.23 recognize "C2" in 2.12 as "C2W" instead of "C2D"
 *           2014/12/07 1.24 add read rinex option -SYS=...
 *-----------------------------------------------------------------------------*/
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include "rtklib.h"
 
 static const char rcsid[]="$Id:$";
@@ -96,6 +103,8 @@ static const char rcsid[]="$Id:$";
 #define MINFREQ_GLO -7                  /* min frequency number glonass */
 #define MAXFREQ_GLO 13                  /* max frequency number glonass */
 #define NINCOBS     262144              /* inclimental number of obs data */
+#define CACHEID     "RNXCACHE"          /* id of rinex cache file */
+#define CACHEVER    1                   /* version of rinex cache file */
 
 static const int navsys[]={             /* satellite systems */
     SYS_GPS,SYS_GLO,SYS_GAL,SYS_QZS,SYS_SBS,SYS_CMP,0
@@ -121,6 +130,44 @@ typedef struct {                        /* signal index type */
     double shift[MAXOBSTYPE];           /* phase shift (cycle) */
 } sigind_t;
 
+typedef struct {                        /* byte buffer type */
+    char *buff;                         /* buffer */
+    size_t n,nmax;                      /* number of bytes/allocated */
+    int err;                            /* allocation error */
+} rnxbuf_t;
+
+typedef struct {                        /* rinex line reader type */
+    FILE *fp;                           /* file pointer (NULL: no file) */
+    decomp_t *dc;                       /* decompressing file (NULL: no file) */
+    const char *p;                      /* current position in mapped file */
+    const char *end;                    /* end of mapped file */
+    rnxbuf_t *rec;                      /* record of lines read (NULL: off) */
+} rnxrd_t;
+
+typedef struct {                        /* rinex cache file header type */
+    char id[8];                         /* file id (CACHEID) */
+    int ver;                            /* file version (CACHEVER) */
+    int size[4];                        /* size of obsd_t,eph_t,geph_t,seph_t */
+    int n[6];                           /* number of header bytes,obs data,
+                                           epochs,eph,geph,seph */
+    double fsize;                       /* size of rinex file (bytes) */
+    double mtime;                       /* modified time of rinex file */
+    char path[1024];                    /* rinex file path */
+    char opt[256];                      /* rinex options */
+} cachehead_t;
+
+typedef struct {                        /* rinex cache data type */
+    const char *hdr;                    /* header lines */
+    const obsd_t *obs;                  /* obs data */
+    const int *ep;                      /* number of obs data of epochs */
+    const eph_t *eph;                   /* GPS/QZS/GAL ephemeris */
+    const geph_t *geph;                 /* GLONASS ephemeris */
+    const seph_t *seph;                 /* SBAS ephemeris */
+    int n[6];                           /* number of data as cachehead_t */
+} cache_t;
+
+static char cachedir[1024]="";          /* directory of rinex cache files */
+
 /* set string without tail space ---------------------------------------------*/
 static void setstr(char *dst, const char *src, int n)
 {
@@ -130,6 +177,132 @@ static void setstr(char *dst, const char *src, int n)
     *p--='\0';
     while (p>=dst&&*p==' ') *p--='\0';
 }
+/* map file to memory for read -----------------------------------------------*/
+static const char *maprnx(const char *file, size_t *size)
+{
+    void *map;
+#ifdef WIN32
+    HANDLE fh,mh;
+    LARGE_INTEGER len;
+    
+    if ((fh=CreateFile(file,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,0,
+                       NULL))==INVALID_HANDLE_VALUE) return NULL;
+    if (!GetFileSizeEx(fh,&len)||len.QuadPart<=0||
+        !(mh=CreateFileMapping(fh,NULL,PAGE_READONLY,0,0,NULL))) {
+        CloseHandle(fh);
+        return NULL;
+    }
+    map=MapViewOfFile(mh,FILE_MAP_READ,0,0,0);
+    CloseHandle(mh);
+    CloseHandle(fh);
+    *size=(size_t)len.QuadPart;
+#else
+    struct stat st;
+    int fd;
+    
+    if ((fd=open(file,O_RDONLY))<0) return NULL;
+    if (fstat(fd,&st)<0||!S_ISREG(st.st_mode)||st.st_size<=0) {
+        close(fd);
+        return NULL;
+    }
+    map=mmap(NULL,(size_t)st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (map==MAP_FAILED) return NULL;
+#ifdef MADV_SEQUENTIAL
+    madvise(map,(size_t)st.st_size,MADV_SEQUENTIAL);
+#endif
+    *size=(size_t)st.st_size;
+#endif
+    return (const char *)map;
+}
+/* unmap file mapped by maprnx() ---------------------------------------------*/
+static void unmaprnx(const char *map, size_t size)
+{
+    if (!map) return;
+#ifdef WIN32
+    UnmapViewOfFile(map);
+#else
+    munmap((void *)map,size);
+#endif
+}
+/* add bytes to buffer ------------------------------------------------------*/
+static int addbuf(rnxbuf_t *buf, const void *data, size_t n)
+{
+    char *p;
+    
+    if (buf->n+n>buf->nmax) {
+        buf->nmax=buf->n+n>buf->nmax*2?buf->n+n:buf->nmax*2;
+        if (!(p=(char *)realloc(buf->buff,buf->nmax))) {
+            buf->err=1;
+            return 0;
+        }
+        buf->buff=p;
+    }
+    memcpy(buf->buff+buf->n,data,n);
+    buf->n+=n;
+    return 1;
+}
+/* read line by rinex line reader (as fgets()) -------------------------------*/
+static char *rdline(rnxrd_t *rd, char *buff)
+{
+    const char *q;
+    char *p=buff;
+    int n;
+    
+    if (rd->fp) p=fgets(buff,MAXRNXLEN,rd->fp);
+    else if (rd->dc) p=getsdecomp(buff,MAXRNXLEN,rd->dc);
+    else {
+        if (rd->p>=rd->end) return NULL;
+        n=rd->end-rd->p<MAXRNXLEN-1?(int)(rd->end-rd->p):MAXRNXLEN-1;
+        if ((q=(const char *)memchr(rd->p,'\n',n))) n=(int)(q-rd->p)+1;
+        memcpy(buff,rd->p,n);
+        buff[n]='\0';
+        rd->p+=n;
+    }
+    if (p&&rd->rec) addbuf(rd->rec,p,strlen(p));
+    return p;
+}
+/* string to number of obs data field ------------------------------------------
+* convert fixed-width field of obs data (F14.3) in string to number as
+* str2num(). the digits with a decimal point are accumulated as integer and
+* divided by power of 10, which is exact up to 15 digits. the field in other
+* formats is converted by str2num()
+* args   : char   *s        I   string
+*          int    len       I   length of string
+*          int    i,n       I   substring position and width
+* return : converted number (0.0:error)
+*-----------------------------------------------------------------------------*/
+static double str2obs(const char *s, int len, int i, int n)
+{
+    static const double pow10[]={
+        1E0,1E1,1E2,1E3,1E4,1E5,1E6,1E7,1E8,1E9,1E10,1E11,1E12,1E13,1E14,1E15
+    };
+    const char *p,*e;
+    double val=0.0;
+    int neg=0,nd=0,nf=-1;
+    
+    if (i<0||len<i) return 0.0;
+    
+    p=s+i; e=s+(i+n<len?i+n:len);
+    
+    while (p<e&&*p==' ') p++;
+    if (p<e&&(*p=='-'||*p=='+')) neg=*p++=='-';
+    for (;p<e;p++) {
+        if ('0'<=*p&&*p<='9') {
+            val=val*10.0+(*p-'0');
+            nd++;
+            if (nf>=0) nf++;
+        }
+        else if (*p=='.'&&nf<0) nf=0;
+        else break;
+    }
+    while (p<e&&(*p==' '||*p=='\r'||*p=='\n')) p++;
+    
+    if (p<e||nd>15) return str2num(s,i,n);
+    if (nd<=0) return 0.0;
+    if (nf>0) val/=pow10[nf];
+    return neg?-val:val;
+}
 /* adjust time considering week handover -------------------------------------*/
 static gtime_t adjweek(gtime_t t, gtime_t t0)
 {
@@ -291,7 +464,7 @@ static void convcode(double ver, int sys, const char *str, char *type)
     trace(3,"convcode: ver=%.2f sys=%2d type= %s -> %s\n",ver,sys,str,type);
 }
 /* decode obs header ---------------------------------------------------------*/
-static void decode_obsh(FILE *fp, char *buff, double ver, int *tsys,
+static void decode_obsh(rnxrd_t *rd, char *buff, double ver, int *tsys,
                         char tobs[][MAXOBSTYPE][4], nav_t *nav, sta_t *sta)
 {
     /* default codes for unknown code */
@@ -359,7 +532,7 @@ static void decode_obsh(FILE *fp, char *buff, double ver, int *tsys,
         n=(int)str2num(buff,3,3);
         for (j=nt=0,k=7;j<n;j++,k+=4) {
             if (k>58) {
-                if (!fgets(buff,MAXRNXLEN,fp)) break;
+                if (!rdline(rd,buff)) break;
                 k=7;
             }
             if (nt<MAXOBSTYPE-1) setstr(tobs[i][nt++],buff+k,3);
@@ -384,7 +557,7 @@ static void decode_obsh(FILE *fp, char *buff, double ver, int *tsys,
         n=(int)str2num(buff,0,6);
         for (i=nt=0,j=10;i<n;i++,j+=6) {
             if (j>58) {
-                if (!fgets(buff,MAXRNXLEN,fp)) break;
+                if (!rdline(rd,buff)) break;
                 j=10;
             }
             if (nt>=MAXOBSTYPE-1) continue;
@@ -571,7 +744,7 @@ static void decode_hnavh(char *buff, nav_t *nav)
     }
 }
 /* read rinex header ---------------------------------------------------------*/
-static int readrnxh(FILE *fp, double *ver, char *type, int *sys, int *tsys,
+static int readrnxh(rnxrd_t *rd, double *ver, char *type, int *sys, int *tsys,
                     char tobs[][MAXOBSTYPE][4], nav_t *nav, sta_t *sta)
 {
     double bias;
@@ -582,7 +755,7 @@ static int readrnxh(FILE *fp, double *ver, char *type, int *sys, int *tsys,
     
     *ver=2.10; *type=' '; *sys=SYS_GPS; *tsys=TSYS_GPS;
     
-    while (fgets(buff,MAXRNXLEN,fp)) {
+    while (rdline(rd,buff)) {
         
         if (strlen(buff)<=60) continue;
         
@@ -618,18 +791,18 @@ static int readrnxh(FILE *fp, double *ver, char *type, int *sys, int *tsys,
                 /* cnes/cls grg clock */
                 if (!strncmp(buff,"WL",2)&&(sat=satid2no(buff+3))&&
                     sscanf(buff+40,"%lf",&bias)==1) {
-                    nav->wlbias[sat-1]=bias;
+                    if (nav) nav->wlbias[sat-1]=bias;
                 }
                 /* cnes ppp-wizard clock */
                 else if ((sat=satid2no(buff+1))&&sscanf(buff+6,"%lf",&bias)==1) {
-                    nav->wlbias[sat-1]=bias;
+                    if (nav) nav->wlbias[sat-1]=bias;
                 }
             }
             continue; 
         }
         /* file type */
         switch (*type) {
-            case 'O': decode_obsh(fp,buff,*ver,tsys,tobs,nav,sta); break;
+            case 'O': decode_obsh(rd,buff,*ver,tsys,tobs,nav,sta); break;
             case 'N': decode_navh (buff,nav); break;
             case 'G': decode_gnavh(buff,nav); break;
             case 'H': decode_hnavh(buff,nav); break;
@@ -643,7 +816,7 @@ static int readrnxh(FILE *fp, double *ver, char *type, int *sys, int *tsys,
     return 0;
 }
 /* decode obs epoch ----------------------------------------------------------*/
-static int decode_obsepoch(FILE *fp, char *buff, double ver, gtime_t *time,
+static int decode_obsepoch(rnxrd_t *rd, char *buff, double ver, gtime_t *time,
                            int *flag, int *sats)
 {
     int i,j,n;
@@ -665,7 +838,7 @@ static int decode_obsepoch(FILE *fp, char *buff, double ver, gtime_t *time,
         }
         for (i=0,j=32;i<n;i++,j+=3) {
             if (j>=68) {
-                if (!fgets(buff,MAXRNXLEN,fp)) break;
+                if (!rdline(rd,buff)) break;
                 j=32;
             }
             if (i<MAXOBS) {
@@ -690,14 +863,14 @@ static int decode_obsepoch(FILE *fp, char *buff, double ver, gtime_t *time,
     return n;
 }
 /* decode obs data -----------------------------------------------------------*/
-static int decode_obsdata(FILE *fp, char *buff, double ver, int mask,
+static int decode_obsdata(rnxrd_t *rd, char *buff, double ver, int mask,
                           sigind_t *index, obsd_t *obs)
 {
     sigind_t *ind;
     double val[MAXOBSTYPE]={0};
     unsigned char lli[MAXOBSTYPE]={0};
     char satid[8]="";
-    int i,j,n,m,stat=1,p[MAXOBSTYPE],k[16],l[16];
+    int i,j,n,m,len,stat=1,p[MAXOBSTYPE],k[16],l[16];
     
     trace(4,"decode_obsdata: ver=%.2f\n",ver);
     
@@ -721,15 +894,18 @@ static int decode_obsdata(FILE *fp, char *buff, double ver, int mask,
         case SYS_CMP: ind=index+5; break;
         default:      ind=index  ; break;
     }
+    len=(int)strlen(buff);
+    
     for (i=0,j=ver<=2.99?0:3;i<ind->n;i++,j+=16) {
         
         if (ver<=2.99&&j>=80) { /* ver.2 */
-            if (!fgets(buff,MAXRNXLEN,fp)) break;
+            if (!rdline(rd,buff)) break;
+            len=(int)strlen(buff);
             j=0;
         }
         if (stat) {
-            val[i]=str2num(buff,j,14)+ind->shift[i];
-            lli[i]=(unsigned char)str2num(buff,j+14,1)&3;
+            val[i]=str2obs(buff,len,j,14)+ind->shift[i];
+            lli[i]=(unsigned char)str2obs(buff,len,j+14,1)&3;
         }
     }
     if (!stat) return 0;
@@ -798,7 +974,7 @@ static int decode_obsdata(FILE *fp, char *buff, double ver, int mask,
     return 1;
 }
 /* save slips ----------------------------------------------------------------*/
-static void saveslips(unsigned char slips[][NFREQ], obsd_t *data)
+static void saveslips(unsigned char slips[][NFREQ], const obsd_t *data)
 {
     int i;
     for (i=0;i<NFREQ;i++) {
@@ -928,32 +1104,31 @@ static void set_index(double ver, int sys, const char *opt,
     }
 #endif
 }
-/* read rinex obs data body --------------------------------------------------*/
-static int readrnxobsb(FILE *fp, const char *opt, double ver,
-                       char tobs[][MAXOBSTYPE][4], int *flag, obsd_t *data)
+/* set signal index of systems ----------------------------------------------*/
+static void set_indexs(double ver, const char *opt, char tobs[][MAXOBSTYPE][4],
+                       sigind_t *index)
 {
-    gtime_t time={0};
-    sigind_t index[6]={{0}};
-    char buff[MAXRNXLEN];
-    int i=0,n=0,nsat=0,sats[MAXOBS]={0},mask;
-    
-    /* set system mask */
-    mask=set_sysmask(opt);
-    
-    /* set signal index */
     set_index(ver,SYS_GPS,opt,tobs[0],index  );
     set_index(ver,SYS_GLO,opt,tobs[1],index+1);
     set_index(ver,SYS_GAL,opt,tobs[2],index+2);
     set_index(ver,SYS_QZS,opt,tobs[3],index+3);
     set_index(ver,SYS_SBS,opt,tobs[4],index+4);
     set_index(ver,SYS_CMP,opt,tobs[5],index+5);
+}
+/* read rinex obs data body by system mask and signal index ------------------*/
+static int readrnxobsi(rnxrd_t *rd, double ver, int mask, sigind_t *index,
+                       int *flag, obsd_t *data)
+{
+    gtime_t time={0};
+    char buff[MAXRNXLEN];
+    int i=0,n=0,nsat=0,sats[MAXOBS]={0};
     
     /* read record */
-    while (fgets(buff,MAXRNXLEN,fp)) {
+    while (rdline(rd,buff)) {
         
         /* decode obs epoch */
         if (i==0) {
-            if ((nsat=decode_obsepoch(fp,buff,ver,&time,flag,sats))<=0) {
+            if ((nsat=decode_obsepoch(rd,buff,ver,&time,flag,sats))<=0) {
                 continue;
             }
         }
@@ -963,20 +1138,40 @@ static int readrnxobsb(FILE *fp, const char *opt, double ver,
             data[n].sat=(unsigned char)sats[i-1];
             
             /* decode obs data */
-            if (decode_obsdata(fp,buff,ver,mask,index,data+n)&&n<MAXOBS) n++;
+            if (decode_obsdata(rd,buff,ver,mask,index,data+n)&&n<MAXOBS) n++;
         }
         if (++i>nsat) return n;
     }
     return -1;
 }
-/* read rinex obs ------------------------------------------------------------*/
-static int readrnxobs(FILE *fp, gtime_t ts, gtime_t te, double tint,
-                      const char *opt, int rcv, double ver, int tsys,
-                      char tobs[][MAXOBSTYPE][4], obs_t *obs)
+/* read rinex obs data body --------------------------------------------------*/
+static int readrnxobsb(rnxrd_t *rd, const char *opt, double ver,
+                       char tobs[][MAXOBSTYPE][4], int *flag, obsd_t *data)
+{
+    sigind_t index[NUMSYS]={{0}};
+    
+    /* set signal index */
+    set_indexs(ver,opt,tobs,index);
+    
+    return readrnxobsi(rd,ver,set_sysmask(opt),index,flag,data);
+}
+/* read rinex obs --------------------------------------------------------------
+* read rinex obs data body. the rest of the file is mapped to memory if the
+* file path is given (read by the line reader if mapping failed)
+*-----------------------------------------------------------------------------*/
+static int readrnxobs(rnxrd_t *rdf, const char *file, gtime_t ts, gtime_t te,
+                      double tint, const char *opt, int rcv, double ver,
+                      int tsys, char tobs[][MAXOBSTYPE][4], obs_t *obs,
+                      rnxbuf_t *eps)
 {
     obsd_t *data;
+    rnxrd_t rd={0};
+    sigind_t index[NUMSYS]={{0}};
     unsigned char slips[MAXSAT][NFREQ]={{0}};
-    int i,n,flag=0,stat=0;
+    const char *map=NULL;
+    size_t size=0;
+    long pos;
+    int i,n,mask,flag=0,stat=0;
     
     trace(4,"readrnxobs: rcv=%d ver=%.2f tsys=%d\n",rcv,ver,tsys);
     
@@ -984,8 +1179,20 @@ static int readrnxobs(FILE *fp, gtime_t ts, gtime_t te, double tint,
     
     if (!(data=(obsd_t *)malloc(sizeof(obsd_t)*MAXOBS))) return 0;
     
+    rd=*rdf;
+    
+    /* map rest of file to memory */
+    if (file&&rd.fp&&(pos=ftell(rd.fp))>=0&&(map=maprnx(file,&size))) {
+        if ((size_t)pos<=size) {
+            rd.fp=NULL; rd.p=map+pos; rd.end=map+size;
+        }
+    }
+    /* set system mask and signal index */
+    mask=set_sysmask(opt);
+    set_indexs(ver,opt,tobs,index);
+    
     /* read rinex obs data body */
-    while ((n=readrnxobsb(fp,opt,ver,tobs,&flag,data))>=0&&stat>=0) {
+    while ((n=readrnxobsi(&rd,ver,mask,index,&flag,data))>=0&&stat>=0) {
         
         for (i=0;i<n;i++) {
             
@@ -998,6 +1205,9 @@ static int readrnxobs(FILE *fp, gtime_t ts, gtime_t te, double tint,
         /* screen data by time */
         if (n>0&&!screent(data[0].time,ts,te,tint)) continue;
         
+        /* number of obs data of epoch */
+        if (n>0&&eps) addbuf(eps,&n,sizeof(int));
+        
         for (i=0;i<n;i++) {
             
             /* restore cycle-slip */
@@ -1011,6 +1221,7 @@ static int readrnxobs(FILE *fp, gtime_t ts, gtime_t te, double tint,
     }
     trace(4,"readrnxobs: nobs=%d stat=%d\n",obs->n,stat);
     
+    unmaprnx(map,size);
     free(data);
     
     return stat;
@@ -1198,7 +1409,7 @@ static int decode_seph(double ver, int sat, gtime_t toc, double *data,
     return 1;
 }
 /* read rinex navigation data body -------------------------------------------*/
-static int readrnxnavb(FILE *fp, const char *opt, double ver, int sys,
+static int readrnxnavb(rnxrd_t *rd, const char *opt, double ver, int sys,
                        int *type, eph_t *eph, geph_t *geph, seph_t *seph)
 {
     gtime_t toc;
@@ -1211,7 +1422,7 @@ static int readrnxnavb(FILE *fp, const char *opt, double ver, int sys,
     /* set system mask */
     mask=set_sysmask(opt);
     
-    while (fgets(buff,MAXRNXLEN,fp)) {
+    while (rdline(rd,buff)) {
         
         if (i==0) {
             
@@ -1321,7 +1532,7 @@ static int add_seph(nav_t *nav, const seph_t *seph)
     return 1;
 }
 /* read rinex nav/gnav/geo nav -----------------------------------------------*/
-static int readrnxnav(FILE *fp, const char *opt, double ver, int sys,
+static int readrnxnav(rnxrd_t *rd, const char *opt, double ver, int sys,
                       nav_t *nav)
 {
     eph_t eph;
@@ -1334,7 +1545,7 @@ static int readrnxnav(FILE *fp, const char *opt, double ver, int sys,
     if (!nav) return 0;
     
     /* read rinex navigation data body */
-    while ((stat=readrnxnavb(fp,opt,ver,sys,&type,&eph,&geph,&seph))>=0) {
+    while ((stat=readrnxnavb(rd,opt,ver,sys,&type,&eph,&geph,&seph))>=0) {
         
         /* add ephemeris to navigation data */
         if (stat) {
@@ -1349,7 +1560,7 @@ static int readrnxnav(FILE *fp, const char *opt, double ver, int sys,
     return nav->n>0||nav->ng>0||nav->ns>0;
 }
 /* read rinex clock ----------------------------------------------------------*/
-static int readrnxclk(FILE *fp, const char *opt, int index, nav_t *nav)
+static int readrnxclk(rnxrd_t *rd, const char *opt, int index, nav_t *nav)
 {
     pclk_t *nav_pclk;
     gtime_t time;
@@ -1364,7 +1575,7 @@ static int readrnxclk(FILE *fp, const char *opt, int index, nav_t *nav)
     /* set system mask */
     mask=set_sysmask(opt);
     
-    while (fgets(buff,sizeof(buff),fp)) {
+    while (rdline(rd,buff)) {
         
         if (str2time(buff,8,26,&time)) {
             trace(2,"rinex clk invalid epoch: %34.34s\n",buff);
@@ -1403,9 +1614,9 @@ static int readrnxclk(FILE *fp, const char *opt, int index, nav_t *nav)
     return nav->nc>0;
 }
 /* read rinex file -----------------------------------------------------------*/
-static int readrnxfp(FILE *fp, gtime_t ts, gtime_t te, double tint,
-                     const char *opt, int flag, int index, char *type,
-                     obs_t *obs, nav_t *nav, sta_t *sta)
+static int readrnxfp(rnxrd_t *rd, const char *file, gtime_t ts, gtime_t te,
+                     double tint, const char *opt, int flag, int index,
+                     char *type, obs_t *obs, nav_t *nav, sta_t *sta)
 {
     double ver;
     int sys,tsys;
@@ -1415,39 +1626,426 @@ static int readrnxfp(FILE *fp, gtime_t ts, gtime_t te, double tint,
     trace(3,"readrnxfp: flag=%d index=%d\n",flag,index);
     
     /* read rinex header */
-    if (!readrnxh(fp,&ver,type,&sys,&tsys,tobs,nav,sta)) return 0;
+    if (!readrnxh(rd,&ver,type,&sys,&tsys,tobs,nav,sta)) return 0;
     
     /* flag=0:except for clock,1:clock */
     if ((!flag&&*type=='C')||(flag&&*type!='C')) return 0;
     
     /* read rinex body */
     switch (*type) {
-        case 'O': stat=readrnxobs(fp,ts,te,tint,opt,index,ver,tsys,tobs,obs); break;
-        case 'N': stat=readrnxnav(fp,opt,ver,sys    ,nav); break;
-        case 'G': stat=readrnxnav(fp,opt,ver,SYS_GLO,nav); break;
-        case 'H': stat=readrnxnav(fp,opt,ver,SYS_SBS,nav); break;
-        case 'J': stat=readrnxnav(fp,opt,ver,SYS_QZS,nav);  break; /* extension */
-        case 'L': stat=readrnxnav(fp,opt,ver,SYS_GAL,nav);  break; /* extension */
-        case 'C': stat=readrnxclk(fp,opt,index,nav); break;
+        case 'O': stat=readrnxobs(rd,file,ts,te,tint,opt,index,ver,tsys,tobs,
+                                  obs,NULL); break;
+        case 'N': stat=readrnxnav(rd,opt,ver,sys    ,nav); break;
+        case 'G': stat=readrnxnav(rd,opt,ver,SYS_GLO,nav); break;
+        case 'H': stat=readrnxnav(rd,opt,ver,SYS_SBS,nav); break;
+        case 'J': stat=readrnxnav(rd,opt,ver,SYS_QZS,nav);  break; /* extension */
+        case 'L': stat=readrnxnav(rd,opt,ver,SYS_GAL,nav);  break; /* extension */
+        case 'C': stat=readrnxclk(rd,opt,index,nav); break;
     }
     set_default_leaps();
     if(!stat)
         trace(2,"unsupported rinex type ver=%.2f type=%c\n",ver,*type);
     return stat;
 }
+/* rinex cache file path -----------------------------------------------------*/
+static char *cachepath(const char *file, const char *opt, char *path)
+{
+    unsigned int hash=2166136261u;
+    const char *p,*q;
+    
+    if (!*cachedir) return NULL;
+    
+    for (p=file;*p;p++) hash=(hash^(unsigned char)*p)*16777619u;
+    hash=(hash^'\n')*16777619u;
+    for (p=opt;p&&*p;p++) hash=(hash^(unsigned char)*p)*16777619u;
+    
+    if (!(q=strrchr(file,FILEPATHSEP))) q=file-1;
+    if (!strcmp(cachedir,"*")) {
+        sprintf(path,"%.*s%.255s.%08x.rnc",(int)(q+1-file),file,q+1,hash);
+    }
+    else {
+        sprintf(path,"%.768s%c%.255s.%08x.rnc",cachedir,FILEPATHSEP,q+1,hash);
+    }
+    return path;
+}
+/* size and modified time of file -------------------------------------------*/
+static int filestat(const char *file, double *fsize, double *mtime)
+{
+    struct stat st;
+    
+    if (stat(file,&st)) return 0;
+    *fsize=(double)st.st_size;
+    *mtime=(double)st.st_mtime;
+    return 1;
+}
+/* offsets of sections of rinex cache file -----------------------------------*/
+static size_t cacheoff(const int *n, int i)
+{
+    const size_t size[]={
+        1,sizeof(obsd_t),sizeof(int),sizeof(eph_t),sizeof(geph_t),
+        sizeof(seph_t)
+    };
+    size_t off=(sizeof(cachehead_t)+7)/8*8;
+    int j;
+    
+    for (j=0;j<i;j++) off+=(size[j]*n[j]+7)/8*8;
+    return off;
+}
+/* open rinex cache file -------------------------------------------------------
+* map rinex cache file and check the header by the rinex file and options
+* return : mapped file (NULL: no valid cache)
+*-----------------------------------------------------------------------------*/
+static const char *opencache(const char *path, const char *file,
+                             const char *opt, double fsize, double mtime,
+                             size_t *size, cache_t *c)
+{
+    const cachehead_t *h;
+    const char *map;
+    int i,m;
+    
+    if (!(map=maprnx(path,size))) return NULL;
+    
+    h=(const cachehead_t *)map;
+    if (*size<sizeof(cachehead_t)||strncmp(h->id,CACHEID,8)||
+        h->ver!=CACHEVER||h->size[0]!=(int)sizeof(obsd_t)||
+        h->size[1]!=(int)sizeof(eph_t)||h->size[2]!=(int)sizeof(geph_t)||
+        h->size[3]!=(int)sizeof(seph_t)||h->fsize!=fsize||h->mtime!=mtime||
+        strncmp(h->path,file,sizeof(h->path))||
+        strncmp(h->opt,opt?opt:"",sizeof(h->opt))) {
+        unmaprnx(map,*size);
+        return NULL;
+    }
+    for (i=0;i<6;i++) {
+        if ((c->n[i]=h->n[i])<0) break;
+    }
+    if (i<6||cacheoff(c->n,6)!=*size) {
+        trace(2,"rinex cache file error: %s\n",path);
+        unmaprnx(map,*size);
+        return NULL;
+    }
+    c->hdr =map+cacheoff(c->n,0);
+    c->obs =(const obsd_t *)(map+cacheoff(c->n,1));
+    c->ep  =(const int    *)(map+cacheoff(c->n,2));
+    c->eph =(const eph_t  *)(map+cacheoff(c->n,3));
+    c->geph=(const geph_t *)(map+cacheoff(c->n,4));
+    c->seph=(const seph_t *)(map+cacheoff(c->n,5));
+    
+    /* check number of obs data of epochs */
+    for (i=m=0;i<c->n[2];i++) {
+        if (c->ep[i]<=0||c->ep[i]>c->n[1]-m) break;
+        m+=c->ep[i];
+    }
+    if (i<c->n[2]||m!=c->n[1]) {
+        trace(2,"rinex cache file epoch error: %s\n",path);
+        unmaprnx(map,*size);
+        return NULL;
+    }
+    return map;
+}
+/* write rinex cache file ------------------------------------------------------
+* write rinex cache file to temporary file and rename it to the cache file
+*-----------------------------------------------------------------------------*/
+static void writecache(const char *path, const char *file, const char *opt,
+                       double fsize, double mtime, const cache_t *c)
+{
+    FILE *fp;
+    cachehead_t h;
+    const void *data[6];
+    const size_t size[]={
+        1,sizeof(obsd_t),sizeof(int),sizeof(eph_t),sizeof(geph_t),
+        sizeof(seph_t)
+    };
+    const char pad[8]={0};
+    char tmpfile[1100];
+    size_t off;
+    int i,stat=1;
+    
+    trace(3,"writecache: path=%s\n",path);
+    
+    memset(&h,0,sizeof(h));
+    memcpy(h.id,CACHEID,8);
+    h.ver=CACHEVER;
+    h.size[0]=(int)sizeof(obsd_t);
+    h.size[1]=(int)sizeof(eph_t);
+    h.size[2]=(int)sizeof(geph_t);
+    h.size[3]=(int)sizeof(seph_t);
+    for (i=0;i<6;i++) h.n[i]=c->n[i];
+    h.fsize=fsize;
+    h.mtime=mtime;
+    if (strlen(file)>=sizeof(h.path)||(opt&&strlen(opt)>=sizeof(h.opt))) return;
+    strcpy(h.path,file);
+    strcpy(h.opt,opt?opt:"");
+    
+    data[0]=c->hdr;  data[1]=c->obs;  data[2]=c->ep;
+    data[3]=c->eph;  data[4]=c->geph; data[5]=c->seph;
+    
+    sprintf(tmpfile,"%s.%08x",path,(unsigned int)(tickget()^(size_t)c));
+    
+    if (!(fp=fopen(tmpfile,"wb"))) {
+        trace(2,"rinex cache file open error: %s\n",tmpfile);
+        return;
+    }
+    stat=fwrite(&h,sizeof(h),1,fp)==1;
+    off=sizeof(h);
+    for (i=0;i<6&&stat;i++) {
+        
+        /* pad to the section and write data of the section */
+        if (off<cacheoff(c->n,i)) {
+            stat=fwrite(pad,cacheoff(c->n,i)-off,1,fp)==1;
+        }
+        off=cacheoff(c->n,i)+size[i]*c->n[i];
+        if (c->n[i]>0&&stat) stat=fwrite(data[i],size[i],c->n[i],fp)==(size_t)c->n[i];
+    }
+    if (stat&&off<cacheoff(c->n,6)) {
+        stat=fwrite(pad,cacheoff(c->n,6)-off,1,fp)==1;
+    }
+    fclose(fp);
+    
+    if (!stat) {
+        trace(2,"rinex cache file write error: %s\n",tmpfile);
+        remove(tmpfile);
+        return;
+    }
+#ifdef WIN32
+    remove(path);
+#endif
+    if (rename(tmpfile,path)) remove(tmpfile);
+}
+/* load obs data of rinex cache ----------------------------------------------
+* screen the obs data by time and restore the cycle-slips as readrnxobs()
+*-----------------------------------------------------------------------------*/
+static int loadobs(const cache_t *c, gtime_t ts, gtime_t te, double tint,
+                   int rcv, obs_t *obs)
+{
+    obsd_t *obs_data;
+    unsigned char slips[MAXSAT][NFREQ]={{0}};
+    int i,j,k,n,stat=0;
+    
+    if (!obs||rcv>MAXRCV) return 0;
+    
+    for (i=k=0;i<c->n[2];i++,k+=n) {
+        n=c->ep[i];
+        
+        /* save cycle-slip */
+        for (j=0;j<n;j++) saveslips(slips,c->obs+k+j);
+        
+        /* screen data by time */
+        if (!screent(c->obs[k].time,ts,te,tint)) continue;
+        
+        if (obs->nmax<obs->n+n) {
+            if (obs->nmax<=0) obs->nmax=NINCOBS;
+            while (obs->nmax<obs->n+n) obs->nmax*=2;
+            if (!(obs_data=(obsd_t *)realloc(obs->data,sizeof(obsd_t)*obs->nmax))) {
+                trace(1,"loadobs: memalloc error n=%dx%d\n",sizeof(obsd_t),obs->nmax);
+                free(obs->data); obs->data=NULL; obs->n=obs->nmax=0;
+                return -1;
+            }
+            obs->data=obs_data;
+        }
+        memcpy(obs->data+obs->n,c->obs+k,sizeof(obsd_t)*n);
+        
+        for (j=0;j<n;j++,obs->n++) {
+            
+            /* restore cycle-slip */
+            restslips(slips,obs->data+obs->n);
+            
+            obs->data[obs->n].rcv=(unsigned char)rcv;
+        }
+        stat=1;
+    }
+    return stat;
+}
+/* load nav data of rinex cache ----------------------------------------------*/
+static int loadnav(const cache_t *c, nav_t *nav)
+{
+    eph_t *nav_eph;
+    geph_t *nav_geph;
+    seph_t *nav_seph;
+    
+    if (!nav) return 0;
+    
+    if (c->n[3]>0) {
+        if (nav->nmax<nav->n+c->n[3]) {
+            nav->nmax=nav->n+c->n[3]+1024;
+            if (!(nav_eph=(eph_t *)realloc(nav->eph,sizeof(eph_t)*nav->nmax))) {
+                trace(1,"loadnav malloc error: n=%d\n",nav->nmax);
+                free(nav->eph); nav->eph=NULL; nav->n=nav->nmax=0;
+                return 0;
+            }
+            nav->eph=nav_eph;
+        }
+        memcpy(nav->eph+nav->n,c->eph,sizeof(eph_t)*c->n[3]);
+        nav->n+=c->n[3];
+    }
+    if (c->n[4]>0) {
+        if (nav->ngmax<nav->ng+c->n[4]) {
+            nav->ngmax=nav->ng+c->n[4]+1024;
+            if (!(nav_geph=(geph_t *)realloc(nav->geph,sizeof(geph_t)*nav->ngmax))) {
+                trace(1,"loadnav malloc error: n=%d\n",nav->ngmax);
+                free(nav->geph); nav->geph=NULL; nav->ng=nav->ngmax=0;
+                return 0;
+            }
+            nav->geph=nav_geph;
+        }
+        memcpy(nav->geph+nav->ng,c->geph,sizeof(geph_t)*c->n[4]);
+        nav->ng+=c->n[4];
+    }
+    if (c->n[5]>0) {
+        if (nav->nsmax<nav->ns+c->n[5]) {
+            nav->nsmax=nav->ns+c->n[5]+1024;
+            if (!(nav_seph=(seph_t *)realloc(nav->seph,sizeof(seph_t)*nav->nsmax))) {
+                trace(1,"loadnav malloc error: n=%d\n",nav->nsmax);
+                free(nav->seph); nav->seph=NULL; nav->ns=nav->nsmax=0;
+                return 0;
+            }
+            nav->seph=nav_seph;
+        }
+        memcpy(nav->seph+nav->ns,c->seph,sizeof(seph_t)*c->n[5]);
+        nav->ns+=c->n[5];
+    }
+    return nav->n>0||nav->ng>0||nav->ns>0;
+}
+/* load rinex cache ------------------------------------------------------------
+* decode the header lines and load the obs or nav data of rinex cache as
+* readrnxfp()
+*-----------------------------------------------------------------------------*/
+static int loadcache(const cache_t *c, gtime_t ts, gtime_t te, double tint,
+                     int index, char *type, obs_t *obs, nav_t *nav, sta_t *sta)
+{
+    rnxrd_t rd={0};
+    double ver;
+    int sys,tsys,stat;
+    char tobs[NUMSYS][MAXOBSTYPE][4]={{""}};
+    
+    trace(3,"loadcache: index=%d nobs=%d neph=%d\n",index,c->n[1],c->n[3]);
+    
+    rd.p=c->hdr;
+    rd.end=c->hdr+c->n[0];
+    
+    if (!readrnxh(&rd,&ver,type,&sys,&tsys,tobs,nav,sta)) return 0;
+    
+    stat=*type=='O'?loadobs(c,ts,te,tint,index,obs):loadnav(c,nav);
+    
+    set_default_leaps();
+    return stat;
+}
+/* read rinex file by rinex cache ----------------------------------------------
+* read all data of rinex file, write them to rinex cache file and load them as
+* readrnxfp(). mfile is the path of the file mapped for obs data (NULL: no map)
+*-----------------------------------------------------------------------------*/
+static int readrnxcache(rnxrd_t *rd, const char *file, const char *mfile,
+                        const char *path, double fsize, double mtime,
+                        gtime_t ts, gtime_t te, double tint, const char *opt,
+                        int index, char *type, obs_t *obs, nav_t *nav,
+                        sta_t *sta)
+{
+    gtime_t t0={0};
+    rnxbuf_t hdr={0},eps={0};
+    obs_t obsc={0};
+    nav_t *navc;
+    cache_t c={0};
+    double ver;
+    int sys,tsys,stat;
+    char tobs[NUMSYS][MAXOBSTYPE][4]={{""}};
+    
+    trace(3,"readrnxcache: file=%s\n",file);
+    
+    if (!(navc=(nav_t *)calloc(1,sizeof(nav_t)))) return -1;
+    
+    /* read rinex header with record of the lines */
+    rd->rec=&hdr;
+    stat=readrnxh(rd,&ver,type,&sys,&tsys,tobs,navc,NULL);
+    rd->rec=NULL;
+    
+    if (!stat||!strchr("ONGHJL",*type)) {
+        free(hdr.buff); free(navc);
+        if (stat&&*type!='C') set_default_leaps();
+        return 0;
+    }
+    /* read all data of rinex body */
+    switch (*type) {
+        case 'O': stat=readrnxobs(rd,mfile,t0,t0,0.0,opt,1,ver,tsys,tobs,
+                                  &obsc,&eps); break;
+        case 'N': stat=readrnxnav(rd,opt,ver,sys    ,navc); break;
+        case 'G': stat=readrnxnav(rd,opt,ver,SYS_GLO,navc); break;
+        case 'H': stat=readrnxnav(rd,opt,ver,SYS_SBS,navc); break;
+        case 'J': stat=readrnxnav(rd,opt,ver,SYS_QZS,navc); break;
+        case 'L': stat=readrnxnav(rd,opt,ver,SYS_GAL,navc); break;
+    }
+    if (stat>=0&&!hdr.err&&!eps.err&&!(rd->dc&&rd->dc->err)) {
+        c.hdr=hdr.buff; c.n[0]=(int)hdr.n;
+        c.obs=obsc.data; c.n[1]=obsc.n;
+        c.ep=(const int *)eps.buff; c.n[2]=(int)(eps.n/sizeof(int));
+        c.eph=navc->eph; c.n[3]=navc->n;
+        c.geph=navc->geph; c.n[4]=navc->ng;
+        c.seph=navc->seph; c.n[5]=navc->ns;
+        
+        /* write rinex cache file and load the data */
+        writecache(path,file,opt,fsize,mtime,&c);
+        stat=loadcache(&c,ts,te,tint,index,type,obs,nav,sta);
+    }
+    else {
+        set_default_leaps();
+        stat=-1;
+    }
+    free(hdr.buff); free(eps.buff); free(obsc.data);
+    free(navc->eph); free(navc->geph); free(navc->seph); free(navc);
+    return stat;
+}
 /* uncompress and read rinex file --------------------------------------------*/
 static int readrnxfile(const char *file, gtime_t ts, gtime_t te, double tint,
                        const char *opt, int flag, int index, char *type,
                        obs_t *obs, nav_t *nav, sta_t *sta)
 {
     FILE *fp;
-    int cstat,stat;
-    char tmpfile[1024];
+    decomp_t dc;
+    rnxrd_t rd={0};
+    cache_t c;
+    const char *map;
+    size_t size;
+    double fsize=0.0,mtime=0.0;
+    int cstat,stat,n[5]={0};
+    char tmpfile[1024],path[1100],*cache=NULL;
     
     trace(3,"readrnxfile: file=%s flag=%d index=%d\n",file,flag,index);
     
     if (sta) init_sta(sta);
     
+    /* load rinex cache if the cache file is valid */
+    if (!flag&&cachepath(file,opt,path)&&filestat(file,&fsize,&mtime)) {
+        if ((map=opencache(path,file,opt,fsize,mtime,&size,&c))) {
+            stat=loadcache(&c,ts,te,tint,index,type,obs,nav,sta);
+            unmaprnx(map,size);
+            return stat;
+        }
+        cache=path;
+    }
+    /* decompress file in-process except for tar file */
+    if (!strstr(file,".tar")&&(cstat=opendecomp(&dc,file))!=-2) {
+        if (cstat<0) return 0;
+        if (cstat>0) {
+            rd.dc=&dc;
+            if (obs) n[0]=obs->n;
+            if (nav) {n[1]=nav->n; n[2]=nav->ng; n[3]=nav->ns; n[4]=nav->nc;}
+            if (cache) {
+                stat=readrnxcache(&rd,file,NULL,cache,fsize,mtime,ts,te,tint,
+                                  opt,index,type,obs,nav,sta);
+            }
+            else {
+                stat=readrnxfp(&rd,NULL,ts,te,tint,opt,flag,index,type,obs,
+                               nav,sta);
+            }
+            /* discard data of truncated or corrupted file */
+            if (dc.err) {
+                trace(2,"rinex file decompress error: %s\n",file);
+                if (obs) obs->n=n[0];
+                if (nav) {nav->n=n[1]; nav->ng=n[2]; nav->ns=n[3]; nav->nc=n[4];}
+                stat=0;
+            }
+            closedecomp(&dc);
+            return stat;
+        }
+    }
     /* uncompress file */
     if ((cstat=uncompress(file,tmpfile))<0) {
         trace(2,"rinex file uncompact error: %s\n",file);
@@ -1458,8 +2056,15 @@ static int readrnxfile(const char *file, gtime_t ts, gtime_t te, double tint,
         return 0;
     }
     /* read rinex file */
-    stat=readrnxfp(fp,ts,te,tint,opt,flag,index,type,obs,nav,sta);
-    
+    rd.fp=fp;
+    if (cache) {
+        stat=readrnxcache(&rd,file,cstat?tmpfile:file,cache,fsize,mtime,ts,
+                          te,tint,opt,index,type,obs,nav,sta);
+    }
+    else {
+        stat=readrnxfp(&rd,cstat?tmpfile:file,ts,te,tint,opt,flag,index,type,
+                       obs,nav,sta);
+    }
     fclose(fp);
     
     /* delete temporary file */
@@ -1504,6 +2109,7 @@ extern int readrnxt(const char *file, int rcv, gtime_t ts, gtime_t te,
                     double tint, const char *opt, obs_t *obs, nav_t *nav,
                     sta_t *sta)
 {
+    rnxrd_t rd={0};
     int i,n,stat=0;
     const char *p;
     char type=' ',*files[MAXEXFILE]={0};
@@ -1511,7 +2117,8 @@ extern int readrnxt(const char *file, int rcv, gtime_t ts, gtime_t te,
     trace(3,"readrnxt: file=%s rcv=%d\n",file,rcv);
     
     if (!*file) {
-        return readrnxfp(stdin,ts,te,tint,opt,0,1,&type,obs,nav,sta);
+        rd.fp=stdin;
+        return readrnxfp(&rd,NULL,ts,te,tint,opt,0,1,&type,obs,nav,sta);
     }
     for (i=0;i<MAXEXFILE;i++) {
         if (!(files[i]=(char *)malloc(1024))) {
@@ -1546,6 +2153,244 @@ extern int readrnx(const char *file, int rcv, const char *opt, obs_t *obs,
     
     return readrnxt(file,rcv,t,t,0.0,opt,obs,nav,sta);
 }
+/* set directory of rinex cache files ------------------------------------------
+* set directory of rinex cache files used by readrnxt()
+* args   : char   *dir     I      directory of rinex cache files
+*                                 ("": no cache, "*": directory of rinex file)
+* return : none
+* notes  : the obs and nav data of a rinex file (except for clock) are written
+*          to a cache file <dir>/<file name>.<hash>.rnc when the file is read,
+*          and loaded from the cache file instead of reading the rinex file
+*          later. the cache file is keyed by the path of the rinex file and the
+*          rinex options and it is valid only for the size and the modified
+*          time of the rinex file and the build (version and structure sizes).
+*          the cache file holds all the data of the rinex file and the data
+*          are screened by time and interval in loading.
+*          the directory is shared by all the threads. set it before reading.
+*-----------------------------------------------------------------------------*/
+extern void setrnxcache(const char *dir)
+{
+    trace(3,"setrnxcache: dir=%s\n",dir);
+    
+    strncpy(cachedir,dir?dir:"",sizeof(cachedir)-1);
+}
+/* open file of rinex obs stream ---------------------------------------------*/
+static int openfile_rnxobs(rnxobs_t *rnx, const char *file, rnxrd_t *rd)
+{
+    int cstat;
+    
+    memset(rd,0,sizeof(rnxrd_t));
+    
+    if ((cstat=opendecomp(&rnx->dc,file))<0) return 0;
+    
+    if (cstat>0) rd->dc=&rnx->dc;
+    else if ((rnx->fp=fopen(file,"r"))) rd->fp=rnx->fp;
+    else return 0;
+    return 1;
+}
+/* close file of rinex obs stream --------------------------------------------*/
+static void closefile_rnxobs(rnxobs_t *rnx)
+{
+    if (rnx->fp) fclose(rnx->fp);
+    rnx->fp=NULL;
+    if (rnx->dc.fp) closedecomp(&rnx->dc);
+}
+/* open rinex obs stream -------------------------------------------------------
+* open rinex obs files as a stream of observation epochs
+* args   : rnxobs_t *rnx I      rinex obs stream
+*          char  **files I      files (wild-card * expanded)
+*          int   n       I      number of files
+*          int   rcv     I      receiver number for obs data
+*         (gtime_t ts)   I      observation time start (ts.time==0: no limit)
+*         (gtime_t te)   I      observation time end   (te.time==0: no limit)
+*         (double tint)  I      observation time interval (s) (0:all)
+*          char  *opt    I      rinex options (see readrnxt())
+* return : number of obs files (-1: error)
+* notes  : files other than rinex obs are skipped. the epochs are input in the
+*          order of the files, which should be given in time order.
+*          compressed files are decompressed in-process while input. tar files
+*          and unsupported compressions are uncompressed to temporary files
+*          deleted by close_rnxobs().
+*-----------------------------------------------------------------------------*/
+extern int open_rnxobs(rnxobs_t *rnx, char **files, int n, int rcv,
+                       gtime_t ts, gtime_t te, double tint, const char *opt)
+{
+    decomp_t dc;
+    rnxrd_t rd;
+    double ver;
+    int i,j,m,cstat,sys,tsys;
+    char type,tobs[NUMSYS][MAXOBSTYPE][4],tmpfile[1024],*paths[MAXEXFILE]={0};
+    char **rnx_files;
+    unsigned char *rnx_tmp;
+    
+    trace(3,"open_rnxobs: n=%d rcv=%d\n",n,rcv);
+    
+    memset(rnx,0,sizeof(rnxobs_t));
+    rnx->rcv=rcv; rnx->ts=ts; rnx->te=te; rnx->tint=tint;
+    if (opt) strncpy(rnx->opt,opt,255);
+    
+    for (i=0;i<MAXEXFILE;i++) {
+        if (!(paths[i]=(char *)malloc(1024))) {
+            for (i--;i>=0;i--) free(paths[i]);
+            return -1;
+        }
+    }
+    for (i=0;i<n;i++) {
+        
+        /* expand wild-card */
+        if ((m=expath(files[i],paths,MAXEXFILE))<=0) continue;
+        
+        for (j=0;j<m;j++) {
+            
+            /* uncompress tar file or unsupported compression */
+            cstat=0;
+            if (strstr(paths[j],".tar")||opendecomp(&dc,paths[j])==-2) {
+                if ((cstat=uncompress(paths[j],tmpfile))<0) {
+                    trace(2,"rinex file uncompact error: %s\n",paths[j]);
+                    continue;
+                }
+            }
+            else closedecomp(&dc);
+            
+            if (!openfile_rnxobs(rnx,cstat?tmpfile:paths[j],&rd)) {
+                trace(2,"rinex file open error: %s\n",cstat?tmpfile:paths[j]);
+                if (cstat) remove(tmpfile);
+                continue;
+            }
+            type=' ';
+            readrnxh(&rd,&ver,&type,&sys,&tsys,tobs,NULL,NULL);
+            closefile_rnxobs(rnx);
+            
+            if (type!='O') {
+                if (cstat) remove(tmpfile);
+                continue;
+            }
+            if (rnx->nmax<=rnx->n) {
+                rnx->nmax=rnx->nmax<=0?16:rnx->nmax*2;
+                rnx_files=(char **)realloc(rnx->files,sizeof(char *)*rnx->nmax);
+                rnx_tmp=(unsigned char *)realloc(rnx->tmp,rnx->nmax);
+                if (rnx_files) rnx->files=rnx_files;
+                if (rnx_tmp  ) rnx->tmp  =rnx_tmp;
+                if (!rnx_files||!rnx_tmp) {
+                    trace(1,"open_rnxobs: memory allocation error\n");
+                    if (cstat) remove(tmpfile);
+                    for (j=0;j<MAXEXFILE;j++) free(paths[j]);
+                    close_rnxobs(rnx);
+                    return -1;
+                }
+            }
+            if (!(rnx->files[rnx->n]=(char *)malloc(1024))) {
+                if (cstat) remove(tmpfile);
+                for (j=0;j<MAXEXFILE;j++) free(paths[j]);
+                close_rnxobs(rnx);
+                return -1;
+            }
+            strcpy(rnx->files[rnx->n],cstat?tmpfile:paths[j]);
+            rnx->tmp[rnx->n++]=(unsigned char)cstat;
+        }
+    }
+    for (i=0;i<MAXEXFILE;i++) free(paths[i]);
+    
+    return rnx->n;
+}
+/* open next file of rinex obs stream ----------------------------------------*/
+static int nextfile_rnxobs(rnxobs_t *rnx, rnxrd_t *rd)
+{
+    char type=' ';
+    int sys;
+    
+    for (;rnx->ifile<rnx->n;rnx->ifile++) {
+        if (!openfile_rnxobs(rnx,rnx->files[rnx->ifile],rd)) {
+            trace(2,"rinex file open error: %s\n",rnx->files[rnx->ifile]);
+            continue;
+        }
+        memset(rnx->tobs,0,sizeof(rnx->tobs));
+        memset(rnx->slips,0,sizeof(rnx->slips));
+        
+        if (readrnxh(rd,&rnx->ver,&type,&sys,&rnx->tsys,rnx->tobs,NULL,NULL)&&
+            type=='O') {
+            return 1;
+        }
+        closefile_rnxobs(rnx);
+    }
+    return 0;
+}
+/* input rinex obs stream ------------------------------------------------------
+* input next observation epoch from rinex obs stream
+* args   : rnxobs_t *rnx I      rinex obs stream
+*          obsd_t *data  O      observation data of the epoch (MAXOBS)
+* return : number of observation data (-1: end of stream)
+* notes  : the epochs are screened by time and the cycle-slips in the skipped
+*          epochs are restored as readrnxt()
+*-----------------------------------------------------------------------------*/
+extern int input_rnxobs(rnxobs_t *rnx, obsd_t *data)
+{
+    rnxrd_t rd={0};
+    int i,n,flag=0;
+    
+    trace(4,"input_rnxobs: rcv=%d ifile=%d\n",rnx->rcv,rnx->ifile);
+    
+    for (;;) {
+        if (rnx->fp||rnx->dc.fp) {
+            rd.fp=rnx->fp;
+            rd.dc=rnx->dc.fp?&rnx->dc:NULL;
+        }
+        else if (!nextfile_rnxobs(rnx,&rd)) return -1;
+        
+        while ((n=readrnxobsb(&rd,rnx->opt,rnx->ver,rnx->tobs,&flag,
+                              data))>=0) {
+            for (i=0;i<n;i++) {
+                
+                /* utc -> gpst */
+                if (rnx->tsys==TSYS_UTC) data[i].time=utc2gpst(data[i].time);
+                
+                /* save cycle-slip */
+                saveslips(rnx->slips,data+i);
+            }
+            /* screen data by time */
+            if (n<=0||!screent(data[0].time,rnx->ts,rnx->te,rnx->tint)) continue;
+            
+            for (i=0;i<n;i++) {
+                
+                /* restore cycle-slip */
+                restslips(rnx->slips,data+i);
+                
+                data[i].rcv=(unsigned char)rnx->rcv;
+            }
+            return n;
+        }
+        if (rnx->dc.fp&&rnx->dc.err) {
+            trace(2,"rinex obs stream decompress error: ifile=%d\n",rnx->ifile);
+        }
+        closefile_rnxobs(rnx);
+        rnx->ifile++;
+    }
+}
+/* rewind rinex obs stream ---------------------------------------------------*/
+extern void rewind_rnxobs(rnxobs_t *rnx)
+{
+    trace(3,"rewind_rnxobs:\n");
+    
+    closefile_rnxobs(rnx);
+    rnx->ifile=0;
+}
+/* close rinex obs stream ----------------------------------------------------*/
+extern void close_rnxobs(rnxobs_t *rnx)
+{
+    int i;
+    
+    trace(3,"close_rnxobs:\n");
+    
+    closefile_rnxobs(rnx);
+    
+    for (i=0;i<rnx->n;i++) {
+        if (rnx->tmp[i]) remove(rnx->files[i]);
+        free(rnx->files[i]);
+    }
+    free(rnx->files); rnx->files=NULL;
+    free(rnx->tmp); rnx->tmp=NULL;
+    rnx->n=rnx->nmax=rnx->ifile=0;
+}
 /* compare precise clock -----------------------------------------------------*/
 static int cmppclk(const void *p1, const void *p2)
 {
@@ -1696,14 +2541,17 @@ extern void free_rnxctr(rnxctr_t *rnx)
 extern int open_rnxctr(rnxctr_t *rnx, FILE *fp)
 {
     const char *rnxtypes="ONGLJHC";
+    rnxrd_t rd={0};
     double ver;
     char type,tobs[6][MAXOBSTYPE][4]={{""}};
     int i,j,sys,tsys;
     
     trace(3,"open_rnxctr:\n");
     
+    rd.fp=fp;
+    
     /* read rinex header from file */
-    if (!readrnxh(fp,&ver,&type,&sys,&tsys,tobs,&rnx->nav,&rnx->sta)) {
+    if (!readrnxh(&rd,&ver,&type,&sys,&tsys,tobs,&rnx->nav,&rnx->sta)) {
         trace(2,"open_rnxctr: rinex header read error\n");
         return 0;
     }
@@ -1733,13 +2581,16 @@ extern int input_rnxctr(rnxctr_t *rnx, FILE *fp)
     eph_t eph={0};
     geph_t geph={0};
     seph_t seph={0};
+    rnxrd_t rd={0};
     int n,sys,stat,flag,prn,type;
     
     trace(4,"input_rnxctr:\n");
     
+    rd.fp=fp;
+    
     /* read rinex obs data */
     if (rnx->type=='O') {
-        if ((n=readrnxobsb(fp,rnx->opt,rnx->ver,rnx->tobs,&flag,
+        if ((n=readrnxobsb(&rd,rnx->opt,rnx->ver,rnx->tobs,&flag,
                            rnx->obs.data))<=0) {
             rnx->obs.n=0;
             return n<0?-2:0;
@@ -1757,7 +2608,8 @@ extern int input_rnxctr(rnxctr_t *rnx, FILE *fp)
         case 'J': sys=SYS_QZS ; break; /* extension */
         default: return 0;
     }
-    if ((stat=readrnxnavb(fp,rnx->opt,rnx->ver,sys,&type,&eph,&geph,&seph))<=0) {
+    if ((stat=readrnxnavb(&rd,rnx->opt,rnx->ver,sys,&type,&eph,&geph,
+                          &seph))<=0) {
         return stat<0?-2:0;
     }
     if (type==1) {
@@ -1667,43 +1667,45 @@ static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
                            msm_h_t *h, int *hsize)
 {
     msm_h_t h0={0};
+    bitstr_t bs;
     double tow,tod;
     char *msg;
-    int i=24,j,dow,mask,staid,type,ncell=0;
+    int j,dow,mask,staid,type,ncell=0;
     
-    type=getbitu(rtcm->buff,i,12); i+=12;
+    bsinit(&bs,rtcm->buff,24);
+    type=bsgetu(&bs,12);
     
     *h=h0;
-    if (i+157<=rtcm->len*8) {
-        staid     =getbitu(rtcm->buff,i,12);       i+=12;
+    if (bs.pos+157<=rtcm->len*8) {
+        staid     =bsgetu(&bs,12);
         
         if (sys==SYS_GLO) {
-            dow   =getbitu(rtcm->buff,i, 3);       i+= 3;
-            tod   =getbitu(rtcm->buff,i,27)*0.001; i+=27;
+            dow   =bsgetu(&bs,3);
+            tod   =bsgetu(&bs,27)*0.001;
             adjday_glot(rtcm,tod);
         }
         else if (sys==SYS_CMP) {
-            tow   =getbitu(rtcm->buff,i,30)*0.001; i+=30;
+            tow   =bsgetu(&bs,30)*0.001;
             tow+=14.0; /* BDT -> GPST */
             adjweek(rtcm,tow);
         }
         else {
-            tow   =getbitu(rtcm->buff,i,30)*0.001; i+=30;
+            tow   =bsgetu(&bs,30)*0.001;
             adjweek(rtcm,tow);
         }
-        *sync     =getbitu(rtcm->buff,i, 1);       i+= 1;
-        *iod      =getbitu(rtcm->buff,i, 3);       i+= 3;
-        h->time_s =getbitu(rtcm->buff,i, 7);       i+= 7;
-        h->clk_str=getbitu(rtcm->buff,i, 2);       i+= 2;
-        h->clk_ext=getbitu(rtcm->buff,i, 2);       i+= 2;
-        h->smooth =getbitu(rtcm->buff,i, 1);       i+= 1;
-        h->tint_s =getbitu(rtcm->buff,i, 3);       i+= 3;
+        *sync     =bsgetu(&bs,1);
+        *iod      =bsgetu(&bs,3);
+        h->time_s =bsgetu(&bs,7);
+        h->clk_str=bsgetu(&bs,2);
+        h->clk_ext=bsgetu(&bs,2);
+        h->smooth =bsgetu(&bs,1);
+        h->tint_s =bsgetu(&bs,3);
         for (j=1;j<=64;j++) {
-            mask=getbitu(rtcm->buff,i,1); i+=1;
+            mask=bsgetu(&bs,1);
             if (mask) h->sats[h->nsat++]=j;
         }
         for (j=1;j<=32;j++) {
-            mask=getbitu(rtcm->buff,i,1); i+=1;
+            mask=bsgetu(&bs,1);
             if (mask) h->sigs[h->nsig++]=j;
         }
     }
@@ -1719,16 +1721,16 @@ static int decode_msm_head(rtcm_t *rtcm, int sys, int *sync, int *iod,
               type,h->nsat,h->nsig);
         return -1;
     }
-    if (i+h->nsat*h->nsig>rtcm->len*8) {
+    if (bs.pos+h->nsat*h->nsig>rtcm->len*8) {
         trace(2,"rtcm3 %d length error: len=%d nsat=%d nsig=%d\n",type,
               rtcm->len,h->nsat,h->nsig);
         return -1;
     }
     for (j=0;j<h->nsat*h->nsig;j++) {
-        h->cellmask[j]=getbitu(rtcm->buff,i,1); i+=1;
+        h->cellmask[j]=bsgetu(&bs,1);
         if (h->cellmask[j]) ncell++;
     }
-    *hsize=i;
+    *hsize=bs.pos;
     
     trace(4,"decode_head_msm: time=%s sys=%d staid=%d nsat=%d nsig=%d sync=%d iod=%d ncell=%d\n",
           time_str(rtcm->time,2),sys,staid,h->nsat,h->nsig,*sync,*iod,ncell);
@@ -1753,6 +1755,7 @@ static int decode_msm0(rtcm_t *rtcm, int sys)
 static int decode_msm4(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
+    bitstr_t bs;
     double r[64],pr[64],cp[64],cnr[64];
     int i,j,type,sync,iod,ncell,rng,rng_m,prv,cpv,lock[64],half[64];
     
@@ -1770,31 +1773,32 @@ static int decode_msm4(rtcm_t *rtcm, int sys)
     for (j=0;j<ncell;j++) pr[j]=cp[j]=-1E16;
     
     /* decode satellite data */
+    bsinit(&bs,rtcm->buff,i);
     for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
+        rng  =bsgetu(&bs,8);
         if (rng!=255) r[j]=rng*RANGE_MS;
     }
     for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
+        rng_m=bsgetu(&bs,10);
         if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
     }
     /* decode signal data */
     for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,15); i+=15;
+        prv=bsgets(&bs,15);
         if (prv!=-16384) pr[j]=prv*P2_24*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,22); i+=22;
+        cpv=bsgets(&bs,22);
         if (cpv!=-2097152) cp[j]=cpv*P2_29*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,4); i+=4;
+        lock[j]=bsgetu(&bs,4);
     }
     for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
+        half[j]=bsgetu(&bs,1);
     }
     for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,6)*1.0; i+=6;
+        cnr[j]=bsgetu(&bs,6)*1.0;
     }
     /* save obs data in msm message */
     save_msm_obs(rtcm,sys,&h,r,pr,cp,NULL,NULL,cnr,lock,NULL,half);
@@ -1806,6 +1810,7 @@ static int decode_msm4(rtcm_t *rtcm, int sys)
 static int decode_msm5(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
+    bitstr_t bs;
     double r[64],rr[64],pr[64],cp[64],rrf[64],cnr[64];
     int i,j,type,sync,iod,ncell,rng,rng_m,rate,prv,cpv,rrv,lock[64];
     int ex[64],half[64];
@@ -1826,41 +1831,42 @@ static int decode_msm5(rtcm_t *rtcm, int sys)
     for (j=0;j<ncell;j++) pr[j]=cp[j]=rrf[j]=-1E16;
     
     /* decode satellite data */
+    bsinit(&bs,rtcm->buff,i);
     for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
+        rng  =bsgetu(&bs,8);
         if (rng!=255) r[j]=rng*RANGE_MS;
     }
     for (j=0;j<h.nsat;j++) { /* extended info */
-        ex[j]=getbitu(rtcm->buff,i, 4); i+= 4;
+        ex[j]=bsgetu(&bs,4);
     }
     for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
+        rng_m=bsgetu(&bs,10);
         if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
     }
     for (j=0;j<h.nsat;j++) { /* phaserangerate */
-        rate =getbits(rtcm->buff,i,14); i+=14;
+        rate =bsgets(&bs,14);
         if (rate!=-8192) rr[j]=rate*1.0;
     }
     /* decode signal data */
     for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,15); i+=15;
+        prv=bsgets(&bs,15);
         if (prv!=-16384) pr[j]=prv*P2_24*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,22); i+=22;
+        cpv=bsgets(&bs,22);
         if (cpv!=-2097152) cp[j]=cpv*P2_29*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,4); i+=4;
+        lock[j]=bsgetu(&bs,4);
     }
     for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
+        half[j]=bsgetu(&bs,1);
     }
     for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,6)*1.0; i+=6;
+        cnr[j]=bsgetu(&bs,6)*1.0;
     }
     for (j=0;j<ncell;j++) { /* phaserangerate */
-        rrv=getbits(rtcm->buff,i,15); i+=15;
+        rrv=bsgets(&bs,15);
         if (rrv!=-16384) rrf[j]=rrv*0.0001;
     }
     /* save obs data in msm message */
@@ -1873,6 +1879,7 @@ static int decode_msm5(rtcm_t *rtcm, int sys)
 static int decode_msm6(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
+    bitstr_t bs;
     double r[64],pr[64],cp[64],cnr[64];
     int i,j,type,sync,iod,ncell,rng,rng_m,prv,cpv,lock[64],half[64];
     
@@ -1890,31 +1897,32 @@ static int decode_msm6(rtcm_t *rtcm, int sys)
     for (j=0;j<ncell;j++) pr[j]=cp[j]=-1E16;
     
     /* decode satellite data */
+    bsinit(&bs,rtcm->buff,i);
     for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
+        rng  =bsgetu(&bs,8);
         if (rng!=255) r[j]=rng*RANGE_MS;
     }
     for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
+        rng_m=bsgetu(&bs,10);
         if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
     }
     /* decode signal data */
     for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,20); i+=20;
+        prv=bsgets(&bs,20);
         if (prv!=-524288) pr[j]=prv*P2_29*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,24); i+=24;
+        cpv=bsgets(&bs,24);
         if (cpv!=-8388608) cp[j]=cpv*P2_31*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,10); i+=10;
+        lock[j]=bsgetu(&bs,10);
     }
     for (j=0;j<ncell;j++) { /* half-cycle ambiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
+        half[j]=bsgetu(&bs,1);
     }
     for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,10)*0.0625; i+=10;
+        cnr[j]=bsgetu(&bs,10)*0.0625;
     }
     /* save obs data in msm message */
     save_msm_obs(rtcm,sys,&h,r,pr,cp,NULL,NULL,cnr,lock,NULL,half);
@@ -1926,6 +1934,7 @@ static int decode_msm6(rtcm_t *rtcm, int sys)
 static int decode_msm7(rtcm_t *rtcm, int sys)
 {
     msm_h_t h={0};
+    bitstr_t bs;
     double r[64],rr[64],pr[64],cp[64],rrf[64],cnr[64];
     int i,j,type,sync,iod,ncell,rng,rng_m,rate,prv,cpv,rrv,lock[64];
     int ex[64],half[64];
@@ -1946,41 +1955,42 @@ static int decode_msm7(rtcm_t *rtcm, int sys)
     for (j=0;j<ncell;j++) pr[j]=cp[j]=rrf[j]=-1E16;
     
     /* decode satellite data */
+    bsinit(&bs,rtcm->buff,i);
     for (j=0;j<h.nsat;j++) { /* range */
-        rng  =getbitu(rtcm->buff,i, 8); i+= 8;
+        rng  =bsgetu(&bs,8);
         if (rng!=255) r[j]=rng*RANGE_MS;
     }
     for (j=0;j<h.nsat;j++) { /* extended info */
-        ex[j]=getbitu(rtcm->buff,i, 4); i+= 4;
+        ex[j]=bsgetu(&bs,4);
     }
     for (j=0;j<h.nsat;j++) {
-        rng_m=getbitu(rtcm->buff,i,10); i+=10;
+        rng_m=bsgetu(&bs,10);
         if (r[j]!=0.0) r[j]+=rng_m*P2_10*RANGE_MS;
     }
     for (j=0;j<h.nsat;j++) { /* phaserangerate */
-        rate =getbits(rtcm->buff,i,14); i+=14;
+        rate =bsgets(&bs,14);
         if (rate!=-8192) rr[j]=rate*1.0;
     }
     /* decode signal data */
     for (j=0;j<ncell;j++) { /* pseudorange */
-        prv=getbits(rtcm->buff,i,20); i+=20;
+        prv=bsgets(&bs,20);
         if (prv!=-524288) pr[j]=prv*P2_29*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* phaserange */
-        cpv=getbits(rtcm->buff,i,24); i+=24;
+        cpv=bsgets(&bs,24);
         if (cpv!=-8388608) cp[j]=cpv*P2_31*RANGE_MS;
     }
     for (j=0;j<ncell;j++) { /* lock time */
-        lock[j]=getbitu(rtcm->buff,i,10); i+=10;
+        lock[j]=bsgetu(&bs,10);
     }
     for (j=0;j<ncell;j++) { /* half-cycle amiguity */
-        half[j]=getbitu(rtcm->buff,i,1); i+=1;
+        half[j]=bsgetu(&bs,1);
     }
     for (j=0;j<ncell;j++) { /* cnr */
-        cnr[j]=getbitu(rtcm->buff,i,10)*0.0625; i+=10;
+        cnr[j]=bsgetu(&bs,10)*0.0625;
     }
     for (j=0;j<ncell;j++) { /* phaserangerate */
-        rrv=getbits(rtcm->buff,i,15); i+=15;
+        rrv=bsgets(&bs,15);
         if (rrv!=-16384) rrf[j]=rrv*0.0001;
     }
     /* save obs data in msm message */
@@ -6,6 +6,7 @@
 * options : -DLAPACK   use LAPACK/BLAS
 *           -DMKL      use Intel MKL
 *           -DTRACE    enable debug trace
+*           -DNTRACE   remove debug trace calls at compile time
 *           -DWIN32    use WIN32 API
 *           -DNOCALLOC no use calloc for zero matrix
 *           -DIERS_MODEL use GMF instead of NMF
@@ -115,8 +116,17 @@
 #include <sys/time.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
 #endif
+#include <stddef.h>
 #include "rtklib.h"
+#if !defined(NOSIMD)&&defined(__GNUC__)&&(defined(__x86_64__)||defined(__i386__))
+#define SIMD_X86            /* x86 simd kernels with runtime dispatch */
+#include <immintrin.h>
+#endif
 
 static const char rcsid[]="$Id: rtkcmn.c,v 1.1 2008/07/17 21:48:06 ttaka Exp ttaka $";
 
@@ -337,6 +347,9 @@ static const unsigned int tbl_CRC24Q[]={
 #define dgetrf_     dgetrf
 #define dgetri_     dgetri
 #define dgetrs_     dgetrs
+#define dpotrf_     dpotrf
+#define dtrsm_      dtrsm
+#define dsyrk_      dsyrk
 #endif
 #ifdef LAPACK
 extern void dgemm_(char *, char *, int *, int *, int *, double *, double *,
@@ -345,6 +358,11 @@ extern void dgetrf_(int *, int *, double *, int *, int *, int *);
 extern void dgetri_(int *, double *, int *, int *, double *, int *, int *);
 extern void dgetrs_(char *, int *, int *, double *, int *, int *, double *,
                     int *, int *);
+extern void dpotrf_(char *, int *, double *, int *, int *);
+extern void dtrsm_(char *, char *, char *, char *, int *, int *, double *,
+                   double *, int *, double *, int *);
+extern void dsyrk_(char *, char *, int *, int *, double *, double *, int *,
+                   double *, double *, int *);
 #endif
 
 #ifdef IERS_MODEL
@@ -616,6 +634,88 @@ extern int getcodepri(int sys, unsigned char code, const char *opt)
     /* search code priority */
     return (p=strchr(codepris[i][j-1],obs[1]))?14-(int)(p-codepris[i][j-1]):0;
 }
+/* initialize bit stream cursor -----------------------------------------------
+* initialize bit stream cursor to read or write bits sequentially
+* args   : bitstr_t *bs     O   bit stream cursor
+*          unsigned char *buff I byte data
+*          int    pos       I   bit position from start of data (bits)
+* return : none
+* notes  : buff should be writable to set bits by bssetu() or bssets()
+*-----------------------------------------------------------------------------*/
+extern void bsinit(bitstr_t *bs, const unsigned char *buff, int pos)
+{
+    bs->buff=(unsigned char *)buff;
+    bs->pos=pos;
+}
+/* get unsigned/signed bits by bit stream cursor -------------------------------
+* extract unsigned/signed bits at the cursor and advance the cursor
+* args   : bitstr_t *bs     IO  bit stream cursor
+*          int    len       I   bit length (bits) (len<=32)
+* return : extracted unsigned/signed bits
+* notes  : the bits are extracted by shift and mask of a big-endian word of
+*          the bytes covering them. no byte after them is accessed
+*-----------------------------------------------------------------------------*/
+extern unsigned int bsgetu(bitstr_t *bs, int len)
+{
+    const unsigned char *p;
+    unsigned int bits;
+    int off,n;
+    
+    if (len<=0) return 0;
+    if (len>32) { /* lower 32 bits */
+        bs->pos+=len-32; len=32;
+    }
+    p=bs->buff+bs->pos/8; off=bs->pos%8; n=off+len;
+    bs->pos+=len;
+    
+    bits=(unsigned int)p[0]<<24;
+    if (n> 8) bits|=(unsigned int)p[1]<<16;
+    if (n>16) bits|=(unsigned int)p[2]<<8;
+    if (n>24) bits|=(unsigned int)p[3];
+    bits<<=off;
+    if (n>32) bits|=(unsigned int)p[4]>>(8-off);
+    return bits>>(32-len);
+}
+extern int bsgets(bitstr_t *bs, int len)
+{
+    unsigned int bits=bsgetu(bs,len);
+    if (len<=0||32<=len||!(bits&(1u<<(len-1)))) return (int)bits;
+    return (int)(bits|(~0u<<len)); /* extend sign */
+}
+/* set unsigned/signed bits by bit stream cursor -------------------------------
+* set unsigned/signed bits at the cursor and advance the cursor
+* args   : bitstr_t *bs     IO  bit stream cursor
+*          int    len       I   bit length (bits) (len<=32)
+*         (unsigned) int I      unsigned/signed data
+* return : none
+* notes  : other bits of the bytes covering the bits are kept
+*-----------------------------------------------------------------------------*/
+extern void bssetu(bitstr_t *bs, int len, unsigned int data)
+{
+    unsigned char *p;
+    unsigned int mask,bits;
+    int off,n;
+    
+    if (len<=0||32<len) return;
+    p=bs->buff+bs->pos/8; off=bs->pos%8; n=off+len;
+    bs->pos+=len;
+    
+    mask=(~0u<<(32-len))>>off;
+    bits=(data<<(32-len))>>off;
+    p[0]=(unsigned char)((p[0]&~(mask>>24))|(bits>>24));
+    if (n> 8) p[1]=(unsigned char)((p[1]&~(mask>>16))|(bits>>16));
+    if (n>16) p[2]=(unsigned char)((p[2]&~(mask>> 8))|(bits>> 8));
+    if (n>24) p[3]=(unsigned char)((p[3]&~mask)|bits);
+    if (n>32) {
+        mask=(0xFFu<<(40-n))&0xFF;
+        p[4]=(unsigned char)((p[4]&~mask)|((data<<(40-n))&mask));
+    }
+}
+extern void bssets(bitstr_t *bs, int len, int data)
+{
+    if (data<0) data|=1<<(len-1); else data&=~(1<<(len-1)); /* set sign bit */
+    bssetu(bs,len,(unsigned int)data);
+}
 /* extract unsigned/signed bits ------------------------------------------------
 * extract unsigned/signed bits from byte data
 * args   : unsigned char *buff I byte data
@@ -625,16 +725,15 @@ extern int getcodepri(int sys, unsigned char code, const char *opt)
 *-----------------------------------------------------------------------------*/
 extern unsigned int getbitu(const unsigned char *buff, int pos, int len)
 {
-    unsigned int bits=0;
-    int i;
-    for (i=pos;i<pos+len;i++) bits=(bits<<1)+((buff[i/8]>>(7-i%8))&1u);
-    return bits;
+    bitstr_t bs;
+    bsinit(&bs,buff,pos);
+    return bsgetu(&bs,len);
 }
 extern int getbits(const unsigned char *buff, int pos, int len)
 {
-    unsigned int bits=getbitu(buff,pos,len);
-    if (len<=0||32<=len||!(bits&(1u<<(len-1)))) return (int)bits;
-    return (int)(bits|(~0u<<len)); /* extend sign */
+    bitstr_t bs;
+    bsinit(&bs,buff,pos);
+    return bsgets(&bs,len);
 }
 /* set unsigned/signed bits ----------------------------------------------------
 * set unsigned/signed bits to byte data
@@ -646,17 +745,67 @@ extern int getbits(const unsigned char *buff, int pos, int len)
 *-----------------------------------------------------------------------------*/
 extern void setbitu(unsigned char *buff, int pos, int len, unsigned int data)
 {
-    unsigned int mask=1u<<(len-1);
-    int i;
-    if (len<=0||32<len) return;
-    for (i=pos;i<pos+len;i++,mask>>=1) {
-        if (data&mask) buff[i/8]|=1u<<(7-i%8); else buff[i/8]&=~(1u<<(7-i%8));
-    }
+    bitstr_t bs;
+    bsinit(&bs,buff,pos);
+    bssetu(&bs,len,data);
 }
 extern void setbits(unsigned char *buff, int pos, int len, int data)
 {
-    if (data<0) data|=1<<(len-1); else data&=~(1<<(len-1)); /* set sign bit */
-    setbitu(buff,pos,len,(unsigned int)data);
+    bitstr_t bs;
+    bsinit(&bs,buff,pos);
+    bssets(&bs,len,data);
+}
+/* slicing-by-8 crc tables ---------------------------------------------------*/
+static unsigned int   tbl_CRC32_8 [8][256];
+static unsigned int   tbl_CRC24Q_8[8][256];
+static unsigned short tbl_CRC16_8 [8][256];
+#ifdef WIN32
+static volatile LONG  tbl_CRC_init=0;   /* 0:none,1:generating,2:generated */
+#else
+static pthread_once_t tbl_CRC_once=PTHREAD_ONCE_INIT;
+#endif
+
+/* generate slicing-by-8 crc tables --------------------------------------------
+* table k is crc of a byte followed by k zero bytes
+*-----------------------------------------------------------------------------*/
+static void gen_crc(void)
+{
+    unsigned int crc;
+    int i,j,k;
+    
+    for (i=0;i<256;i++) {
+        for (j=0,crc=i;j<8;j++) {
+            if (crc&1) crc=(crc>>1)^POLYCRC32; else crc>>=1;
+        }
+        tbl_CRC32_8 [0][i]=crc;
+        tbl_CRC24Q_8[0][i]=tbl_CRC24Q[i];
+        tbl_CRC16_8 [0][i]=tbl_CRC16[i];
+    }
+    for (k=1;k<8;k++) for (i=0;i<256;i++) {
+        crc=tbl_CRC32_8[k-1][i];
+        tbl_CRC32_8[k][i]=(crc>>8)^tbl_CRC32_8[0][crc&0xFF];
+        crc=tbl_CRC24Q_8[k-1][i];
+        tbl_CRC24Q_8[k][i]=((crc<<8)&0xFFFFFF)^tbl_CRC24Q_8[0][crc>>16];
+        crc=tbl_CRC16_8[k-1][i];
+        tbl_CRC16_8[k][i]=(unsigned short)((crc<<8)^tbl_CRC16_8[0][crc>>8]);
+    }
+}
+/* initialize crc tables -------------------------------------------------------
+* generate the tables once at the first call of crc functions. threads calling
+* concurrently wait until the tables are generated by the first one
+*-----------------------------------------------------------------------------*/
+static void init_crc(void)
+{
+#ifdef WIN32
+    if (InterlockedCompareExchange(&tbl_CRC_init,1,0)==0) {
+        gen_crc();
+        InterlockedExchange(&tbl_CRC_init,2);
+        return;
+    }
+    while (InterlockedCompareExchange(&tbl_CRC_init,2,2)!=2) Sleep(0);
+#else
+    pthread_once(&tbl_CRC_once,gen_crc);
+#endif
 }
 /* crc-32 parity ---------------------------------------------------------------
 * compute crc-32 parity for novatel raw
@@ -664,20 +813,37 @@ extern void setbits(unsigned char *buff, int pos, int len, int data)
 *          int    len    I      data length (bytes)
 * return : crc-32 parity
 * notes  : see NovAtel OEMV firmware manual 1.7 32-bit CRC
+*          computed by slicing-by-8 with 8 bytes at a time
 *-----------------------------------------------------------------------------*/
 extern unsigned int crc32(const unsigned char *buff, int len)
 {
-    unsigned int crc=0;
-    int i,j;
+    return crc32_update(0,buff,len);
+}
+/* update crc-32 parity --------------------------------------------------------
+* update crc-32 parity with following data
+* args   : unsigned int crc  I  crc-32 parity of preceding data (0: no data)
+*          unsigned char *buff I data
+*          int    len    I      data length (bytes)
+* return : crc-32 parity of preceding and following data
+* notes  : crc32(buff,n) == crc32_update(crc32(buff,m),buff+m,n-m)
+*          crc-32 of gzip (iso-hdlc) is ~crc32_update(~crc,buff,len)
+*-----------------------------------------------------------------------------*/
+extern unsigned int crc32_update(unsigned int crc, const unsigned char *buff,
+                                 int len)
+{
+    unsigned int (*T)[256]=tbl_CRC32_8;
+    unsigned int hi;
+    int i;
     
-    trace(4,"crc32: len=%d\n",len);
+    init_crc();
     
-    for (i=0;i<len;i++) {
-        crc^=buff[i];
-        for (j=0;j<8;j++) {
-            if (crc&1) crc=(crc>>1)^POLYCRC32; else crc>>=1;
-        }
+    for (i=0;i+8<=len;i+=8,buff+=8) {
+        crc^=buff[0]|(buff[1]<<8)|(buff[2]<<16)|((unsigned int)buff[3]<<24);
+        hi  =buff[4]|(buff[5]<<8)|(buff[6]<<16)|((unsigned int)buff[7]<<24);
+        crc=T[7][crc&0xFF]^T[6][(crc>>8)&0xFF]^T[5][(crc>>16)&0xFF]^T[4][crc>>24]^
+            T[3][hi &0xFF]^T[2][(hi >>8)&0xFF]^T[1][(hi >>16)&0xFF]^T[0][hi >>24];
     }
+    for (;i<len;i++) crc=(crc>>8)^T[0][(crc^*buff++)&0xFF];
     return crc;
 }
 /* crc-24q parity --------------------------------------------------------------
@@ -689,12 +855,31 @@ extern unsigned int crc32(const unsigned char *buff, int len)
 *-----------------------------------------------------------------------------*/
 extern unsigned int crc24q(const unsigned char *buff, int len)
 {
-    unsigned int crc=0;
+    return crc24q_update(0,buff,len);
+}
+/* update crc-24q parity -------------------------------------------------------
+* update crc-24q parity with following data
+* args   : unsigned int crc  I  crc-24q parity of preceding data (0: no data)
+*          unsigned char *buff I data
+*          int    len    I      data length (bytes)
+* return : crc-24Q parity of preceding and following data
+* notes  : crc24q(buff,n) == crc24q_update(crc24q(buff,m),buff+m,n-m)
+*          computed by slicing-by-8 with 8 bytes at a time
+*-----------------------------------------------------------------------------*/
+extern unsigned int crc24q_update(unsigned int crc, const unsigned char *buff,
+                                  int len)
+{
+    unsigned int (*T)[256]=tbl_CRC24Q_8;
     int i;
     
-    trace(4,"crc24q: len=%d\n",len);
+    init_crc();
     
-    for (i=0;i<len;i++) crc=((crc<<8)&0xFFFFFF)^tbl_CRC24Q[(crc>>16)^buff[i]];
+    for (i=0;i+8<=len;i+=8,buff+=8) {
+        crc=T[7][(crc>>16)^buff[0]]^T[6][((crc>>8)&0xFF)^buff[1]]^
+            T[5][(crc&0xFF)^buff[2]]^T[4][buff[3]]^T[3][buff[4]]^
+            T[2][buff[5]]^T[1][buff[6]]^T[0][buff[7]];
+    }
+    for (;i<len;i++) crc=((crc<<8)&0xFFFFFF)^T[0][(crc>>16)^*buff++];
     return crc;
 }
 /* crc-16 parity ---------------------------------------------------------------
@@ -703,18 +888,23 @@ extern unsigned int crc24q(const unsigned char *buff, int len)
 *          int    len    I      data length (bytes)
 * return : crc-16 parity
 * notes  : see reference [10] A.3.
+*          computed by slicing-by-8 with 8 bytes at a time
 *-----------------------------------------------------------------------------*/
 extern unsigned short crc16(const unsigned char *buff, int len)
 {
-    unsigned short crc=0;
+    unsigned short (*T)[256]=tbl_CRC16_8;
+    unsigned int crc=0;
     int i;
     
-    trace(4,"crc16: len=%d\n",len);
+    init_crc();
     
-    for (i=0;i<len;i++) {
-        crc=(crc<<8)^tbl_CRC16[((crc>>8)^buff[i])&0xFF];
+    for (i=0;i+8<=len;i+=8,buff+=8) {
+        crc=T[7][(crc>>8)^buff[0]]^T[6][(crc&0xFF)^buff[1]]^T[5][buff[2]]^
+            T[4][buff[3]]^T[3][buff[4]]^T[2][buff[5]]^T[1][buff[6]]^
+            T[0][buff[7]];
     }
-    return crc;
+    for (;i<len;i++) crc=((crc<<8)&0xFFFF)^T[0][(crc>>8)^*buff++];
+    return (unsigned short)crc;
 }
 /* decode navigation data word -------------------------------------------------
 * check party and decode navigation data word
@@ -871,6 +1061,52 @@ extern void matcpy(double *A, const double *B, int n, int m)
 }
 /* matrix routines -----------------------------------------------------------*/
 
+/* multiply matrix by strides ------------------------------------------------*/
+static void matmuls(int n, int k, int m, int ai, int ax, int bx, int bj,
+                    double alpha, const double *A, const double *B,
+                    double beta, double *C)
+{
+    double d;
+    int i,j,x;
+    
+    for (i=0;i<n;i++) for (j=0;j<k;j++) {
+        for (x=0,d=0.0;x<m;x++) d+=A[i*ai+x*ax]*B[x*bx+j*bj];
+        if (beta==0.0) C[i+j*n]=alpha*d; else C[i+j*n]=alpha*d+beta*C[i+j*n];
+    }
+}
+#define MATMULS(f,n,k,m,alpha,A,B,beta,C) \
+    switch (f) { \
+        case 1: matmuls(n,k,m,1,n,1,m,alpha,A,B,beta,C); break; \
+        case 2: matmuls(n,k,m,1,n,k,1,alpha,A,B,beta,C); break; \
+        case 3: matmuls(n,k,m,m,1,1,m,alpha,A,B,beta,C); break; \
+        default:matmuls(n,k,m,m,1,k,1,alpha,A,B,beta,C); break; \
+    }
+
+/* multiply matrix of fixed size -----------------------------------------------
+* multiply matrix of small fixed size (3x3*3x3, 3x3*3x1, 4x4*4x4) by unrolled
+* kernels specialized for transpose flags
+* args   : same as matmul()
+* return : status (1:done,0:not fixed size)
+* notes  : the order of additions is the same as the general loop, so the
+*          results are identical to it
+*-----------------------------------------------------------------------------*/
+static int matmulfix(const char *tr, int n, int k, int m, double alpha,
+                     const double *A, const double *B, double beta, double *C)
+{
+    int f=tr[0]=='N'?(tr[1]=='N'?1:2):(tr[1]=='N'?3:4);
+    
+    if (n==3&&k==3&&m==3) {
+        MATMULS(f,3,3,3,alpha,A,B,beta,C);
+    }
+    else if (n==3&&k==1&&m==3) {
+        MATMULS(f,3,1,3,alpha,A,B,beta,C);
+    }
+    else if (n==4&&k==4&&m==4) {
+        MATMULS(f,4,4,4,alpha,A,B,beta,C);
+    }
+    else return 0;
+    return 1;
+}
 #ifdef LAPACK /* with LAPACK/BLAS or MKL */
 
 /* multiply matrix (wrapper of blas dgemm) -------------------------------------
@@ -888,6 +1124,8 @@ extern void matmul(const char *tr, int n, int k, int m, double alpha,
 {
     int lda=tr[0]=='T'?m:n,ldb=tr[1]=='T'?k:m;
     
+    if (matmulfix(tr,n,k,m,alpha,A,B,beta,C)) return;
+    
     dgemm_((char *)tr,(char *)tr+1,&n,&k,&m,&alpha,(double *)A,&lda,(double *)B,
            &ldb,&beta,C,&n);
 }
@@ -897,14 +1135,20 @@ extern void matmul(const char *tr, int n, int k, int m, double alpha,
 *          int    n         I   size of matrix A
 * return : status (0:ok,0>:error)
 *-----------------------------------------------------------------------------*/
-extern int matinv(double *A, int n)
+static int matinv_(double *A, int n, int *ipiv, double *work)
 {
-    double *work;
-    int info,lwork=n*16,*ipiv=imat(n,1);
+    int info,lwork=n*16;
     
-    work=mat(lwork,1);
     dgetrf_(&n,&n,A,&n,ipiv,&info);
     if (!info) dgetri_(&n,A,&n,ipiv,work,&lwork,&info);
+    return info;
+}
+extern int matinv(double *A, int n)
+{
+    double *work=mat(n*16,1);
+    int info,*ipiv=imat(n,1);
+    
+    info=matinv_(A,n,ipiv,work);
     free(ipiv); free(work);
     return info;
 }
@@ -932,17 +1176,186 @@ extern int solve(const char *tr, const double *A, const double *Y, int n,
     free(ipiv); free(B); 
     return info;
 }
+/* symmetric rank-m downdate by cholesky (wrapper of lapack/blas) -----------
+* Q=L*L', W=W*L'^-1, P=P-W*W' (only upper triangle of P is updated)
+*-----------------------------------------------------------------------------*/
+static int cholupd(double *Q, double *W, double *P, int n, int m)
+{
+    double one=1.0,mone=-1.0;
+    int info;
+    
+    dpotrf_("L",&m,Q,&m,&info);
+    if (info) return info;
+    dtrsm_("R","L","T","N",&n,&m,&one,Q,&m,W,&n);
+    dsyrk_("U","N",&n,&m,&mone,W,&n,&one,P,&n);
+    return 0;
+}
 
 #else /* without LAPACK/BLAS or MKL */
 
-/* multiply matrix -----------------------------------------------------------*/
+#ifdef SIMD_X86
+/* multiply matrix by sse2/avx2 ------------------------------------------------
+* multiply matrix with 2 (sse2) or 4 (avx2) elements of C in a vector. A is
+* vectorized by rows for "N?" and "TN" and B by columns for "TT". rows (i0) or
+* columns (j0) done are returned and the others are left to the scalar loop.
+* mul and add are not fused to keep the results identical to the scalar loop
+*-----------------------------------------------------------------------------*/
+static void matmul_sse2(int f, int n, int k, int m, double alpha,
+                        const double *A, const double *B, double beta,
+                        double *C, int *i0, int *j0)
+{
+    __m128d a,b,d,c,s=_mm_set1_pd(alpha),t=_mm_set1_pd(beta);
+    double e[2];
+    int i,j,x,bx=f==1?1:k,bj=f==1?m:1;
+    
+    if (f<=2) { /* A: normal */
+        for (j=0;j<k;j++) for (i=0;i+2<=n;i+=2) {
+            for (x=0,d=_mm_setzero_pd();x<m;x++) {
+                a=_mm_loadu_pd(A+i+x*n);
+                b=_mm_set1_pd(B[x*bx+j*bj]);
+                d=_mm_add_pd(d,_mm_mul_pd(a,b));
+            }
+            d=_mm_mul_pd(s,d);
+            if (beta!=0.0) {
+                c=_mm_loadu_pd(C+i+j*n);
+                d=_mm_add_pd(d,_mm_mul_pd(t,c));
+            }
+            _mm_storeu_pd(C+i+j*n,d);
+        }
+        *i0=n-n%2; /* rows done */
+    }
+    else if (f==3) { /* A: transposed, B: normal */
+        for (j=0;j<k;j++) for (i=0;i+2<=n;i+=2) {
+            for (x=0,d=_mm_setzero_pd();x<m;x++) {
+                a=_mm_set_pd(A[x+(i+1)*m],A[x+i*m]);
+                b=_mm_set1_pd(B[x+j*m]);
+                d=_mm_add_pd(d,_mm_mul_pd(a,b));
+            }
+            d=_mm_mul_pd(s,d);
+            if (beta!=0.0) {
+                c=_mm_loadu_pd(C+i+j*n);
+                d=_mm_add_pd(d,_mm_mul_pd(t,c));
+            }
+            _mm_storeu_pd(C+i+j*n,d);
+        }
+        *i0=n-n%2;
+    }
+    else if (f==4) { /* A and B: transposed */
+        for (i=0;i<n;i++) for (j=0;j+2<=k;j+=2) {
+            for (x=0,d=_mm_setzero_pd();x<m;x++) {
+                a=_mm_set1_pd(A[x+i*m]);
+                b=_mm_loadu_pd(B+j+x*k);
+                d=_mm_add_pd(d,_mm_mul_pd(a,b));
+            }
+            d=_mm_mul_pd(s,d);
+            if (beta!=0.0) {
+                c=_mm_set_pd(C[i+(j+1)*n],C[i+j*n]);
+                d=_mm_add_pd(d,_mm_mul_pd(t,c));
+            }
+            _mm_storeu_pd(e,d);
+            C[i+j*n]=e[0]; C[i+(j+1)*n]=e[1];
+        }
+        *j0=k-k%2; /* columns done */
+    }
+}
+__attribute__((target("avx2")))
+static void matmul_avx2(int f, int n, int k, int m, double alpha,
+                        const double *A, const double *B, double beta,
+                        double *C, int *i0, int *j0)
+{
+    __m256d a,b,d,c,s=_mm256_set1_pd(alpha),t=_mm256_set1_pd(beta);
+    double e[4];
+    int i,j,x,bx=f==1?1:k,bj=f==1?m:1;
+    
+    if (f<=2) { /* A: normal */
+        for (j=0;j<k;j++) for (i=0;i+4<=n;i+=4) {
+            for (x=0,d=_mm256_setzero_pd();x<m;x++) {
+                a=_mm256_loadu_pd(A+i+x*n);
+                b=_mm256_set1_pd(B[x*bx+j*bj]);
+                d=_mm256_add_pd(d,_mm256_mul_pd(a,b));
+            }
+            d=_mm256_mul_pd(s,d);
+            if (beta!=0.0) {
+                c=_mm256_loadu_pd(C+i+j*n);
+                d=_mm256_add_pd(d,_mm256_mul_pd(t,c));
+            }
+            _mm256_storeu_pd(C+i+j*n,d);
+        }
+        *i0=n-n%4;
+    }
+    else if (f==3) { /* A: transposed, B: normal */
+        for (j=0;j<k;j++) for (i=0;i+4<=n;i+=4) {
+            for (x=0,d=_mm256_setzero_pd();x<m;x++) {
+                a=_mm256_set_pd(A[x+(i+3)*m],A[x+(i+2)*m],A[x+(i+1)*m],
+                                A[x+i*m]);
+                b=_mm256_set1_pd(B[x+j*m]);
+                d=_mm256_add_pd(d,_mm256_mul_pd(a,b));
+            }
+            d=_mm256_mul_pd(s,d);
+            if (beta!=0.0) {
+                c=_mm256_loadu_pd(C+i+j*n);
+                d=_mm256_add_pd(d,_mm256_mul_pd(t,c));
+            }
+            _mm256_storeu_pd(C+i+j*n,d);
+        }
+        *i0=n-n%4;
+    }
+    else if (f==4) { /* A and B: transposed */
+        for (i=0;i<n;i++) for (j=0;j+4<=k;j+=4) {
+            for (x=0,d=_mm256_setzero_pd();x<m;x++) {
+                a=_mm256_set1_pd(A[x+i*m]);
+                b=_mm256_loadu_pd(B+j+x*k);
+                d=_mm256_add_pd(d,_mm256_mul_pd(a,b));
+            }
+            d=_mm256_mul_pd(s,d);
+            if (beta!=0.0) {
+                c=_mm256_set_pd(C[i+(j+3)*n],C[i+(j+2)*n],C[i+(j+1)*n],
+                                C[i+j*n]);
+                d=_mm256_add_pd(d,_mm256_mul_pd(t,c));
+            }
+            _mm256_storeu_pd(e,d);
+            C[i+j*n]=e[0]; C[i+(j+1)*n]=e[1];
+            C[i+(j+2)*n]=e[2]; C[i+(j+3)*n]=e[3];
+        }
+        *j0=k-k%4;
+    }
+}
+/* simd level of cpu (0:none,1:sse2,2:avx2) ----------------------------------*/
+static int simdlevel(void)
+{
+    static THREADLOCAL int level=-1;
+    
+    if (level<0) {
+        __builtin_cpu_init();
+        level=__builtin_cpu_supports("avx2")?2:(__builtin_cpu_supports("sse2")?1:0);
+    }
+    return level;
+}
+#endif /* SIMD_X86 */
+
+/* multiply matrix -------------------------------------------------------------
+* multiply matrix by matrix (C=alpha*A*B+beta*C)
+* args   : same as matmul() with LAPACK
+* notes  : fixed small sizes are done by matmulfix(). with SIMD_X86, the
+*          others are vectorized by avx2 or sse2 selected by the cpu at run
+*          time, and the remainders are done by the scalar loop. compile with
+*          -DNOSIMD for the scalar loop only
+*-----------------------------------------------------------------------------*/
 extern void matmul(const char *tr, int n, int k, int m, double alpha,
                    const double *A, const double *B, double beta, double *C)
 {
     double d;
-    int i,j,x,f=tr[0]=='N'?(tr[1]=='N'?1:2):(tr[1]=='N'?3:4);
+    int i,j,x,i0=0,j0=0,f=tr[0]=='N'?(tr[1]=='N'?1:2):(tr[1]=='N'?3:4);
     
-    for (i=0;i<n;i++) for (j=0;j<k;j++) {
+    if (matmulfix(tr,n,k,m,alpha,A,B,beta,C)) return;
+    
+#ifdef SIMD_X86
+    switch (simdlevel()) {
+        case 2: matmul_avx2(f,n,k,m,alpha,A,B,beta,C,&i0,&j0); break;
+        case 1: matmul_sse2(f,n,k,m,alpha,A,B,beta,C,&i0,&j0); break;
+    }
+#endif
+    for (i=i0;i<n;i++) for (j=j0;j<k;j++) {
         d=0.0;
         switch (f) {
             case 1: for (x=0;x<m;x++) d+=A[i+x*n]*B[x+j*m]; break;
@@ -954,15 +1367,15 @@ extern void matmul(const char *tr, int n, int k, int m, double alpha,
     }
 }
 /* LU decomposition ----------------------------------------------------------*/
-static int ludcmp(double *A, int n, int *indx, double *d)
+static int ludcmp(double *A, int n, int *indx, double *d, double *vv)
 {
-    double big,s,tmp,*vv=mat(n,1);
+    double big,s,tmp;
     int i,imax=0,j,k;
     
     *d=1.0;
     for (i=0;i<n;i++) {
         big=0.0; for (j=0;j<n;j++) if ((tmp=fabs(A[i+j*n]))>big) big=tmp;
-        if (big>0.0) vv[i]=1.0/big; else {free(vv); return -1;}
+        if (big>0.0) vv[i]=1.0/big; else return -1;
     }
     for (j=0;j<n;j++) {
         for (i=0;i<j;i++) {
@@ -980,12 +1393,11 @@ static int ludcmp(double *A, int n, int *indx, double *d)
             *d=-(*d); vv[imax]=vv[j];
         }
         indx[j]=imax;
-        if (A[j+j*n]==0.0) {free(vv); return -1;}
+        if (A[j+j*n]==0.0) return -1;
         if (j!=n-1) {
             tmp=1.0/A[j+j*n]; for (i=j+1;i<n;i++) A[i+j*n]*=tmp;
         }
     }
-    free(vv);
     return 0;
 }
 /* LU back-substitution ------------------------------------------------------*/
@@ -1003,21 +1415,30 @@ static void lubksb(const double *A, int n, const int *indx, double *b)
         s=b[i]; for (j=i+1;j<n;j++) s-=A[i+j*n]*b[j]; b[i]=s/A[i+i*n];
     }
 }
-/* inverse of matrix ---------------------------------------------------------*/
-extern int matinv(double *A, int n)
+/* inverse of matrix with work area (n x n+1) ------------------------------*/
+static int matinv_(double *A, int n, int *indx, double *work)
 {
-    double d,*B;
-    int i,j,*indx;
+    double d,*B=work,*vv=work+n*n;
+    int i,j;
     
-    indx=imat(n,1); B=mat(n,n); matcpy(B,A,n,n);
-    if (ludcmp(B,n,indx,&d)) {free(indx); free(B); return -1;}
+    matcpy(B,A,n,n);
+    if (ludcmp(B,n,indx,&d,vv)) return -1;
     for (j=0;j<n;j++) {
         for (i=0;i<n;i++) A[i+j*n]=0.0; A[j+j*n]=1.0;
         lubksb(B,n,indx,A+j*n);
     }
-    free(indx); free(B);
     return 0;
 }
+/* inverse of matrix ---------------------------------------------------------*/
+extern int matinv(double *A, int n)
+{
+    double *work=mat(n,n+1);
+    int info,*indx=imat(n,1);
+    
+    info=matinv_(A,n,indx,work);
+    free(indx); free(work);
+    return info;
+}
 /* solve linear equation -----------------------------------------------------*/
 extern int solve(const char *tr, const double *A, const double *Y, int n,
                  int m, double *X)
@@ -1030,6 +1451,40 @@ extern int solve(const char *tr, const double *A, const double *Y, int n,
     free(B);
     return info;
 }
+/* symmetric rank-m downdate by cholesky -------------------------------------
+* Q=L*L', W=W*L'^-1, P=P-W*W' (only upper triangle of P is updated)
+*-----------------------------------------------------------------------------*/
+static int cholupd(double *Q, double *W, double *P, int n, int m)
+{
+    double s,*w;
+    int i,j,k;
+    
+    for (j=0;j<m;j++) { /* cholesky decomposition (lower) */
+        s=Q[j+j*m]; for (k=0;k<j;k++) s-=Q[j+k*m]*Q[j+k*m];
+        if (s<=0.0) return -1;
+        Q[j+j*m]=s=sqrt(s);
+        for (i=j+1;i<m;i++) {
+            for (k=0;k<j;k++) Q[i+j*m]-=Q[i+k*m]*Q[j+k*m];
+            Q[i+j*m]/=s;
+        }
+    }
+    for (j=0;j<m;j++) { /* W=W*L'^-1 */
+        w=W+j*n;
+        for (k=0;k<j;k++) {
+            if ((s=Q[j+k*m])==0.0) continue;
+            for (i=0;i<n;i++) w[i]-=W[i+k*n]*s;
+        }
+        s=1.0/Q[j+j*m]; for (i=0;i<n;i++) w[i]*=s;
+    }
+    for (k=0;k<m;k++) { /* P=P-W*W' */
+        w=W+k*n;
+        for (j=0;j<n;j++) {
+            if ((s=w[j])==0.0) continue;
+            for (i=0;i<=j;i++) P[i+j*n]-=w[i]*s;
+        }
+    }
+    return 0;
+}
 #endif
 /* end of matrix routines ----------------------------------------------------*/
 
@@ -1077,43 +1532,153 @@ extern int lsq(const double *A, const double *y, int n, int m, double *x,
 *-----------------------------------------------------------------------------*/
 static int filter_(const double *x, const double *P, const double *H,
                    const double *v, const double *R, int n, int m,
-                   double *xp, double *Pp)
+                   double *xp, double *Pp, filterws_t *ws)
 {
-    double *F=mat(n,m),*Q=mat(m,m),*K=mat(n,m),*I=eye(n);
-    int info;
+    double *F=ws->F,*Q=ws->Q,*K=ws->K,*I=ws->I;
+    int i,info;
     
+    for (i=0;i<n*n;i++) I[i]=0.0;
+    for (i=0;i<n;i++) I[i+i*n]=1.0;
     matcpy(Q,R,m,m);
     matcpy(xp,x,n,1);
     matmul("NN",n,m,n,1.0,P,H,0.0,F);       /* Q=H'*P*H+R */
     matmul("TN",m,m,n,1.0,H,F,1.0,Q);
-    if (!(info=matinv(Q,m))) {
+    if (!(info=matinv_(Q,m,ws->ipiv,ws->work))) {
         matmul("NN",n,m,m,1.0,F,Q,0.0,K);   /* K=P*H*Q^-1 */
         matmul("NN",n,1,m,1.0,K,v,1.0,xp);  /* xp=x+K*v */
         matmul("NT",n,n,m,-1.0,K,H,1.0,I);  /* Pp=(I-K*H')*P */
         matmul("NN",n,n,n,1.0,I,P,0.0,Pp);
     }
-    free(F); free(Q); free(K); free(I);
     return info;
 }
+static int filter_chol(const double *x, const double *P, const double *H,
+                       const double *v, const double *R, int n, int m,
+                       double *xp, double *Pp, filterws_t *ws)
+{
+    double s,*W=ws->F,*Q=ws->Q,*z=ws->work;
+    int i,j,info;
+    
+    matcpy(Q,R,m,m);
+    matcpy(xp,x,n,1);
+    matcpy(Pp,P,n,n);
+    matmul("NN",n,m,n,1.0,P,H,0.0,W);       /* Q=H'*P*H+R */
+    matmul("TN",m,m,n,1.0,H,W,1.0,Q);
+    if ((info=cholupd(Q,W,Pp,n,m))) { /* Q=L*L', W=P*H*L'^-1, Pp=P-W*W' */
+        return info;
+    }
+    for (j=0;j<m;j++) { /* z=L^-1*v */
+        s=v[j]; for (i=0;i<j;i++) s-=Q[j+i*m]*z[i];
+        z[j]=s/Q[j+j*m];
+    }
+    matmul("NN",n,1,m,1.0,W,z,1.0,xp);      /* xp=x+W*z */
+    for (j=0;j<n;j++) for (i=0;i<j;i++) Pp[j+i*n]=Pp[i+j*n];
+    return 0;
+}
 extern int filter(double *x, double *P, const double *H, const double *v,
                   const double *R, int n, int m)
+{
+    filterws_t ws={0};
+    int info;
+    
+    initfilterws(&ws,n,m);
+    info=filter_ws(x,P,H,v,R,n,m,&ws);
+    freefilterws(&ws);
+    return info;
+}
+/* initialize kalman filter workspace ------------------------------------------
+* allocate or grow kalman filter workspace for filter_ws()
+* args   : filterws_t *ws   IO  kalman filter workspace (zero-cleared at first)
+*          int    n,m       I   number of states and measurements
+* return : none
+* notes  : the workspace is reallocated only if n or m exceeds the allocated
+*          size, so the steady state of the filter has no heap traffic
+*-----------------------------------------------------------------------------*/
+extern void initfilterws(filterws_t *ws, int n, int m)
+{
+    int nw;
+    
+    if (n<=ws->nmax&&m<=ws->mmax) return;
+    
+    trace(4,"initfilterws: n=%d m=%d\n",n,m);
+    
+    if (n<ws->nmax) n=ws->nmax;
+    if (m<ws->mmax) m=ws->mmax;
+    freefilterws(ws);
+#ifdef LAPACK
+    nw=m*16;
+#else
+    nw=m*(m+1);
+#endif
+    ws->xp =mat(n,1); ws->Pp=mat(n,n);
+    ws->v  =mat(m,1); ws->H =mat(n,m); ws->R=mat(m,m);
+    ws->ix =imat(n,1); ws->ipiv=imat(m,1);
+    ws->x_ =mat(n,1); ws->xp_=mat(n,1);
+    ws->P_ =mat(n,n); ws->Pp_=mat(n,n); ws->H_=mat(n,m);
+    ws->F  =mat(n,m); ws->Q=mat(m,m); ws->K=mat(n,m); ws->I=mat(n,n);
+    ws->work=mat(nw,1);
+    ws->nmax=n; ws->mmax=m;
+}
+/* free kalman filter workspace ------------------------------------------------
+* free memory for kalman filter workspace
+* args   : filterws_t *ws   IO  kalman filter workspace
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void freefilterws(filterws_t *ws)
+{
+    free(ws->xp ); ws->xp =NULL; free(ws->Pp ); ws->Pp =NULL;
+    free(ws->v  ); ws->v  =NULL; free(ws->H  ); ws->H  =NULL;
+    free(ws->R  ); ws->R  =NULL; free(ws->ix ); ws->ix =NULL;
+    free(ws->ipiv); ws->ipiv=NULL;
+    free(ws->x_ ); ws->x_ =NULL; free(ws->xp_); ws->xp_=NULL;
+    free(ws->P_ ); ws->P_ =NULL; free(ws->Pp_); ws->Pp_=NULL;
+    free(ws->H_ ); ws->H_ =NULL; free(ws->F  ); ws->F  =NULL;
+    free(ws->Q  ); ws->Q  =NULL; free(ws->K  ); ws->K  =NULL;
+    free(ws->I  ); ws->I  =NULL; free(ws->work); ws->work=NULL;
+    ws->nmax=ws->mmax=0;
+}
+/* kalman filter with workspace ------------------------------------------------
+* kalman filter state update same as filter() with caller-owned workspace
+* args   : double *x,*P,*H,*v,*R,n,m (see filter())
+*          filterws_t *ws   IO  kalman filter workspace
+* return : status (0:ok,<0:error)
+*          ws->mode selects the measurement update as follows:
+*
+*          KFUPD_STD : same as filter()
+*          KFUPD_CHOL: Q=H'*P*H+R=L*L' (cholesky), W=P*H*L'^-1,
+*                      xp=x+W*L^-1*v, Pp=P-W*W'
+*
+*          KFUPD_CHOL keeps Pp symmetric and needs O(n^2*m) operations instead
+*          of O(n^3) for Pp=(I-K*H')*P
+* notes  : no memory is allocated if the workspace has been initialized by
+*          initfilterws() for n states and m measurements or more. in that
+*          case x, P, H, v and R may point to ws->xp, ws->Pp, ws->H, ws->v and
+*          ws->R
+*-----------------------------------------------------------------------------*/
+extern int filter_ws(double *x, double *P, const double *H, const double *v,
+                     const double *R, int n, int m, filterws_t *ws)
 {
     double *x_,*xp_,*P_,*Pp_,*H_;
     int i,j,k,info,*ix;
     
-    ix=imat(n,1); for (i=k=0;i<n;i++) if (x[i]!=0.0&&P[i+i*n]>0.0) ix[k++]=i;
-    x_=mat(k,1); xp_=mat(k,1); P_=mat(k,k); Pp_=mat(k,k); H_=mat(k,m);
+    initfilterws(ws,n,m);
+    
+    ix=ws->ix; for (i=k=0;i<n;i++) if (x[i]!=0.0&&P[i+i*n]>0.0) ix[k++]=i;
+    x_=ws->x_; xp_=ws->xp_; P_=ws->P_; Pp_=ws->Pp_; H_=ws->H_;
     for (i=0;i<k;i++) {
         x_[i]=x[ix[i]];
         for (j=0;j<k;j++) P_[i+j*k]=P[ix[i]+ix[j]*n];
         for (j=0;j<m;j++) H_[i+j*k]=H[ix[i]+j*n];
     }
-    info=filter_(x_,P_,H_,v,R,k,m,xp_,Pp_);
+    if (ws->mode==KFUPD_CHOL) {
+        info=filter_chol(x_,P_,H_,v,R,k,m,xp_,Pp_,ws);
+    }
+    else {
+        info=filter_(x_,P_,H_,v,R,k,m,xp_,Pp_,ws);
+    }
     for (i=0;i<k;i++) {
         x[ix[i]]=xp_[i];
         for (j=0;j<k;j++) P[ix[i]+ix[j]*n]=Pp_[i+j*k];
     }
-    free(ix); free(x_); free(xp_); free(P_); free(Pp_); free(H_);
     return info;
 }
 /* smoother --------------------------------------------------------------------
@@ -1462,17 +2027,27 @@ extern int read_leaps(const char *file)
     fclose(fp);
     return 1;
 }
+/* set leap seconds -------------------------------------------------------------
+* set leap seconds (utc-gpst) of all epochs of leap seconds table
+* args   : int    leap      I   leap seconds (gpst-utc) (s)
+* return : none
+* notes  : the leap seconds are set for the calling thread and they are valid
+*          until set_default_leaps() is called by the thread
+*-----------------------------------------------------------------------------*/
+static THREADLOCAL int leapset_=0;  /* leap seconds set by set_leaps() */
+static THREADLOCAL int leap_=0;     /* leap seconds (gpst-utc) (s) */
+
 extern void set_leaps(int leap)
 {
-    int i;
-
-    for (i=0;leaps[i][0]>0;i++) {
-        leaps[i][6]=-leap;
-    }
+    leap_=leap;
+    leapset_=1;
 }
 extern void set_default_leaps()
 {
-    memcpy(leaps, default_leaps, (MAXLEAPS+1)*7*sizeof(double));
+    leapset_=0;
+    if (memcmp(leaps,default_leaps,sizeof(leaps))) {
+        memcpy(leaps,default_leaps,sizeof(leaps));
+    }
 }
 /* gpstime to utc --------------------------------------------------------------
 * convert gpstime to utc considering leap seconds
@@ -1486,7 +2061,7 @@ extern gtime_t gpst2utc(gtime_t t)
     int i;
     
     for (i=0;leaps[i][0]>0;i++) {
-        tu=timeadd(t,leaps[i][6]);
+        tu=timeadd(t,leapset_?-leap_:leaps[i][6]);
         if (timediff(tu,epoch2time(leaps[i]))>=0.0) return tu;
     }
     return t;
@@ -1502,7 +2077,8 @@ extern gtime_t utc2gpst(gtime_t t)
     int i;
     
     for (i=0;leaps[i][0]>0;i++) {
-        if (timediff(t,epoch2time(leaps[i]))>=0.0) return timeadd(t,-leaps[i][6]);
+        if (timediff(t,epoch2time(leaps[i]))<0.0) continue;
+        return timeadd(t,leapset_?leap_:-leaps[i][6]);
     }
     return t;
 }
@@ -1582,13 +2158,27 @@ extern void time2str(gtime_t t, char *s, int n)
 *          int    n         I   number of decimals
 * return : time string
 * notes  : not reentrant, do not use multiple in a function
+*          the string buffer is local to the thread
 *-----------------------------------------------------------------------------*/
 extern char *time_str(gtime_t t, int n)
 {
-    static char buff[64];
+    static THREADLOCAL char buff[64];
     time2str(t,buff,n);
     return buff;
 }
+/* get time string with buffer -------------------------------------------------
+* get time string with the buffer supplied by the caller
+* args   : gtime_t t        I   gtime_t struct
+*          int    n         I   number of decimals
+*          char   *str      O   time string (>=64 bytes)
+* return : time string
+* notes  : thread-safe version of time_str()
+*-----------------------------------------------------------------------------*/
+extern char *time_str_r(gtime_t t, int n, char *str)
+{
+    time2str(t,str,n);
+    return str;
+}
 /* time to day of year ---------------------------------------------------------
 * convert time to day of year
 * args   : gtime_t t        I   gtime_t struct
@@ -1967,8 +2557,8 @@ static void nut_iau1980(double t, const double *f, double *dpsi, double *deps)
 extern void eci2ecef(gtime_t tutc, const double *erpv, double *U, double *gmst)
 {
     const double ep2000[]={2000,1,1,12,0,0};
-    static gtime_t tutc_;
-    static double U_[9],gmst_;
+    static THREADLOCAL gtime_t tutc_;
+    static THREADLOCAL double U_[9],gmst_;
     gtime_t tgps;
     double eps,ze,th,z,t,t2,t3,dpsi,deps,gast,f[5];
     double R1[9],R2[9],R3[9],R[9],W[9],N[9],P[9],NP[9];
@@ -2262,8 +2852,8 @@ extern pcv_t *searchpcv(int sat, const char *type, gtime_t time,
 *-----------------------------------------------------------------------------*/
 extern void readpos(const char *file, const char *rcv, double *pos)
 {
-    static double poss[2048][3];
-    static char stas[2048][16];
+    static THREADLOCAL double poss[2048][3];
+    static THREADLOCAL char stas[2048][16];
     FILE *fp;
     int i,j,len,np=0;
     char buff[256],str[256];
@@ -2439,6 +3029,86 @@ extern int geterp(const erp_t *erp, gtime_t time, double *erpv)
     erpv[3]=(1.0-a)*erp->data[j].lod    +a*erp->data[j+1].lod;
     return 1;
 }
+/* delete duplicated records by hash table ------------------------------------
+* delete records with the same key keeping the first one in input order
+* args   : void   *data   IO  records
+*          int    n       I   number of records
+*          size_t size    I   size of a record (bytes)
+*          hash,equal     I   hash and equality of record keys
+* return : number of records after deletion (n if no memory)
+*-----------------------------------------------------------------------------*/
+static int uniqhash(void *data, int n, size_t size,
+                    unsigned int (*hash)(const void *),
+                    int (*equal)(const void *, const void *))
+{
+    unsigned char *p=(unsigned char *)data;
+    int *tbl,i,j,k,m;
+    
+    for (m=16;m<2*n;m<<=1) ;
+    
+    if (!(tbl=(int *)malloc(sizeof(int)*m))) return n;
+    
+    for (i=0;i<m;i++) tbl[i]=-1;
+    
+    for (i=j=0;i<n;i++) {
+        for (k=hash(p+size*i)&(m-1);tbl[k]>=0;k=(k+1)&(m-1)) {
+            if (equal(p+size*tbl[k],p+size*i)) break;
+        }
+        if (tbl[k]>=0) continue;
+        if (j<i) memcpy(p+size*j,p+size*i,size);
+        tbl[k]=j++;
+    }
+    free(tbl);
+    return j;
+}
+/* hash of words (fnv-1a by word) --------------------------------------------*/
+static unsigned int hashword(unsigned int h, unsigned int w)
+{
+    return (h^w)*16777619u;
+}
+/* hash and equality of ephemeris keys ---------------------------------------*/
+static unsigned int hasheph(const void *p)
+{
+    const eph_t *q=(const eph_t *)p;
+    unsigned int h=2166136261u;
+    h=hashword(h,(unsigned int)q->ttr.time);
+    h=hashword(h,(unsigned int)q->toe.time);
+    return hashword(h,(unsigned int)(q->sat<<16^q->iode));
+}
+static int equaleph(const void *p1, const void *p2)
+{
+    const eph_t *q1=(const eph_t *)p1,*q2=(const eph_t *)p2;
+    return q1->ttr.time==q2->ttr.time&&q1->toe.time==q2->toe.time&&
+           q1->sat==q2->sat&&q1->iode==q2->iode;
+}
+static unsigned int hashgeph(const void *p)
+{
+    const geph_t *q=(const geph_t *)p;
+    unsigned int h=2166136261u;
+    h=hashword(h,(unsigned int)q->tof.time);
+    h=hashword(h,(unsigned int)q->toe.time);
+    return hashword(h,(unsigned int)(q->sat<<16^q->svh));
+}
+static int equalgeph(const void *p1, const void *p2)
+{
+    const geph_t *q1=(const geph_t *)p1,*q2=(const geph_t *)p2;
+    return q1->tof.time==q2->tof.time&&q1->toe.time==q2->toe.time&&
+           q1->sat==q2->sat&&q1->svh==q2->svh;
+}
+static unsigned int hashseph(const void *p)
+{
+    const seph_t *q=(const seph_t *)p;
+    unsigned int h=2166136261u;
+    h=hashword(h,(unsigned int)q->tof.time);
+    h=hashword(h,(unsigned int)q->t0.time);
+    return hashword(h,(unsigned int)q->sat);
+}
+static int equalseph(const void *p1, const void *p2)
+{
+    const seph_t *q1=(const seph_t *)p1,*q2=(const seph_t *)p2;
+    return q1->tof.time==q2->tof.time&&q1->t0.time==q2->t0.time&&
+           q1->sat==q2->sat;
+}
 /* compare ephemeris ---------------------------------------------------------*/
 static int cmpeph(const void *p1, const void *p2)
 {
@@ -2457,6 +3127,9 @@ static void uniqeph(nav_t *nav)
     
     if (nav->n<=0) return;
     
+    /* delete duplicated ephemeris before sort */
+    nav->n=uniqhash(nav->eph,nav->n,sizeof(eph_t),hasheph,equaleph);
+    
     qsort(nav->eph,nav->n,sizeof(eph_t),cmpeph);
     
     for (i=1,j=0;i<nav->n;i++) {
@@ -2495,6 +3168,9 @@ static void uniqgeph(nav_t *nav)
     
     if (nav->ng<=0) return;
     
+    /* delete duplicated ephemeris before sort */
+    nav->ng=uniqhash(nav->geph,nav->ng,sizeof(geph_t),hashgeph,equalgeph);
+    
     qsort(nav->geph,nav->ng,sizeof(geph_t),cmpgeph);
     
     for (i=j=0;i<nav->ng;i++) {
@@ -2534,6 +3210,9 @@ static void uniqseph(nav_t *nav)
     
     if (nav->ns<=0) return;
     
+    /* delete duplicated ephemeris before sort */
+    nav->ns=uniqhash(nav->seph,nav->ns,sizeof(seph_t),hashseph,equalseph);
+    
     qsort(nav->seph,nav->ns,sizeof(seph_t),cmpseph);
     
     for (i=j=0;i<nav->ns;i++) {
@@ -2584,19 +3263,170 @@ static int cmpobs(const void *p1, const void *p2)
     if (q1->rcv!=q2->rcv) return (int)q1->rcv-(int)q2->rcv;
     return (int)q1->sat-(int)q2->sat;
 }
-/* sort and unique observation data --------------------------------------------
-* sort and unique observation data by time, rcv, sat
-* args   : obs_t *obs    IO     observation data
-* return : number of epochs
+typedef struct {                    /* sort key of observation data record */
+    time_t time;                    /* time (s) */
+    double sec;                     /* fraction of time (s) */
+    int id;                         /* receiver and satellite (rcv<<8|sat) */
+    int index;                      /* index of record */
+} obskey_t;
+
+/* compare observation keys by time or by receiver and satellite -------------*/
+static int cmpkeyt(const obskey_t *q1, const obskey_t *q2)
+{
+    if (q1->time!=q2->time) return q1->time<q2->time?-1:1;
+    return q1->sec<q2->sec?-1:(q1->sec>q2->sec?1:0);
+}
+static int cmpkeyr(const obskey_t *q1, const obskey_t *q2)
+{
+    return q1->id-q2->id;
+}
+/* stable sort of observation keys by merging ascending runs -----------------
+* args   : obskey_t *key  IO  keys
+*          obskey_t *work I   work buffer (n)
+*          int    *run    I   work buffer of run indices (n+1)
+*          int    n       I   number of keys
+*          cmp            I   compare function of keys
+* return : none
+* notes  : O(n) for sorted keys and O(n log r) for r ascending runs as
+*          concatenated observation files
 *-----------------------------------------------------------------------------*/
-extern int sortobs(obs_t *obs)
+static void sortkey(obskey_t *key, obskey_t *work, int *run, int n,
+                    int (*cmp)(const obskey_t *, const obskey_t *))
 {
-    int i,j,n;
+    obskey_t *src=key,*dst=work,*tmp;
+    int i,j,k,l,m,nrun,a,b,c;
     
-    trace(3,"sortobs: nobs=%d\n",obs->n);
+    for (i=nrun=0;i<n;i=j) {
+        run[nrun++]=i;
+        for (j=i+1;j<n&&cmp(key+j-1,key+j)<=0;j++) ;
+    }
+    while (nrun>1) {
+        for (i=m=0;i<nrun;i+=2) {
+            a=run[i];
+            b=i+1<nrun?run[i+1]:n;
+            c=i+2<nrun?run[i+2]:n;
+            run[m++]=a;
+            for (j=a,k=b,l=a;j<b&&k<c;) {
+                dst[l++]=cmp(src+k,src+j)<0?src[k++]:src[j++];
+            }
+            if (j<b) memcpy(dst+l,src+j,sizeof(obskey_t)*(b-j));
+            if (k<c) memcpy(dst+l,src+k,sizeof(obskey_t)*(c-k));
+        }
+        nrun=m;
+        tmp=src; src=dst; dst=tmp;
+    }
+    if (src!=key) memcpy(key,src,sizeof(obskey_t)*n);
+}
+/* time difference of observation keys (same as timediff()) -----------------*/
+static double keydiff(const obskey_t *q1, const obskey_t *q2)
+{
+    return difftime(q1->time,q2->time)+q1->sec-q2->sec;
+}
+/* gather observation data records in order of keys in place ----------------
+* args   : obsd_t *data   IO  observation data records
+*          obskey_t *key  IO  keys of records (index is set to the position)
+*          int    *need   I   work buffer of flags (nd)
+*          int    n       I   number of keys
+*          int    nd      I   number of data records (nd>=n)
+* return : none
+* notes  : data[i]=data[key[i].index] (i=0..n-1) by moving each record once
+*-----------------------------------------------------------------------------*/
+static void gatherobs(obsd_t *data, obskey_t *key, int *need, int n, int nd)
+{
+    obsd_t tmp;
+    int i,j,k;
+    
+    for (i=0;i<nd;i++) need[i]=0;
+    for (i=0;i<n;i++) need[key[i].index]=1;
+    
+    /* paths starting from positions whose records are not needed */
+    for (i=0;i<n;i++) {
+        if (need[i]) continue;
+        for (j=i;j<n&&key[j].index!=j;j=k) {
+            k=key[j].index;
+            data[j]=data[k];
+            key[j].index=j;
+        }
+    }
+    /* remaining cycles */
+    for (i=0;i<n;i++) {
+        if (key[i].index==i) continue;
+        tmp=data[i];
+        for (j=i;(k=key[j].index)!=i;j=k) {
+            data[j]=data[k];
+            key[j].index=j;
+        }
+        data[j]=tmp;
+        key[j].index=j;
+    }
+}
+/* sort and unique observation data with sort keys ---------------------------*/
+static int sortobskey(obs_t *obs)
+{
+    obskey_t *key,*work;
+    int i,j,n,*run;
+    
+    key =(obskey_t *)malloc(sizeof(obskey_t)*obs->n);
+    work=(obskey_t *)malloc(sizeof(obskey_t)*obs->n);
+    run =(int *)malloc(sizeof(int)*(obs->n+1));
+    
+    if (!key||!work||!run) {
+        free(key); free(work); free(run);
+        return -1;
+    }
+    for (i=0;i<obs->n;i++) {
+        key[i].time =obs->data[i].time.time;
+        key[i].sec  =obs->data[i].time.sec;
+        key[i].id   =obs->data[i].rcv<<8|obs->data[i].sat;
+        key[i].index=i;
+    }
+    /* sort by time */
+    sortkey(key,work,run,obs->n,cmpkeyt);
+    
+    /* sort by rcv and sat in epochs within DTTOL */
+    for (i=0;i<obs->n;i=j) {
+        for (j=i+1;j<obs->n;j++) {
+            if (keydiff(key+j,key+i)>DTTOL) break;
+        }
+        if (j-i>1) sortkey(key+i,work,run,j-i,cmpkeyr);
+    }
+    /* delete duplicated data */
+    for (i=j=0;i<obs->n;i++) {
+        if (key[i].id!=key[j].id||keydiff(key+i,key+j)!=0.0) key[++j]=key[i];
+    }
+    n=j+1;
+    free(work);
+    
+    /* gather data records in sorted order */
+    gatherobs(obs->data,key,run,n,obs->n);
+    obs->n=n;
+    
+    /* count epochs */
+    for (i=n=0;i<obs->n;i=j,n++) {
+        for (j=i+1;j<obs->n;j++) {
+            if (keydiff(key+j,key+i)>DTTOL) break;
+        }
+    }
+    free(key); free(run);
+    return n;
+}
+/* sort and unique observation data --------------------------------------------
+* sort and unique observation data by time, rcv, sat
+* args   : obs_t *obs    IO     observation data
+* return : number of epochs
+* notes  : data are sorted by time, then by rcv and sat in each epoch whose
+*          times are within DTTOL from the first one
+*-----------------------------------------------------------------------------*/
+extern int sortobs(obs_t *obs)
+{
+    int i,j,n;
+    
+    trace(3,"sortobs: nobs=%d\n",obs->n);
     
     if (obs->n<=0) return 0;
     
+    if ((n=sortobskey(obs))>=0) return n;
+    
     qsort(obs->data,obs->n,sizeof(obsd_t),cmpobs);
     
     /* delete duplicated data */
@@ -2748,13 +3578,59 @@ extern void freenav(nav_t *nav, int opt)
 /* debug trace functions -----------------------------------------------------*/
 #ifdef TRACE
 
+#define MAXTRACERING 32             /* max number of trace ring buffers */
+#define TRACERINGSIZE 0x100000      /* size of trace ring buffer (bytes) (2^n) */
+#define MAXTRACEREC 4096            /* max length of binary trace record */
+#define NTRACEFMT   16384           /* size of trace format table (2^n) */
+#define TRACEBCYCLE 10              /* cycle of binary trace writer (ms) */
+
+#ifdef WIN32
+#define MEMBAR()    MemoryBarrier()
+#else
+#define MEMBAR()    __sync_synchronize()
+#endif
+
+typedef struct {                    /* trace ring buffer of a thread */
+    unsigned char *buff;            /* ring buffer */
+    volatile unsigned int wp;       /* write pointer (free running) */
+    volatile unsigned int rp;       /* read pointer (free running) */
+    volatile unsigned int lost;     /* number of lost records */
+    unsigned int nlost;             /* number of lost records output */
+    volatile int state;             /* state (0:free,1:used,2:thread exited) */
+} tracering_t;
+
 static FILE *fp_trace=NULL;     /* file pointer of trace */
 static char file_trace[1024];   /* trace file */
-static int level_trace=0;       /* level of trace */
+int level_trace=0;              /* level of trace */
 static unsigned int tick_trace=0; /* tick time at traceopen (ms) */
 static gtime_t time_trace={0};  /* time at traceopen */
 static lock_t lock_trace;       /* lock for trace */
 
+static int mode_trace=0;        /* trace mode (0:text,1:binary) */
+static volatile int state_trace=0; /* state of binary trace writer */
+static thread_t thread_trace;   /* binary trace writer thread */
+static tracering_t ring_trace[MAXTRACERING]; /* trace ring buffers */
+static const char *fmt_trace[NTRACEFMT]; /* trace formats output */
+static unsigned short fid_trace[NTRACEFMT]; /* trace format ids */
+static int nfmt_trace=0;        /* number of trace formats output */
+static int key_init=0;          /* thread key initialized flag */
+#ifdef WIN32
+static DWORD key_trace;         /* thread key of trace ring buffer */
+#else
+static pthread_key_t key_trace; /* thread key of trace ring buffer */
+#endif
+
+/* write binary trace file header --------------------------------------------*/
+static void tracebhead(void)
+{
+    unsigned int endian=0x01020304,size=sizeof(long);
+    
+    fwrite(TRACEB_MAGIC,1,8,fp_trace);
+    fwrite(&endian,4,1,fp_trace);
+    fwrite(&size,4,1,fp_trace);
+    nfmt_trace=0;
+    memset(fmt_trace,0,sizeof(fmt_trace));
+}
 static void traceswap(void)
 {
     gtime_t time=utc2gpst(timeget());
@@ -2775,10 +3651,272 @@ static void traceswap(void)
     }
     if (fp_trace) fclose(fp_trace);
     
-    if (!(fp_trace=fopen(path,"w"))) {
+    if (!(fp_trace=fopen(path,mode_trace?"wb":"w"))) {
         fp_trace=stderr;
     }
+    else if (mode_trace) tracebhead();
+    
+    unlock(&lock_trace);
+}
+/* ring buffer of binary trace -----------------------------------------------*/
+static void tracebexit(void *arg)
+{
+    ((tracering_t *)arg)->state=2;
+}
+static tracering_t *tracering(void)
+{
+    tracering_t *r=NULL;
+    int i;
+    
+#ifdef WIN32
+    if ((r=(tracering_t *)TlsGetValue(key_trace))) return r;
+#else
+    if ((r=(tracering_t *)pthread_getspecific(key_trace))) return r;
+#endif
+    lock(&lock_trace);
+    for (i=0;i<MAXTRACERING;i++) {
+        if (ring_trace[i].state) continue;
+        if (!ring_trace[i].buff&&
+            !(ring_trace[i].buff=(unsigned char *)malloc(TRACERINGSIZE))) {
+            break;
+        }
+        r=ring_trace+i;
+        r->rp=r->wp;
+        r->nlost=r->lost;
+        r->state=1;
+#ifdef WIN32
+        TlsSetValue(key_trace,r);
+#else
+        pthread_setspecific(key_trace,r);
+#endif
+        break;
+    }
     unlock(&lock_trace);
+    return r;
+}
+static void ringcopy(unsigned char *buff, unsigned int pos, unsigned char *p,
+                     int n, int put)
+{
+    int i=(int)(pos&(TRACERINGSIZE-1)),k=TRACERINGSIZE-i;
+    
+    if (n<=k) {
+        if (put) memcpy(buff+i,p,n); else memcpy(p,buff+i,n);
+    }
+    else if (put) {
+        memcpy(buff+i,p,k); memcpy(buff,p+k,n-k);
+    }
+    else {
+        memcpy(p,buff+i,k); memcpy(p+k,buff,n-k);
+    }
+}
+/* put binary trace record to ring buffer ------------------------------------*/
+static void tracebput(unsigned char *rec, int len)
+{
+    tracering_t *r;
+    unsigned short n=(unsigned short)len;
+    unsigned int wp,rp;
+    
+    if (!(r=tracering())) return;
+    wp=r->wp;
+    rp=r->rp;
+    MEMBAR();
+    
+    if (len<=0||len>TRACERINGSIZE-(int)(wp-rp)) {
+        r->lost++;
+        return;
+    }
+    memcpy(rec,&n,2);
+    ringcopy(r->buff,wp,rec,len,1);
+    MEMBAR();
+    r->wp=wp+len;
+}
+/* set binary trace record header --------------------------------------------*/
+static int tracebrec(unsigned char *rec, int type, int level)
+{
+    unsigned int tick=tickget()-tick_trace;
+    
+    rec[2]=(unsigned char)type;
+    rec[3]=(unsigned char)level;
+    rec[4]=rec[5]=rec[6]=rec[7]=0;
+    memcpy(rec+8,&tick,4);
+    return TRACEB_HLEN;
+}
+static int putlong(unsigned char *rec, int n, long val)
+{
+    if (n<0||n+(int)sizeof(long)>MAXTRACEREC) return -1;
+    memcpy(rec+n,&val,sizeof(long));
+    return n+(int)sizeof(long);
+}
+/* put formatted binary trace ------------------------------------------------*/
+static void tracebfmt(int type, int level, const char *format, va_list ap)
+{
+    unsigned char rec[MAXTRACEREC];
+    const char *p;
+    char *s;
+    double d;
+    int i,j,n,nl;
+    
+    n=tracebrec(rec,type,level);
+    memcpy(rec+n,&format,sizeof(format)); n+=(int)sizeof(format);
+    
+    for (p=format;*p&&n>=0;p++) {
+        if (*p!='%') continue;
+        if (!*++p) break;
+        if (*p=='%') continue;
+        
+        while (*p&&strchr("-+ #0",*p)) p++;
+        for (i=0;i<2;i++) { /* width and precision */
+            if (i==1) {
+                if (*p!='.') break;
+                p++;
+            }
+            if (*p=='*') {
+                n=putlong(rec,n,(long)va_arg(ap,int)); p++;
+            }
+            else while (isdigit((int)*p)) p++;
+        }
+        for (nl=0;*p=='h'||*p=='l';p++) if (*p=='l') nl++;
+        
+        switch (nl>1?'\0':*p) {
+            case 'd': case 'i': case 'c':
+                n=putlong(rec,n,nl?va_arg(ap,long):(long)va_arg(ap,int));
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                n=putlong(rec,n,nl?(long)va_arg(ap,unsigned long):
+                                   (long)va_arg(ap,unsigned int));
+                break;
+            case 'e': case 'E': case 'f': case 'g': case 'G':
+                d=va_arg(ap,double);
+                if (n+(int)sizeof(double)>MAXTRACEREC) n=-1;
+                else {memcpy(rec+n,&d,sizeof(double)); n+=(int)sizeof(double);}
+                break;
+            case 's':
+                if (!(s=va_arg(ap,char *))) s="(null)";
+                j=(int)strlen(s);
+                if (j>MAXTRACEREC-n-1) j=MAXTRACEREC-n-1;
+                if (j<0) {n=-1; break;}
+                memcpy(rec+n,s,j); rec[n+j]='\0'; n+=j+1;
+                break;
+            default: /* unsupported conversion */
+                n=-1;
+                break;
+        }
+        if (!*p) break;
+    }
+    tracebput(rec,n);
+}
+/* put matrix to binary trace ------------------------------------------------*/
+static void tracebmat(int level, const double *A, int n, int m, int p, int q)
+{
+    const int nmax=(MAXTRACEREC-TRACEB_HLEN-16)/(int)sizeof(double);
+    unsigned char rec[MAXTRACEREC];
+    int i,j,k,len,nd,hd[4];
+    
+    for (i=0;i<n;i++) {
+        j=0;
+        do {
+            nd=m-j<nmax?m-j:nmax;
+            hd[0]=p; hd[1]=q; hd[2]=j+nd>=m; hd[3]=nd;
+            len=tracebrec(rec,TRACEB_MAT,level);
+            memcpy(rec+len,hd,16); len+=16;
+            for (k=0;k<nd;k++,len+=(int)sizeof(double)) {
+                memcpy(rec+len,A+i+(j+k)*n,sizeof(double));
+            }
+            tracebput(rec,len);
+            j+=nd;
+        } while (j<m);
+    }
+}
+/* write binary trace records in ring buffers to file ------------------------*/
+static void tracebwrite(void)
+{
+    tracering_t *r;
+    unsigned char rec[MAXTRACEREC];
+    const char *format;
+    unsigned short len,fid;
+    unsigned int wp,nlost,ndrop;
+    int i,j,type,ptr=(int)sizeof(format);
+    
+    for (i=0;i<MAXTRACERING;i++) {
+        r=ring_trace+i;
+        if (!r->buff||!r->state) continue;
+        
+        wp=r->wp;
+        ndrop=0;
+        MEMBAR();
+        
+        while (r->rp!=wp) {
+            ringcopy(r->buff,r->rp,rec,2,0);
+            memcpy(&len,rec,2);
+            ringcopy(r->buff,r->rp,rec,len,0);
+            MEMBAR();
+            r->rp+=len;
+            
+            rec[4]=(unsigned char)i;
+            type=rec[2];
+            if (type!=TRACEB_MSG&&type!=TRACEB_MSGT&&type!=TRACEB_RAW) {
+                fwrite(rec,1,len,fp_trace);
+                continue;
+            }
+            /* format pointer to format id */
+            memcpy(&format,rec+TRACEB_HLEN,ptr);
+            j=(int)(((unsigned long)format>>2)&(NTRACEFMT-1));
+            while (fmt_trace[j]&&fmt_trace[j]!=format) j=(j+1)&(NTRACEFMT-1);
+            
+            if (!fmt_trace[j]) {
+                if (nfmt_trace>=NTRACEFMT/2) { /* table of formats full */
+                    ndrop++;
+                    continue;
+                }
+                fmt_trace[j]=format;
+                fid_trace[j]=(unsigned short)nfmt_trace++;
+                
+                /* write format record */
+                fid=(unsigned short)(TRACEB_HLEN+strlen(format)+1);
+                fwrite(&fid,2,1,fp_trace);
+                fputc(TRACEB_FMT,fp_trace);
+                fputc(0,fp_trace);
+                fputc(i,fp_trace);
+                fputc(0,fp_trace);
+                fwrite(fid_trace+j,2,1,fp_trace);
+                fwrite(rec+8,4,1,fp_trace);
+                fwrite(format,1,strlen(format)+1,fp_trace);
+            }
+            len-=(unsigned short)ptr;
+            memcpy(rec,&len,2);
+            memcpy(rec+6,fid_trace+j,2);
+            fwrite(rec,1,TRACEB_HLEN,fp_trace);
+            fwrite(rec+TRACEB_HLEN+ptr,1,len-TRACEB_HLEN,fp_trace);
+        }
+        if ((nlost=r->lost)!=r->nlost||ndrop) {
+            len=TRACEB_HLEN+4;
+            j=tracebrec(rec,TRACEB_LOST,0);
+            memcpy(rec,&len,2);
+            rec[4]=(unsigned char)i;
+            r->nlost=nlost-r->nlost+ndrop;
+            memcpy(rec+j,&r->nlost,4);
+            fwrite(rec,1,len,fp_trace);
+            r->nlost=nlost;
+        }
+        if (r->state==2) r->state=0;
+    }
+}
+/* binary trace writer thread ------------------------------------------------*/
+#ifdef WIN32
+static DWORD WINAPI tracebthread(void *arg)
+#else
+static void *tracebthread(void *arg)
+#endif
+{
+    while (state_trace) {
+        traceswap();
+        tracebwrite();
+        fflush(fp_trace);
+        sleepms(TRACEBCYCLE);
+    }
+    tracebwrite();
+    fflush(fp_trace);
+    return 0;
 }
 extern void traceopen(const char *file)
 {
@@ -2792,8 +3930,74 @@ extern void traceopen(const char *file)
     time_trace=time;
     initlock(&lock_trace);
 }
+/* open binary trace -----------------------------------------------------------
+* open trace file in binary format. the trace records are put to ring buffers
+* of the calling threads without lock and written to the file by the writer
+* thread. the file is converted to text by util/convtrace
+* args   : char   *file     I   trace file path (with keywords)
+* return : none
+* notes  : the trace is output as text to stderr if the file or the writer
+*          thread can not be opened. a record is lost if the ring buffer of
+*          the thread is full or the table of formats (NTRACEFMT/2) is full.
+*          the format of trace() and tracet() must be a string literal, as
+*          the writer thread reads it after the call returns and identifies
+*          it by the pointer (checked at compile time by the trace macros of
+*          c99 or later compilers).
+*          the ring buffers of exited threads are not reused with WIN32
+*-----------------------------------------------------------------------------*/
+extern void traceopenb(const char *file)
+{
+    gtime_t time=utc2gpst(timeget());
+    char path[1024];
+    int i;
+    
+    if (!key_init) {
+        initlock(&lock_trace);
+#ifdef WIN32
+        key_trace=TlsAlloc();
+#else
+        pthread_key_create(&key_trace,tracebexit);
+#endif
+        key_init=1;
+    }
+    reppath(file,path,time,"","");
+    if (!*path||!(fp_trace=fopen(path,"wb"))) {
+        fp_trace=stderr;
+        return;
+    }
+    strcpy(file_trace,file);
+    tick_trace=tickget();
+    time_trace=time;
+    
+    for (i=0;i<MAXTRACERING;i++) {
+        ring_trace[i].rp=ring_trace[i].wp;
+        ring_trace[i].nlost=ring_trace[i].lost;
+    }
+    tracebhead();
+    mode_trace=state_trace=1;
+    
+#ifdef WIN32
+    if (!(thread_trace=CreateThread(NULL,0,tracebthread,NULL,0,NULL))) {
+#else
+    if (pthread_create(&thread_trace,NULL,tracebthread,NULL)) {
+#endif
+        mode_trace=state_trace=0;
+        fclose(fp_trace);
+        fp_trace=stderr;
+    }
+}
 extern void traceclose(void)
 {
+    if (mode_trace) {
+        state_trace=0;
+#ifdef WIN32
+        WaitForSingleObject(thread_trace,10000);
+        CloseHandle(thread_trace);
+#else
+        pthread_join(thread_trace,NULL);
+#endif
+        mode_trace=0;
+    }
     if (fp_trace&&fp_trace!=stderr) fclose(fp_trace);
     fp_trace=NULL;
     file_trace[0]='\0';
@@ -2802,7 +4006,17 @@ extern void tracelevel(int level)
 {
     level_trace=level;
 }
-extern void trace(int level, const char *format, ...)
+/* output trace text without level -------------------------------------------*/
+static void tracefp(int level, const char *format, ...)
+{
+    va_list ap;
+    
+    va_start(ap,format);
+    if (mode_trace) tracebfmt(TRACEB_RAW,level,format,ap);
+    else vfprintf(fp_trace,format,ap);
+    va_end(ap);
+}
+extern void (trace)(int level, const char *format, ...)
 {
     va_list ap;
     
@@ -2811,27 +4025,39 @@ extern void trace(int level, const char *format, ...)
         va_start(ap,format); vfprintf(stderr,format,ap); va_end(ap);
     }
     if (!fp_trace||level>level_trace) return;
+    if (mode_trace) {
+        va_start(ap,format); tracebfmt(TRACEB_MSG,level,format,ap); va_end(ap);
+        return;
+    }
     traceswap();
     fprintf(fp_trace,"%d ",level);
     va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
     fflush(fp_trace);
 }
-extern void tracet(int level, const char *format, ...)
+extern void (tracet)(int level, const char *format, ...)
 {
     va_list ap;
     
     if (!fp_trace||level>level_trace) return;
+    if (mode_trace) {
+        va_start(ap,format); tracebfmt(TRACEB_MSGT,level,format,ap); va_end(ap);
+        return;
+    }
     traceswap();
     fprintf(fp_trace,"%d %9.3f: ",level,(tickget()-tick_trace)/1000.0);
     va_start(ap,format); vfprintf(fp_trace,format,ap); va_end(ap);
     fflush(fp_trace);
 }
-extern void tracemat(int level, const double *A, int n, int m, int p, int q)
+extern void (tracemat)(int level, const double *A, int n, int m, int p, int q)
 {
     if (!fp_trace||level>level_trace) return;
+    if (mode_trace) {
+        tracebmat(level,A,n,m,p,q);
+        return;
+    }
     matfprint(A,n,m,p,q,fp_trace); fflush(fp_trace);
 }
-extern void traceobs(int level, const obsd_t *obs, int n)
+extern void (traceobs)(int level, const obsd_t *obs, int n)
 {
     char str[64],id[16];
     int i;
@@ -2840,14 +4066,14 @@ extern void traceobs(int level, const obsd_t *obs, int n)
     for (i=0;i<n;i++) {
         time2str(obs[i].time,str,3);
         satno2id(obs[i].sat,id);
-        fprintf(fp_trace," (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
+        tracefp(level," (%2d) %s %-3s rcv%d %13.3f %13.3f %13.3f %13.3f %d %d %d %d %3.1f %3.1f\n",
               i+1,str,id,obs[i].rcv,obs[i].L[0],obs[i].L[1],obs[i].P[0],
               obs[i].P[1],obs[i].LLI[0],obs[i].LLI[1],obs[i].code[0],
               obs[i].code[1],obs[i].SNR[0]*0.25,obs[i].SNR[1]*0.25);
     }
-    fflush(fp_trace);
+    if (!mode_trace) fflush(fp_trace);
 }
-extern void tracenav(int level, const nav_t *nav)
+extern void (tracenav)(int level, const nav_t *nav)
 {
     char s1[64],s2[64],id[16];
     int i;
@@ -2857,17 +4083,17 @@ extern void tracenav(int level, const nav_t *nav)
         time2str(nav->eph[i].toe,s1,0);
         time2str(nav->eph[i].ttr,s2,0);
         satno2id(nav->eph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
+        tracefp(level,"(%3d) %-3s : %s %s %3d %3d %02x\n",i+1,
                 id,s1,s2,nav->eph[i].iode,nav->eph[i].iodc,nav->eph[i].svh);
     }
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
+    tracefp(level,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[0],
             nav->ion_gps[1],nav->ion_gps[2],nav->ion_gps[3]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
+    tracefp(level,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gps[4],
             nav->ion_gps[5],nav->ion_gps[6],nav->ion_gps[7]);
-    fprintf(fp_trace,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
+    tracefp(level,"(ion) %9.4e %9.4e %9.4e %9.4e\n",nav->ion_gal[0],
             nav->ion_gal[1],nav->ion_gal[2],nav->ion_gal[3]);
 }
-extern void tracegnav(int level, const nav_t *nav)
+extern void (tracegnav)(int level, const nav_t *nav)
 {
     char s1[64],s2[64],id[16];
     int i;
@@ -2877,11 +4103,11 @@ extern void tracegnav(int level, const nav_t *nav)
         time2str(nav->geph[i].toe,s1,0);
         time2str(nav->geph[i].tof,s2,0);
         satno2id(nav->geph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
+        tracefp(level,"(%3d) %-3s : %s %s %2d %2d %8.3f\n",i+1,
                 id,s1,s2,nav->geph[i].frq,nav->geph[i].svh,nav->geph[i].taun*1E6);
     }
 }
-extern void tracehnav(int level, const nav_t *nav)
+extern void (tracehnav)(int level, const nav_t *nav)
 {
     char s1[64],s2[64],id[16];
     int i;
@@ -2891,11 +4117,11 @@ extern void tracehnav(int level, const nav_t *nav)
         time2str(nav->seph[i].t0,s1,0);
         time2str(nav->seph[i].tof,s2,0);
         satno2id(nav->seph[i].sat,id);
-        fprintf(fp_trace,"(%3d) %-3s : %s %s %2d %2d\n",i+1,
+        tracefp(level,"(%3d) %-3s : %s %s %2d %2d\n",i+1,
                 id,s1,s2,nav->seph[i].svh,nav->seph[i].sva);
     }
 }
-extern void tracepeph(int level, const nav_t *nav)
+extern void (tracepeph)(int level, const nav_t *nav)
 {
     char s[64],id[16];
     int i,j;
@@ -2906,7 +4132,7 @@ extern void tracepeph(int level, const nav_t *nav)
         time2str(nav->peph[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
+            tracefp(level,"%-3s %d %-3s %13.3f %13.3f %13.3f %13.3f %6.3f %6.3f %6.3f %6.3f\n",
                     s,nav->peph[i].index,id,
                     nav->peph[i].pos[j][0],nav->peph[i].pos[j][1],
                     nav->peph[i].pos[j][2],nav->peph[i].pos[j][3]*1E9,
@@ -2915,7 +4141,7 @@ extern void tracepeph(int level, const nav_t *nav)
         }
     }
 }
-extern void tracepclk(int level, const nav_t *nav)
+extern void (tracepclk)(int level, const nav_t *nav)
 {
     char s[64],id[16];
     int i,j;
@@ -2926,33 +4152,40 @@ extern void tracepclk(int level, const nav_t *nav)
         time2str(nav->pclk[i].time,s,0);
         for (j=0;j<MAXSAT;j++) {
             satno2id(j+1,id);
-            fprintf(fp_trace,"%-3s %d %-3s %13.3f %6.3f\n",
+            tracefp(level,"%-3s %d %-3s %13.3f %6.3f\n",
                     s,nav->pclk[i].index,id,
                     nav->pclk[i].clk[j][0]*1E9,nav->pclk[i].std[j][0]*1E9);
         }
     }
 }
-extern void traceb(int level, const unsigned char *p, int n)
+extern void (traceb)(int level, const unsigned char *p, int n)
 {
+    char str[256]="",*q=str;
     int i;
     if (!fp_trace||level>level_trace) return;
-    for (i=0;i<n;i++) fprintf(fp_trace,"%02X%s",*p++,i%8==7?" ":"");
-    fprintf(fp_trace,"\n");
+    for (i=0;i<n;i++) {
+        q+=sprintf(q,"%02X%s",*p++,i%8==7?" ":"");
+        if (q-str>=240) {tracefp(level,"%s",str); *(q=str)='\0';}
+    }
+    tracefp(level,"%s\n",str);
 }
 #else
+int level_trace=0;              /* level of trace (always 0) */
+
 extern void traceopen(const char *file) {}
+extern void traceopenb(const char *file) {}
 extern void traceclose(void) {}
 extern void tracelevel(int level) {}
-extern void trace   (int level, const char *format, ...) {}
-extern void tracet  (int level, const char *format, ...) {}
-extern void tracemat(int level, const double *A, int n, int m, int p, int q) {}
-extern void traceobs(int level, const obsd_t *obs, int n) {}
-extern void tracenav(int level, const nav_t *nav) {}
-extern void tracegnav(int level, const nav_t *nav) {}
-extern void tracehnav(int level, const nav_t *nav) {}
-extern void tracepeph(int level, const nav_t *nav) {}
-extern void tracepclk(int level, const nav_t *nav) {}
-extern void traceb  (int level, const unsigned char *p, int n) {}
+extern void (trace)   (int level, const char *format, ...) {}
+extern void (tracet)  (int level, const char *format, ...) {}
+extern void (tracemat)(int level, const double *A, int n, int m, int p, int q) {}
+extern void (traceobs)(int level, const obsd_t *obs, int n) {}
+extern void (tracenav)(int level, const nav_t *nav) {}
+extern void (tracegnav)(int level, const nav_t *nav) {}
+extern void (tracehnav)(int level, const nav_t *nav) {}
+extern void (tracepeph)(int level, const nav_t *nav) {}
+extern void (tracepclk)(int level, const nav_t *nav) {}
+extern void (traceb)  (int level, const unsigned char *p, int n) {}
 
 #endif /* TRACE */
 
@@ -3059,26 +4292,36 @@ extern int expath(const char *path, char *paths[], int nmax)
     return n;
 }
 /* create directory ------------------------------------------------------------
-* create directory if not exist
+* create directory and its parents if not exist
 * args   : char   *path     I   file path to be saved
 * return : none
-* notes  : not recursive. only one level
+* notes  : the directories up to the last path separator are created
 *-----------------------------------------------------------------------------*/
 extern void createdir(const char *path)
 {
     char buff[1024],*p;
+    int stat;
     
     tracet(3,"createdir: path=%s\n",path);
     
+    if (strlen(path)>=sizeof(buff)) {
+        trace(2,"createdir: path too long %s\n",path);
+        return;
+    }
     strcpy(buff,path);
-    if (!(p=strrchr(buff,FILEPATHSEP))) return;
-    *p='\0';
     
+    for (p=buff+1;*p;p++) {
+        if ((*p!=FILEPATHSEP&&*p!='/')||p[-1]==FILEPATHSEP||p[-1]=='/'||
+            p[-1]==':') continue;
+        *p='\0';
 #ifdef WIN32
-    CreateDirectory(buff,NULL);
+        stat=CreateDirectory(buff,NULL)||GetLastError()==ERROR_ALREADY_EXISTS;
 #else
-    mkdir(buff,0777);
+        stat=!mkdir(buff,0777)||errno==EEXIST;
 #endif
+        if (!stat) trace(2,"createdir: directory create error %s\n",buff);
+        *p=FILEPATHSEP;
+    }
 }
 /* replace string ------------------------------------------------------------*/
 static int repstr(char *str, const char *pat, const char *rep)
@@ -3759,84 +5002,1033 @@ extern void csmooth(obs_t *obs, int ns)
         }
     }
 }
-/* uncompress file -------------------------------------------------------------
-* uncompress (uncompress/unzip/uncompact hatanaka-compression/tar) file
-* args   : char   *file     I   input file
-*          char   *uncfile  O   uncompressed file
-* return : status (-1:error,0:not compressed file,1:uncompress completed)
-* note   : creates uncompressed file in tempolary directory
-*          gzip and crx2rnx commands have to be installed in commands path
+/* in-process decompression ----------------------------------------------------
+* gzip (deflate), unix compress (lzw) and hatanaka-compression (crinex 1.0 and
+* 3.0) are decoded in-process and the decoded file is read as lines
 *-----------------------------------------------------------------------------*/
-extern int uncompress(const char *file, char *uncfile)
+#define NDECBUFF    32768           /* size of decompression buffers */
+#define GZWINSIZE   65536           /* size of deflate window buffer */
+#define GZFASTBITS  9               /* bits of fast huffman code table */
+#define LZWMAXBITS  16              /* max code bits of unix compress */
+#define MAXCRXLEN   4096            /* max line length of crinex */
+#define MAXCRXORD   9               /* max order of crinex differences */
+
+typedef struct {                    /* unix compress (lzw) decoder */
+    unsigned char in[NDECBUFF];     /* input buffer */
+    int nin,iin;                    /* number of bytes/index in input buffer */
+    unsigned long bits;             /* bit buffer */
+    int nbit;                       /* number of bits in bit buffer */
+    int maxbits,block;              /* max code bits/block mode */
+    int nbits,maxcode,freeent;      /* code bits/max code/next free entry */
+    int oldcode,finchar;            /* previous code/first char of string */
+    int ncode;                      /* number of codes in code group */
+    int nstk;                       /* number of chars in output stack */
+    int err;                        /* decoding error */
+    unsigned short prefix[1<<LZWMAXBITS]; /* prefix codes of entries */
+    unsigned char suffix[1<<LZWMAXBITS]; /* suffix chars of entries */
+    unsigned char stack[1<<LZWMAXBITS]; /* output stack */
+} lzw_t;
+
+typedef struct {                    /* huffman code table of deflate */
+    short count[16];                /* number of codes of each length */
+    short symbol[320];              /* symbols ordered by codes */
+    unsigned short fast[1<<GZFASTBITS]; /* symbols by short codes (len<<9|sym) */
+} huff_t;
+
+typedef struct {                    /* gzip (deflate) decoder */
+    unsigned char in[NDECBUFF];     /* input buffer */
+    int nin,iin;                    /* number of bytes/index in input buffer */
+    unsigned long bits;             /* bit buffer */
+    int nbit;                       /* number of bits in bit buffer */
+    unsigned char win[GZWINSIZE];   /* sliding window of decoded data */
+    int wp,rp;                      /* write/read pointer of window */
+    int state;                      /* state (0:member header,1:block header,
+                                       2:stored block,3:huffman block,
+                                       4:member trailer,5:end) */
+    int last;                       /* last block of member */
+    int len;                        /* remaining length of stored block */
+    int nmem;                       /* number of members decoded */
+    int err;                        /* decoding error */
+    unsigned int crc;               /* crc-32 of decoded data of member */
+    unsigned long size;             /* size of decoded data of member */
+    huff_t lit,dist;                /* literal/length and distance codes */
+} gzd_t;
+
+typedef struct {                    /* crinex data arc */
+    int ord;                        /* order of differences (-1: no data) */
+    int n;                          /* current order of differences */
+    double y[MAXCRXORD+1];          /* value and differences (integer) */
+} crxarc_t;
+
+typedef struct {                    /* crinex satellite data */
+    char id[4];                     /* satellite id */
+    char flag[MAXOBSTYPE*2+1];      /* lli and signal strength flags */
+    crxarc_t arc[MAXOBSTYPE];       /* data arcs of obs types */
+} crxsat_t;
+
+typedef struct {                    /* crinex decoder */
+    int ver;                        /* crinex version (1,3) */
+    int hdr;                        /* end of header read */
+    int ntype[128];                 /* number of obs types (by system code) */
+    char epoch[MAXCRXLEN];          /* epoch line of previous epoch */
+    char line[MAXCRXLEN];           /* input line */
+    crxarc_t clk;                   /* receiver clock offset */
+    crxsat_t *sat,*prev;            /* satellite data (current/previous) */
+    int nsat,nprev,nmaxsat;         /* number of satellites/allocated */
+    char *out;                      /* decoded rinex lines of epoch */
+    int nout,iout,nmaxout;          /* number of chars/index/allocated */
+} crx_t;
+
+/* read bits of lzw code -----------------------------------------------------*/
+static int lzw_getbits(lzw_t *z, FILE *fp, int n)
 {
-    int stat=0;
-    char *p,cmd[2048]="",tmpfile[1024]="",buff[1024],*fname,*dir="";
-    
-    trace(3,"uncompress: file=%s\n",file);
+    int val;
     
-    strcpy(tmpfile,file);
-    if (!(p=strrchr(tmpfile,'.'))) return 0;
+    while (z->nbit<n) {
+        if (z->iin>=z->nin) {
+            if ((z->nin=(int)fread(z->in,1,NDECBUFF,fp))<=0) return -1;
+            z->iin=0;
+        }
+        z->bits|=(unsigned long)z->in[z->iin++]<<z->nbit;
+        z->nbit+=8;
+    }
+    val=(int)(z->bits&((1UL<<n)-1));
+    z->bits>>=n; z->nbit-=n;
+    return val;
+}
+/* skip rest of lzw code group -----------------------------------------------*/
+static int lzw_skip(lzw_t *z, FILE *fp)
+{
+    /* codes are written in groups of 8 padded at change of code bits */
+    for (;z->ncode>0&&z->ncode<8;z->ncode++) {
+        if (lzw_getbits(z,fp,z->nbits)<0) return 0;
+    }
+    z->ncode=0;
+    return 1;
+}
+/* decode unix compress (lzw) ------------------------------------------------*/
+static int lzw_read(lzw_t *z, FILE *fp, unsigned char *buff, int size)
+{
+    int n=0,code,incode;
     
-    /* uncompress by gzip */
-    if (!strcmp(p,".z"  )||!strcmp(p,".Z"  )||
-        !strcmp(p,".gz" )||!strcmp(p,".GZ" )||
-        !strcmp(p,".zip")||!strcmp(p,".ZIP")) {
+    for (;;) {
+        /* output decoded string in stack */
+        while (z->nstk>0&&n<size) buff[n++]=z->stack[--z->nstk];
+        if (n>=size) break;
         
-        strcpy(uncfile,tmpfile); uncfile[p-tmpfile]='\0';
-        sprintf(cmd,"gzip -f -d -c \"%s\" > \"%s\"",tmpfile,uncfile);
+        /* increase code bits */
+        if (z->freeent>z->maxcode) {
+            if (!lzw_skip(z,fp)) break;
+            z->nbits++;
+            z->maxcode=z->nbits>=z->maxbits?1<<z->maxbits:(1<<z->nbits)-1;
+        }
+        if ((code=lzw_getbits(z,fp,z->nbits))<0) break;
+        z->ncode=(z->ncode+1)%8;
         
-        if (execcmd(cmd)) {
-            remove(uncfile);
-            return -1;
+        if (z->oldcode<0) { /* first code */
+            if (code>=256) {
+                trace(2,"lzw code error: code=%d\n",code);
+                z->err=1;
+                break;
+            }
+            z->oldcode=z->finchar=code;
+            z->stack[z->nstk++]=(unsigned char)code;
+            continue;
         }
-        strcpy(tmpfile,uncfile);
-        stat=1;
-    }
-    /* extract tar file */
-    if ((p=strrchr(tmpfile,'.'))&&!strcmp(p,".tar")) {
+        if (code==256&&z->block) { /* clear code table */
+            z->freeent=256;
+            if (!lzw_skip(z,fp)) break;
+            z->nbits=9;
+            z->maxcode=(1<<9)-1;
+            continue;
+        }
+        incode=code;
         
-        strcpy(uncfile,tmpfile); uncfile[p-tmpfile]='\0';
-        strcpy(buff,tmpfile);
-        fname=buff;
-#ifdef WIN32
-        if ((p=strrchr(buff,'\\'))) {
-            *p='\0'; dir=fname; fname=p+1;
+        if (code>=z->freeent) { /* string not yet in table */
+            if (code>z->freeent) {
+                trace(2,"lzw code error: code=%d\n",code);
+                z->err=1;
+                break;
+            }
+            z->stack[z->nstk++]=(unsigned char)z->finchar;
+            code=z->oldcode;
         }
-        sprintf(cmd,"set PATH=%%CD%%;%%PATH%% & cd /D \"%s\" & tar -xf \"%s\"",
-                dir,fname);
-#else
-        if ((p=strrchr(buff,'/'))) {
-            *p='\0'; dir=fname; fname=p+1;
+        while (code>=256&&z->nstk<(1<<LZWMAXBITS)-1) {
+            z->stack[z->nstk++]=z->suffix[code];
+            code=z->prefix[code];
         }
-        sprintf(cmd,"tar -C \"%s\" -xf \"%s\"",dir,tmpfile);
-#endif
-        if (execcmd(cmd)) {
-            if (stat) remove(tmpfile);
-            return -1;
+        if (code>=256) {
+            trace(2,"lzw code table error\n");
+            z->err=1;
+            break;
         }
-        if (stat) remove(tmpfile);
-        stat=1;
-    }
-    /* extract hatanaka-compressed file by cnx2rnx */
-    else if ((p=strrchr(tmpfile,'.'))&&strlen(p)>3&&(*(p+3)=='d'||*(p+3)=='D')) {
-        
-        strcpy(uncfile,tmpfile);
-        uncfile[p-tmpfile+3]=*(p+3)=='D'?'O':'o';
-        sprintf(cmd,"crx2rnx < \"%s\" > \"%s\"",tmpfile,uncfile);
+        z->finchar=code;
+        z->stack[z->nstk++]=(unsigned char)code;
         
-        if (execcmd(cmd)) {
-            remove(uncfile);
-            if (stat) remove(tmpfile);
-            return -1;
+        if (z->freeent<(1<<z->maxbits)) {
+            z->prefix[z->freeent]=(unsigned short)z->oldcode;
+            z->suffix[z->freeent++]=(unsigned char)z->finchar;
         }
-        if (stat) remove(tmpfile);
-        stat=1;
+        z->oldcode=incode;
     }
-    trace(3,"uncompress: stat=%d\n",stat);
-    return stat;
+    return n;
 }
-/* dummy application functions for shared library ----------------------------*/
-#ifdef DLL
+/* read bits of deflate stream -----------------------------------------------*/
+static int gz_need(gzd_t *g, FILE *fp, int n)
+{
+    while (g->nbit<n) {
+        if (g->iin>=g->nin) {
+            if ((g->nin=(int)fread(g->in,1,NDECBUFF,fp))<=0) {
+                g->nin=0;
+                return 0;
+            }
+            g->iin=0;
+        }
+        g->bits|=(unsigned long)g->in[g->iin++]<<g->nbit;
+        g->nbit+=8;
+    }
+    return 1;
+}
+static int gz_bits(gzd_t *g, FILE *fp, int n)
+{
+    int val;
+    
+    if (!gz_need(g,fp,n)) return -1;
+    val=(int)(g->bits&((1UL<<n)-1));
+    g->bits>>=n; g->nbit-=n;
+    return val;
+}
+/* construct huffman code table by code lengths ------------------------------*/
+static int gz_huff(huff_t *h, const short *len, int n)
+{
+    short offs[16];
+    int i,j,k,sym,left,code;
+    
+    memset(h->count,0,sizeof(h->count));
+    for (sym=0;sym<n;sym++) {
+        if (len[sym]<0||len[sym]>15) return 0;
+        h->count[len[sym]]++;
+    }
+    
+    for (i=1,left=1;i<16;i++) { /* over-subscribed */
+        left<<=1; left-=h->count[i];
+        if (left<0) return 0;
+    }
+    for (i=1,offs[1]=0;i<15;i++) offs[i+1]=offs[i]+h->count[i];
+    for (sym=0;sym<n;sym++) if (len[sym]) h->symbol[offs[len[sym]]++]=sym;
+    
+    /* table of bit-reversed codes up to fast bits */
+    memset(h->fast,0,sizeof(h->fast));
+    for (i=1,k=code=0;i<=GZFASTBITS;i++,code<<=1) {
+        for (j=0;j<h->count[i];j++,k++,code++) {
+            for (sym=0,left=0;left<i;left++) sym|=((code>>left)&1)<<(i-1-left);
+            for (;sym<(1<<GZFASTBITS);sym+=1<<i) {
+                h->fast[sym]=(unsigned short)(h->symbol[k]|(i<<9));
+            }
+        }
+    }
+    return 1;
+}
+/* decode huffman code -------------------------------------------------------*/
+static int gz_decode(gzd_t *g, FILE *fp, const huff_t *h)
+{
+    int i,b,code=0,first=0,index=0,count,e;
+    
+    gz_need(g,fp,GZFASTBITS);
+    
+    if ((e=h->fast[g->bits&((1<<GZFASTBITS)-1)])&&(e>>9)<=g->nbit) {
+        g->bits>>=e>>9; g->nbit-=e>>9;
+        return e&0x1FF;
+    }
+    for (i=1;i<16;i++) {
+        if ((b=gz_bits(g,fp,1))<0) return -1;
+        code|=b;
+        count=h->count[i];
+        if (code-count<first) return h->symbol[index+(code-first)];
+        index+=count; first+=count;
+        first<<=1; code<<=1;
+    }
+    return -1;
+}
+/* read gzip member header ---------------------------------------------------
+* return : status (1:ok,0:end of file,-1:error)
+*-----------------------------------------------------------------------------*/
+static int gz_header(gzd_t *g, FILE *fp)
+{
+    int i,flg,n,c;
+    
+    if ((c=gz_bits(g,fp,8))<0) { /* end of file */
+        if (g->nmem>0) return 0;
+        trace(2,"gzip header error: no data\n");
+        return -1;
+    }
+    if (c!=0x1F||gz_bits(g,fp,8)!=0x8B||gz_bits(g,fp,8)!=8) {
+        if (g->nmem>0) return 0; /* trailing garbage ignored */
+        trace(2,"gzip header error\n");
+        return -1;
+    }
+    if ((flg=gz_bits(g,fp,8))<0) return -1;
+    for (i=0;i<6;i++) { /* mtime,xfl,os */
+        if (gz_bits(g,fp,8)<0) return -1;
+    }
+    if (flg&4) { /* extra field */
+        if ((n=gz_bits(g,fp,16))<0) return -1;
+        for (i=0;i<n;i++) if (gz_bits(g,fp,8)<0) return -1;
+    }
+    if (flg&8 ) while ((c=gz_bits(g,fp,8))>0) ; /* file name */
+    if (c<0) return -1;
+    if (flg&16) while ((c=gz_bits(g,fp,8))>0) ; /* comment */
+    if (c<0) return -1;
+    if ((flg&2)&&gz_bits(g,fp,16)<0) return -1; /* header crc */
+    g->crc=0;
+    g->size=0;
+    return 1;
+}
+/* read deflate block header -------------------------------------------------*/
+static int gz_block(gzd_t *g, FILE *fp)
+{
+    static const short order[19]={
+        16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15
+    };
+    short len[320];
+    int i,n,sym,type,nlen,ndist,ncode,rep;
+    
+    if ((g->last=gz_bits(g,fp,1))<0||(type=gz_bits(g,fp,2))<0) return 0;
+    
+    if (type==0) { /* stored block */
+        g->bits>>=g->nbit%8; g->nbit-=g->nbit%8;
+        g->len=gz_bits(g,fp,16);
+        if (g->len<0||gz_bits(g,fp,16)!=(~g->len&0xFFFF)) return 0;
+        g->state=2;
+        return 1;
+    }
+    if (type==1) { /* fixed codes */
+        for (i=0;i<144;i++) len[i]=8;
+        for (;i<256;i++) len[i]=9;
+        for (;i<280;i++) len[i]=7;
+        for (;i<288;i++) len[i]=8;
+        gz_huff(&g->lit,len,288);
+        for (i=0;i<30;i++) len[i]=5;
+        gz_huff(&g->dist,len,30);
+        g->state=3;
+        return 1;
+    }
+    if (type!=2) return 0;
+    
+    /* dynamic codes */
+    if ((nlen =gz_bits(g,fp,5))<0||(ndist=gz_bits(g,fp,5))<0||
+        (ncode=gz_bits(g,fp,4))<0) return 0;
+    nlen+=257; ndist+=1; ncode+=4;
+    if (nlen>286||ndist>30) return 0;
+    
+    for (i=0;i<19;i++) {
+        if (i>=ncode) {len[order[i]]=0; continue;}
+        if ((n=gz_bits(g,fp,3))<0) return 0;
+        len[order[i]]=(short)n;
+    }
+    if (!gz_huff(&g->lit,len,19)) return 0;
+    
+    for (i=0;i<nlen+ndist;) {
+        if ((sym=gz_decode(g,fp,&g->lit))<0) return 0;
+        if (sym<16) {
+            len[i++]=(short)sym;
+            continue;
+        }
+        if (sym==16) {
+            if (i==0||(n=gz_bits(g,fp,2))<0) return 0;
+            rep=len[i-1]; n+=3;
+        }
+        else if (sym==17) {
+            if ((n=gz_bits(g,fp,3))<0) return 0;
+            rep=0; n+=3;
+        }
+        else {
+            if ((n=gz_bits(g,fp,7))<0) return 0;
+            rep=0; n+=11;
+        }
+        if (i+n>nlen+ndist) return 0;
+        while (n--) len[i++]=(short)rep;
+    }
+    if (!gz_huff(&g->lit,len,nlen)||!gz_huff(&g->dist,len+nlen,ndist)) {
+        return 0;
+    }
+    g->state=3;
+    return 1;
+}
+/* decode deflate codes to window --------------------------------------------*/
+static int gz_codes(gzd_t *g, FILE *fp)
+{
+    static const short lbase[29]={
+        3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,
+        163,195,227,258
+    };
+    static const short lext[29]={
+        0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0
+    };
+    static const short dbase[30]={
+        1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,
+        2049,3073,4097,6145,8193,12289,16385,24577
+    };
+    static const short dext[30]={
+        0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13
+    };
+    int sym,len,dist,ext;
+    
+    while (g->wp<=GZWINSIZE-258) {
+        if ((sym=gz_decode(g,fp,&g->lit))<0) return 0;
+        
+        if (sym<256) { /* literal */
+            g->win[g->wp++]=(unsigned char)sym;
+        }
+        else if (sym==256) { /* end of block */
+            g->state=g->last?4:1;
+            break;
+        }
+        else { /* length and distance */
+            if ((sym-=257)>=29||(ext=gz_bits(g,fp,lext[sym]))<0) return 0;
+            len=lbase[sym]+ext;
+            if ((sym=gz_decode(g,fp,&g->dist))<0||sym>=30) return 0;
+            if ((ext=gz_bits(g,fp,dext[sym]))<0) return 0;
+            dist=dbase[sym]+ext;
+            if (dist>g->wp) return 0;
+            for (;len>0;len--,g->wp++) g->win[g->wp]=g->win[g->wp-dist];
+        }
+    }
+    return 1;
+}
+/* decode gzip ---------------------------------------------------------------*/
+static int gz_read(gzd_t *g, FILE *fp, unsigned char *buff, int size)
+{
+    unsigned int crc;
+    unsigned long isize;
+    int i=0,n=0,m,stat=1;
+    
+    while (n<size) {
+        
+        /* output decoded data in window */
+        if (g->rp<g->wp) {
+            m=g->wp-g->rp<size-n?g->wp-g->rp:size-n;
+            memcpy(buff+n,g->win+g->rp,m);
+            g->crc=~crc32_update(~g->crc,g->win+g->rp,m);
+            g->size+=m;
+            g->rp+=m; n+=m;
+            continue;
+        }
+        if (g->state==5) break;
+        
+        /* slide window */
+        if (g->wp>GZWINSIZE-258) {
+            memmove(g->win,g->win+g->wp-32768,32768);
+            g->wp=g->rp=32768;
+        }
+        switch (g->state) {
+            case 0: /* member header */
+                if ((stat=gz_header(g,fp))>0) g->state=1;
+                else if (stat==0) {g->state=5; stat=1;}
+                else stat=0;
+                break;
+            case 1: /* block header */
+                stat=gz_block(g,fp);
+                break;
+            case 2: /* stored block */
+                for (;g->len>0&&g->wp<GZWINSIZE;g->len--) {
+                    if ((i=gz_bits(g,fp,8))<0) break;
+                    g->win[g->wp++]=(unsigned char)i;
+                }
+                if (g->len>0&&i<0) stat=0;
+                else if (g->len<=0) g->state=g->last?4:1;
+                break;
+            case 3: /* huffman block */
+                stat=gz_codes(g,fp);
+                break;
+            case 4: /* member trailer (crc32 and isize) */
+                g->bits>>=g->nbit%8; g->nbit-=g->nbit%8;
+                crc=isize=0;
+                for (m=0;m<32&&stat;m+=8) {
+                    if ((i=gz_bits(g,fp,8))<0) stat=0;
+                    else crc|=(unsigned int)i<<m;
+                }
+                for (m=0;m<32&&stat;m+=8) {
+                    if ((i=gz_bits(g,fp,8))<0) stat=0;
+                    else isize|=(unsigned long)i<<m;
+                }
+                if (stat&&(crc!=g->crc||isize!=(g->size&0xFFFFFFFFUL))) {
+                    trace(2,"gzip crc/size error: crc=%08X %08X size=%lu %lu\n",
+                          crc,g->crc,isize,g->size&0xFFFFFFFFUL);
+                    stat=0;
+                }
+                g->nmem++;
+                g->state=0;
+                break;
+        }
+        if (!stat) {
+            trace(2,"gzip data error: state=%d\n",g->state);
+            g->err=1;
+            g->state=5;
+        }
+    }
+    return n;
+}
+/* fill buffer of decompressed data ------------------------------------------*/
+static int fill_decomp(decomp_t *dc)
+{
+    dc->ib=0;
+    switch (dc->type) {
+        case 1 :
+            dc->nb=gz_read((gzd_t *)dc->dec,dc->fp,dc->buff,NDECBUFF);
+            dc->err=((gzd_t *)dc->dec)->err;
+            break;
+        case 2 :
+            dc->nb=lzw_read((lzw_t *)dc->dec,dc->fp,dc->buff,NDECBUFF);
+            dc->err=((lzw_t *)dc->dec)->err;
+            break;
+        default: dc->nb=(int)fread(dc->buff,1,NDECBUFF,dc->fp); break;
+    }
+    if (dc->nb<0) dc->nb=0;
+    return dc->nb>0;
+}
+/* read line of decompressed data --------------------------------------------*/
+static char *getsraw(char *buff, int size, decomp_t *dc)
+{
+    unsigned char *p=NULL;
+    int n=0,m;
+    
+    while (n<size-1) {
+        if (dc->ib>=dc->nb&&!fill_decomp(dc)) break;
+        m=dc->nb-dc->ib<size-1-n?dc->nb-dc->ib:size-1-n;
+        if ((p=(unsigned char *)memchr(dc->buff+dc->ib,'\n',m))) {
+            m=(int)(p-dc->buff)-dc->ib+1;
+        }
+        memcpy(buff+n,dc->buff+dc->ib,m);
+        dc->ib+=m; n+=m;
+        if (p) break;
+    }
+    if (n<=0) return NULL;
+    buff[n]='\0';
+    return buff;
+}
+/* chop line feed ------------------------------------------------------------*/
+static int crx_chop(char *s)
+{
+    int n=(int)strlen(s);
+    while (n>0&&(s[n-1]=='\n'||s[n-1]=='\r')) s[--n]='\0';
+    return n;
+}
+/* repair string by crinex difference ----------------------------------------*/
+static void crx_repair(char *s, const char *ds, int size)
+{
+    int i,n=(int)strlen(s);
+    
+    /* ' ': unchanged, '&': space, others: new char */
+    for (i=0;ds[i]&&i<size-1;i++) {
+        if (i<n&&ds[i]==' ') continue;
+        s[i]=ds[i]=='&'?' ':ds[i];
+    }
+    if (i>n) s[i]='\0';
+}
+/* decode data arc of crinex field -------------------------------------------*/
+static void crx_field(crxarc_t *a, const char *s, int n)
+{
+    double val=0.0;
+    int i=0,j,m,neg=0;
+    
+    if (n<=0) { /* no data */
+        a->ord=-1;
+        return;
+    }
+    if (n>=2&&s[1]=='&') { /* initialize arc: "<order>&<value>" */
+        if (s[0]<'0'||s[0]>'0'+MAXCRXORD) {
+            a->ord=-1;
+            return;
+        }
+        a->ord=s[0]-'0'; a->n=-1; i=2;
+    }
+    else if (a->ord<0) { /* difference without arc */
+        trace(2,"crinex difference without arc: %.*s\n",n,s);
+        return;
+    }
+    if (i<n&&s[i]=='-') {neg=1; i++;}
+    for (;i<n;i++) {
+        if (s[i]<'0'||s[i]>'9') {
+            trace(2,"crinex field error: %.*s\n",n,s);
+            a->ord=-1;
+            return;
+        }
+        val=val*10.0+(s[i]-'0');
+    }
+    if (neg) val=-val;
+    
+    if (a->n<0) {
+        a->y[0]=val; a->n=0;
+        return;
+    }
+    /* value by differences up to the order of arc */
+    m=a->n<a->ord?a->n+1:a->ord;
+    a->y[m]=val;
+    for (j=m;j>0;j--) a->y[j-1]+=a->y[j];
+    a->n=m;
+}
+/* format integer value of crinex as fixed-point number ----------------------*/
+static void crx_fmtval(char *s, double val, int ndec, int width)
+{
+    double q,v=fabs(val);
+    char *p=s+width;
+    int i;
+    
+    /* digits from right (exact for integer less than 2^53) */
+    *p='\0';
+    for (i=0;p>s&&(i<=ndec||v>0.0);i++) {
+        if (i==ndec) {
+            *--p='.';
+            if (p==s) break;
+        }
+        q=floor(v/10.0);
+        *--p=(char)('0'+(int)(v-q*10.0));
+        v=q;
+    }
+    if (val<0.0&&p>s) *--p='-';
+    while (p>s) *--p=' ';
+}
+/* output decoded rinex line -------------------------------------------------*/
+static int crx_outline(crx_t *c, const char *s, int n)
+{
+    char *out;
+    int nmax;
+    
+    while (n>0&&s[n-1]==' ') n--;
+    
+    if (c->nout+n+1>c->nmaxout) {
+        for (nmax=c->nmaxout<=0?8192:c->nmaxout;nmax<c->nout+n+1;) nmax*=2;
+        if (!(out=(char *)realloc(c->out,nmax))) {
+            trace(1,"crx_outline: memory allocation error\n");
+            return 0;
+        }
+        c->out=out; c->nmaxout=nmax;
+    }
+    memcpy(c->out+c->nout,s,n);
+    c->out[c->nout+n]='\n';
+    c->nout+=n+1;
+    return 1;
+}
+/* decode crinex header line -------------------------------------------------*/
+static void crx_header(crx_t *c, const char *buff)
+{
+    int n;
+    
+    if (strlen(buff)<=60) return;
+    
+    if (strstr(buff+60,"# / TYPES OF OBSERV")) { /* ver.2 */
+        if ((n=(int)str2num(buff,0,6))>0) {
+            c->ntype[0]=n<MAXOBSTYPE?n:MAXOBSTYPE;
+        }
+    }
+    else if (strstr(buff+60,"SYS / # / OBS TYPES")) { /* ver.3 */
+        if (buff[0]!=' '&&(n=(int)str2num(buff,3,3))>0) {
+            c->ntype[buff[0]&0x7F]=n<MAXOBSTYPE?n:MAXOBSTYPE;
+        }
+    }
+    else if (strstr(buff+60,"END OF HEADER")) c->hdr=1;
+}
+/* decode crinex epoch -------------------------------------------------------*/
+static int crx_epoch(decomp_t *dc, crx_t *c)
+{
+    crxsat_t *s,*sat;
+    char buff[MAXCRXLEN],*ep=buff,*p,*q;
+    int i,j,k,n,len,nsat=0,flag,ntype,pos=c->ver==1?32:41;
+    
+    /* epoch line ('&' or '>' at head: initialized) */
+    if (!getsraw(c->line,MAXCRXLEN,dc)) return 0;
+    crx_chop(c->line);
+    
+    if (c->line[0]==(c->ver==1?'&':'>')) {
+        strcpy(ep,c->line);
+        if (c->ver==1) ep[0]=' ';
+    }
+    else {
+        strcpy(ep,c->epoch);
+        crx_repair(ep,c->line,MAXCRXLEN);
+    }
+    len=(int)strlen(ep);
+    flag=len>(c->ver==1?28:31)?ep[c->ver==1?28:31]:'0';
+    for (i=c->ver==1?29:32,j=0;j<3&&i<len;i++,j++) {
+        if ('0'<=ep[i]&&ep[i]<='9') nsat=nsat*10+(ep[i]-'0');
+    }
+    /* event flag 2-5: special records copied */
+    if ('2'<=flag&&flag<='5') {
+        if (!crx_outline(c,ep,len)) return 0;
+        for (i=0;i<nsat&&getsraw(c->line,MAXCRXLEN,dc);i++) {
+            if (!crx_outline(c,c->line,crx_chop(c->line))) return 0;
+        }
+        return 1;
+    }
+    strcpy(c->epoch,ep);
+    ep=c->epoch;
+    
+    /* receiver clock offset line */
+    if (!getsraw(c->line,MAXCRXLEN,dc)) return 0;
+    crx_field(&c->clk,c->line,crx_chop(c->line));
+    
+    if (nsat>c->nmaxsat) {
+        if (!(sat=(crxsat_t *)realloc(c->sat,sizeof(crxsat_t)*nsat))) return 0;
+        c->sat=sat;
+        if (!(sat=(crxsat_t *)realloc(c->prev,sizeof(crxsat_t)*nsat))) return 0;
+        c->prev=sat;
+        c->nmaxsat=nsat;
+    }
+    for (i=0;i<nsat;i++) {
+        s=c->sat+i;
+        for (j=0;j<3;j++) s->id[j]=pos+i*3+j<len?ep[pos+i*3+j]:' ';
+        s->id[3]='\0';
+        
+        /* satellite data of previous epoch */
+        if (i<c->nprev&&!strcmp(c->prev[i].id,s->id)) j=i;
+        else {
+            for (j=0;j<c->nprev;j++) if (!strcmp(c->prev[j].id,s->id)) break;
+        }
+        ntype=c->ver==1?c->ntype[0]:c->ntype[s->id[0]&0x7F];
+        
+        if (j<c->nprev) {
+            strcpy(s->flag,c->prev[j].flag);
+            memcpy(s->arc,c->prev[j].arc,sizeof(crxarc_t)*ntype);
+        }
+        else {
+            s->flag[0]='\0';
+            for (k=0;k<ntype;k++) s->arc[k].ord=-1;
+        }
+        
+        /* data line: fields separated by space and flags */
+        if (!getsraw(c->line,MAXCRXLEN,dc)) return 0;
+        crx_chop(c->line);
+        
+        for (j=0,p=c->line;j<ntype;j++) {
+            for (q=p;*q&&*q!=' ';q++) ;
+            crx_field(s->arc+j,p,(int)(q-p));
+            p=*q?q+1:q;
+        }
+        crx_repair(s->flag,p,MAXOBSTYPE*2+1);
+    }
+    c->nsat=nsat;
+    
+    /* output rinex epoch lines */
+    if (c->ver==1) {
+        for (i=0;i==0||i<nsat;i+=12) {
+            n=i==0?(len<32?len:32):0;
+            memcpy(buff,ep,n);
+            for (;n<32;n++) buff[n]=' ';
+            for (j=i;j<i+12&&j<nsat;j++,n+=3) memcpy(buff+n,c->sat[j].id,3);
+            if (i==0&&c->clk.ord>=0) {
+                for (;n<68;n++) buff[n]=' ';
+                crx_fmtval(buff+n,c->clk.y[0],9,12);
+                n=(int)strlen(buff);
+            }
+            if (!crx_outline(c,buff,n)) return 0;
+        }
+    }
+    else {
+        n=len<35?len:35;
+        for (;n<35;n++) buff[n]=' ';
+        if (c->clk.ord>=0) {
+            for (;n<41;n++) buff[n]=' ';
+            crx_fmtval(buff+n,c->clk.y[0],12,15);
+            n=(int)strlen(buff);
+        }
+        if (!crx_outline(c,buff,n)) return 0;
+    }
+    /* output rinex data lines */
+    for (i=0;i<nsat;i++) {
+        s=c->sat+i;
+        ntype=c->ver==1?c->ntype[0]:c->ntype[s->id[0]&0x7F];
+        len=(int)strlen(s->flag);
+        n=0;
+        if (c->ver!=1) {
+            memcpy(buff,s->id,3); n=3;
+        }
+        for (j=0;j<ntype;j++) {
+            if (c->ver==1&&j>0&&j%5==0) {
+                if (!crx_outline(c,buff,n)) return 0;
+                n=0;
+            }
+            if (s->arc[j].ord>=0) crx_fmtval(buff+n,s->arc[j].y[0],3,14);
+            else sprintf(buff+n,"%14s","");
+            n+=14;
+            buff[n++]=2*j  <len?s->flag[2*j  ]:' ';
+            buff[n++]=2*j+1<len?s->flag[2*j+1]:' ';
+        }
+        if (!crx_outline(c,buff,n)) return 0;
+    }
+    sat=c->prev; c->prev=c->sat; c->sat=sat;
+    c->nprev=nsat;
+    return 1;
+}
+/* open decompressing file -----------------------------------------------------
+* open file decompressed in-process while read
+* args   : decomp_t *dc  O      decompressing file
+*          char   *file  I      file path
+* return : status (1:compressed,0:not compressed,-1:error,
+*                  -2:unsupported compression)
+* notes  : gzip, unix compress (.Z) and hatanaka-compression (crinex 1.0 and
+*          3.0) are detected by the content. zip is not supported.
+*          the file not compressed is closed with status 0.
+*-----------------------------------------------------------------------------*/
+extern int opendecomp(decomp_t *dc, const char *file)
+{
+    unsigned char magic[3]={0};
+    char buff[MAXCRXLEN];
+    crx_t *crx;
+    lzw_t *lzw;
+    gzd_t *gzd;
+    int n;
+    
+    trace(3,"opendecomp: file=%s\n",file);
+    
+    memset(dc,0,sizeof(decomp_t));
+    
+    if (!(dc->fp=fopen(file,"rb"))) {
+        trace(2,"decompressing file open error: %s\n",file);
+        return -1;
+    }
+    n=(int)fread(magic,1,3,dc->fp);
+    
+    if (n>=2&&magic[0]==0x1F&&magic[1]==0x8B) dc->type=1; /* gzip */
+    else if (n>=3&&magic[0]==0x1F&&magic[1]==0x9D) dc->type=2; /* compress */
+    else if (n>=2&&magic[0]=='P'&&magic[1]=='K') { /* zip */
+        closedecomp(dc);
+        return -2;
+    }
+    if (dc->type!=2) rewind(dc->fp);
+    
+    if (!(dc->buff=(unsigned char *)malloc(NDECBUFF))) {
+        closedecomp(dc);
+        return -1;
+    }
+    if (dc->type==1) {
+        if (!(gzd=(gzd_t *)calloc(1,sizeof(gzd_t)))) {
+            closedecomp(dc);
+            return -1;
+        }
+        dc->dec=gzd;
+    }
+    if (dc->type==2) {
+        if (!(lzw=(lzw_t *)calloc(1,sizeof(lzw_t)))) {
+            closedecomp(dc);
+            return -1;
+        }
+        lzw->maxbits=magic[2]&0x1F;
+        lzw->block=magic[2]&0x80;
+        if (lzw->maxbits<9||lzw->maxbits>LZWMAXBITS) {
+            trace(2,"unsupported lzw bits: bits=%d\n",lzw->maxbits);
+            free(lzw);
+            closedecomp(dc);
+            return -1;
+        }
+        lzw->nbits=9;
+        lzw->maxcode=(1<<9)-1;
+        lzw->freeent=lzw->block?257:256;
+        lzw->oldcode=-1;
+        dc->dec=lzw;
+    }
+    /* hatanaka-compression detected by first line */
+    if (getsraw(buff,MAXCRXLEN,dc)&&strlen(buff)>60&&
+        strstr(buff+60,"CRINEX VERS")) {
+        
+        if (!(crx=(crx_t *)calloc(1,sizeof(crx_t)))) {
+            closedecomp(dc);
+            return -1;
+        }
+        crx->ver=str2num(buff,0,9)>=3.0?3:1;
+        dc->crxd=crx;
+        
+        /* skip crinex program line */
+        getsraw(buff,MAXCRXLEN,dc);
+    }
+    else if (dc->type==0) {
+        closedecomp(dc);
+        return 0;
+    }
+    else dc->ib=0; /* first line in first buffer */
+    
+    if (dc->err) {
+        trace(2,"decompressing file error: %s\n",file);
+        closedecomp(dc);
+        return -1;
+    }
+    
+    trace(3,"opendecomp: type=%d crx=%d\n",dc->type,
+          dc->crxd?((crx_t *)dc->crxd)->ver:0);
+    return 1;
+}
+/* read line of decompressing file ---------------------------------------------
+* read line of decompressing file as fgets()
+* args   : char   *buff  O      line
+*          int    size   I      size of buffer
+*          decomp_t *dc  IO     decompressing file
+* return : line (NULL: end of file or error)
+* notes  : hatanaka-compressed file is read as rinex obs
+*          dc->err is set to 1 on decoding error, truncated data or crc error
+*-----------------------------------------------------------------------------*/
+extern char *getsdecomp(char *buff, int size, decomp_t *dc)
+{
+    crx_t *c=(crx_t *)dc->crxd;
+    char *p;
+    int n;
+    
+    if (!dc->fp||size<=1) return NULL;
+    
+    if (!c) return getsraw(buff,size,dc);
+    
+    if (!c->hdr) {
+        if (!getsraw(buff,size,dc)) return NULL;
+        crx_header(c,buff);
+        return buff;
+    }
+    while (c->iout>=c->nout) {
+        c->iout=c->nout=0;
+        if (!crx_epoch(dc,c)) return NULL;
+    }
+    n=c->nout-c->iout<size-1?c->nout-c->iout:size-1;
+    if ((p=(char *)memchr(c->out+c->iout,'\n',n))) n=(int)(p-c->out)-c->iout+1;
+    memcpy(buff,c->out+c->iout,n);
+    buff[n]='\0';
+    c->iout+=n;
+    return buff;
+}
+/* close decompressing file --------------------------------------------------*/
+extern void closedecomp(decomp_t *dc)
+{
+    crx_t *c=(crx_t *)dc->crxd;
+    
+    trace(3,"closedecomp:\n");
+    
+    if (c) {
+        free(c->sat); free(c->prev); free(c->out);
+    }
+    free(dc->crxd);
+    free(dc->dec);
+    free(dc->buff);
+    if (dc->fp) fclose(dc->fp);
+    memset(dc,0,sizeof(decomp_t));
+}
+/* decompress file in-process ------------------------------------------------*/
+static int decompfile(const char *file, const char *uncfile)
+{
+    decomp_t dc;
+    FILE *fp;
+    char buff[MAXCRXLEN];
+    int stat;
+    
+    if ((stat=opendecomp(&dc,file))<=0) return stat==0?-1:stat;
+    
+    if (!(fp=fopen(uncfile,dc.crxd?"w":"wb"))) {
+        closedecomp(&dc);
+        return -1;
+    }
+    if (dc.crxd) {
+        while (getsdecomp(buff,MAXCRXLEN,&dc)) fputs(buff,fp);
+    }
+    else {
+        while (dc.ib<dc.nb||fill_decomp(&dc)) {
+            fwrite(dc.buff+dc.ib,1,dc.nb-dc.ib,fp);
+            dc.ib=dc.nb;
+        }
+    }
+    fclose(fp);
+    stat=dc.err?-1:1;
+    closedecomp(&dc);
+    
+    if (stat<0) trace(2,"decompressing file error: %s\n",file);
+    return stat;
+}
+/* uncompress file -------------------------------------------------------------
+* uncompress (uncompress/unzip/uncompact hatanaka-compression/tar) file
+* args   : char   *file     I   input file
+*          char   *uncfile  O   uncompressed file
+* return : status (-1:error,0:not compressed file,1:uncompress completed)
+* note   : creates uncompressed file in tempolary directory
+*          gzip, compress and hatanaka-compression are decoded in-process.
+*          gzip (for zip) and tar commands have to be installed in commands
+*          path
+*-----------------------------------------------------------------------------*/
+extern int uncompress(const char *file, char *uncfile)
+{
+    int stat=0,cstat;
+    char *p,*q,cmd[2048]="",tmpfile[1024]="",buff[1024],*fname,*dir="";
+    
+    trace(3,"uncompress: file=%s\n",file);
+    
+    strcpy(tmpfile,file);
+    if (!(p=strrchr(tmpfile,'.'))) return 0;
+    
+    /* uncompress by gzip */
+    if (!strcmp(p,".z"  )||!strcmp(p,".Z"  )||
+        !strcmp(p,".gz" )||!strcmp(p,".GZ" )||
+        !strcmp(p,".zip")||!strcmp(p,".ZIP")) {
+        
+        strcpy(uncfile,tmpfile); uncfile[p-tmpfile]='\0';
+        
+        /* uncompress and uncompact hatanaka-compression in-process */
+        if ((q=strrchr(uncfile,'.'))&&strlen(q)>3&&(*(q+3)=='d'||*(q+3)=='D')) {
+            *(q+3)=*(q+3)=='D'?'O':'o';
+        }
+        if ((cstat=decompfile(tmpfile,uncfile))==-1) {
+            remove(uncfile);
+            return -1;
+        }
+        if (cstat==-2) {
+            strcpy(uncfile,tmpfile); uncfile[p-tmpfile]='\0';
+            sprintf(cmd,"gzip -f -d -c \"%s\" > \"%s\"",tmpfile,uncfile);
+            
+            if (execcmd(cmd)) {
+                remove(uncfile);
+                return -1;
+            }
+        }
+        strcpy(tmpfile,uncfile);
+        stat=1;
+    }
+    /* extract tar file */
+    if ((p=strrchr(tmpfile,'.'))&&!strcmp(p,".tar")) {
+        
+        strcpy(uncfile,tmpfile); uncfile[p-tmpfile]='\0';
+        strcpy(buff,tmpfile);
+        fname=buff;
+#ifdef WIN32
+        if ((p=strrchr(buff,'\\'))) {
+            *p='\0'; dir=fname; fname=p+1;
+        }
+        sprintf(cmd,"set PATH=%%CD%%;%%PATH%% & cd /D \"%s\" & tar -xf \"%s\"",
+                dir,fname);
+#else
+        if ((p=strrchr(buff,'/'))) {
+            *p='\0'; dir=fname; fname=p+1;
+        }
+        sprintf(cmd,"tar -C \"%s\" -xf \"%s\"",dir,tmpfile);
+#endif
+        if (execcmd(cmd)) {
+            if (stat) remove(tmpfile);
+            return -1;
+        }
+        if (stat) remove(tmpfile);
+        stat=1;
+    }
+    /* uncompact hatanaka-compressed file */
+    else if ((p=strrchr(tmpfile,'.'))&&strlen(p)>3&&(*(p+3)=='d'||*(p+3)=='D')) {
+        
+        strcpy(uncfile,tmpfile);
+        uncfile[p-tmpfile+3]=*(p+3)=='D'?'O':'o';
+        
+        if (decompfile(tmpfile,uncfile)<0) {
+            remove(uncfile);
+            if (stat) remove(tmpfile);
+            return -1;
+        }
+        if (stat) remove(tmpfile);
+        stat=1;
+    }
+    trace(3,"uncompress: stat=%d\n",stat);
+    return stat;
+}
+/* dummy application functions for shared library ----------------------------*/
+#ifdef DLL
 extern int showmsg(char *format,...) {return 0;}
 extern void settspan(gtime_t ts, gtime_t te) {}
 extern void settime(gtime_t time) {}
@@ -3849,67 +6041,313 @@ extern int input_lexrf(raw_t *raw, FILE *fp) {return 0;}
 extern int gen_lexr(const char *msg, unsigned char *buff) {return 0;}
 #endif /* EXTLEX */
 
-extern void prepareOutputFiles(outputFiles_t *files, prcopt_t *prcopt)
-{
-  memset(files, 0, sizeof(outputFiles_t));
+/* column schemas of output files */
+static const outcol_t trajectoryCols[] = {
+  {"T", 12, 6}, {"X", 12, 6}, {"Y", 12, 6}, {"Z", 12, 6},
+  {"Vx", 12, 6}, {"Vy", 12, 6}, {"Vz", 12, 6}
+};
+static const outcol_t matrixCols[] = {
+  {"T", 12, 6}, {"qr(11)", 12, 6}, {"qr(12)", 12, 6}, {"qr(13)", 12, 6},
+  {"qr(22)", 12, 6}, {"qr(23)", 12, 6}, {"qr(33)", 12, 6}, {"qr(44)", 12, 6},
+  {"qr(45)", 12, 6}, {"qr(46)", 12, 6}, {"qr(55)", 12, 6}, {"qr(56)", 12, 6},
+  {"qr(66)", 12, 6}
+};
+static const outcol_t residualsCols[] = {
+  {"T", 12, 6}, {"Nsv", 2, 0}, {"delta_C1", 10, 3}, {"delta_L1", 10, 3}
+};
+static const outcol_t clockCols[] = {
+  {"T", 12, 6}, {"delta_t", 10, 0}, {"delta_f/f", 10, 0}
+};
+static const outcol_t ambiguityCols[] = {
+  {"T", 12, 6}, {"Nsv", 2, 0}, {"amb_L1", 10, 2}, {"sigma_amb_L1", 5, 2},
+  {"amb_L2", 10, 2}, {"sigma_amb_L2", 5, 2}
+};
+static const outcol_t ionosphereCols[] = {
+  {"T", 12, 6}, {"Nsv", 2, 0}, {"Azsv", 5, 1}, {"Elsv", 5, 1}, {"Bsv", 7, 2},
+  {"Lsv", 7, 2}, {"Hsv", 7, 2}, {"S_TEC", 9, 4}, {"VS_TEC", 9, 4}
+};
+static const outcol_t troposphereCols[] = {
+  {"T", 12, 6}, {"Nsv", 2, 0}, {"delta_Ttro", 5, 0}, {"Vdelta_Ttro*e-8", 6, 3}
+};
+static const outcol_t measuresCols[] = {
+  {"T", 12, 6}, {"Nsv", 2, 0}, {"ant", 1, 0},
+  {"code_L1", 2, 0}, {"freq_L1", 1, 0}, {"status_L1", 1, 0}, {"TpFD_L1", 3, 0},
+  {"C_L1", 15, 3}, {"L_L1", 10, 3}, {"D_L1", 10, 3},
+  {"code_L2", 2, 0}, {"freq_L2", 1, 0}, {"status_L2", 1, 0}, {"TpFD_L2", 3, 0},
+  {"C_L2", 15, 3}, {"L_L2", 10, 3}, {"D_L2", 10, 3}
+};
+#define NCOLS(cols) ((int)(sizeof(cols) / sizeof(outcol_t)))
+
+const outschema_t outputSchemas[] = {
+  {"tr_pso_gosk.txt", "tr_pso_gosk.txt", NCOLS(trajectoryCols), trajectoryCols},
+  {"cov_pso_gosk.txt", "cov_pso_gosk.txt", NCOLS(matrixCols), matrixCols},
+  {"residual.txt", "residuals.txt", NCOLS(residualsCols), residualsCols},
+  {"clock.txt", "clock.txt", NCOLS(clockCols), clockCols},
+  {"ambiguity.txt", "ambiguity.txt", NCOLS(ambiguityCols), ambiguityCols},
+  {"ionosphere.txt", "ionosphere.txt", NCOLS(ionosphereCols), ionosphereCols},
+  {"troposphere.txt", "troposphere.txt", NCOLS(troposphereCols), troposphereCols},
+  {"out_Nsv.txt", "out_Nsv.txt", NCOLS(measuresCols), measuresCols},
+  {"SVinclud.txt", "SVinclud.txt", 0, NULL},
+  {"SVexclud.txt", "SVexclud.txt", 0, NULL}
+};
+
+/* format value as printf "%0<width>.<precision>f" without printf. the value is
+   rounded by double arithmetic, and values near a rounding tie, too large or
+   not finite are formatted by sprintf to keep the output identical */
+static int formatFixed(char* buff, double value, int width, int precision)
+{
+  static const double scale[] = {1E0, 1E1, 1E2, 1E3, 1E4, 1E5, 1E6, 1E7, 1E8, 1E9};
+  char digits[32], *p = buff;
+  double y, r, hi;
+  unsigned long lo;
+  int i, n = 0, len, negative;
 
-  files->trajectory = fopen("tr_pso_gosk.txt", "w");
-  files->matrix = fopen("cov_pso_gosk.txt", "w");
+  if(precision < 0 || precision > 9 ||
+     !((y = fabs(value) * scale[precision]) < 1E13) ||
+     fabs(y - floor(y) - 0.5) <= y * 1E-15)
+    return sprintf(buff, "%0*.*f", width, precision, value);
 
-  fprintf(files->trajectory, "%% tr_pso_gosk.txt T X Y Z Vx Vy Vz\n");
-  fprintf(files->matrix, "%% cov_pso_gosk.txt T qr(11) qr(12) qr(13) qr(22) qr(23) qr(33) qr(44) qr(45) qr(46) qr(55) qr(56) qr(66)\n");
+  negative = value < 0.0 || (value == 0.0 && 1.0 / value < 0.0);
+  r = floor(y + 0.5);
+  hi = floor(r / 1E9);
+  lo = (unsigned long)(r - hi * 1E9);
+  for(i = 0; i < 9; i++, lo /= 10)
+    digits[n++] = (char)('0' + lo % 10);
+  for(lo = (unsigned long)hi; lo; lo /= 10)
+    digits[n++] = (char)('0' + lo % 10);
+  while(n > precision + 1 && digits[n - 1] == '0')
+    n--;
 
-  if(prcopt->outresiduals)
+  len = negative + n + (precision > 0 ? 1 : 0);
+  if(negative)
+    *p++ = '-';
+  for(i = len; i < width; i++)
+    *p++ = '0';
+  for(i = n - 1; i >= precision; i--)
+    *p++ = digits[i];
+  if(precision > 0)
   {
-    files->residuals = fopen("residual.txt", "w");
-    fprintf(files->residuals, "%% residuals.txt T Nsv delta_C1 delta_L1\n");
+    *p++ = '.';
+    for(i = precision - 1; i >= 0; i--)
+      *p++ = digits[i];
   }
+  *p = '\0';
+  return (int)(p - buff);
+}
 
-  if(prcopt->outclock)
+/* set header of binary output file */
+static void setBinaryHeader(outbhead_t* head, const outschema_t* schema)
+{
+  memset(head, 0, sizeof(outbhead_t));
+  memcpy(head->magic, OUTB_MAGIC, 8);
+  head->endian = 0x01020304;
+  head->hlen = (int)(sizeof(outbhead_t) + sizeof(outbcol_t) * schema->n);
+  head->ncol = schema->n;
+  strncpy(head->title, schema->title, sizeof(head->title) - 1);
+}
+
+/* open output file with buffer and write header of the schema. in binary
+   format the columns are written to the header and the rows are written as
+   doubles. the files of variable columns are always text */
+static FILE* openOutputFile(const prcopt_t* prcopt, const outschema_t* schema, int format)
+{
+  FILE* fp;
+  outbhead_t head;
+  outbcol_t col;
+  char file[1024], *p;
+  int i;
+
+  outputPath(prcopt, schema->file, file);
+  if(format == OUTFMT_BIN && schema->n > 0)
   {
-    files->clock = fopen("clock.txt", "w");
-    fprintf(files->clock, "%% clock.txt T delta_t delta_f/f\n");
-  }
+    if((p = strrchr(file, '.')))
+      *p = '\0';
+    strcat(file, ".bin");
+    if(!(fp = fopen(file, "wb")))
+    {
+      trace(2, "output file open error: %s\n", file);
+      return NULL;
+    }
+    setvbuf(fp, NULL, _IOFBF, OUTBUFSIZE);
 
-  if(prcopt->outambiguity)
+    setBinaryHeader(&head, schema);
+    fwrite(&head, sizeof(head), 1, fp);
+    for(i = 0; i < schema->n; i++)
+    {
+      memset(&col, 0, sizeof(col));
+      strncpy(col.name, schema->cols[i].name, sizeof(col.name) - 1);
+      col.width = schema->cols[i].width;
+      col.precision = schema->cols[i].precision;
+      fwrite(&col, sizeof(col), 1, fp);
+    }
+    return fp;
+  }
+  if(!(fp = fopen(file, "w")))
   {
-    files->ambiguity = fopen("ambiguity.txt", "w");
-    fprintf(files->ambiguity, "%% ambiguity.txt T Nsv amb_L1 sigma_amb_L1 amb_L2 sigma_amb_L2\n");
+    trace(2, "output file open error: %s\n", file);
+    return NULL;
   }
+  setvbuf(fp, NULL, _IOFBF, OUTBUFSIZE);
 
-  if(prcopt->outionosphere)
+  fprintf(fp, "%% %s", schema->title);
+  for(i = 0; i < schema->n; i++)
+    fprintf(fp, " %s", schema->cols[i].name);
+  fprintf(fp, "\n");
+  return fp;
+}
+
+#define OUTQCYCLE   10                  /* output writer cycle (ms) */
+#define OUTREC_TIME 0                   /* output record: start time */
+#define OUTREC_ROW  1                   /* output record: row of values */
+#define OUTREC_SATS 2                   /* output record: line of satellites */
+
+typedef struct {                        /* record of output writer queue */
+  int stream;                           /* stream (OUTF_???) */
+  int type;                             /* record type (OUTREC_???) */
+  int n;                                /* number of values following */
+  int pad;
+} outrec_t;
+
+static void stopOutputWriter(outputFiles_t* files);
+
+/* copy data to/from the ring buffer of the queue at position pos */
+static void queueCopyIn(outqueue_t* queue, int pos, const void* data, int len)
+{
+  int m = queue->size - pos < len ? queue->size - pos : len;
+
+  memcpy(queue->buff + pos, data, m);
+  memcpy(queue->buff, (const unsigned char*)data + m, len - m);
+}
+
+static void queueCopyOut(const outqueue_t* queue, int pos, void* data, int len)
+{
+  int m = queue->size - pos < len ? queue->size - pos : len;
+
+  memcpy(data, queue->buff + pos, m);
+  memcpy((unsigned char*)data + m, queue->buff, len - m);
+}
+
+/* output file of the stream (OUTF_???) */
+static FILE* outputFile(const outputFiles_t* files, int stream)
+{
+  switch(stream)
   {
-    files->ionosphere = fopen("ionosphere.txt", "w");
-    fprintf(files->ionosphere, "%% ionosphere.txt T Nsv Azsv Elsv Bsv Lsv Hsv S_TEC VS_TEC\n");
+    case OUTF_TRAJECTORY: return files->trajectory;
+    case OUTF_MATRIX: return files->matrix;
+    case OUTF_RESIDUALS: return files->residuals;
+    case OUTF_CLOCK: return files->clock;
+    case OUTF_AMBIGUITY: return files->ambiguity;
+    case OUTF_IONOSPHERE: return files->ionosphere;
+    case OUTF_TROPOSPHERE: return files->troposphere;
+    case OUTF_MEASURES: return files->measures;
+    case OUTF_INCLUDEDSATS: return files->includedSats;
+    case OUTF_EXCLUDEDSATS: return files->excludedSats;
   }
+  return NULL;
+}
 
-  if(prcopt->outtroposphere)
+/* path of the output file in the directory of output files (prcopt->outdir) */
+extern char* outputPath(const prcopt_t* prcopt, const char* file, char* path)
+{
+  int n = (int)strlen(prcopt->outdir);
+
+  strcpy(path, prcopt->outdir);
+  if(n > 0 && path[n - 1] != FILEPATHSEP && path[n - 1] != '/')
+    path[n++] = FILEPATHSEP;
+  strcpy(path + n, file);
+  return path;
+}
+
+/* open debug log of processing session. the solution and kalman filter logs
+   are opened with the debug log level prcopt->dbglevel>0 and the filter
+   snapshot with prcopt->dbgsnap. the single point covariance is always
+   output */
+extern dbglog_t* openDebugLog(const prcopt_t* prcopt)
+{
+  dbglog_t* log;
+  char path[1024];
+
+  if(!(log = (dbglog_t*)calloc(1, sizeof(dbglog_t))))
+    return NULL;
+
+  if((log->fpcov = fopen(outputPath(prcopt, "cov_matr_single.txt", path), "a")))
+    setvbuf(log->fpcov, NULL, _IOFBF, OUTBUFSIZE);
+#ifndef NDBGLOG
+  if(prcopt->dbglevel > 0)
   {
-    files->troposphere = fopen("troposphere.txt", "w");
-    fprintf(files->troposphere, "%% troposphere.txt T Nsv delta_Ttro Vdelta_Ttro*e-8\n");
+    if((log->fp = fopen(outputPath(prcopt, "solution_log.txt", path), "a")))
+      setvbuf(log->fp, NULL, _IOFBF, OUTBUFSIZE);
+    if((log->fpkf = fopen(outputPath(prcopt, "KalmanFiltering.txt", path), "a")))
+      setvbuf(log->fpkf, NULL, _IOFBF, OUTBUFSIZE);
+    log->level = log->fp ? prcopt->dbglevel : 0;
   }
+  if(prcopt->dbgsnap)
+    log->fpsnap = openSnapshotFile(outputPath(prcopt, SNAP_FILE, path));
+#endif
+  return log;
+}
+
+/* close debug log of processing session */
+extern void closeDebugLog(dbglog_t* log)
+{
+  if(!log)
+    return;
+  if(log->fp) fclose(log->fp);
+  if(log->fpkf) fclose(log->fpkf);
+  if(log->fpcov) fclose(log->fpcov);
+  if(log->fpsnap) fclose(log->fpsnap);
+  free(log);
+}
+
+/* open output files of the session. returns 0 if any file requested by the
+   options could not be opened */
+extern int prepareOutputFiles(outputFiles_t *files, prcopt_t *prcopt)
+{
+  memset(files, 0, sizeof(outputFiles_t));
+  files->format = prcopt->outformat;
+
+  files->trajectory = openOutputFile(prcopt, outputSchemas + OUTF_TRAJECTORY, files->format);
+  files->matrix = openOutputFile(prcopt, outputSchemas + OUTF_MATRIX, files->format);
+
+  if(prcopt->outresiduals)
+    files->residuals = openOutputFile(prcopt, outputSchemas + OUTF_RESIDUALS, files->format);
+
+  if(prcopt->outclock)
+    files->clock = openOutputFile(prcopt, outputSchemas + OUTF_CLOCK, files->format);
+
+  if(prcopt->outambiguity)
+    files->ambiguity = openOutputFile(prcopt, outputSchemas + OUTF_AMBIGUITY, files->format);
+
+  if(prcopt->outionosphere)
+    files->ionosphere = openOutputFile(prcopt, outputSchemas + OUTF_IONOSPHERE, files->format);
+
+  if(prcopt->outtroposphere)
+    files->troposphere = openOutputFile(prcopt, outputSchemas + OUTF_TROPOSPHERE, files->format);
 
   if(prcopt->outmeasures)
-  {
-    files->measures = fopen("out_Nsv.txt", "w");
-    fprintf(files->measures, "%% out_Nsv.txt T Nsv ant code_L1 freq_L1 status_L1 TpFD_L1 C_L1 L_L1 D_L1 code_L2 freq_L2 status_L2 TpFD_L2 C_L2 L_L2 D_L2\n");
-  }
+    files->measures = openOutputFile(prcopt, outputSchemas + OUTF_MEASURES, files->format);
 
   if(prcopt->outincludedsats)
-  {
-    files->includedSats = fopen("SVinclud.txt", "w");
-    fprintf(files->includedSats, "%% SVinclud.txt\n");
-  }
+    files->includedSats = openOutputFile(prcopt, outputSchemas + OUTF_INCLUDEDSATS, files->format);
 
   if(prcopt->outexcludedsats)
-  {
-    files->excludedSats = fopen("SVexclud.txt", "w");
-    fprintf(files->excludedSats, "%% SVexclud.txt\n");
-  }
+    files->excludedSats = openOutputFile(prcopt, outputSchemas + OUTF_EXCLUDEDSATS, files->format);
+
+  return files->trajectory && files->matrix &&
+         (!prcopt->outresiduals || files->residuals) &&
+         (!prcopt->outclock || files->clock) &&
+         (!prcopt->outambiguity || files->ambiguity) &&
+         (!prcopt->outionosphere || files->ionosphere) &&
+         (!prcopt->outtroposphere || files->troposphere) &&
+         (!prcopt->outmeasures || files->measures) &&
+         (!prcopt->outincludedsats || files->includedSats) &&
+         (!prcopt->outexcludedsats || files->excludedSats);
 }
 
 extern void closeOutputFiles(outputFiles_t* files)
 {
+  stopOutputWriter(files);
+
   if(files->ambiguity) fclose(files->ambiguity);
   if(files->clock) fclose(files->clock);
   if(files->excludedSats) fclose(files->excludedSats);
@@ -3930,220 +6368,727 @@ extern void writeTimeToFile(FILE* output, gtime_t time)
   fprintf(output, "%% %04.0f %02.0f %02.0f %02.0f %02.0f %02.7f\n", epoch[0], epoch[1], epoch[2], epoch[3], epoch[4], epoch[5]);
 }
 
-extern void writeLineToFile(FILE* output, int* symbols_count, int* precisions, int n, ...)
+/* write start time to the file of the stream */
+static void putOutputTime(const outputFiles_t* files, int stream, FILE* fp, gtime_t time)
+{
+  outbhead_t head;
+
+  if(files->format != OUTFMT_BIN || outputSchemas[stream].n <= 0)
+  {
+    writeTimeToFile(fp, time);
+    return;
+  }
+  setBinaryHeader(&head, outputSchemas + stream);
+  head.tset = 1;
+  head.time = (double)time.time;
+  head.sec = time.sec;
+  fseek(fp, 0, SEEK_SET);
+  fwrite(&head, sizeof(head), 1, fp);
+  fseek(fp, 0, SEEK_END);
+}
+
+/* write a row of values to the file of the stream */
+static void putOutputRow(const outputFiles_t* files, int stream, FILE* fp, const double* values)
 {
+  if(files->format == OUTFMT_BIN && outputSchemas[stream].n > 0)
+    fwrite(values, sizeof(double), outputSchemas[stream].n, fp);
+  else
+    writeColumns(fp, outputSchemas + stream, values);
+}
+
+/* write a line of satellites {timeDiff,n,sats[n],reasons[n]} (reasons=NULL:
+   without exclude reasons) */
+static void putSatsLine(FILE* output, double timeDiff, int n, const double* sats, const double* reasons)
+{
+  char line[MAXOUTLINE], *p = line;
   int i;
-  double value;
-  char format_string[20];
-  va_list vl;
 
-  va_start(vl, n);
+  p += formatFixed(p, timeDiff, 12, 6);
+  *p++ = ' ';
+  p += formatFixed(p, (double)n, 2, 0);
+  *p++ = ' ';
   for(i = 0; i < n; i++)
   {
-    value = va_arg(vl, double);
-    sprintf(format_string, "%%0%i.%ilf ", symbols_count[i], precisions[i]);
-    fprintf(output, format_string, value);
+    if(p - line > MAXOUTLINE - 32)
+    {
+      fwrite(line, 1, p - line, output);
+      p = line;
+    }
+    p += formatFixed(p, sats[i], 2, 0);
+    *p++ = ' ';
+    if(reasons)
+    {
+      *p++ = reasons[i] == 0.0 ? 'R' : (reasons[i] == 1.0 ? 'V' : 'E');
+      *p++ = ' ';
+    }
   }
-  va_end(vl);
-  fprintf(output, "\n");
+  *p++ = '\n';
+  fwrite(line, 1, p - line, output);
 }
 
-extern void writeTrajectory(FILE* output, double timeDiff, double* position)
+/* put a record of the stream to the queue of the output writer. the caller
+   waits while the queue is full */
+static void pushOutput(outqueue_t* queue, int stream, int type, int n, const double* values)
 {
-  int symbolsCount[7];
-  int precisions[7];
-  int i;
+  outrec_t rec;
+  int len = (int)(sizeof(rec) + sizeof(double) * n), nfree, m;
+
+  rec.stream = stream;
+  rec.type = type;
+  rec.n = n;
+  rec.pad = 0;
+
+  for(;;)
+  {
+    lock(&queue->lock);
+    nfree = (queue->rp - queue->wp - 1 + queue->size) % queue->size;
+    unlock(&queue->lock);
+    if(nfree >= len || !queue->state)
+      break;
+    sleepms(1);
+  }
+  if(nfree < len)
+    return;
+
+  queueCopyIn(queue, queue->wp, &rec, (int)sizeof(rec));
+  m = (queue->wp + (int)sizeof(rec)) % queue->size;
+  queueCopyIn(queue, m, values, (int)sizeof(double) * n);
+
+  lock(&queue->lock);
+  queue->wp = (queue->wp + len) % queue->size;
+  unlock(&queue->lock);
+}
+
+/* write the records in the queue to the files */
+static void popOutput(outputFiles_t* files)
+{
+  outqueue_t* queue = files->queue;
+  outrec_t rec;
+  double values[2 + 2 * MAXSAT];
+  FILE* fp;
+  int wp, rp, n;
+
+  lock(&queue->lock);
+  wp = queue->wp;
+  unlock(&queue->lock);
 
-  for(i = 0; i < 7; i++)
+  for(rp = queue->rp; rp != wp; )
   {
-    symbolsCount[i] = 12;
-    precisions[i] = 6;
+    queueCopyOut(queue, rp, &rec, (int)sizeof(rec));
+    rp = (rp + (int)sizeof(rec)) % queue->size;
+    queueCopyOut(queue, rp, values, (int)sizeof(double) * rec.n);
+    rp = (rp + (int)sizeof(double) * rec.n) % queue->size;
+
+    if(!(fp = outputFile(files, rec.stream)))
+      continue;
+    switch(rec.type)
+    {
+      case OUTREC_TIME:
+      {
+        gtime_t time;
+        time.time = (time_t)values[0];
+        time.sec = values[1];
+        putOutputTime(files, rec.stream, fp, time);
+        break;
+      }
+      case OUTREC_ROW:
+        putOutputRow(files, rec.stream, fp, values);
+        break;
+      case OUTREC_SATS:
+        n = (int)values[1];
+        putSatsLine(fp, values[0], n, values + 2, rec.stream == OUTF_EXCLUDEDSATS ? values + 2 + n : NULL);
+        break;
+    }
   }
+  lock(&queue->lock);
+  queue->rp = rp;
+  unlock(&queue->lock);
+}
+
+/* output writer thread */
+#ifdef WIN32
+static DWORD WINAPI outputThread(void* arg)
+#else
+static void* outputThread(void* arg)
+#endif
+{
+  outputFiles_t* files = (outputFiles_t*)arg;
 
-  writeLineToFile(output, symbolsCount, precisions, 7, timeDiff, position[0], position[1], position[2], position[3], position[4], position[5]);
+  while(files->queue->state)
+  {
+    popOutput(files);
+    sleepms(OUTQCYCLE);
+  }
+  popOutput(files);
+  return 0;
 }
 
-extern void writeCovariationMatrix(FILE* output, double timeDiff, float* positionMatrix, float* velocityMatrix)
+/* start asynchronous writer of the output files. the rows are put to the queue
+   of size bytes (0: OUTQUEUESIZE) by the positioning and formatted and written
+   by the writer thread. closeOutputFiles() writes the rest of the queue and
+   stops the writer. returns 1 for ok, 0 for error (rows written synchronously) */
+extern int startOutputWriter(outputFiles_t* files, int size)
 {
-  int symbolsCount[13];
-  int precisions[13];
-  int i;
+  outqueue_t* queue;
+
+  if(files->queue)
+    return 1;
+  if(size <= 0)
+    size = OUTQUEUESIZE;
+  if(size < (int)(sizeof(outrec_t) + sizeof(double) * (2 + 2 * MAXSAT)) * 2)
+    size = (int)(sizeof(outrec_t) + sizeof(double) * (2 + 2 * MAXSAT)) * 2;
+  if(!(queue = (outqueue_t*)calloc(1, sizeof(outqueue_t))))
+    return 0;
+  if(!(queue->buff = (unsigned char*)malloc(size)))
+  {
+    free(queue);
+    return 0;
+  }
+  queue->size = size;
+  queue->state = 1;
+  initlock(&queue->lock);
+  files->queue = queue;
 
-  for(i = 0; i < 13; i++)
+#ifdef WIN32
+  if(!(queue->thread = CreateThread(NULL, 0, outputThread, files, 0, NULL)))
+#else
+  if(pthread_create(&queue->thread, NULL, outputThread, files))
+#endif
   {
-    symbolsCount[i] = 12;
-    precisions[i] = 6;
+    files->queue = NULL;
+    free(queue->buff);
+    free(queue);
+    return 0;
   }
+  return 1;
+}
+
+/* stop asynchronous writer after writing the rest of the queue */
+static void stopOutputWriter(outputFiles_t* files)
+{
+  outqueue_t* queue = files->queue;
 
-  writeLineToFile(output, symbolsCount, precisions, 13, timeDiff, (double)positionMatrix[0], (double)positionMatrix[3], (double)positionMatrix[5], (double)positionMatrix[1], (double)positionMatrix[4], (double)positionMatrix[2], (double)velocityMatrix[0], (double)velocityMatrix[3], (double)velocityMatrix[5], (double)velocityMatrix[1], (double)velocityMatrix[4], (double)velocityMatrix[2]);
+  if(!queue)
+    return;
+  lock(&queue->lock);
+  queue->state = 0;
+  unlock(&queue->lock);
+#ifdef WIN32
+  WaitForSingleObject(queue->thread, INFINITE);
+  CloseHandle(queue->thread);
+#else
+  pthread_join(queue->thread, NULL);
+#endif
+  files->queue = NULL;
+  free(queue->buff);
+  free(queue);
 }
 
-extern void writeResiduals(FILE* output, double timeDiff, int satNumber, double codeResidual, double phaseResidual)
+/* write start time of the stream */
+extern void writeOutputTime(outputFiles_t* files, int stream, gtime_t time)
 {
-  int symbolsCount[4];
-  int precisions[4];
-  int i;
+  FILE* fp = outputFile(files, stream);
+  double values[2];
+
+  if(!fp)
+    return;
+  if(files->queue)
+  {
+    values[0] = (double)time.time;
+    values[1] = time.sec;
+    pushOutput(files->queue, stream, OUTREC_TIME, 2, values);
+    return;
+  }
+  putOutputTime(files, stream, fp, time);
+}
+
+/* write a row of values to the stream */
+extern void writeOutputRow(outputFiles_t* files, int stream, const double* values)
+{
+  FILE* fp = outputFile(files, stream);
 
-  symbolsCount[0] = 12;
-  precisions[0] = 6;
-  symbolsCount[1] = 2;
-  precisions[1] = 0;
-  for(i = 2; i < 4; i++)
+  if(!fp)
+    return;
+  if(files->queue)
   {
-    symbolsCount[i] = 10;
-    precisions[i] = 3;
+    pushOutput(files->queue, stream, OUTREC_ROW, outputSchemas[stream].n, values);
+    return;
   }
+  putOutputRow(files, stream, fp, values);
+}
 
-  writeLineToFile(output, symbolsCount, precisions, 4, timeDiff, (double)satNumber, codeResidual, phaseResidual);
+/* write a line of satellites to the stream */
+static void writeSatsLine(outputFiles_t* files, int stream, double timeDiff, int n, const int* sats, const int* reasons)
+{
+  FILE* fp = outputFile(files, stream);
+  double values[2 + 2 * MAXSAT];
+  int i;
+
+  if(!fp)
+    return;
+  if(n > MAXSAT)
+    n = MAXSAT;
+  values[0] = timeDiff;
+  values[1] = (double)n;
+  for(i = 0; i < n; i++)
+  {
+    values[2 + i] = (double)sats[i];
+    if(reasons)
+      values[2 + n + i] = (double)reasons[i];
+  }
+  if(files->queue)
+    pushOutput(files->queue, stream, OUTREC_SATS, 2 + (reasons ? 2 : 1) * n, values);
+  else
+    putSatsLine(fp, timeDiff, n, values + 2, reasons ? values + 2 + n : NULL);
 }
 
-extern void writeClock(FILE* output, double timeDiff, double deltaT, double deltaF)
+/* write a row of values by the column schema */
+extern void writeColumns(FILE* output, const outschema_t* schema, const double* values)
 {
-  int symbolsCount[3];
-  int precisions[3];
+  char line[MAXOUTLINE], *p = line;
   int i;
 
-  symbolsCount[0] = 12;
-  precisions[0] = 6;
-  for(i = 1; i < 3; i++)
+  for(i = 0; i < schema->n; i++)
   {
-    symbolsCount[i] = 10;
-    precisions[i] = 0;
+    if(p - line > MAXOUTLINE - 400)
+    {
+      fwrite(line, 1, p - line, output);
+      p = line;
+    }
+    p += formatFixed(p, values[i], schema->cols[i].width, schema->cols[i].precision);
+    *p++ = ' ';
   }
+  *p++ = '\n';
+  fwrite(line, 1, p - line, output);
+}
+
+extern void writeLineToFile(FILE* output, int* symbols_count, int* precisions, int n, ...)
+{
+  char field[512];
+  int i, len;
+  va_list vl;
 
-  writeLineToFile(output, symbolsCount, precisions, 3, timeDiff, deltaT, deltaF);
+  va_start(vl, n);
+  for(i = 0; i < n; i++)
+  {
+    len = formatFixed(field, va_arg(vl, double), symbols_count[i], precisions[i]);
+    field[len++] = ' ';
+    fwrite(field, 1, len, output);
+  }
+  va_end(vl);
+  fputc('\n', output);
 }
 
-extern void writeAmbiguity(FILE* output, double timeDiff, int satNumber, double ambiguityL1, double ambiguityL2, double sigmaL1, double sigmaL2)
+extern void writeTrajectory(outputFiles_t* files, double timeDiff, double* position)
 {
-  int symbolsCount[6];
-  int precisions[6];
+  double values[7];
   int i;
 
-  symbolsCount[0] = 12;
-  precisions[0] = 6;
+  values[0] = timeDiff;
+  for(i = 0; i < 6; i++)
+    values[i + 1] = position[i];
 
-  symbolsCount[1] = 2;
-  precisions[1] = 0;
+  writeOutputRow(files, OUTF_TRAJECTORY, values);
+}
 
-  for(i = 2; i < 6; i++)
-    precisions[i] = 2;
+extern void writeCovariationMatrix(outputFiles_t* files, double timeDiff, float* positionMatrix, float* velocityMatrix)
+{
+  static const int index[] = {0, 3, 5, 1, 4, 2};
+  double values[13];
+  int i;
 
-  symbolsCount[2] = 10;
-  symbolsCount[3] = 5;
-  symbolsCount[4] = 10;
-  symbolsCount[5] = 5;
+  values[0] = timeDiff;
+  for(i = 0; i < 6; i++)
+  {
+    values[i + 1] = (double)positionMatrix[index[i]];
+    values[i + 7] = (double)velocityMatrix[index[i]];
+  }
 
-  writeLineToFile(output, symbolsCount, precisions, 6, timeDiff, (double)satNumber, ambiguityL1, sigmaL1, ambiguityL2, sigmaL2);
+  writeOutputRow(files, OUTF_MATRIX, values);
 }
 
-extern void writeIonosphere(FILE* output, double timeDiff, int satNumber, double azimuth, double elevation, double latitude, double longitude, double height, double s_TEC, double vs_TEC)
+extern void writeResiduals(outputFiles_t* files, double timeDiff, int satNumber, double codeResidual, double phaseResidual)
 {
-  int symbolsCount[9];
-  int precisions[9];
-  int i;
+  double values[4];
+
+  values[0] = timeDiff;
+  values[1] = (double)satNumber;
+  values[2] = codeResidual;
+  values[3] = phaseResidual;
+
+  writeOutputRow(files, OUTF_RESIDUALS, values);
+}
+
+extern void writeClock(outputFiles_t* files, double timeDiff, double deltaT, double deltaF)
+{
+  double values[3];
+
+  values[0] = timeDiff;
+  values[1] = deltaT;
+  values[2] = deltaF;
+
+  writeOutputRow(files, OUTF_CLOCK, values);
+}
+
+extern void writeAmbiguity(outputFiles_t* files, double timeDiff, int satNumber, double ambiguityL1, double ambiguityL2, double sigmaL1, double sigmaL2)
+{
+  double values[6];
+
+  values[0] = timeDiff;
+  values[1] = (double)satNumber;
+  values[2] = ambiguityL1;
+  values[3] = sigmaL1;
+  values[4] = ambiguityL2;
+  values[5] = sigmaL2;
+
+  writeOutputRow(files, OUTF_AMBIGUITY, values);
+}
+
+extern void writeIonosphere(outputFiles_t* files, double timeDiff, int satNumber, double azimuth, double elevation, double latitude, double longitude, double height, double s_TEC, double vs_TEC)
+{
+  double values[9];
+
+  values[0] = timeDiff;
+  values[1] = (double)satNumber;
+  values[2] = azimuth;
+  values[3] = elevation;
+  values[4] = latitude;
+  values[5] = longitude;
+  values[6] = height;
+  values[7] = s_TEC;
+  values[8] = vs_TEC;
+
+  writeOutputRow(files, OUTF_IONOSPHERE, values);
+}
+
+extern void writeTroposphere(outputFiles_t* files, double timeDiff, int satNumber, double deltaT, double deltaTdot)
+{
+  double values[4];
 
-  symbolsCount[0] = 12;
-  precisions[0] = 6;
+  values[0] = timeDiff;
+  values[1] = (double)satNumber;
+  values[2] = deltaT;
+  values[3] = deltaTdot;
 
-  symbolsCount[1] = 2;
-  precisions[1] = 0;
+  writeOutputRow(files, OUTF_TROPOSPHERE, values);
+}
+
+extern void writeMeasures(outputFiles_t* files, double timeDiff, const obsd_t* measure)
+{
+  double values[17];
+  int i;
 
-  for(i = 2; i < 4; i++)
+  values[0] = timeDiff;
+  values[1] = (double)measure->sat;
+  values[2] = (double)measure->rcv;
+
+  for(i = 0; i < 2; i++)
   {
-    symbolsCount[i] = 5;
-    precisions[i] = 1;
+    values[3 + i*7] = (double)measure->code[i];
+    values[4 + i*7] = 1.0;
+    values[5 + i*7] = 1.0;
+    values[6 + i*7] = 1.0;
+    values[7 + i*7] = measure->P[i];
+    values[8 + i*7] = measure->L[i];
+    values[9 + i*7] = (double)measure->D[i];
   }
-  for(i = 4; i < 7; i++)
+
+  writeOutputRow(files, OUTF_MEASURES, values);
+}
+
+extern void writeIncludedSats(outputFiles_t* files, double timeDiff, int n, int* includedSats)
+{
+  writeSatsLine(files, OUTF_INCLUDEDSATS, timeDiff, n, includedSats, NULL);
+}
+
+extern void writeExcludedSats(outputFiles_t* files, double timeDiff, int n, int* excludedSats, int* excludeReasons)
+{
+  writeSatsLine(files, OUTF_EXCLUDEDSATS, timeDiff, n, excludedSats, excludeReasons);
+}
+
+/* map file to memory for read. returns mapped address (NULL: error) */
+static void* mapFile(const char* file, size_t minsize, size_t* size)
+{
+  void* map;
+#ifdef WIN32
+  HANDLE fh, mh;
+  LARGE_INTEGER len;
+
+  if((fh = CreateFile(file, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+    return NULL;
+  if(!GetFileSizeEx(fh, &len) || len.QuadPart < (LONGLONG)minsize ||
+     !(mh = CreateFileMapping(fh, NULL, PAGE_READONLY, 0, 0, NULL)))
   {
-    symbolsCount[i] = 7;
-    precisions[i] = 2;
+    CloseHandle(fh);
+    return NULL;
   }
-  for(i = 7; i < 9; i++)
+  map = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mh);
+  CloseHandle(fh);
+  *size = (size_t)len.QuadPart;
+#else
+  struct stat st;
+  int fd;
+
+  if((fd = open(file, O_RDONLY)) < 0)
+    return NULL;
+  if(fstat(fd, &st) < 0 || st.st_size < (off_t)minsize)
   {
-    symbolsCount[i] = 9;
-    precisions[i] = 4;
+    close(fd);
+    return NULL;
   }
+  map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED)
+    return NULL;
+  *size = (size_t)st.st_size;
+#endif
+  return map;
+}
 
-  writeLineToFile(output, symbolsCount, precisions, 9, timeDiff, (double)satNumber, azimuth, elevation, latitude, longitude, height, s_TEC, vs_TEC);
+/* unmap file mapped by mapFile() */
+static void unmapFile(void* map, size_t size)
+{
+  if(!map)
+    return;
+#ifdef WIN32
+  UnmapViewOfFile(map);
+#else
+  munmap(map, size);
+#endif
 }
 
-extern void writeTroposphere(FILE* output, double timeDiff, int satNumber, double deltaT, double deltaTdot)
+/* open binary output file mapped to memory. the rows of the file are read in
+   place by out->data[i*out->head->ncol+j]. returns 1 for ok, 0 for error */
+extern int openBinaryOutput(const char* file, outbfile_t* out)
 {
-  int symbolsCount[4];
-  int precisions[4];
+  const outbhead_t* head;
+  size_t size;
 
-  symbolsCount[0] = 12;
-  precisions[0] = 6;
+  memset(out, 0, sizeof(outbfile_t));
+  if(!(out->map = mapFile(file, sizeof(outbhead_t), &size)))
+    return 0;
+  out->size = size;
+  head = (const outbhead_t*)out->map;
 
-  symbolsCount[1] = 2;
-  precisions[1] = 0;
+  if(memcmp(head->magic, OUTB_MAGIC, 8) || head->endian != 0x01020304 || head->ncol <= 0 ||
+     head->hlen != (int)(sizeof(outbhead_t) + sizeof(outbcol_t) * head->ncol) || (size_t)head->hlen > size)
+  {
+    closeBinaryOutput(out);
+    return 0;
+  }
+  out->head = head;
+  out->cols = (const outbcol_t*)(head + 1);
+  out->data = (const double*)((const char*)out->map + head->hlen);
+  out->n = (int)((size - head->hlen) / (sizeof(double) * head->ncol));
+  return 1;
+}
 
-  symbolsCount[2] = 5;
-  precisions[2] = 0;
+/* close binary output file */
+extern void closeBinaryOutput(outbfile_t* out)
+{
+  unmapFile(out->map, out->size);
+  memset(out, 0, sizeof(outbfile_t));
+}
 
-  symbolsCount[3] = 6;
-  precisions[3] = 3;
+/* length of filter snapshot record (bytes) */
+static int snapshotLength(int nx, int nv, int nh)
+{
+  int len = (int)sizeof(snaprec_t) + (int)sizeof(double) * (nx + nx * (nx + 1) / 2 + nv + nv * (nv + 1) / 2 + nh) +
+            (int)sizeof(int) * nh;
 
-  writeLineToFile(output, symbolsCount, precisions, 4, timeDiff, (double)satNumber, deltaT, deltaTdot);
+  return (len + 7) / 8 * 8;
 }
 
-extern void writeMeasures(FILE* output, double timeDiff, const obsd_t* measure)
+/* open filter snapshot file for append. the header is written to a new
+   file. returns file pointer (NULL: error) */
+extern FILE* openSnapshotFile(const char* file)
 {
-  int symbolsCount[17];
-  int precisions[17];
-  int i;
+  snaphead_t head;
+  FILE* fp;
 
-  symbolsCount[0] = 12;
-  precisions[0] = 6;
+  if(!(fp = fopen(file, "ab")))
+    return NULL;
+  setvbuf(fp, NULL, _IOFBF, OUTBUFSIZE);
+  fseek(fp, 0, SEEK_END);
+
+  if(ftell(fp) == 0)
+  {
+    memset(&head, 0, sizeof(head));
+    memcpy(head.magic, SNAP_MAGIC, 8);
+    head.endian = 0x01020304;
+    head.hlen = (int)sizeof(snaphead_t);
+    fwrite(&head, sizeof(head), 1, fp);
+  }
+  return fp;
+}
 
-  symbolsCount[1] = 2;
-  precisions[1] = 0;
+/* write filter snapshot of kalman filter measurement update x'=x+K*v with
+   the states x (nx x 1), covariance P (nx x nx), transposed design matrix
+   H (nx x nv), innovations v (nv x 1) and measurement error covariance R
+   (nv x nv) before the update. P and R are packed to the upper triangles
+   and H to its nonzeros */
+extern void writeSnapshot(FILE* fp, int mode, gtime_t time, int iter, const double* x, const double* P,
+                          const double* H, const double* v, const double* R, int nx, int nv)
+{
+  snaprec_t rec;
+  double* buff;
+  int* idx;
+  int i, j, n = 0, nh = 0;
 
-  symbolsCount[2] = 1;
-  precisions[2] = 0;
+  for(i = 0; i < nx * nv; i++)
+    if(H[i] != 0.0)
+      nh++;
 
-  for(i = 0; i < 2; i++)
+  memset(&rec, 0, sizeof(rec));
+  rec.time = (double)time.time;
+  rec.sec = time.sec;
+  rec.len = snapshotLength(nx, nv, nh);
+  rec.mode = mode;
+  rec.iter = iter;
+  rec.nx = nx;
+  rec.nv = nv;
+  rec.nh = nh;
+
+  if(!(buff = (double*)calloc(rec.len - sizeof(snaprec_t), 1)))
+    return;
+
+  for(i = 0; i < nx; i++)
+    buff[n++] = x[i];
+  for(j = 0; j < nx; j++)
+    for(i = 0; i <= j; i++)
+      buff[n++] = P[i + j * nx];
+  for(i = 0; i < nv; i++)
+    buff[n++] = v[i];
+  for(j = 0; j < nv; j++)
+    for(i = 0; i <= j; i++)
+      buff[n++] = R[i + j * nv];
+
+  idx = (int*)(buff + n + nh);
+  for(i = 0; i < nx * nv; i++)
   {
-    symbolsCount[3 + i*7] = 2;
-    precisions[3 + i*7] = 0;
+    if(H[i] == 0.0)
+      continue;
+    *idx++ = i;
+    buff[n++] = H[i];
+  }
+  fwrite(&rec, sizeof(rec), 1, fp);
+  fwrite(buff, rec.len - sizeof(snaprec_t), 1, fp);
+  free(buff);
+}
+
+/* open filter snapshot file mapped to memory and index its records.
+   returns 1 for ok, 0 for error */
+extern int openSnapshot(const char* file, snapfile_t* snap)
+{
+  const snaprec_t* rec;
+  size_t size, off;
+  int nmax = 0;
+
+  memset(snap, 0, sizeof(snapfile_t));
+  if(!(snap->map = mapFile(file, sizeof(snaphead_t), &size)))
+    return 0;
+  snap->size = size;
+  snap->head = (const snaphead_t*)snap->map;
 
-    symbolsCount[4 + i*7] = 1;
-    precisions[4 + i*7] = 0;
+  if(memcmp(snap->head->magic, SNAP_MAGIC, 8) || snap->head->endian != 0x01020304 ||
+     snap->head->hlen != (int)sizeof(snaphead_t))
+  {
+    closeSnapshot(snap);
+    return 0;
+  }
+  snap->sorted = 1;
 
-    symbolsCount[5 + i*7] = 1;
-    precisions[5 + i*7] = 0;
+  for(off = sizeof(snaphead_t); off + sizeof(snaprec_t) <= size; off += rec->len)
+  {
+    rec = (const snaprec_t*)((const char*)snap->map + off);
 
-    symbolsCount[6 + i*7] = 3;
-    precisions[6 + i*7] = 0;
+    if(rec->nx < 0 || rec->nv < 0 || rec->nh < 0 || rec->len != snapshotLength(rec->nx, rec->nv, rec->nh) ||
+       off + rec->len > size)
+      break; /* truncated record */
 
-    symbolsCount[7 + i*7] = 15;
-    precisions[7 + i*7] = 3;
+    if(snap->n >= nmax)
+    {
+      const snaprec_t** recs;
 
-    symbolsCount[8 + i*7] = 10;
-    precisions[8 + i*7] = 3;
+      nmax = nmax ? nmax * 2 : 1024;
+      if(!(recs = (const snaprec_t**)realloc((void*)snap->recs, sizeof(snaprec_t*) * nmax)))
+      {
+        closeSnapshot(snap);
+        return 0;
+      }
+      snap->recs = recs;
+    }
+    if(snap->n > 0 && (rec->time < snap->recs[snap->n - 1]->time ||
+                       (rec->time == snap->recs[snap->n - 1]->time && rec->sec < snap->recs[snap->n - 1]->sec)))
+      snap->sorted = 0;
 
-    symbolsCount[9 + i*7] = 10;
-    precisions[9 + i*7] = 3;
+    snap->recs[snap->n++] = rec;
   }
+  return 1;
+}
 
-  writeLineToFile(output, symbolsCount, precisions, 17, timeDiff, (double)measure->sat, (double)measure->rcv, (double)measure->code[0], 1.0, 1.0, 1.0, measure->P[0], measure->L[0], (double)measure->D[0], (double)measure->code[1], 1.0, 1.0, 1.0, measure->P[1], measure->L[1], (double)measure->D[1]);
+/* close filter snapshot file */
+extern void closeSnapshot(snapfile_t* snap)
+{
+  unmapFile(snap->map, snap->size);
+  free((void*)snap->recs);
+  memset(snap, 0, sizeof(snapfile_t));
 }
 
-extern void writeIncludedSats(FILE* output, double timeDiff, int n, int* includedSats)
+/* get filter snapshot of record index in place of mapped file.
+   returns 1 for ok, 0 for no record */
+extern int getSnapshot(const snapfile_t* snap, int index, snapshot_t* snapshot)
 {
-  int i;
-  fprintf(output, "%012.6f %02d ", timeDiff, n);
-  for(i = 0; i < n; i++)
-    fprintf(output, "%02d ", includedSats[i]);
-  fprintf(output, "\n");
+  const snaprec_t* rec;
+  const double* p;
+
+  if(index < 0 || index >= snap->n)
+    return 0;
+
+  rec = snap->recs[index];
+  p = (const double*)(rec + 1);
+
+  snapshot->rec = rec;
+  snapshot->time.time = (time_t)rec->time;
+  snapshot->time.sec = rec->sec;
+  snapshot->x = p;
+  snapshot->P = p += rec->nx;
+  snapshot->v = p += rec->nx * (rec->nx + 1) / 2;
+  snapshot->R = p += rec->nv;
+  snapshot->H = p += rec->nv * (rec->nv + 1) / 2;
+  snapshot->Hidx = (const int*)(p + rec->nh);
+  return 1;
 }
 
-extern void writeExcludedSats(FILE* output, double timeDiff, int n, int* excludedSats, int* excludeReasons)
+/* seek filter snapshot by epoch. returns index of first record at or after
+   time (snap->n: no record). the records of combined solution (forward and
+   backward) are not sorted and are searched in order of file */
+extern int seekSnapshot(const snapfile_t* snap, gtime_t time)
 {
-  int i;
-  fprintf(output, "%012.6f %02d ", timeDiff, n);
-  for(i = 0; i < n; i++)
-    fprintf(output, "%02d %c ", excludedSats[i], excludeReasons[i] == 0 ? 'R' : (excludeReasons[i] == 1 ? 'V' : 'E'));
-  fprintf(output, "\n");
+  gtime_t t;
+  int i, j, k;
+
+  if(!snap->sorted)
+  {
+    for(i = 0; i < snap->n; i++)
+    {
+      t.time = (time_t)snap->recs[i]->time;
+      t.sec = snap->recs[i]->sec;
+      if(timediff(t, time) >= -DTTOL)
+        break;
+    }
+    return i;
+  }
+  for(i = 0, j = snap->n; i < j;)
+  {
+    k = (i + j) / 2;
+    t.time = (time_t)snap->recs[k]->time;
+    t.sec = snap->recs[k]->sec;
+    if(timediff(t, time) < -DTTOL)
+      i = k + 1;
+    else
+      j = k;
+  }
+  return i;
 }
@@ -205,9 +205,40 @@ extern "C" {
 #define MAXDTOE_S   86400.0             /* max time difference to ephem toe (s) for other */
 #define MAXGDOP     300.0               /* max GDOP */
 
+#define OUTF_TRAJECTORY   0             /* output file: trajectory */
+#define OUTF_MATRIX       1             /* output file: covariance matrix */
+#define OUTF_RESIDUALS    2             /* output file: residuals */
+#define OUTF_CLOCK        3             /* output file: receiver clock */
+#define OUTF_AMBIGUITY    4             /* output file: ambiguity */
+#define OUTF_IONOSPHERE   5             /* output file: ionosphere */
+#define OUTF_TROPOSPHERE  6             /* output file: troposphere */
+#define OUTF_MEASURES     7             /* output file: measurements */
+#define OUTF_INCLUDEDSATS 8             /* output file: included satellites */
+#define OUTF_EXCLUDEDSATS 9             /* output file: excluded satellites */
+#define OUTFMT_TEXT 0                   /* output file format: text */
+#define OUTFMT_BIN  1                   /* output file format: binary columnar */
+#define OUTT_SOL    0                   /* output start time: solution */
+#define OUTT_RES    1                   /* output start time: residuals */
+#define OUTT_ION    2                   /* output start time: ionosphere */
+#define OUTB_MAGIC  "RTKOUTB1"          /* binary output file magic */
+#define OUTBUFSIZE  1048576             /* size of output file buffer (bytes) */
+#define MAXOUTLINE  2048                /* max length of output file line buffer */
+#define OUTQUEUESIZE 4194304            /* size of output writer queue (bytes) */
+#define SNAP_MAGIC  "RTKSNAP1"          /* filter snapshot file magic */
+#define SNAP_FILE   "filter_snapshot.bin" /* filter snapshot file name */
+
 #define INT_SWAP_TRAC 86400.0           /* swap interval of trace file (s) */
 #define INT_SWAP_STAT 86400.0           /* swap interval of solution status file (s) */
 
+#define TRACEB_MAGIC "RTKTRCB1"         /* binary trace: file magic */
+#define TRACEB_HLEN 12                  /* binary trace: record header length */
+#define TRACEB_FMT  0                   /* binary trace record: format string */
+#define TRACEB_MSG  1                   /* binary trace record: trace() */
+#define TRACEB_MSGT 2                   /* binary trace record: tracet() */
+#define TRACEB_RAW  3                   /* binary trace record: text without level */
+#define TRACEB_MAT  4                   /* binary trace record: row of tracemat() */
+#define TRACEB_LOST 5                   /* binary trace record: lost records */
+
 #define MAXEXFILE   1024                /* max number of expanded files */
 #define MAXSBSAGEF  30.0                /* max age of SBAS fast correction (s) */
 #define MAXSBSAGEL  1800.0              /* max age of SBAS long term corr (s) */
@@ -361,6 +392,9 @@ extern "C" {
 #define ARMODE_WLNL 6                   /* AR mode: wide lane/narrow lane */
 #define ARMODE_TCAR 7                   /* AR mode: triple carrier ar */
 
+#define KFUPD_STD   0                   /* kalman filter update: standard */
+#define KFUPD_CHOL  1                   /* kalman filter update: symmetric cholesky */
+
 #define SBSOPT_LCORR 1                  /* SBAS option: long term correction */
 #define SBSOPT_FCORR 2                  /* SBAS option: fast correction */
 #define SBSOPT_ICORR 4                  /* SBAS option: ionosphere correction */
@@ -455,6 +489,7 @@ extern "C" {
 #define initlock(f) InitializeCriticalSection(f)
 #define lock(f)     EnterCriticalSection(f)
 #define unlock(f)   LeaveCriticalSection(f)
+#define THREADLOCAL __declspec(thread)
 #define FILEPATHSEP '\\'
 #else
 #define thread_t    pthread_t
@@ -462,6 +497,7 @@ extern "C" {
 #define initlock(f) pthread_mutex_init(f,NULL)
 #define lock(f)     pthread_mutex_lock(f)
 #define unlock(f)   pthread_mutex_unlock(f)
+#define THREADLOCAL __thread
 #define FILEPATHSEP '/'
 #endif
 
@@ -942,6 +978,11 @@ typedef struct {        /* solution status buffer type */
     solstat_t *data;    /* solution status data */
 } solstatbuf_t;
 
+typedef struct {        /* bit stream cursor type */
+    unsigned char *buff; /* byte data */
+    int pos;            /* current bit position from start of data (bits) */
+} bitstr_t;
+
 typedef struct {        /* RTCM control struct type */
     int staid;          /* station id */
     int stah;           /* station health */
@@ -987,6 +1028,33 @@ typedef struct {        /* rinex control struct type */
     char   opt[256];    /* rinex dependent options */
 } rnxctr_t;
 
+typedef struct {        /* decompressing file type */
+    FILE *fp;           /* file pointer (NULL: closed) */
+    int type;           /* compression (0:none,1:gzip,2:unix compress) */
+    void *dec;          /* decoder of compression */
+    void *crxd;         /* decoder of hatanaka-compression (NULL: none) */
+    unsigned char *buff; /* decompressed data buffer */
+    int nb,ib;          /* number of bytes/read index in buffer */
+    int err;            /* decoding error (0:no error,1:error) */
+} decomp_t;
+
+typedef struct {        /* rinex observation stream type */
+    int rcv;            /* receiver number */
+    gtime_t ts,te;      /* observation time start/end (time==0: no limit) */
+    double tint;        /* observation time interval (s) (0:all) */
+    char opt[256];      /* rinex options */
+    int n,nmax;         /* number of observation files/allocated */
+    char **files;       /* observation files */
+    unsigned char *tmp; /* temporary uncompressed file flags */
+    int ifile;          /* current file index */
+    FILE *fp;           /* current file pointer (NULL: closed) */
+    decomp_t dc;        /* current decompressing file (dc.fp==NULL: closed) */
+    double ver;         /* rinex version of current file */
+    int tsys;           /* time system of current file */
+    char tobs[6][MAXOBSTYPE][4]; /* rinex obs types of current file */
+    unsigned char slips[MAXSAT][NFREQ]; /* cycle-slips of current file */
+} rnxobs_t;
+
 typedef struct {        /* download url type */
     char type[32];      /* data type */
     char path[1024];    /* url path */
@@ -1014,6 +1082,14 @@ typedef struct {        /* SNR mask type */
     double mask[NFREQ][9]; /* mask (dBHz) at 5,10,...85 deg */
 } snrmask_t;
 
+typedef struct {        /* debug log of processing session */
+    FILE *fp;           /* solution log (solution_log.txt) (NULL: off) */
+    FILE *fpkf;         /* kalman filter log (KalmanFiltering.txt) (NULL: off) */
+    FILE *fpcov;        /* single point covariance (cov_matr_single.txt) */
+    FILE *fpsnap;       /* filter snapshot (SNAP_FILE) (NULL: off) */
+    int level;          /* debug log level (0:off) */
+} dbglog_t;
+
 typedef struct {        /* processing options type */
     int mode;           /* positioning mode (PMODE_???) */
     int soltype;        /* solution type (0:forward,1:backward,2:combined) */
@@ -1077,6 +1153,19 @@ typedef struct {        /* processing options type */
     int outmeasures;
     int outincludedsats;
     int outexcludedsats;
+    int kfupd;          /* kalman filter measurement update (KFUPD_???) */
+    int ambarc;         /* ppp phase-bias by ambiguity arcs (0:off,1:on) */
+    int outformat;      /* output files format (OUTFMT_???) */
+    char outdir[MAXSTRPATH]; /* directory of output files ("":current) */
+    int dbglevel;       /* debug log level (0:off) */
+    int dbgsnap;        /* filter snapshot output (0:off,1:on) */
+    int nthread;        /* number of threads of processing sessions */
+    int nslice;         /* number of time slices of session (0,1:off) */
+    int streamobs;      /* streaming obs input of forward solutions (0:off,1:on) */
+    int nload;          /* number of threads of loading input files (0,1:off) */
+    char rnxcache[MAXSTRPATH]; /* directory of rinex cache files ("":off) */
+    double slicewarm;   /* warm-up interval of time slices (s) */
+    dbglog_t *dbglog;   /* debug log of session (NULL: no log) */
 } prcopt_t;
 
 typedef struct {        /* solution options type */
@@ -1183,10 +1272,11 @@ typedef struct {        /* ambiguity control type */
 typedef struct {
     int n;
     gtime_t start[MAXAMB];
-    gtime_t end[MAXAMB];
+    gtime_t end[MAXAMB];  /* end of arc ({0}: open to end of data) */
     double amb[MAXAMB];
     double sigma[MAXAMB];
     int nobs[MAXAMB];
+    double phw;           /* phase windup of last measurement (cycle) */
 } ambinfo_t;
 
 typedef struct {
@@ -1202,6 +1292,20 @@ typedef struct {
     antData_t* ant_data;
 } antDataSet_t;
 
+typedef struct {        /* kalman filter workspace type */
+    int mode;           /* measurement update mode (KFUPD_???) */
+    int nmax,mmax;      /* allocated number of states/measurements */
+    double *xp,*Pp;     /* states/covariance under update (n x 1,n x n) */
+    double *v,*H,*R;    /* innovation/design matrix/measurement covariance
+                           (m x 1,n x m,m x m) */
+    int *ix,*ipiv;      /* index of effective states/pivot index */
+    double *x_,*xp_;    /* effective states before/after update */
+    double *P_,*Pp_;    /* effective covariance before/after update */
+    double *H_;         /* effective design matrix */
+    double *F,*Q,*K,*I; /* P*H, innovation covariance, gain and I-K*H' */
+    double *work;       /* work area for matrix inversion */
+} filterws_t;
+
 typedef struct {        /* RTK control/result type */
     sol_t  sol;         /* RTK solution */
     double rb[6];       /* base position/velocity (ecef) (m|m/s) */
@@ -1209,6 +1313,8 @@ typedef struct {        /* RTK control/result type */
     double tt;          /* time difference between current and previous (s) */
     double *x, *P;      /* float states and their covariance */
     double *xa,*Pa;     /* fixed states and their covariance */
+    int nb;             /* number of phase-bias states (last nb of nx) */
+    int ib[MAXSAT][NFREQ]; /* state index of phase-bias (0:no state) */
     int nfix;           /* number of continuous fixes of ambiguity */
     ambc_t ambc[MAXSAT]; /* ambibuity control */
     ssat_t ssat[MAXSAT]; /* satellite status */
@@ -1217,6 +1323,7 @@ typedef struct {        /* RTK control/result type */
     prcopt_t opt;       /* processing options */
     ambinfo_t ambinfo[MAXSAT];
     antDataSet_t ant_dataset[MAXANT];
+    filterws_t ws;      /* kalman filter workspace */
 } rtk_t;
 
 typedef struct {        /* receiver raw data control type */
@@ -1299,6 +1406,113 @@ typedef struct {        /* stream server type */
     lock_t lock;        /* lock flag */
 } strsvr_t;
 
+typedef struct {        /* column of output file */
+  const char* name;     /* column name */
+  int width;            /* field width (symbols) */
+  int precision;        /* number of decimals */
+} outcol_t;
+
+typedef struct {        /* column schema of output file */
+  const char* file;     /* file name */
+  const char* title;    /* title in header */
+  int n;                /* number of columns (0: variable) */
+  const outcol_t* cols; /* columns */
+} outschema_t;
+
+typedef struct {        /* queue of output writer */
+  unsigned char* buff;  /* ring buffer of output records */
+  int size;             /* size of ring buffer (bytes) */
+  int wp, rp;           /* write/read pointer of ring buffer (bytes) */
+  int state;            /* state of writer thread (0:stop,1:run) */
+  thread_t thread;      /* writer thread */
+  lock_t lock;          /* lock flag */
+} outqueue_t;
+
+typedef struct {        /* start times of output files */
+  int tset[3];          /* start time set (OUTT_???) */
+  gtime_t t0[3];        /* start time (OUTT_???) */
+} outtime_t;
+
+typedef struct {
+  FILE* trajectory;
+  FILE* matrix;
+  FILE* residuals;
+  FILE* clock;
+  FILE* ambiguity;
+  FILE* ionosphere;
+  FILE* troposphere;
+  FILE* measures;
+  FILE* includedSats;
+  FILE* excludedSats;
+  int format;           /* output file format (OUTFMT_???) */
+  outqueue_t* queue;    /* queue of asynchronous writer (NULL: synchronous) */
+  outtime_t time;       /* start times of output files */
+} outputFiles_t;
+
+typedef struct {        /* header of binary output file */
+  char magic[8];        /* file magic (OUTB_MAGIC) */
+  unsigned int endian;  /* byte order check (0x01020304) */
+  int hlen;             /* header length with columns (bytes) */
+  int ncol;             /* number of columns */
+  int tset;             /* start time set flag */
+  double time;          /* start time (gtime_t.time) */
+  double sec;           /* start time (gtime_t.sec) */
+  char title[64];       /* title in text header */
+} outbhead_t;
+
+typedef struct {        /* column of binary output file */
+  char name[32];        /* column name */
+  int width;            /* field width in text (symbols) */
+  int precision;        /* number of decimals in text */
+} outbcol_t;
+
+typedef struct {        /* binary output file mapped to memory */
+  const outbhead_t* head; /* header */
+  const outbcol_t* cols; /* columns */
+  const double* data;   /* rows (row major, n x head->ncol) */
+  int n;                /* number of rows */
+  void* map;            /* mapped address */
+  size_t size;          /* mapped size (bytes) */
+} outbfile_t;
+
+typedef struct {        /* header of filter snapshot file */
+  char magic[8];        /* file magic (SNAP_MAGIC) */
+  unsigned int endian;  /* byte order check (0x01020304) */
+  int hlen;             /* header length (bytes) */
+} snaphead_t;
+
+typedef struct {        /* record of filter snapshot file */
+  double time;          /* epoch (gtime_t.time) */
+  double sec;           /* epoch (gtime_t.sec) */
+  int len;              /* record length with this header (bytes) */
+  int mode;             /* positioning mode (PMODE_???) */
+  int iter;             /* iteration of measurement update */
+  int nx;               /* number of states */
+  int nv;               /* number of measurements */
+  int nh;               /* number of nonzeros of H */
+} snaprec_t;            /* followed by x[nx], P[nx*(nx+1)/2], v[nv],
+                           R[nv*(nv+1)/2], H[nh] and index of H[nh] (int) */
+
+typedef struct {        /* filter snapshot in place of mapped file */
+  const snaprec_t* rec; /* record header */
+  gtime_t time;         /* epoch */
+  const double* x;      /* states before update {x} */
+  const double* P;      /* packed upper triangle of covariance {P(i,j),i<=j} */
+  const double* v;      /* innovations {v} */
+  const double* R;      /* packed upper triangle of measurement error cov */
+  const double* H;      /* nonzeros of transposed design matrix */
+  const int* Hidx;      /* index of nonzeros in H (i+j*nx, i:state,j:meas) */
+} snapshot_t;
+
+typedef struct {        /* filter snapshot file mapped to memory */
+  const snaphead_t* head; /* header */
+  const snaprec_t** recs; /* records */
+  int n;                /* number of records */
+  int sorted;           /* records sorted by epoch flag */
+  void* map;            /* mapped address */
+  size_t size;          /* mapped size (bytes) */
+} snapfile_t;
+
 typedef struct {        /* RTK server type */
     int state;          /* server state (0:stop,1:running) */
     int cycle;          /* processing cycle (ms) */
@@ -1334,24 +1548,15 @@ typedef struct {        /* RTK server type */
     thread_t thread;    /* server thread */
     int cputime;        /* CPU time (ms) for a processing cycle */
     int prcout;         /* missing observation data count */
+    int outfile;        /* diagnostic output files flag (0:off,1:on) */
+    gtime_t outtime;    /* start time of diagnostic output files */
+    outputFiles_t outfiles; /* diagnostic output files */
     lock_t lock;        /* lock flag */
 } rtksvr_t;
 
-typedef struct {
-  FILE* trajectory;
-  FILE* matrix;
-  FILE* residuals;
-  FILE* clock;
-  FILE* ambiguity;
-  FILE* ionosphere;
-  FILE* troposphere;
-  FILE* measures;
-  FILE* includedSats;
-  FILE* excludedSats;
-} outputFiles_t;
-
 /* global variables ----------------------------------------------------------*/
 extern const double chisqr[];           /* chi-sqr(n) table (alpha=0.001) */
+extern const outschema_t outputSchemas[]; /* column schemas of output files (OUTF_???) */
 extern const double lam_carr[];         /* carrier wave length (m) {L1,L2,...} */
 extern const prcopt_t prcopt_default;   /* default positioning options */
 extern const solopt_t solopt_default;   /* default solution output options */
@@ -1392,6 +1597,10 @@ extern int  lsq   (const double *A, const double *y, int n, int m, double *x,
                    double *Q);
 extern int  filter(double *x, double *P, const double *H, const double *v,
                    const double *R, int n, int m);
+extern void initfilterws(filterws_t *ws, int n, int m);
+extern void freefilterws(filterws_t *ws);
+extern int  filter_ws(double *x, double *P, const double *H, const double *v,
+                      const double *R, int n, int m, filterws_t *ws);
 extern int  smoother(const double *xf, const double *Qf, const double *xb,
                      const double *Qb, int n, double *xs, double *Qs);
 extern void matprint (const double *A, int n, int m, int p, int q);
@@ -1411,6 +1620,7 @@ extern double  time2gst(gtime_t t, int *week);
 extern gtime_t bdt2time(int week, double sec);
 extern double  time2bdt(gtime_t t, int *week);
 extern char    *time_str(gtime_t t, int n);
+extern char    *time_str_r(gtime_t t, int n, char *str);
 
 extern gtime_t timeadd  (gtime_t t, double sec);
 extern double  timediff (gtime_t t1, gtime_t t2);
@@ -1460,25 +1670,42 @@ extern int  readblq(const char *file, const char *sta, double *odisp);
 extern int  readerp(const char *file, erp_t *erp);
 extern int  geterp (const erp_t *erp, gtime_t time, double *val);
 
-extern void prepareOutputFiles(outputFiles_t *files, prcopt_t *prcopt);
+extern char* outputPath(const prcopt_t* prcopt, const char* file, char* path);
+extern int prepareOutputFiles(outputFiles_t *files, prcopt_t *prcopt);
+extern dbglog_t* openDebugLog(const prcopt_t* prcopt);
+extern void closeDebugLog(dbglog_t* log);
 extern void closeOutputFiles(outputFiles_t* files);
+extern int startOutputWriter(outputFiles_t* files, int size);
 extern void writeTimeToFile(FILE* output, gtime_t time);
+extern void writeColumns(FILE* output, const outschema_t* schema, const double* values);
+extern void writeOutputTime(outputFiles_t* files, int stream, gtime_t time);
+extern void writeOutputRow(outputFiles_t* files, int stream, const double* values);
+extern int openBinaryOutput(const char* file, outbfile_t* out);
+extern void closeBinaryOutput(outbfile_t* out);
+extern FILE* openSnapshotFile(const char* file);
+extern void writeSnapshot(FILE* fp, int mode, gtime_t time, int iter, const double* x, const double* P,
+                          const double* H, const double* v, const double* R, int nx, int nv);
+extern int openSnapshot(const char* file, snapfile_t* snap);
+extern void closeSnapshot(snapfile_t* snap);
+extern int getSnapshot(const snapfile_t* snap, int index, snapshot_t* snapshot);
+extern int seekSnapshot(const snapfile_t* snap, gtime_t time);
 extern void writeLineToFile(FILE* output, int* symbols_count, int* precisions, int n, ...);
-extern void writeTrajectory(FILE* output, double timeDiff, double* position);
-extern void writeCovariationMatrix(FILE* output, double timeDiff, float* positionMatrix, float* velocityMatrix);
-extern void writeResiduals(FILE* output, double timeDiff, int satNumber, double codeResidual, double phaseResidual);
-extern void writeClock(FILE* output, double timeDiff, double deltaT, double deltaF);
-extern void writeAmbiguity(FILE* output, double timeDiff, int satNumber, double ambiguityL1, double ambiguityL2, double sigmaL1, double sigmaL2);
-extern void writeIonosphere(FILE* output, double timeDiff, int satNumber, double azimuth, double elevation, double latitude, double longitude, double height, double s_TEC, double vs_TEC);
-extern void writeTroposphere(FILE* output, double timeDiff, int satNumber, double deltaT, double deltaTdot);
-extern void writeMeasures(FILE* output, double timeDiff, const obsd_t* measure);
-extern void writeIncludedSats(FILE* output, double timeDiff, int n, int* includedSats);
-extern void writeExcludedSats(FILE* output, double timeDiff, int n, int* excludedSats, int* excludeReasons);
+extern void writeTrajectory(outputFiles_t* files, double timeDiff, double* position);
+extern void writeCovariationMatrix(outputFiles_t* files, double timeDiff, float* positionMatrix, float* velocityMatrix);
+extern void writeResiduals(outputFiles_t* files, double timeDiff, int satNumber, double codeResidual, double phaseResidual);
+extern void writeClock(outputFiles_t* files, double timeDiff, double deltaT, double deltaF);
+extern void writeAmbiguity(outputFiles_t* files, double timeDiff, int satNumber, double ambiguityL1, double ambiguityL2, double sigmaL1, double sigmaL2);
+extern void writeIonosphere(outputFiles_t* files, double timeDiff, int satNumber, double azimuth, double elevation, double latitude, double longitude, double height, double s_TEC, double vs_TEC);
+extern void writeTroposphere(outputFiles_t* files, double timeDiff, int satNumber, double deltaT, double deltaTdot);
+extern void writeMeasures(outputFiles_t* files, double timeDiff, const obsd_t* measure);
+extern void writeIncludedSats(outputFiles_t* files, double timeDiff, int n, int* includedSats);
+extern void writeExcludedSats(outputFiles_t* files, double timeDiff, int n, int* excludedSats, int* excludeReasons);
 extern void outputtofile(const char* filename, gtime_t time, const char* header, int* symbols_count, int* precisions, int n_data, int n_arrays, ...);
 
 
 /* debug trace functions -----------------------------------------------------*/
 extern void traceopen(const char *file);
+extern void traceopenb(const char *file);
 extern void traceclose(void);
 extern void tracelevel(int level);
 extern void trace    (int level, const char *format, ...);
@@ -1492,6 +1719,64 @@ extern void tracepeph(int level, const nav_t *nav);
 extern void tracepclk(int level, const nav_t *nav);
 extern void traceb   (int level, const unsigned char *p, int n);
 
+/* debug trace macros: the trace level is checked before the arguments are
+   evaluated. trace(level<=1,...) is always output to stderr with -DTRACE.
+   without -DTRACE or with -DNTRACE, the trace calls are dead code and the
+   arguments are not evaluated. trace() and tracet() are wrapped only by c99
+   or later compilers, as variadic macros are not in c89. otherwise the level
+   is checked in the functions. the format of trace() and tracet() must be a
+   string literal for the binary trace (see traceopenb()) ------------------*/
+extern int level_trace;
+#define TRACEON(level) ((level)<=level_trace)
+#if defined(__STDC_VERSION__)&&__STDC_VERSION__>=199901L
+#define TRACEVA                     /* variadic trace macros */
+#endif
+#if defined(NTRACE)||!defined(TRACE)
+#ifdef TRACEVA
+#define trace(level,...)            (0?(trace)(level,"" __VA_ARGS__):(void)0)
+#define tracet(level,...)           (0?(tracet)(level,"" __VA_ARGS__):(void)0)
+#endif
+#define tracemat(level,A,n,m,p,q)   (0?(tracemat)(level,A,n,m,p,q):(void)0)
+#define traceobs(level,obs,n)       (0?(traceobs)(level,obs,n):(void)0)
+#define tracenav(level,nav)         (0?(tracenav )(level,nav):(void)0)
+#define tracegnav(level,nav)        (0?(tracegnav)(level,nav):(void)0)
+#define tracehnav(level,nav)        (0?(tracehnav)(level,nav):(void)0)
+#define tracepeph(level,nav)        (0?(tracepeph)(level,nav):(void)0)
+#define tracepclk(level,nav)        (0?(tracepclk)(level,nav):(void)0)
+#define traceb(level,p,n)           (0?(traceb)(level,p,n):(void)0)
+#else
+#ifdef TRACEVA
+#define trace(level,...) \
+    ((level)<=1||TRACEON(level)?(trace)(level,"" __VA_ARGS__):(void)0)
+#define tracet(level,...) \
+    (TRACEON(level)?(tracet)(level,"" __VA_ARGS__):(void)0)
+#endif
+#define tracemat(level,A,n,m,p,q) \
+    (TRACEON(level)?(tracemat)(level,A,n,m,p,q):(void)0)
+#define traceobs(level,obs,n) \
+    (TRACEON(level)?(traceobs)(level,obs,n):(void)0)
+#define tracenav(level,nav)  (TRACEON(level)?(tracenav )(level,nav):(void)0)
+#define tracegnav(level,nav) (TRACEON(level)?(tracegnav)(level,nav):(void)0)
+#define tracehnav(level,nav) (TRACEON(level)?(tracehnav)(level,nav):(void)0)
+#define tracepeph(level,nav) (TRACEON(level)?(tracepeph)(level,nav):(void)0)
+#define tracepclk(level,nav) (TRACEON(level)?(tracepclk)(level,nav):(void)0)
+#define traceb(level,p,n)    (TRACEON(level)?(traceb)(level,p,n):(void)0)
+#endif
+
+/* debug log macros: file of the debug log of the session if the level is
+   enabled (DBGSNAP: filter snapshot is enabled), or NULL. the debug log is
+   removed at compile time with -DNDBGLOG */
+#ifdef NDBGLOG
+#define DBGLOG(opt,lv)      ((FILE *)NULL)
+#define DBGLOGKF(opt)       ((FILE *)NULL)
+#define DBGSNAP(opt)        ((FILE *)NULL)
+#else
+#define DBGLOG(opt,lv) \
+    ((opt)->dbglog&&(lv)<=(opt)->dbglog->level?(opt)->dbglog->fp:NULL)
+#define DBGLOGKF(opt)       (DBGLOG(opt,3)?(opt)->dbglog->fpkf:NULL)
+#define DBGSNAP(opt)        ((opt)->dbglog?(opt)->dbglog->fpsnap:NULL)
+#endif
+
 /* platform dependent functions ----------------------------------------------*/
 extern int execcmd(const char *cmd);
 extern int expath (const char *path, char *paths[], int nmax);
@@ -1562,6 +1847,7 @@ extern int readrnxt(const char *file, int rcv, gtime_t ts, gtime_t te,
                     double tint, const char *opt, obs_t *obs, nav_t *nav,
                     sta_t *sta);
 extern int readrnxc(const char *file, nav_t *nav);
+extern void setrnxcache(const char *dir);
 extern int outrnxobsh(FILE *fp, const rnxopt_t *opt, const nav_t *nav);
 extern int outrnxobsb(FILE *fp, const rnxopt_t *opt, const obsd_t *obs, int n,
                       int epflag);
@@ -1575,11 +1861,19 @@ extern int outrnxnavb (FILE *fp, const rnxopt_t *opt, const eph_t *eph);
 extern int outrnxgnavb(FILE *fp, const rnxopt_t *opt, const geph_t *geph);
 extern int outrnxhnavb(FILE *fp, const rnxopt_t *opt, const seph_t *seph);
 extern int uncompress(const char *file, char *uncfile);
+extern int  opendecomp (decomp_t *dc, const char *file);
+extern char *getsdecomp(char *buff, int size, decomp_t *dc);
+extern void closedecomp(decomp_t *dc);
 extern int convrnx(int format, rnxopt_t *opt, const char *file, char **ofile);
 extern int  init_rnxctr (rnxctr_t *rnx);
 extern void free_rnxctr (rnxctr_t *rnx);
 extern int  open_rnxctr (rnxctr_t *rnx, FILE *fp);
 extern int  input_rnxctr(rnxctr_t *rnx, FILE *fp);
+extern int  open_rnxobs  (rnxobs_t *rnx, char **files, int n, int rcv,
+                          gtime_t ts, gtime_t te, double tint, const char *opt);
+extern int  input_rnxobs (rnxobs_t *rnx, obsd_t *data);
+extern void rewind_rnxobs(rnxobs_t *rnx);
+extern void close_rnxobs (rnxobs_t *rnx);
 
 /* ephemeris and clock functions ---------------------------------------------*/
 extern double eph2clk (gtime_t time, const eph_t  *eph);
@@ -1616,8 +1910,17 @@ extern unsigned int getbitu(const unsigned char *buff, int pos, int len);
 extern int          getbits(const unsigned char *buff, int pos, int len);
 extern void setbitu(unsigned char *buff, int pos, int len, unsigned int data);
 extern void setbits(unsigned char *buff, int pos, int len, int data);
+extern void bsinit(bitstr_t *bs, const unsigned char *buff, int pos);
+extern unsigned int bsgetu(bitstr_t *bs, int len);
+extern int          bsgets(bitstr_t *bs, int len);
+extern void bssetu(bitstr_t *bs, int len, unsigned int data);
+extern void bssets(bitstr_t *bs, int len, int data);
 extern unsigned int __attribute__ ((visibility ("hidden"))) crc32  (const unsigned char *buff, int len);
+extern unsigned int crc32_update(unsigned int crc, const unsigned char *buff,
+                                 int len);
 extern unsigned int crc24q (const unsigned char *buff, int len);
+extern unsigned int crc24q_update(unsigned int crc, const unsigned char *buff,
+                                  int len);
 extern unsigned short __attribute__ ((visibility ("hidden"))) crc16(const unsigned char *buff, int len);
 extern int decode_word (unsigned int word, unsigned char *data);
 extern int decode_frame(const unsigned char *buff, eph_t *eph, alm_t *alm,
@@ -1771,6 +2074,9 @@ extern int pntpos(const obsd_t *obs, int n, const nav_t *nav,
 /* precise positioning -------------------------------------------------------*/
 extern void rtkinit(rtk_t *rtk, const prcopt_t *opt);
 extern void rtkfree(rtk_t *rtk);
+extern int  assignbias (rtk_t *rtk, int sat, int f);
+extern void releasebias(rtk_t *rtk, int sat, int f);
+extern void packbias   (rtk_t *rtk);
 extern int  rtkpos (rtk_t *rtk, const obsd_t *obs, int nobs, const nav_t *nav, outputFiles_t *files);
 extern int  rtkopenstat(const char *file, int level);
 extern void rtkclosestat(void);
@@ -1783,7 +2089,8 @@ extern int pppnx(const prcopt_t *opt);
 extern void pppoutsolstat(rtk_t *rtk, int level, FILE *fp);
 extern void windupcorr(gtime_t time, const double *rs, const double *rr,
                        double *phw);
-extern void getambinfo(rtk_t *rtk,  const obs_t *obs, const nav_t *nav);
+extern void getambinfo(const prcopt_t *opt, const obs_t *obs, const nav_t *nav,
+                       const double *rr, ambinfo_t *ambinfo);
 
 /* post-processing positioning -----------------------------------------------*/
 extern int postpos(gtime_t ts, gtime_t te, double ti, double tu,
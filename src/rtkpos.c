@@ -69,15 +69,13 @@ static const char rcsid[]="$Id:$";
 #define NI(opt)     ((opt)->ionoopt!=IONOOPT_EST?0:MAXSAT)
 #define NT(opt)     ((opt)->tropopt<TROPOPT_EST?0:((opt)->tropopt<TROPOPT_ESTG?2:6))
 #define NL(opt)     ((opt)->glomodear!=2?0:NFREQGLO)
-#define NB(opt)     ((opt)->mode<=PMODE_DGPS?0:MAXSAT*NF(opt))
 #define NR(opt)     (NP(opt)+NI(opt)+NT(opt)+NL(opt))
-#define NX(opt)     (NR(opt)+NB(opt))
 
 /* state variable index */
 #define II(s,opt)   (NP(opt)+(s)-1)                 /* ionos (s:satellite no) */
 #define IT(r,opt)   (NP(opt)+NI(opt)+NT(opt)/2*(r)) /* tropos (r:0=rov,1:ref) */
 #define IL(f,opt)   (NP(opt)+NI(opt)+NT(opt)+(f))   /* receiver h/w bias */
-#define IB(s,f,opt) (NR(opt)+MAXSAT*(f)+(s)-1) /* phase bias (s:satno,f:freq) */
+#define IB(s,f,rtk) ((rtk)->ib[(s)-1][(f)]) /* phase bias (s:satno,f:freq,0:none) */
 
 #ifdef EXTGSI
 
@@ -406,6 +404,89 @@ static void initx(rtk_t *rtk, double xi, double var, int i)
         rtk->P[i+j*rtk->nx]=rtk->P[j+i*rtk->nx]=i==j?var:0.0;
     }
 }
+/* relocate phase-bias states -------------------------------------------------
+* relocate states of assigned phase-biases after the other states in order of
+* frequency and satellite and resize x/P to them. (sat,f) is assigned a new
+* state if sat>0. released states are dropped
+*-----------------------------------------------------------------------------*/
+static void relocbias(rtk_t *rtk, int sat, int f)
+{
+    double *x,*P;
+    int i,j,k,nr=rtk->nx-rtk->nb,nb=0,nx,*index;
+    
+    for (j=0;j<NFREQ;j++) for (i=0;i<MAXSAT;i++) {
+        if (rtk->ib[i][j]||(i==sat-1&&j==f)) nb++;
+    }
+    nx=nr+nb;
+    
+    trace(4,"relocbias: nx=%d->%d sat=%d f=%d\n",rtk->nx,nx,sat,f);
+    
+    index=imat(nx,1);
+    for (i=0;i<nr;i++) index[i]=i;
+    for (j=0,k=nr;j<NFREQ;j++) for (i=0;i<MAXSAT;i++) {
+        if (rtk->ib[i][j]) index[k]=rtk->ib[i][j];
+        else if (i==sat-1&&j==f) index[k]=-1; /* new state */
+        else continue;
+        rtk->ib[i][j]=k++;
+    }
+    x=zeros(nx,1); P=zeros(nx,nx);
+    for (i=0;i<nx;i++) {
+        if (index[i]<0) continue;
+        x[i]=rtk->x[index[i]];
+        for (j=0;j<nx;j++) {
+            if (index[j]<0) continue;
+            P[i+j*nx]=rtk->P[index[i]+index[j]*rtk->nx];
+        }
+    }
+    free(rtk->x); free(rtk->P); free(index);
+    rtk->x=x; rtk->P=P; rtk->nx=nx; rtk->nb=nb;
+}
+/* assign phase-bias state -----------------------------------------------------
+* assign a state of phase-bias to satellite and frequency. x and P grow by one
+* state with zero value and covariance if no state has been assigned yet
+* args   : rtk_t  *rtk      IO  rtk control/result struct
+*          int    sat       I   satellite number
+*          int    f         I   frequency index
+* return : state index of phase-bias
+* notes  : assigning a new state may relocate other phase-bias states and
+*          reallocate rtk->x and rtk->P
+*-----------------------------------------------------------------------------*/
+extern int assignbias(rtk_t *rtk, int sat, int f)
+{
+    if (!rtk->ib[sat-1][f]) relocbias(rtk,sat,f);
+    return rtk->ib[sat-1][f];
+}
+/* release phase-bias state ----------------------------------------------------
+* reset the state of phase-bias and release it for satellite and frequency
+* args   : rtk_t  *rtk      IO  rtk control/result struct
+*          int    sat       I   satellite number
+*          int    f         I   frequency index
+* return : none
+* notes  : the state is kept in x and P with zero value until packbias()
+*-----------------------------------------------------------------------------*/
+extern void releasebias(rtk_t *rtk, int sat, int f)
+{
+    int i,j;
+    
+    if (!(i=rtk->ib[sat-1][f])) return;
+    rtk->x[i]=0.0;
+    for (j=0;j<rtk->nx;j++) rtk->P[i+j*rtk->nx]=rtk->P[j+i*rtk->nx]=0.0;
+    rtk->ib[sat-1][f]=0;
+}
+/* pack phase-bias states ------------------------------------------------------
+* drop released states of phase-bias and shrink x and P
+* args   : rtk_t  *rtk      IO  rtk control/result struct
+* return : none
+*-----------------------------------------------------------------------------*/
+extern void packbias(rtk_t *rtk)
+{
+    int i,j,nb=0;
+    
+    for (i=0;i<MAXSAT;i++) for (j=0;j<NFREQ;j++) {
+        if (rtk->ib[i][j]) nb++;
+    }
+    if (nb<rtk->nb) relocbias(rtk,0,0);
+}
 /* select common satellites between rover and reference station --------------*/
 static int selsat(const obsd_t *obs, double *azel, int nu, int nr,
                   const prcopt_t *opt, int *sat, int *iu, int *ir)
@@ -679,7 +760,7 @@ static void udbias(rtk_t *rtk, double tt, const obsd_t *obs, const int *sat,
                    const int *iu, const int *ir, int ns, const nav_t *nav)
 {
     double cp,pr,cp1,cp2,pr1,pr2,*bias,offset,lami,lam1,lam2,C1,C2;
-    int i,j,f,slip,reset,nf=NF(&rtk->opt);
+    int i,j,k,f,slip,reset,nf=NF(&rtk->opt);
     
     trace(3,"udbias  : tt=%.1f ns=%d\n",tt,ns);
     
@@ -704,13 +785,16 @@ static void udbias(rtk_t *rtk, double tt, const obsd_t *obs, const int *sat,
             
             reset=++rtk->ssat[i-1].outc[f]>(unsigned int)rtk->opt.maxout;
             
-            if (rtk->opt.modear==ARMODE_INST&&rtk->x[IB(i,f,&rtk->opt)]!=0.0) {
-                initx(rtk,0.0,0.0,IB(i,f,&rtk->opt));
+            if (!(j=IB(i,f,rtk))) ;
+            else if (rtk->opt.modear==ARMODE_INST&&rtk->x[j]!=0.0) {
+                releasebias(rtk,i,f);
             }
-            else if (reset&&rtk->x[IB(i,f,&rtk->opt)]!=0.0) {
-                initx(rtk,0.0,0.0,IB(i,f,&rtk->opt));
-                trace(3,"udbias : obs outage counter overflow (sat=%3d L%d n=%d)\n",
-                      i,f+1,rtk->ssat[i-1].outc[f]);
+            else if (reset) {
+                if (rtk->x[j]!=0.0) {
+                    trace(3,"udbias : obs outage counter overflow (sat=%3d L%d n=%d)\n",
+                          i,f+1,rtk->ssat[i-1].outc[f]);
+                }
+                releasebias(rtk,i,f);
             }
             if (rtk->opt.modear!=ARMODE_INST&&reset) {
                 rtk->ssat[i-1].lock[f]=-rtk->opt.minlock;
@@ -718,7 +802,7 @@ static void udbias(rtk_t *rtk, double tt, const obsd_t *obs, const int *sat,
         }
         /* reset phase-bias if detecting cycle slip */
         for (i=0;i<ns;i++) {
-            j=IB(sat[i],f,&rtk->opt);
+            if (!(j=IB(sat[i],f,rtk))) continue;
             rtk->P[j+j*rtk->nx]+=rtk->opt.prn[0]*rtk->opt.prn[0]*tt;
             slip=rtk->ssat[sat[i]-1].slip[f];
             if (rtk->opt.ionoopt==IONOOPT_IFLC) slip|=rtk->ssat[sat[i]-1].slip[1];
@@ -752,24 +836,26 @@ static void udbias(rtk_t *rtk, double tt, const obsd_t *obs, const int *sat,
                 C2=-SQR(lam1)/(SQR(lam2)-SQR(lam1));
                 bias[i]=(C1*lam1*cp1+C2*lam2*cp2)-(C1*pr1+C2*pr2);
             }
-            if (rtk->x[IB(sat[i],f,&rtk->opt)]!=0.0) {
-                offset+=bias[i]-rtk->x[IB(sat[i],f,&rtk->opt)];
+            if ((k=IB(sat[i],f,rtk))&&rtk->x[k]!=0.0) {
+                offset+=bias[i]-rtk->x[k];
                 j++;
             }
         }
         /* correct phase-bias offset to enssure phase-code coherency */
         if (j>0) {
             for (i=1;i<=MAXSAT;i++) {
-                if (rtk->x[IB(i,f,&rtk->opt)]!=0.0) rtk->x[IB(i,f,&rtk->opt)]+=offset/j;
+                if ((k=IB(i,f,rtk))&&rtk->x[k]!=0.0) rtk->x[k]+=offset/j;
             }
         }
         /* set initial states of phase-bias */
         for (i=0;i<ns;i++) {
-            if (bias[i]==0.0||rtk->x[IB(sat[i],f,&rtk->opt)]!=0.0) continue;
-            initx(rtk,bias[i],SQR(rtk->opt.std[0]),IB(sat[i],f,&rtk->opt));
+            if (bias[i]==0.0||((k=IB(sat[i],f,rtk))&&rtk->x[k]!=0.0)) continue;
+            initx(rtk,bias[i],SQR(rtk->opt.std[0]),assignbias(rtk,sat[i],f));
         }
         free(bias);
     }
+    /* drop released states of phase-bias */
+    packbias(rtk);
 }
 /* temporal update of states --------------------------------------------------*/
 static void udstate(rtk_t *rtk, const obsd_t *obs, const int *sat,
@@ -1026,7 +1112,7 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
     prcopt_t *opt=&rtk->opt;
     double bl,dr[3],posu[3],posr[3],didxi=0.0,didxj=0.0,*im;
     double *tropr,*tropu,*dtdxr,*dtdxu,*Ri,*Rj,lami,lamj,fi,fj,df,*Hi=NULL;
-    int i,j,k,m,f,ff,nv=0,nb[NFREQ*4*2+2]={0},b=0,sysi,sysj,nf=NF(opt);
+    int i,j,k,m,f,ff,bi,bj,nv=0,nb[NFREQ*4*2+2]={0},b=0,sysi,sysj,nf=NF(opt);
     
     trace(3,"ddres   : dt=%.1f nx=%d ns=%d\n",dt,rtk->nx,ns);
     
@@ -1108,18 +1194,19 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
             }
             /* double-differenced phase-bias term */
             if (f<nf) {
+                bi=IB(sat[i],f,rtk); bj=IB(sat[j],f,rtk);
                 if (opt->ionoopt!=IONOOPT_IFLC) {
-                    v[nv]-=lami*x[IB(sat[i],f,opt)]-lamj*x[IB(sat[j],f,opt)];
+                    v[nv]-=lami*(bi?x[bi]:0.0)-lamj*(bj?x[bj]:0.0);
                     if (H) {
-                        Hi[IB(sat[i],f,opt)]= lami;
-                        Hi[IB(sat[j],f,opt)]=-lamj;
+                        if (bi) Hi[bi]= lami;
+                        if (bj) Hi[bj]=-lamj;
                     }
                 }
                 else {
-                    v[nv]-=x[IB(sat[i],f,opt)]-x[IB(sat[j],f,opt)];
+                    v[nv]-=(bi?x[bi]:0.0)-(bj?x[bj]:0.0);
                     if (H) {
-                        Hi[IB(sat[i],f,opt)]= 1.0;
-                        Hi[IB(sat[j],f,opt)]=-1.0;
+                        if (bi) Hi[bi]= 1.0;
+                        if (bj) Hi[bj]=-1.0;
                     }
                 }
             }
@@ -1205,10 +1292,10 @@ static int ddres(rtk_t *rtk, const nav_t *nav, double dt, const double *x,
 static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
                       rtk_t *rtk, double *y)
 {
-    static obsd_t obsb[MAXOBS];
-    static double yb[MAXOBS*NFREQ*2],rs[MAXOBS*6],dts[MAXOBS*2],var[MAXOBS];
-    static double e[MAXOBS*3],azel[MAXOBS*2];
-    static int nb=0,svh[MAXOBS*2];
+    static THREADLOCAL obsd_t obsb[MAXOBS];
+    static THREADLOCAL double yb[MAXOBS*NFREQ*2],rs[MAXOBS*6],dts[MAXOBS*2];
+    static THREADLOCAL double var[MAXOBS],e[MAXOBS*3],azel[MAXOBS*2];
+    static THREADLOCAL int nb=0,svh[MAXOBS*2];
     prcopt_t *opt=&rtk->opt;
     double tt=timediff(time,obs[0].time),ttb,*p,*q;
     int i,j,k,nf=NF(opt);
@@ -1239,7 +1326,7 @@ static double intpres(gtime_t time, const obsd_t *obs, int n, const nav_t *nav,
 /* single to double-difference transformation matrix (D') --------------------*/
 static int ddmat(rtk_t *rtk, double *D)
 {
-    int i,j,k,m,f,nb=0,nx=rtk->nx,na=rtk->na,nf=NF(&rtk->opt);
+    int i,j,k,l,m,f,nb=0,nx=rtk->nx,na=rtk->na,nf=NF(&rtk->opt);
     
     trace(3,"ddmat   :\n");
     
@@ -1253,34 +1340,34 @@ static int ddmat(rtk_t *rtk, double *D)
         if (m==1&&rtk->opt.glomodear==0) continue;
         if (m==3&&rtk->opt.bdsmodear==0) continue;
         
-        for (f=0,k=na;f<nf;f++,k+=MAXSAT) {
+        for (f=0;f<nf;f++) {
             
-            for (i=k;i<k+MAXSAT;i++) {
-                if (rtk->x[i]==0.0||!test_sys(rtk->ssat[i-k].sys,m)||
-                    !rtk->ssat[i-k].vsat[f]) {
+            for (i=0;i<MAXSAT;i++) {
+                if (!(k=IB(i+1,f,rtk))||rtk->x[k]==0.0||
+                    !test_sys(rtk->ssat[i].sys,m)||!rtk->ssat[i].vsat[f]) {
                     continue;
                 }
-                if (rtk->ssat[i-k].lock[f]>0&&!(rtk->ssat[i-k].slip[f]&2)&&
-                    rtk->ssat[i-k].azel[1]>=rtk->opt.elmaskar) {
-                    rtk->ssat[i-k].fix[f]=2; /* fix */
+                if (rtk->ssat[i].lock[f]>0&&!(rtk->ssat[i].slip[f]&2)&&
+                    rtk->ssat[i].azel[1]>=rtk->opt.elmaskar) {
+                    rtk->ssat[i].fix[f]=2; /* fix */
                     break;
                 }
-                else rtk->ssat[i-k].fix[f]=1;
+                else rtk->ssat[i].fix[f]=1;
             }
-            for (j=k;j<k+MAXSAT;j++) {
-                if (i==j||rtk->x[j]==0.0||!test_sys(rtk->ssat[j-k].sys,m)||
-                    !rtk->ssat[j-k].vsat[f]) {
+            for (j=0;j<MAXSAT;j++) {
+                if (i==j||!(l=IB(j+1,f,rtk))||rtk->x[l]==0.0||
+                    !test_sys(rtk->ssat[j].sys,m)||!rtk->ssat[j].vsat[f]) {
                     continue;
                 }
-                if (rtk->ssat[j-k].lock[f]>0&&!(rtk->ssat[j-k].slip[f]&2)&&
-                    rtk->ssat[i-k].vsat[f]&&
-                    rtk->ssat[j-k].azel[1]>=rtk->opt.elmaskar) {
-                    D[i+(na+nb)*nx]= 1.0;
-                    D[j+(na+nb)*nx]=-1.0;
+                if (i<MAXSAT&&rtk->ssat[j].lock[f]>0&&!(rtk->ssat[j].slip[f]&2)&&
+                    rtk->ssat[i].vsat[f]&&
+                    rtk->ssat[j].azel[1]>=rtk->opt.elmaskar) {
+                    D[IB(i+1,f,rtk)+(na+nb)*nx]= 1.0;
+                    D[l+(na+nb)*nx]=-1.0;
                     nb++;
-                    rtk->ssat[j-k].fix[f]=2; /* fix */
+                    rtk->ssat[j].fix[f]=2; /* fix */
                 }
-                else rtk->ssat[j-k].fix[f]=1;
+                else rtk->ssat[j].fix[f]=1;
             }
         }
     }
@@ -1303,7 +1390,7 @@ static void restamb(rtk_t *rtk, const double *bias, int nb, double *xa)
             if (!test_sys(rtk->ssat[i].sys,m)||rtk->ssat[i].fix[f]!=2) {
                 continue;
             }
-            index[n++]=IB(i+1,f,&rtk->opt);
+            index[n++]=IB(i+1,f,rtk);
         }
         if (n<2) continue;
         
@@ -1331,7 +1418,7 @@ static void holdamb(rtk_t *rtk, const double *xa)
                 rtk->ssat[i].azel[1]<rtk->opt.elmaskhold) {
                 continue;
             }
-            index[n++]=IB(i+1,f,&rtk->opt);
+            index[n++]=IB(i+1,f,rtk);
             rtk->ssat[i].fix[f]=3; /* hold */
         }
         /* constraint to fixed ambiguity */
@@ -1348,7 +1435,7 @@ static void holdamb(rtk_t *rtk, const double *xa)
         for (i=0;i<nv;i++) R[i+i*nv]=VAR_HOLDAMB;
         
         /* update states with constraints */
-        if ((info=filter(rtk->x,rtk->P,H,v,R,rtk->nx,nv))) {
+        if ((info=filter_ws(rtk->x,rtk->P,H,v,R,rtk->nx,nv,&rtk->ws))) {
             errmsg(rtk,"filter error (info=%d)\n",info);
         }
         free(R);
@@ -1536,11 +1623,14 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
     
     trace(4,"x(0)="); tracemat(4,rtk->x,1,NR(opt),13,4);
     
-    xp=mat(rtk->nx,1); Pp=zeros(rtk->nx,rtk->nx); xa=mat(rtk->nx,1);
-    matcpy(xp,rtk->x,rtk->nx,1);
-    
+    /* measurement update buffers in kalman filter workspace */
     ny=ns*nf*2+2;
-    v=mat(ny,1); H=zeros(rtk->nx,ny); R=mat(ny,ny); bias=mat(rtk->nx,1);
+    initfilterws(&rtk->ws,rtk->nx,ny);
+    xp=rtk->ws.xp; Pp=rtk->ws.Pp; v=rtk->ws.v; H=rtk->ws.H; R=rtk->ws.R;
+    for (i=0;i<rtk->nx*rtk->nx;i++) Pp[i]=0.0;
+    for (i=0;i<rtk->nx*ny;i++) H[i]=0.0;
+    xa=mat(rtk->nx,1); bias=mat(rtk->nx,1);
+    matcpy(xp,rtk->x,rtk->nx,1);
     
     /* add 2 iterations for baseline-constraint moving-base */
     niter=opt->niter+(opt->mode==PMODE_MOVEB&&opt->baseline[0]>0.0?2:0);
@@ -1560,7 +1650,10 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         }
         /* kalman filter measurement update */
         matcpy(Pp,rtk->P,rtk->nx,rtk->nx);
-        if ((info=filter(xp,Pp,H,v,R,rtk->nx,nv))) {
+        if (DBGSNAP(opt)) {
+            writeSnapshot(DBGSNAP(opt),opt->mode,time,i,xp,Pp,H,v,R,rtk->nx,nv);
+        }
+        if ((info=filter_ws(xp,Pp,H,v,R,rtk->nx,nv,&rtk->ws))) {
             errmsg(rtk,"filter error (info=%d)\n",info);
             stat=SOLQ_NONE;
             break;
@@ -1661,7 +1754,7 @@ static int relpos(rtk_t *rtk, const obsd_t *obs, int nu, int nr,
         if (rtk->ssat[i].slip[j]&1) rtk->ssat[i].slipc[j]++;
     }
     free(rs); free(dts); free(var); free(y); free(e); free(azel);
-    free(xp); free(Pp);  free(xa);  free(v); free(H); free(R); free(bias);
+    free(xa); free(bias);
     
     if (stat!=SOLQ_NONE) rtk->sol.stat=stat;
     
@@ -1678,14 +1771,16 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
     sol_t sol0={{0}};
     ambc_t ambc0={{{0}}};
     ssat_t ssat0={0};
-    int i;
+    filterws_t ws0={0};
+    int i,j;
     
     trace(3,"rtkinit :\n");
     
     rtk->sol=sol0;
     for (i=0;i<6;i++) rtk->rb[i]=0.0;
-    rtk->nx=opt->mode<=PMODE_FIXED?NX(opt):pppnx(opt);
+    rtk->nx=opt->mode<=PMODE_FIXED?NR(opt):pppnx(opt);
     rtk->na=opt->mode<=PMODE_FIXED?NR(opt):0;
+    rtk->nb=0;
     rtk->tt=0.0;
     rtk->x=zeros(rtk->nx,1);
     rtk->P=zeros(rtk->nx,rtk->nx);
@@ -1695,9 +1790,13 @@ extern void rtkinit(rtk_t *rtk, const prcopt_t *opt)
     for (i=0;i<MAXSAT;i++) {
         rtk->ambc[i]=ambc0;
         rtk->ssat[i]=ssat0;
+        for (j=0;j<NFREQ;j++) rtk->ib[i][j]=0;
     }
     for (i=0;i<MAXERRMSG;i++) rtk->errbuf[i]=0;
     rtk->opt=*opt;
+    rtk->ws=ws0;
+    rtk->ws.mode=opt->kfupd;
+    initfilterws(&rtk->ws,rtk->nx,1);
 }
 /* free rtk control ------------------------------------------------------------
 * free memory for rtk control struct
@@ -1708,11 +1807,12 @@ extern void rtkfree(rtk_t *rtk)
 {
     trace(3,"rtkfree :\n");
     
-    rtk->nx=rtk->na=0;
+    rtk->nx=rtk->na=rtk->nb=0;
     free(rtk->x ); rtk->x =NULL;
     free(rtk->P ); rtk->P =NULL;
     free(rtk->xa); rtk->xa=NULL;
     free(rtk->Pa); rtk->Pa=NULL;
+    freefilterws(&rtk->ws);
 }
 /* precise positioning ---------------------------------------------------------
 * input observation data and navigation message, compute rover position by 
@@ -384,6 +384,22 @@ static void decodefile(rtksvr_t *svr, int index)
         rtksvrunlock(svr);
     }
 }
+/* write diagnostic output files ---------------------------------------------*/
+static void writeoutfiles(rtksvr_t *svr, const obsd_t *obs)
+{
+    double dt;
+    
+    if (svr->outtime.time==0) {
+        writeOutputTime(&svr->outfiles,OUTF_TRAJECTORY,svr->rtk.sol.time);
+        writeOutputTime(&svr->outfiles,OUTF_MATRIX,svr->rtk.sol.time);
+        writeOutputTime(&svr->outfiles,OUTF_CLOCK,obs[0].time);
+        svr->outtime=svr->rtk.sol.time;
+    }
+    dt=timediff(svr->rtk.sol.time,svr->outtime);
+    writeTrajectory(&svr->outfiles,dt,svr->rtk.sol.rr);
+    writeCovariationMatrix(&svr->outfiles,dt,svr->rtk.sol.qr,svr->rtk.sol.qvr);
+    writeClock(&svr->outfiles,dt,1E9*timediff(svr->rtk.sol.time,obs[0].time),0);
+}
 /* rtk server thread ---------------------------------------------------------*/
 #ifdef WIN32
 static DWORD WINAPI rtksvrthread(void *arg)
@@ -447,10 +463,14 @@ static void *rtksvrthread(void *arg)
             }
             /* rtk positioning */
             rtksvrlock(svr);
-            rtkpos(&svr->rtk,obs.data,obs.n,&svr->nav,NULL);
+            rtkpos(&svr->rtk,obs.data,obs.n,&svr->nav,
+                   svr->outfile?&svr->outfiles:NULL);
             rtksvrunlock(svr);
             if (svr->rtk.sol.stat!=SOLQ_NONE) {
                 
+                /* write diagnostic output files */
+                if (svr->outfile) writeoutfiles(svr,obs.data);
+                
                 /* adjust current time */
                 tt=(int)(tickget()-tick)/1000.0+DTTOL;
                 timeset(gpst2utc(timeadd(svr->rtk.sol.time,tt)));
@@ -488,6 +508,12 @@ static void *rtksvrthread(void *arg)
         sleepms(svr->cycle-cputime);
     }
     for (i=0;i<MAXSTRRTK;i++) strclose(svr->stream+i);
+    if (svr->outfile) {
+        closeOutputFiles(&svr->outfiles);
+        closeDebugLog(svr->rtk.opt.dbglog);
+        svr->rtk.opt.dbglog=NULL;
+        svr->outfile=0;
+    }
     for (i=0;i<3;i++) {
         svr->nb[i]=svr->npb[i]=0;
         free(svr->buff[i]); svr->buff[i]=NULL;
@@ -525,6 +551,7 @@ extern int rtksvrinit(rtksvr_t *svr)
     for (i=0;i<3;i++) svr->format[i]=0;
     for (i=0;i<2;i++) svr->solopt[i]=solopt_default;
     svr->navsel=svr->nsbs=svr->nsol=0;
+    svr->outfile=0;
     rtkinit(&svr->rtk,&prcopt_default);
     for (i=0;i<3;i++) svr->nb[i]=0;
     for (i=0;i<2;i++) svr->nsb[i]=0;
@@ -648,6 +675,7 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
                        solopt_t *solopt, stream_t *moni)
 {
     gtime_t time,time0={0};
+    char path[1024];
     int i,j,rw;
     
     tracet(3,"rtksvrstart: cycle=%d buffsize=%d navsel=%d nmeacycle=%d nmeareq=%d\n",
@@ -740,6 +768,22 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     for (i=3;i<5;i++) {
         writesolhead(svr->stream+i,svr->solopt+i-3);
     }
+    /* open diagnostic output files written by the output writer thread */
+    svr->outfile=prcopt->outresiduals||prcopt->outclock||prcopt->outambiguity||
+                 prcopt->outionosphere||prcopt->outtroposphere||
+                 prcopt->outmeasures||prcopt->outincludedsats||
+                 prcopt->outexcludedsats;
+    svr->outtime=time0;
+    if (svr->outfile) {
+        reppath(prcopt->outdir,svr->rtk.opt.outdir,utc2gpst(timeget()),"","");
+        createdir(outputPath(&svr->rtk.opt,"",path));
+        if (!prepareOutputFiles(&svr->outfiles,&svr->rtk.opt)) {
+            tracet(1,"rtksvrstart: output file open error outdir=%s\n",
+                   svr->rtk.opt.outdir);
+        }
+        startOutputWriter(&svr->outfiles,0);
+        svr->rtk.opt.dbglog=openDebugLog(&svr->rtk.opt);
+    }
     /* create rtk server thread */
 #ifdef WIN32
     if (!(svr->thread=CreateThread(NULL,0,rtksvrthread,svr,0,NULL))) {
@@ -747,6 +791,12 @@ extern int rtksvrstart(rtksvr_t *svr, int cycle, int buffsize, int *strs,
     if (pthread_create(&svr->thread,NULL,rtksvrthread,svr)) {
 #endif
         for (i=0;i<MAXSTRRTK;i++) strclose(svr->stream+i);
+        if (svr->outfile) {
+            closeOutputFiles(&svr->outfiles);
+            closeDebugLog(svr->rtk.opt.dbglog);
+            svr->rtk.opt.dbglog=NULL;
+        }
+        svr->outfile=0;
         return 0;
     }
     return 1;
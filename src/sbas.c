@@ -753,7 +753,7 @@ extern double sbstropcorr(gtime_t time, const double *pos, const double *azel,
                           double *var)
 {
     const double k1=77.604,k2=382000.0,rd=287.054,gm=9.784,g=9.80665;
-    static double pos_[3]={0},zh=0.0,zw=0.0;
+    static THREADLOCAL double pos_[3]={0},zh=0.0,zw=0.0;
     int i;
     double c,met[10],sinel=sin(azel[1]),h=pos[2],m;
     
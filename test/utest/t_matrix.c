@@ -177,6 +177,109 @@ void utest6(void)
     }
     free(a); free(b);
 }
+/* filter_ws() */
+void utest7(void)
+{
+    filterws_t ws={0};
+    double x1[10],x2[10],P1[100],P2[100],H[10*4],v[4],R[16]={0};
+    int i,j,k,n=10,m=4;
+    
+    for (k=0;k<3;k++) {
+        for (i=0;i<n;i++) {
+            x1[i]=x2[i]=(i==3&&k==1)?0.0:1.0+i*0.5;
+            for (j=0;j<n;j++) P1[i+j*n]=P2[i+j*n]=i==j?1.0+i:0.01*(i+j);
+            for (j=0;j<m;j++) H[i+j*n]=cos(0.3*i+0.7*j+k);
+        }
+        for (j=0;j<m;j++) {v[j]=0.1*(j-1.5); R[j+j*m]=0.01*(j+1);}
+        
+        assert(!filter(x1,P1,H,v,R,n,m));
+        assert(!filter_ws(x2,P2,H,v,R,n,m,&ws));
+        for (i=0;i<n;i++) assert(x1[i]==x2[i]);
+        for (i=0;i<n*n;i++) assert(P1[i]==P2[i]);
+    }
+    assert(ws.nmax==n&&ws.mmax==m);
+    freefilterws(&ws);
+    assert(ws.nmax==0&&ws.F==NULL);
+    
+    printf("%s utest7 : OK\n",__FILE__);
+}
+/* filter_ws() with cholesky update */
+void utest8(void)
+{
+    filterws_t ws1={0},ws2={0};
+    double x1[12],x2[12],P1[144],P2[144],H[12*5],v[5],R[25]={0};
+    int i,j,n=12,m=5;
+    
+    ws2.mode=KFUPD_CHOL;
+    for (i=0;i<n;i++) {
+        x1[i]=x2[i]=i==5?0.0:1.0+i*0.5;
+        for (j=0;j<n;j++) P1[i+j*n]=P2[i+j*n]=i==j?2.0+i:0.1/(1+i+j);
+        for (j=0;j<m;j++) H[i+j*n]=sin(0.4*i+0.9*j);
+    }
+    for (j=0;j<m;j++) {
+        v[j]=0.2*(j-2.0);
+        for (i=0;i<m;i++) R[i+j*m]=i==j?0.02*(j+1):0.001;
+    }
+    assert(!filter_ws(x1,P1,H,v,R,n,m,&ws1));
+    assert(!filter_ws(x2,P2,H,v,R,n,m,&ws2));
+    for (i=0;i<n;i++) assert(fabs(x1[i]-x2[i])<1E-12);
+    for (i=0;i<n;i++) for (j=0;j<n;j++) {
+        assert(fabs(P1[i+j*n]-P2[i+j*n])<1E-12);
+        assert(P2[i+j*n]==P2[j+i*n]);
+    }
+    for (i=0;i<m*m;i++) R[i]=0.0; /* not positive definite */
+    for (i=0;i<n*m;i++) H[i]=0.0;
+    assert(filter_ws(x2,P2,H,v,R,n,m,&ws2));
+    freefilterws(&ws1);
+    freefilterws(&ws2);
+    
+    printf("%s utest8 : OK\n",__FILE__);
+}
+/* matmul() vs reference loop */
+static void matmul_ref(const char *tr, int n, int k, int m, double alpha,
+                       const double *A, const double *B, double beta, double *C)
+{
+    double d;
+    int i,j,x;
+    
+    for (i=0;i<n;i++) for (j=0;j<k;j++) {
+        d=0.0;
+        for (x=0;x<m;x++) {
+            d+=(tr[0]=='N'?A[i+x*n]:A[x+i*m])*(tr[1]=='N'?B[x+j*m]:B[j+x*k]);
+        }
+        if (beta==0.0) C[i+j*n]=alpha*d; else C[i+j*n]=alpha*d+beta*C[i+j*n];
+    }
+}
+void utest9(void)
+{
+    const char *trs[]={"NN","NT","TN","TT"};
+    int size[][3]={{3,3,3},{3,1,3},{4,4,1},{4,4,7},{1,1,1},{2,3,4},{5,7,3},
+                   {8,8,8},{13,6,11},{16,1,16},{31,29,17}};
+    double A[32*32],B[32*32],C1[32*32],C2[32*32],beta;
+    int i,j,n,k,m,b,x;
+    
+    for (i=0;i<32*32;i++) {
+        A[i]=(double)rand()/RAND_MAX-0.5;
+        B[i]=(double)rand()/RAND_MAX-0.5;
+    }
+    for (i=0;i<(int)(sizeof(size)/sizeof(*size));i++) for (j=0;j<4;j++) {
+        for (b=0;b<2;b++) {
+            n=size[i][0]; k=size[i][1]; m=size[i][2]; beta=b?0.7:0.0;
+            memcpy(C1,B,sizeof(double)*n*k);
+            memcpy(C2,B,sizeof(double)*n*k);
+            matmul    (trs[j],n,k,m,1.3,A,B,beta,C1);
+            matmul_ref(trs[j],n,k,m,1.3,A,B,beta,C2);
+            for (x=0;x<n*k;x++) {
+#ifdef LAPACK
+                assert(fabs(C1[x]-C2[x])<1E-12);
+#else
+                assert(C1[x]==C2[x]); /* identical to reference loop */
+#endif
+            }
+        }
+    }
+    printf("%s utest9 : OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
@@ -185,5 +288,8 @@ int main(void)
     utest4();
     utest5();
     utest6();
+    utest7();
+    utest8();
+    utest9();
     return 0;
 }
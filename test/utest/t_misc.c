@@ -182,11 +182,541 @@ void utest4(void)
     
     printf("%s utset4 : OK\n",__FILE__);
 }
+/* bsinit(),bsgetu(),bsgets(),bssetu(),bssets() vs bit-by-bit loop */
+static unsigned int getbitu_ref(const unsigned char *buff, int pos, int len)
+{
+    unsigned int bits=0;
+    int i;
+    for (i=pos;i<pos+len;i++) bits=(bits<<1)+((buff[i/8]>>(7-i%8))&1u);
+    return bits;
+}
+static void setbitu_ref(unsigned char *buff, int pos, int len, unsigned int data)
+{
+    unsigned int mask=1u<<(len-1);
+    int i;
+    for (i=pos;i<pos+len;i++,mask>>=1) {
+        if (data&mask) buff[i/8]|=1u<<(7-i%8); else buff[i/8]&=~(1u<<(7-i%8));
+    }
+}
+void utest5(void)
+{
+    unsigned char buff1[1024],buff2[1024];
+    unsigned int data;
+    int i,len[4096],n,pos;
+    bitstr_t bs;
+    
+    for (i=0;i<1024;i++) buff1[i]=buff2[i]=(unsigned char)rand();
+    for (n=pos=0;pos<8000;n++) {
+        len[n]=rand()%32+1; pos+=len[n];
+    }
+    bsinit(&bs,buff1,3);
+    for (i=0,pos=3;i<n;pos+=len[i++]) {
+        assert(bsgetu(&bs,len[i])==getbitu_ref(buff1,pos,len[i]));
+        assert(bs.pos==pos+len[i]);
+    }
+    bsinit(&bs,buff1,3);
+    for (i=0,pos=3;i<n;pos+=len[i++]) {
+        data=(unsigned int)rand()*(unsigned int)rand();
+        bssetu(&bs,len[i],data);
+        setbitu_ref(buff2,pos,len[i],data);
+        assert(!memcmp(buff1,buff2,1024));
+    }
+    bsinit(&bs,buff1,5);
+    bssets(&bs,20,-524287); bssets(&bs,24,8388607); bssets(&bs,15,-1);
+    bsinit(&bs,buff1,5);
+    assert(bsgets(&bs,20)==-524287);
+    assert(bsgets(&bs,24)== 8388607);
+    assert(bsgets(&bs,15)==-1);
+    
+    buff1[0]=0xAB; /* last byte of data */
+    bsinit(&bs,buff1,4);
+    assert(bsgetu(&bs,4)==0xB);
+    
+    printf("%s utset5 : OK\n",__FILE__);
+}
+/* crc32(),crc24q(),crc24q_update(),crc16() vs bit-by-bit loop */
+static unsigned int crc_ref(const unsigned char *buff, int len, int nbit,
+                            unsigned int poly)
+{
+    unsigned int crc=0,top=1u<<(nbit-1),mask=top|(top-1);
+    int i,j;
+    for (i=0;i<len;i++) {
+        crc^=(unsigned int)buff[i]<<(nbit-8);
+        for (j=0;j<8;j++) crc=crc&top?((crc<<1)^poly)&mask:(crc<<1)&mask;
+    }
+    return crc;
+}
+static unsigned int crc32_ref(const unsigned char *buff, int len)
+{
+    unsigned int crc=0;
+    int i,j;
+    for (i=0;i<len;i++) {
+        crc^=buff[i];
+        for (j=0;j<8;j++) crc=crc&1?(crc>>1)^0xEDB88320u:crc>>1;
+    }
+    return crc;
+}
+void utest6(void)
+{
+    unsigned char buff[1200];
+    unsigned int crc;
+    int i,j;
+    
+    for (i=0;i<1200;i++) buff[i]=(unsigned char)rand();
+    for (i=0;i<1200;i+=i<64?1:97) {
+        assert(crc32 (buff,i)==crc32_ref(buff,i));
+        assert(crc24q(buff,i)==crc_ref(buff,i,24,0x864CFBu));
+        assert(crc16 (buff,i)==crc_ref(buff,i,16,0x1021u));
+        
+        for (j=0;j<=i;j+=j<16?1:13) {
+            crc=crc24q_update(crc24q(buff,j),buff+j,i-j);
+            assert(crc==crc24q(buff,i));
+        }
+    }
+    printf("%s utset6 : OK\n",__FILE__);
+}
+/* traceopenb() */
+void utest7(void)
+{
+    FILE *fp;
+    double A[]={1.0,2.0,3.0,4.0,5.0,6.0};
+    unsigned char buff[4096];
+    unsigned short len,fid;
+    int n[6]={0};
+    
+    traceopenb("t_misc_trace.bin");
+    tracelevel(3);
+    trace(3,"utest7: i=%d s=%s x=%.3f\n",1,"abc",2.5);
+    trace(3,"utest7: i=%d s=%s x=%.3f\n",2,"def",3.5);
+    tracet(2,"utest7: %5.1f%%\n",99.9);
+    trace(4,"utest7: skipped\n");
+    tracemat(3,A,2,3,5,1);
+    traceclose();
+    
+    fp=fopen("t_misc_trace.bin","rb");
+    assert(fp);
+    assert(fread(buff,1,16,fp)==16&&!memcmp(buff,TRACEB_MAGIC,8));
+    while (fread(buff,1,TRACEB_HLEN,fp)==TRACEB_HLEN) {
+        memcpy(&len,buff,2);
+        memcpy(&fid,buff+6,2);
+        assert(len>=TRACEB_HLEN&&buff[2]<=TRACEB_LOST);
+        assert(fread(buff+TRACEB_HLEN,1,len-TRACEB_HLEN,fp)==len-TRACEB_HLEN);
+        if (buff[2]==TRACEB_FMT) assert(fid==n[TRACEB_FMT]);
+        n[buff[2]]++;
+    }
+    fclose(fp);
+    remove("t_misc_trace.bin");
+    assert(n[TRACEB_FMT]==2&&n[TRACEB_MSG]==2&&n[TRACEB_MSGT]==1);
+    assert(n[TRACEB_MAT]==2&&n[TRACEB_LOST]==0);
+    
+    printf("%s utset7 : OK\n",__FILE__);
+}
+/* writeLineToFile() vs fprintf() */
+void utest8(void)
+{
+    FILE *fp;
+    double x[8]={0.5,2.5,0.125,-0.0,-0.0004,1E12,1E20,-123456.7890125},val[4];
+    char buff[4096],ref[4096],*p;
+    int i,j,n,width[4],prec[4];
+    
+    for (i=0;i<5000;i++) {
+        p=ref;
+        for (j=0;j<4;j++) {
+            width[j]=rand()%16;
+            prec[j]=rand()%8;
+            if (i<8) val[j]=x[(i+j)%8];
+            else if (j==0) val[j]=((double)rand()/RAND_MAX-0.5)*pow(10.0,rand()%14-4);
+            else val[j]=floor(val[0]*pow(10.0,prec[j]))/pow(10.0,prec[j])+
+                        0.5/pow(10.0,prec[j]); /* rounding tie */
+            p+=sprintf(p,"%0*.*f ",width[j],prec[j],val[j]);
+        }
+        sprintf(p,"\n");
+        fp=fopen("t_misc_line.txt","w");
+        writeLineToFile(fp,width,prec,4,val[0],val[1],val[2],val[3]);
+        fclose(fp);
+        fp=fopen("t_misc_line.txt","r");
+        n=(int)fread(buff,1,sizeof(buff)-1,fp); buff[n]='\0';
+        fclose(fp);
+        assert(!strcmp(buff,ref));
+    }
+    remove("t_misc_line.txt");
+    
+    printf("%s utset8 : OK\n",__FILE__);
+}
+/* binary output file */
+void utest9(void)
+{
+    prcopt_t opt={0};
+    outputFiles_t files;
+    outbfile_t out;
+    gtime_t t0={0};
+    double ep[]={2005,4,2,0,0,30.5},rr[6]={1.0,2.0,3.0,4.0,5.0,6.0};
+    int i;
+    
+    opt.outformat=OUTFMT_BIN;
+    prepareOutputFiles(&files,&opt);
+    assert(files.trajectory&&files.matrix&&!files.clock);
+    t0=epoch2time(ep);
+    writeOutputTime(&files,OUTF_TRAJECTORY,t0);
+    writeOutputTime(&files,OUTF_CLOCK,t0); /* not opened */
+    for (i=0;i<100;i++) {
+        rr[0]=i*1.5;
+        writeTrajectory(&files,i*30.0,rr);
+    }
+    closeOutputFiles(&files);
+    
+    assert(!openBinaryOutput("tr_pso_gosk.txt",&out));
+    assert(openBinaryOutput("tr_pso_gosk.bin",&out));
+    assert(out.head->tset&&out.head->ncol==7&&out.n==100);
+    assert(out.head->time==(double)t0.time&&out.head->sec==t0.sec);
+    assert(!strcmp(out.cols[0].name,outputSchemas[OUTF_TRAJECTORY].cols[0].name));
+    for (i=0;i<100;i++) {
+        assert(out.data[i*7]==i*30.0&&out.data[i*7+1]==i*1.5);
+        assert(out.data[i*7+6]==6.0);
+    }
+    closeBinaryOutput(&out);
+    assert(!out.map);
+    
+    assert(openBinaryOutput("cov_pso_gosk.bin",&out)&&!out.head->tset&&out.n==0);
+    closeBinaryOutput(&out);
+    remove("tr_pso_gosk.bin");
+    remove("cov_pso_gosk.bin");
+    
+    printf("%s utset9 : OK\n",__FILE__);
+}
+/* write output files synchronously or by the output writer */
+static void writeout(int async, char **buff)
+{
+    const char *file[]={"tr_pso_gosk.txt","SVexclud.txt"};
+    prcopt_t opt={0};
+    outputFiles_t files;
+    FILE *fp;
+    double ep[]={2005,4,2,0,0,0},rr[6]={0};
+    int i,j,n,sats[64],reasons[64];
+    
+    opt.outexcludedsats=1;
+    prepareOutputFiles(&files,&opt);
+    if (async) assert(startOutputWriter(&files,1)&&files.queue);
+    writeOutputTime(&files,OUTF_TRAJECTORY,epoch2time(ep));
+    for (i=0;i<20000;i++) {
+        for (j=0;j<6;j++) rr[j]=i*0.123+j;
+        writeTrajectory(&files,i*30.0,rr);
+        for (j=0,n=i%64;j<n;j++) {
+            sats[j]=j+1; reasons[j]=j%3;
+        }
+        writeExcludedSats(&files,i*30.0,n,sats,reasons);
+    }
+    closeOutputFiles(&files);
+    assert(!files.queue);
+    
+    for (i=0;i<2;i++) {
+        fp=fopen(file[i],"rb");
+        assert(fp);
+        fseek(fp,0,SEEK_END); n=(int)ftell(fp); fseek(fp,0,SEEK_SET);
+        buff[i]=(char *)calloc(n+1,1);
+        assert((int)fread(buff[i],1,n,fp)==n);
+        fclose(fp);
+        remove(file[i]);
+    }
+    remove("cov_pso_gosk.txt");
+}
+/* asynchronous output writer */
+void utest10(void)
+{
+    char *buff1[2],*buff2[2];
+    
+    writeout(0,buff1);
+    writeout(1,buff2);
+    assert(!strcmp(buff1[0],buff2[0])&&strlen(buff1[0])>20000*70);
+    assert(!strcmp(buff1[1],buff2[1]));
+    free(buff1[0]); free(buff1[1]);
+    free(buff2[0]); free(buff2[1]);
+    
+    printf("%s utset10: OK\n",__FILE__);
+}
+/* filter snapshot file */
+void utest12(void)
+{
+    const char *file="filter_snapshot.bin";
+    snapfile_t snap;
+    snapshot_t ss;
+    FILE *fp;
+    gtime_t t0,t;
+    double ep[]={2005,4,2,0,0,0},x[8],P[64],H[8*5],v[5],R[25];
+    int i,j,k,n,nx=8,nv=5;
+    
+    remove(file);
+    t0=epoch2time(ep);
+    
+    for (i=0;i<nx;i++) x[i]=i+1.0;
+    for (i=0;i<nx*nx;i++) P[i]=i+0.5;
+    for (i=0;i<nv;i++) v[i]=-i-1.0;
+    for (i=0;i<nv*nv;i++) R[i]=i*0.25;
+    for (i=0;i<nx*nv;i++) H[i]=i%3==0?i*0.1+1.0:0.0; /* 14 nonzeros */
+    
+    /* forward and backward epochs of combined solution by two opens */
+    for (k=0;k<2;k++) {
+        assert((fp=openSnapshotFile(file)));
+        for (i=0;i<10;i++) {
+            t=timeadd(t0,(k?9-i:i)*30.0);
+            writeSnapshot(fp,PMODE_PPP_KINEMA,t,i%2,x,P,H,v,R,nx,i%2?nv:nv-1);
+        }
+        fclose(fp);
+        
+        assert(openSnapshot(file,&snap)&&snap.n==10*(k+1));
+        assert(snap.sorted==!k);
+        closeSnapshot(&snap);
+    }
+    assert(openSnapshot(file,&snap));
+    assert(getSnapshot(&snap,3,&ss)&&!getSnapshot(&snap,20,&ss));
+    assert(ss.rec->mode==PMODE_PPP_KINEMA&&ss.rec->iter==1&&ss.rec->nx==nx);
+    assert(ss.rec->nv==nv&&ss.rec->nh==14&&timediff(ss.time,t0)==90.0);
+    for (i=0;i<nx;i++) assert(ss.x[i]==x[i]);
+    for (j=n=0;j<nx;j++) for (i=0;i<=j;i++) assert(ss.P[n++]==P[i+j*nx]);
+    for (i=0;i<nv;i++) assert(ss.v[i]==v[i]);
+    for (j=n=0;j<nv;j++) for (i=0;i<=j;i++) assert(ss.R[n++]==R[i+j*nv]);
+    for (i=0;i<ss.rec->nh;i++) {
+        assert(ss.Hidx[i]%3==0&&ss.H[i]==H[ss.Hidx[i]]);
+    }
+    /* seek in unsorted (forward and backward) records */
+    assert(seekSnapshot(&snap,timeadd(t0,120.0))==4);
+    assert(seekSnapshot(&snap,timeadd(t0,1000.0))==snap.n);
+    closeSnapshot(&snap);
+    assert(!snap.map&&!snap.recs);
+    
+    /* seek in sorted records and truncated file */
+    remove(file);
+    fp=openSnapshotFile(file);
+    for (i=0;i<10;i++) {
+        writeSnapshot(fp,PMODE_KINEMA,timeadd(t0,i*30.0),0,x,P,H,v,R,nx,nv);
+    }
+    fwrite(x,sizeof(double),3,fp);
+    fclose(fp);
+    assert(openSnapshot(file,&snap)&&snap.n==10&&snap.sorted);
+    assert(seekSnapshot(&snap,t0)==0);
+    assert(seekSnapshot(&snap,timeadd(t0,45.0))==2);
+    assert(seekSnapshot(&snap,timeadd(t0,270.0))==9);
+    assert(seekSnapshot(&snap,timeadd(t0,271.0))==10);
+    assert(getSnapshot(&snap,9,&ss)&&ss.rec->mode==PMODE_KINEMA);
+    closeSnapshot(&snap);
+    remove(file);
+    
+    assert(!openSnapshot(file,&snap));
+    
+    printf("%s utset12: OK\n",__FILE__);
+}
+/* in-process decompression (gzip, hatanaka) */
+void utest13(void)
+{
+    const unsigned char gz[]={
+        0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x03,0x53,0x50,
+        0x00,0x02,0x23,0x3d,0x43,0x03,0x05,0x04,0xf0,0x77,0x0a,0x76,
+        0x0d,0x0a,0x73,0x0c,0xf1,0xf4,0xf7,0x53,0x70,0x71,0x0c,0x71,
+        0xe4,0x72,0xf5,0x73,0x51,0xf0,0x77,0x53,0xf0,0x70,0x75,0x74,
+        0x71,0x0d,0xe2,0x02,0x00,0xe2,0x78,0x59,0x83,0x33,0x00,0x00,
+        0x00
+    };
+    const char *crx[]={
+        "1.0                 COMPACT RINEX FORMAT                    CRINEX VERS   / TYPE\n",
+        "RNX2CRX ver.4.0.7                       02-Apr-05 00:00     CRINEX PROG / DATE  \n",
+        "     2.10           OBSERVATION DATA    G (GPS)             RINEX VERSION / TYPE\n",
+        "     4    L1    L2    C1    P2                              # / TYPES OF OBSERV\n",
+        "                                                            END OF HEADER\n",
+        "&05  4  2  0  0  0.0000000  0  2G01G04\n",
+        "\n",
+        "3&-11799206602 3&-9194212897 3&21993564516 3&21993560297  7 7\n",
+        "3&-2292750457  3&22276378821 3&22276375748  6\n",
+        "                3              3      G07\n",
+        "2&-123456\n",
+        "-100000010 -99999920 -10000 -10000\n",
+        "-100000 3&-1749426201 100 100 1  6\n",
+        "3&23619095450 3&18384984254 3&20886075300 3&20886077502  5 5\n",
+        "                6              2  7  1&&&\n",
+        "125456\n",
+        "100001 100001 100010 100010\n",
+        "1000 0 1 0\n"
+    };
+    const unsigned char lzw[]={
+        0x1f,0x9d,0x90,0x20,0x02,0x06,0x9c,0xe1,0x02,0x86,0x0c,0x81,
+        0x08,0x11,0x3e,0x11,0x32,0xa5,0x88,0x14,0x2b,0x41,0xa8,0x24,
+        0x79,0xe2,0x04,0x04,0x91,0x88,0x41,0x14,0x14,0x71,0x42,0x04,
+        0xc4,0x13,0x23,0x20,0x90,0x14,0x09,0x42,0xc4,0xa1,0x02,0x1f,
+        0x20,0x64,0xc0,0x80,0x51,0x03,0x04,0x0c,0x1a,0x2e,0x0f,0xae,
+        0x74,0x09,0x23,0x20,0x8c,0x82,0x2b,0x73,0xd6,0x74,0x19,0x50,
+        0xc6,0xc9,0x94,0x2b,0x5b,0xbe,0x8c,0x49,0xb3,0xe8,0x8c,0x9b,
+        0x3a,0x73,0xda,0xec,0xf9,0x53,0x25,0x4b,0x97,0x30,0x0d,0x16,
+        0x85,0x11,0xc3,0x26,0xce,0xa4,0x4b,0x53,0x2a,0x00
+    };
+    const char *crx3[]={
+        "3.0                 COMPACT RINEX FORMAT                    CRINEX VERS   / TYPE\n",
+        "RNX2CRX ver.4.0.7                       02-Apr-05 00:00     CRINEX PROG / DATE\n",
+        "     3.02           OBSERVATION DATA    M                   RINEX VERSION / TYPE\n",
+        "G    2 C1C L1C                                              SYS / # / OBS TYPES\n",
+        "R    2 C1C L1C                                              SYS / # / OBS TYPES\n",
+        "                                                            END OF HEADER\n",
+        "> 2005 04 02 00 00  0.0000000  0  2      G01R05\n",
+        "\n",
+        "3&20000000123 3&105100000456    7\n",
+        "3&21000000500 3&112300000250   16\n",
+        "                   3              3         G 4R05\n",
+        "\n",
+        "30100 157450\n",
+        "3&22000000000 3&115600000000    5\n",
+        "10000 53500   &\n",
+        "                 1 &              2        4R 5&&&\n",
+        "\n",
+        "15500 81500\n",
+        "-500 -3250\n"
+    };
+    unsigned char bad[sizeof(gz)];
+    char uncfile[1024];
+    const char *file="t_misc_decomp.05d";
+    decomp_t dc;
+    FILE *fp;
+    char buff[1024],*p[32];
+    int i,n;
+    
+    fp=fopen("t_misc_decomp.gz","wb");
+    fwrite(gz,1,sizeof(gz),fp);
+    fclose(fp);
+    assert(opendecomp(&dc,"t_misc_decomp.gz")==1);
+    assert(getsdecomp(buff,sizeof(buff),&dc));
+    assert(!strcmp(buff,"     2.10           OBSERVATION DATA\n"));
+    assert(getsdecomp(buff,sizeof(buff),&dc)&&!strcmp(buff,"END OF HEADER\n"));
+    assert(!getsdecomp(buff,sizeof(buff),&dc));
+    closedecomp(&dc);
+    remove("t_misc_decomp.gz");
+    
+    fp=fopen(file,"w");
+    for (i=0;i<(int)(sizeof(crx)/sizeof(*crx));i++) fputs(crx[i],fp);
+    fclose(fp);
+    assert(opendecomp(&dc,file)==1);
+    for (n=0;n<32&&getsdecomp(buff,sizeof(buff),&dc);n++) {
+        for (i=(int)strlen(buff);i>0&&(buff[i-1]=='\n'||buff[i-1]==' ');i--) ;
+        buff[i]='\0';
+        p[n]=(char *)malloc(strlen(buff)+1);
+        strcpy(p[n],buff);
+    }
+    closedecomp(&dc);
+    remove(file);
+    assert(n==13&&!strncmp(p[0],"     2.10",9)&&!strncmp(p[2]+60,"END OF HEADER",13));
+    assert(!strcmp(p[6]," 05  4  2  0  0 30.0000000  0  3G01G04G07       "
+                   "                    -0.000123456"));
+    assert(!strcmp(p[8],"  -2292850.45716  -1749426.201 6  22276378.921  "
+                   "  22276375.848"));
+    assert(!strcmp(p[10]," 05  4  2  0  0 60.0000000  0  2G07G01          "
+                   "                     0.000002000"));
+    assert(!strcmp(p[12]," -11999205.622 7  -9394212.737 7  21993544.517  "
+                   "  21993540.297"));
+    for (i=0;i<n;i++) free(p[i]);
+    
+    assert(opendecomp(&dc,"t_misc_decomp.05o")==-1);
+    
+    /* crinex 3.0 */
+    fp=fopen(file,"w");
+    for (i=0;i<(int)(sizeof(crx3)/sizeof(*crx3));i++) fputs(crx3[i],fp);
+    fclose(fp);
+    assert(opendecomp(&dc,file)==1);
+    for (n=0;n<32&&getsdecomp(buff,sizeof(buff),&dc);n++) {
+        for (i=(int)strlen(buff);i>0&&(buff[i-1]=='\n'||buff[i-1]==' ');i--) ;
+        buff[i]='\0';
+        p[n]=(char *)malloc(strlen(buff)+1);
+        strcpy(p[n],buff);
+    }
+    assert(!dc.err);
+    closedecomp(&dc);
+    remove(file);
+    assert(n==14&&!strncmp(p[0],"     3.02",9)&&!strncmp(p[3]+60,"END OF HEADER",13));
+    assert(!strcmp(p[4],"> 2005 04 02 00 00  0.0000000  0  2"));
+    assert(!strcmp(p[6],"R05  21000000.500   112300000.25016"));
+    assert(!strcmp(p[7],"> 2005 04 02 00 00 30.0000000  0  3"));
+    assert(!strcmp(p[8],"G01  20000030.223   105100157.906 7"));
+    assert(!strcmp(p[10],"R05  21000010.500   112300053.750 6"));
+    assert(!strcmp(p[12],"G04  22000015.500   115600081.500 5"));
+    assert(!strcmp(p[13],"R05  21000020.000   112300104.000 6"));
+    for (i=0;i<n;i++) free(p[i]);
+    
+    /* unix compress (lzw) */
+    fp=fopen("t_misc_decomp.Z","wb");
+    fwrite(lzw,1,sizeof(lzw),fp);
+    fclose(fp);
+    assert(opendecomp(&dc,"t_misc_decomp.Z")==1);
+    for (n=0;getsdecomp(buff,sizeof(buff),&dc);n++) {
+        if (n==0) assert(!strcmp(buff,"     3.02           OBSERVATION DATA\n"));
+    }
+    assert(n==5&&!dc.err&&!strcmp(buff,"> 2005 04 02 00 01  0.0000000  0  2\n"));
+    closedecomp(&dc);
+    remove("t_misc_decomp.Z");
+    
+    /* truncated gzip */
+    fp=fopen("t_misc_decomp.gz","wb");
+    fwrite(gz,1,sizeof(gz)-4,fp);
+    fclose(fp);
+    assert(opendecomp(&dc,"t_misc_decomp.gz")==-1);
+    
+    /* gzip with crc error */
+    memcpy(bad,gz,sizeof(gz));
+    bad[sizeof(gz)-8]^=0x01;
+    fp=fopen("t_misc_decomp.gz","wb");
+    fwrite(bad,1,sizeof(bad),fp);
+    fclose(fp);
+    assert(opendecomp(&dc,"t_misc_decomp.gz")==-1);
+    assert(uncompress("t_misc_decomp.gz",uncfile)==-1);
+    assert(!(fp=fopen("t_misc_decomp","r")));
+    remove("t_misc_decomp.gz");
+    
+    printf("%s utset13: OK\n",__FILE__);
+}
+/* sortobs() */
+void utest14(void)
+{
+    gtime_t t0={1112400000,0.0};
+    obs_t obs={0};
+    int i,j,nep,sat[]={5,2,9};
+    
+    obs.n=obs.nmax=2*2*3*10+1;
+    obs.data=(obsd_t *)calloc(obs.n,sizeof(obsd_t));
+    
+    /* rcv 2 with 0.001s offset and rcv 1 with duplicated epochs 0-9 */
+    for (i=j=0;i<2*3*10;i++,j++) {
+        obs.data[j].time=timeadd(t0,30.0*(i/3)+0.001);
+        obs.data[j].rcv=2; obs.data[j].sat=sat[i%3];
+        obs.data[j].P[0]=i;
+    }
+    for (i=0;i<2*3*10;i++,j++) {
+        obs.data[j].time=timeadd(t0,30.0*(i/3%10));
+        obs.data[j].rcv=1; obs.data[j].sat=sat[i%3];
+        obs.data[j].P[0]=i;
+    }
+    obs.data[j++]=obs.data[0];
+    
+    nep=sortobs(&obs);
+    assert(nep==20&&obs.n==3*30);
+    for (i=0;i<obs.n;i++) {
+        assert(i==0||timediff(obs.data[i].time,obs.data[i-1].time)>-DTTOL);
+        assert(obs.data[i].rcv==(i<60&&i%6<3?1:2));
+        assert(obs.data[i].sat==(i%3==0?2:(i%3==1?5:9)));
+        if (obs.data[i].rcv==2) continue;
+        assert(obs.data[i].P[0]==i/6*3+(i%3==0?1:(i%3==1?0:2)));
+    }
+    free(obs.data);
+    
+    printf("%s utset14: OK\n",__FILE__);
+}
 int main(void)
 {
     utest1();
     utest2();
     utest3();
     utest4();
+    utest5();
+    utest6();
+    utest7();
+    utest8();
+    utest9();
+    utest10();
+    utest12();
+    utest13();
+    utest14();
     return 0;
 }
@@ -203,7 +203,7 @@ void utest8(void)
     
     printf("%s utset8 : OK\n",__FILE__);
 }
-/* time2str() */
+/* time2str(), time_str_r() */
 void utest9(void)
 {
     double ep0[]={1970,12,31,23,59,59.1234567890123456};
@@ -235,6 +235,9 @@ void utest9(void)
     time2str(epoch2time(ep2),s,7);
         ret=strcmp(s,"2006/02/28 23:59:59.9999995");
         assert(!ret);
+    assert(time_str_r(epoch2time(ep1),3,s)==s);
+        ret=strcmp(s,"2004/01/01 00:00:00.000");
+        assert(!ret);
     
     printf("%s utset9 : OK\n",__FILE__);
 }
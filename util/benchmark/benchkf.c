@@ -0,0 +1,129 @@
+/*------------------------------------------------------------------------------
+* benchkf.c : benchmark of kalman filter update in relpos() and pppos()
+*
+* usage  : benchkf [-p mode] [-n loop] [-kfu mode] [-a] obs nav [base]
+*
+*          process the observation data by rtkpos() and count heap allocations
+*          per epoch. the allocations in the kalman filter measurement update
+*          (filter_ws()) are counted separately. with option -a, the update is
+*          done by the allocating filter() as before the filter workspace.
+*          option -kfu selects the measurement update mode (KFUPD_???)
+*
+* notes  : link with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,
+*          --wrap=filter_ws (see makefile)
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rtklib.h"
+
+static long nalloc=0;           /* number of heap allocations */
+static int  oldfilter=0;        /* update by filter() instead of filter_ws() */
+static long nalloc_kf=0;        /* number of allocations in filter update */
+
+extern void *__real_malloc(size_t size);
+extern void *__real_calloc(size_t n, size_t size);
+extern void *__real_realloc(void *p, size_t size);
+extern int __real_filter_ws(double *x, double *P, const double *H,
+                            const double *v, const double *R, int n, int m,
+                            filterws_t *ws);
+
+extern void *__wrap_malloc(size_t size)
+{
+    nalloc++; return __real_malloc(size);
+}
+extern void *__wrap_calloc(size_t n, size_t size)
+{
+    nalloc++; return __real_calloc(n,size);
+}
+extern void *__wrap_realloc(void *p, size_t size)
+{
+    nalloc++; return __real_realloc(p,size);
+}
+extern int __wrap_filter_ws(double *x, double *P, const double *H,
+                            const double *v, const double *R, int n, int m,
+                            filterws_t *ws)
+{
+    long n0=nalloc;
+    int info;
+    
+    if (oldfilter) info=filter(x,P,H,v,R,n,m);
+    else info=__real_filter_ws(x,P,H,v,R,n,m,ws);
+    nalloc_kf+=nalloc-n0;
+    return info;
+}
+/* extract observation data of an epoch --------------------------------------*/
+static int nextobs(const obs_t *obs, int *i, obsd_t *data)
+{
+    int n=0;
+    
+    if (*i>=obs->n) return 0;
+    
+    while (*i+n<obs->n&&timediff(obs->data[*i+n].time,obs->data[*i].time)==0.0&&
+           n<MAXOBS*2) {
+        data[n]=obs->data[*i+n]; n++;
+    }
+    *i+=n;
+    return n;
+}
+int main(int argc, char **argv)
+{
+    gtime_t t0={0};
+    prcopt_t opt=prcopt_default;
+    rtk_t rtk;
+    obs_t obs={0};
+    nav_t nav={0};
+    obsd_t data[MAXOBS*2];
+    double rb[]={-3978241.958,3382840.234,3649900.853};
+    char *files[3]={0};
+    long n0,nall=0,nkf=0;
+    clock_t t;
+    int i,k,n,nfile=0,loop=1,nepoch=0;
+    
+    opt.mode=PMODE_KINEMA;
+    
+    for (i=1;i<argc;i++) {
+        if (!strcmp(argv[i],"-p")&&i+1<argc) opt.mode=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-n")&&i+1<argc) loop=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-kfu")&&i+1<argc) opt.kfupd=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-a")) oldfilter=1;
+        else if (nfile<3) files[nfile++]=argv[i];
+    }
+    if (nfile<2) {
+        fprintf(stderr,"usage: benchkf [-p mode] [-n loop] [-kfu mode] [-a] "
+                "obs nav [base]\n");
+        return -1;
+    }
+    opt.refpos=0;
+    for (i=0;i<3;i++) opt.rb[i]=rb[i];
+    
+    readrnxt(files[0],1,t0,t0,0.0,opt.rnxopt[0],&obs,&nav,NULL);
+    readrnxt(files[1],1,t0,t0,0.0,opt.rnxopt[0],&obs,&nav,NULL);
+    if (nfile>2) readrnxt(files[2],2,t0,t0,0.0,opt.rnxopt[0],&obs,&nav,NULL);
+    sortobs(&obs);
+    uniqnav(&nav);
+    if (obs.n<=0||nav.n<=0) {
+        fprintf(stderr,"no observation or navigation data\n");
+        return -1;
+    }
+    t=clock();
+    for (k=0;k<loop;k++) {
+        memset(&rtk,0,sizeof(rtk_t));
+        rtkinit(&rtk,&opt);
+        for (i=0;(n=nextobs(&obs,&i,data))>0;nepoch++) {
+            n0=nalloc; nalloc_kf=0;
+            rtkpos(&rtk,data,n,&nav,NULL);
+            nall+=nalloc-n0; nkf+=nalloc_kf;
+        }
+        rtkfree(&rtk);
+    }
+    t=clock()-t;
+    
+    printf("mode=%d filter=%s kfupd=%d epochs=%d time=%.3f s\n",opt.mode,
+           oldfilter?"filter":"filter_ws",opt.kfupd,nepoch,
+           (double)t/CLOCKS_PER_SEC);
+    printf("allocations/epoch: total=%.1f kalman update=%.1f\n",
+           (double)nall/nepoch,(double)nkf/nepoch);
+    return 0;
+}
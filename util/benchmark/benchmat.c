@@ -0,0 +1,86 @@
+/*------------------------------------------------------------------------------
+* benchmat.c : benchmark of matrix multiplication matmul()
+*
+* usage  : benchmat [-n scale]
+*
+*          measure time per call of matmul() for the fixed small sizes and the
+*          general sizes used in the kalman filter, compared with the scalar
+*          loop of matmul() without the fixed size and simd kernels.
+*          matmul() is by simd kernels for benchmat, by scalar loop for
+*          benchmat_nosimd (-DNOSIMD) and by dgemm for benchmat_lapack
+*          (-DLAPACK) (see makefile). option -n scales number of calls
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rtklib.h"
+
+/* scalar loop of matmul() ---------------------------------------------------*/
+static void matmul_loop(const char *tr, int n, int k, int m, double alpha,
+                        const double *A, const double *B, double beta,
+                        double *C)
+{
+    double d;
+    int i,j,x,f=tr[0]=='N'?(tr[1]=='N'?1:2):(tr[1]=='N'?3:4);
+    
+    for (i=0;i<n;i++) for (j=0;j<k;j++) {
+        d=0.0;
+        switch (f) {
+            case 1: for (x=0;x<m;x++) d+=A[i+x*n]*B[x+j*m]; break;
+            case 2: for (x=0;x<m;x++) d+=A[i+x*n]*B[j+x*k]; break;
+            case 3: for (x=0;x<m;x++) d+=A[x+i*m]*B[x+j*m]; break;
+            case 4: for (x=0;x<m;x++) d+=A[x+i*m]*B[j+x*k]; break;
+        }
+        if (beta==0.0) C[i+j*n]=alpha*d; else C[i+j*n]=alpha*d+beta*C[i+j*n];
+    }
+}
+/* time per call (ns) --------------------------------------------------------*/
+static double bench(int loop, int old, const char *tr, int n, int k, int m,
+                    const double *A, const double *B, double *C)
+{
+    clock_t t=clock();
+    int i;
+    
+    for (i=0;i<loop;i++) {
+        if (old) matmul_loop(tr,n,k,m,1.0,A,B,0.0,C);
+        else     matmul     (tr,n,k,m,1.0,A,B,0.0,C);
+    }
+    return (double)(clock()-t)/CLOCKS_PER_SEC/loop*1E9;
+}
+int main(int argc, char **argv)
+{
+    const struct {const char *tr; int n,k,m,loop;} size[]={
+        {"NN",  3,  3,  3,1000000},{"TN",  3,  1,  3,1000000},
+        {"NN",  3,  1,  3,1000000},{"NT",  4,  4, 12, 500000},
+        {"NN", 20,  1, 20, 100000},{"TN", 20,100,100,   1000},
+        {"NN",100,100,100,    100},{"NT",100,100,100,    100},
+        {"TN",100,100,100,    100},{"TT",100,100,100,    100},
+        {"NN",300, 20,300,    100}
+    };
+    double *A,*B,*C,t1,t2;
+    int i,j,loop=1;
+    
+    for (i=1;i<argc;i++) {
+        if (!strcmp(argv[i],"-n")&&i+1<argc) loop=atoi(argv[++i]);
+    }
+    A=mat(300,300); B=mat(300,300); C=mat(300,300);
+    for (i=0;i<300*300;i++) {
+        A[i]=(double)rand()/RAND_MAX;
+        B[i]=(double)rand()/RAND_MAX;
+    }
+    printf("%s\n",argv[0]);
+    printf("%2s %3s %3s %3s %12s %12s %7s\n","tr","n","k","m","loop (ns)",
+           "matmul (ns)","speedup");
+    
+    for (i=0;i<(int)(sizeof(size)/sizeof(*size));i++) {
+        j=size[i].loop*loop;
+        if (j<1) j=1;
+        t1=bench(j,1,size[i].tr,size[i].n,size[i].k,size[i].m,A,B,C);
+        t2=bench(j,0,size[i].tr,size[i].n,size[i].k,size[i].m,A,B,C);
+        printf("%2s %3d %3d %3d %12.1f %12.1f %7.2f\n",size[i].tr,size[i].n,
+               size[i].k,size[i].m,t1,t2,t2>0.0?t1/t2:0.0);
+    }
+    free(A); free(B); free(C);
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*------------------------------------------------------------------------------
+* benchout.c : benchmark of output file writers
+*
+* usage  : benchout [-n rows]
+*
+*          write rows of measurements (17 columns) and ionosphere (9 columns)
+*          by writeMeasures() and writeIonosphere() to the output files and
+*          show the rows per second compared with the printf per field as
+*          before the column schema writer. the output files are removed
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rtklib.h"
+
+/* printf per field as before the column schema writer -----------------------*/
+static void writeline_printf(FILE *fp, const outschema_t *schema,
+                             const double *val)
+{
+    char fmt[20];
+    int i;
+    
+    for (i=0;i<schema->n;i++) {
+        sprintf(fmt,"%%0%i.%ilf ",schema->cols[i].width,
+                schema->cols[i].precision);
+        fprintf(fp,fmt,val[i]);
+    }
+    fprintf(fp,"\n");
+}
+static double bench(int old, int type, int nrow)
+{
+    prcopt_t opt=prcopt_default;
+    outputFiles_t files;
+    obsd_t obs={{0}};
+    double val[17]={0};
+    clock_t t;
+    int i;
+    
+    opt.outmeasures=opt.outionosphere=1;
+    prepareOutputFiles(&files,&opt);
+    obs.rcv=1; obs.code[0]=1; obs.code[1]=14;
+    
+    t=clock();
+    for (i=0;i<nrow;i++) {
+        obs.sat=val[1]=i%32+1;
+        val[0]=i*0.1;
+        obs.P[0]=val[7] =2.2E7+i*0.123;
+        obs.L[0]=val[8] =1.1E8+i*0.456;
+        obs.D[0]=(float)(val[9]=-1234.567);
+        obs.P[1]=val[14]=2.2E7+i*0.789;
+        obs.L[1]=val[15]=8.9E7+i*0.321;
+        obs.D[1]=(float)(val[16]=-987.654);
+        if (type==0) {
+            if (old) {
+                val[2]=1; val[3]=1; val[10]=14;
+                val[4]=val[5]=val[6]=val[11]=val[12]=val[13]=1.0;
+                writeline_printf(files.measures,outputSchemas+OUTF_MEASURES,val);
+            }
+            else writeMeasures(files.measures,val[0],&obs);
+        }
+        else {
+            val[2]=123.4; val[3]=45.6; val[4]=59.12; val[5]=30.34; val[6]=350.0;
+            val[7]=12.3456; val[8]=7.8901;
+            if (old) {
+                writeline_printf(files.ionosphere,outputSchemas+OUTF_IONOSPHERE,
+                                 val);
+            }
+            else {
+                writeIonosphere(files.ionosphere,val[0],i%32+1,val[2],val[3],
+                                val[4],val[5],val[6],val[7],val[8]);
+            }
+        }
+    }
+    closeOutputFiles(&files);
+    t=clock()-t;
+    for (i=0;i<=OUTF_EXCLUDEDSATS;i++) remove(outputSchemas[i].file);
+    return t>0?nrow/((double)t/CLOCKS_PER_SEC):0.0;
+}
+int main(int argc, char **argv)
+{
+    double r1,r2;
+    int i,nrow=1000000;
+    
+    for (i=1;i<argc;i++) {
+        if (!strcmp(argv[i],"-n")&&i+1<argc) nrow=atoi(argv[++i]);
+    }
+    for (i=0;i<2;i++) {
+        r1=bench(1,i,nrow);
+        r2=bench(0,i,nrow);
+        printf("%-11s: printf=%10.0f rows/s writer=%10.0f rows/s speedup=%5.2f\n",
+               i==0?"measures":"ionosphere",r1,r2,r1>0.0?r2/r1:0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,88 @@
+/*------------------------------------------------------------------------------
+* benchrtcm.c : benchmark of rtcm 3 decoder
+*
+* usage  : benchrtcm [-n loop] file
+*
+*          decode the rtcm 3 stream in file by input_rtcm3() and show the
+*          throughput of decoding in bits/s of the input stream. the throughput
+*          of getbitu()/getbits() is also shown for the fields of msm 7 read
+*          sequentially over the stream, and of crc24q(), crc16() and crc32()
+*          for frames of 1 KB
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "rtklib.h"
+
+int main(int argc, char **argv)
+{
+    FILE *fp;
+    rtcm_t rtcm;
+    unsigned char *buff;
+    char *file=NULL;
+    double t,ep[]={2012,10,14,0,0,0};
+    clock_t t0;
+    const int len[]={8,4,10,14,20,24,10,1,10,15}; /* msm 7 fields */
+    unsigned int sum=0;
+    long nobs=0,neph=0,nbit=0;
+    int i,j,k,n,pos,loop=10;
+    
+    for (i=1;i<argc;i++) {
+        if (!strcmp(argv[i],"-n")&&i+1<argc) loop=atoi(argv[++i]);
+        else file=argv[i];
+    }
+    if (!file||!(fp=fopen(file,"rb"))) {
+        fprintf(stderr,"usage: benchrtcm [-n loop] file\n");
+        return -1;
+    }
+    fseek(fp,0,SEEK_END); n=(int)ftell(fp); fseek(fp,0,SEEK_SET);
+    buff=(unsigned char *)malloc(n);
+    n=(int)fread(buff,1,n,fp);
+    fclose(fp);
+    
+    t0=clock();
+    for (i=0;i<loop;i++) {
+        init_rtcm(&rtcm);
+        rtcm.time=epoch2time(ep);
+        for (j=0;j<n;j++) {
+            switch (input_rtcm3(&rtcm,buff[j])) {
+                case 1: nobs++; break;
+                case 2: neph++; break;
+            }
+        }
+        free_rtcm(&rtcm);
+    }
+    t=(double)(clock()-t0)/CLOCKS_PER_SEC;
+    
+    printf("file=%s bytes=%d loop=%d obs=%ld eph=%ld time=%.3f s\n",file,n,
+           loop,nobs/loop,neph/loop,t);
+    printf("throughput: %.1f Mbits/s\n",t>0.0?8.0*n*loop/t/1E6:0.0);
+    
+    t0=clock();
+    for (i=0;i<loop*10;i++) {
+        for (j=k=pos=0;pos+32<=n*8;pos+=len[k],j++,k=j%10) {
+            if (k==3||k==4||k==5||k==9) sum+=(unsigned int)getbits(buff,pos,len[k]);
+            else sum+=getbitu(buff,pos,len[k]);
+        }
+        nbit+=pos;
+    }
+    t=(double)(clock()-t0)/CLOCKS_PER_SEC;
+    
+    printf("getbitu/getbits: %.1f Mbits/s (sum=%08X)\n",t>0.0?nbit/t/1E6:0.0,
+           sum);
+    
+    for (k=0;k<3;k++) {
+        t0=clock();
+        for (i=0;i<loop*10;i++) for (j=0;j+1024<=n;j+=1024) {
+            if      (k==0) sum+=crc24q(buff+j,1024);
+            else if (k==1) sum+=crc16 (buff+j,1024);
+            else           sum+=crc32 (buff+j,1024);
+        }
+        t=(double)(clock()-t0)/CLOCKS_PER_SEC;
+        printf("%-6s: %.1f Mbytes/s (sum=%08X)\n",k==0?"crc24q":(k==1?"crc16":"crc32"),
+               t>0.0?(double)(n/1024*1024)*loop*10/t/1E6:0.0,sum);
+    }
+    free(buff);
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*------------------------------------------------------------------------------
+* benchtrace.c : benchmark of debug trace
+*
+* usage  : benchtrace [-n loop] [-t threads] [-l level]
+*
+*          call trace() from threads to the trace file by traceopen() (text)
+*          and traceopenb() (binary) and show the time per call and the max
+*          time of a call in the threads. the trace files are benchtrace.trace
+*          and benchtrace.btrace
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rtklib.h"
+
+#define MAXTHREAD   16              /* max number of threads */
+
+static int loop=100000;             /* number of calls per thread */
+static int level=3;                 /* trace level */
+static unsigned int tmax[MAXTHREAD]; /* max time of a call (ms) */
+
+static void *tracethread(void *arg)
+{
+    gtime_t time=timeget();
+    double rr[3]={-3978241.958,3382840.234,3649900.853};
+    char tstr[64];
+    unsigned int tick,t;
+    int i,index=*(int *)arg;
+    
+    for (i=0;i<loop;i++) {
+        tick=tickget();
+        trace(level,"benchtrace: time=%s thread=%d i=%d rr=%.3f %.3f %.3f\n",
+              time_str_r(time,3,tstr),index,i,rr[0],rr[1],rr[2]);
+        tracet(level,"benchtrace: i=%d\n",i);
+        if ((t=tickget()-tick)>tmax[index]) tmax[index]=t;
+    }
+    return NULL;
+}
+static void bench(int bin, int nthread)
+{
+    pthread_t thread[MAXTHREAD];
+    int i,index[MAXTHREAD];
+    unsigned int tick,t=0;
+    
+    if (bin) traceopenb("benchtrace.btrace"); else traceopen("benchtrace.trace");
+    tracelevel(level);
+    
+    tick=tickget();
+    for (i=0;i<nthread;i++) {
+        index[i]=i; tmax[i]=0;
+        pthread_create(thread+i,NULL,tracethread,index+i);
+    }
+    for (i=0;i<nthread;i++) {
+        pthread_join(thread[i],NULL);
+        if (tmax[i]>t) t=tmax[i];
+    }
+    tick=tickget()-tick;
+    traceclose();
+    
+    printf("%-6s threads=%2d calls=%8d time=%6d ms %8.1f ns/call max=%4u ms\n",
+           bin?"binary":"text",nthread,2*loop*nthread,tick,
+           tick*1E6/(2.0*loop*nthread),t);
+}
+int main(int argc, char **argv)
+{
+    int i,nthread=4;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-n")&&i+1<argc) loop=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-t")&&i+1<argc) nthread=atoi(argv[++i]);
+        else if (!strcmp(argv[i],"-l")&&i+1<argc) level=atoi(argv[++i]);
+    }
+    if (nthread<1) nthread=1; else if (nthread>MAXTHREAD) nthread=MAXTHREAD;
+    
+    bench(0,nthread);
+    bench(1,nthread);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*------------------------------------------------------------------------------
+* convout.c : convert binary output file to text
+*
+* usage  : convout [-o outfile] file
+*
+*          convert the binary columnar output file written with the output
+*          format OUTFMT_BIN (rnx2rtkp -ofm 1) to the text format of the
+*          output file. the output is stdout without option -o
+*
+* notes  : the file is read as written by the same byte order
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rtklib.h"
+
+int main(int argc, char **argv)
+{
+    FILE *fp=stdout;
+    outbfile_t out;
+    outschema_t schema={0};
+    outcol_t *cols;
+    gtime_t time={0};
+    char *file=NULL,*outfile=NULL;
+    int i;
+    
+    for (i=1;i<argc;i++) {
+        if (!strcmp(argv[i],"-o")&&i+1<argc) outfile=argv[++i];
+        else file=argv[i];
+    }
+    if (!file) {
+        fprintf(stderr,"usage: convout [-o outfile] file\n");
+        return -1;
+    }
+    if (!openBinaryOutput(file,&out)) {
+        fprintf(stderr,"binary output file open error: %s\n",file);
+        return -1;
+    }
+    if (outfile&&!(fp=fopen(outfile,"w"))) {
+        fprintf(stderr,"output file open error: %s\n",outfile);
+        closeBinaryOutput(&out);
+        return -1;
+    }
+    if (!(cols=(outcol_t *)malloc(sizeof(outcol_t)*out.head->ncol))) {
+        closeBinaryOutput(&out);
+        return -1;
+    }
+    for (i=0;i<out.head->ncol;i++) {
+        cols[i].name=out.cols[i].name;
+        cols[i].width=out.cols[i].width;
+        cols[i].precision=out.cols[i].precision;
+    }
+    schema.title=out.head->title;
+    schema.n=out.head->ncol;
+    schema.cols=cols;
+    
+    fprintf(fp,"%% %s",schema.title);
+    for (i=0;i<schema.n;i++) fprintf(fp," %s",cols[i].name);
+    fprintf(fp,"\n");
+    
+    if (out.head->tset) {
+        time.time=(time_t)out.head->time;
+        time.sec=out.head->sec;
+        writeTimeToFile(fp,time);
+    }
+    for (i=0;i<out.n;i++) {
+        writeColumns(fp,&schema,out.data+(size_t)i*schema.n);
+    }
+    free(cols);
+    closeBinaryOutput(&out);
+    if (fp!=stdout) fclose(fp);
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*------------------------------------------------------------------------------
+* convtrace.c : convert binary trace file to text
+*
+* usage  : convtrace [-t] [-o outfile] file
+*
+*          convert the binary trace file written by traceopenb() to the text
+*          format of traceopen(). the output is stdout without option -o.
+*          option -t prefixes the index of the trace ring buffer (thread) to
+*          the lines of trace() and tracet()
+*
+* notes  : the file is read as written by the same byte order and size of long
+*-----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "rtklib.h"
+
+#define MAXFMT      65536           /* max number of formats */
+
+static char *fmts[MAXFMT];          /* formats by format id */
+
+/* get long argument ---------------------------------------------------------*/
+static long getlong(const unsigned char **p, const unsigned char *end)
+{
+    long val=0;
+    
+    if (*p+sizeof(long)<=end) memcpy(&val,*p,sizeof(long));
+    *p+=sizeof(long);
+    return val;
+}
+/* print formatted arguments -------------------------------------------------*/
+static void printfmt(FILE *fp, const char *format, const unsigned char *p,
+                     const unsigned char *end)
+{
+    const char *q;
+    char spec[64],*s;
+    double d;
+    int i,nl;
+    
+    for (q=format;*q;q++) {
+        if (*q!='%') {fputc(*q,fp); continue;}
+        if (!*++q) break;
+        if (*q=='%') {fputc('%',fp); continue;}
+        
+        s=spec; *s++='%';
+        while (*q&&strchr("-+ #0",*q)&&s<spec+8) *s++=*q++;
+        for (i=0;i<2;i++) { /* width and precision */
+            if (i==1) {
+                if (*q!='.') break;
+                *s++=*q++;
+            }
+            if (*q=='*') {
+                s+=sprintf(s,"%ld",getlong(&p,end)); q++;
+            }
+            else while (isdigit((int)*q)&&s<spec+40) *s++=*q++;
+        }
+        for (nl=0;*q=='h'||*q=='l';q++) if (*q=='l') nl++;
+        if (nl) *s++='l';
+        *s++=*q; *s='\0';
+        
+        switch (*q) {
+            case 'd': case 'i': case 'c':
+                if (nl) fprintf(fp,spec,getlong(&p,end));
+                else    fprintf(fp,spec,(int)getlong(&p,end));
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                if (nl) fprintf(fp,spec,(unsigned long)getlong(&p,end));
+                else    fprintf(fp,spec,(unsigned int)getlong(&p,end));
+                break;
+            case 'e': case 'E': case 'f': case 'g': case 'G':
+                d=0.0;
+                if (p+sizeof(double)<=end) memcpy(&d,p,sizeof(double));
+                p+=sizeof(double);
+                fprintf(fp,spec,d);
+                break;
+            case 's':
+                if (p>=end) break;
+                fprintf(fp,spec,(const char *)p);
+                p+=strlen((const char *)p)+1;
+                break;
+            default:
+                fprintf(fp,"%s",spec);
+                break;
+        }
+        if (!*q) break;
+    }
+}
+/* print row of matrix -------------------------------------------------------*/
+static void printmat(FILE *fp, const unsigned char *p, const unsigned char *end)
+{
+    double d;
+    int i,hd[4];
+    
+    if (p+16>end) return;
+    memcpy(hd,p,16); p+=16;
+    for (i=0;i<hd[3]&&p+sizeof(double)<=end;i++,p+=sizeof(double)) {
+        memcpy(&d,p,sizeof(double));
+        fprintf(fp," %*.*f",hd[0],hd[1],d);
+    }
+    if (hd[2]) fprintf(fp,"\n");
+}
+/* convert binary trace ------------------------------------------------------*/
+static int convtrace(FILE *ifp, FILE *ofp, int topt)
+{
+    unsigned char buff[65536],*end;
+    unsigned int endian,size,tick,nlost;
+    unsigned short len,fid;
+    char magic[8];
+    int type,level,thread,nrec=0;
+    
+    if (fread(magic,1,8,ifp)!=8||fread(&endian,4,1,ifp)!=1||
+        fread(&size,4,1,ifp)!=1||memcmp(magic,TRACEB_MAGIC,8)) {
+        fprintf(stderr,"not binary trace file\n");
+        return -1;
+    }
+    if (endian!=0x01020304||size!=sizeof(long)) {
+        fprintf(stderr,"byte order or size of long unmatched\n");
+        return -1;
+    }
+    while (fread(buff,1,TRACEB_HLEN,ifp)==TRACEB_HLEN) {
+        memcpy(&len,buff,2);
+        if (len<TRACEB_HLEN||
+            fread(buff+TRACEB_HLEN,1,len-TRACEB_HLEN,ifp)!=len-TRACEB_HLEN) {
+            fprintf(stderr,"record truncated: nrec=%d\n",nrec);
+            break;
+        }
+        type=buff[2]; level=buff[3]; thread=buff[4];
+        memcpy(&fid,buff+6,2);
+        memcpy(&tick,buff+8,4);
+        end=buff+len;
+        nrec++;
+        
+        switch (type) {
+            case TRACEB_FMT:
+                free(fmts[fid]);
+                if ((fmts[fid]=(char *)malloc(len-TRACEB_HLEN+1))) {
+                    memcpy(fmts[fid],buff+TRACEB_HLEN,len-TRACEB_HLEN);
+                    fmts[fid][len-TRACEB_HLEN]='\0';
+                }
+                break;
+            case TRACEB_MSG:
+            case TRACEB_MSGT:
+            case TRACEB_RAW:
+                if (!fmts[fid]) break;
+                if (topt&&type!=TRACEB_RAW) fprintf(ofp,"[%2d] ",thread);
+                if (type==TRACEB_MSG) fprintf(ofp,"%d ",level);
+                if (type==TRACEB_MSGT) fprintf(ofp,"%d %9.3f: ",level,tick/1000.0);
+                printfmt(ofp,fmts[fid],buff+TRACEB_HLEN,end);
+                break;
+            case TRACEB_MAT:
+                printmat(ofp,buff+TRACEB_HLEN,end);
+                break;
+            case TRACEB_LOST:
+                memcpy(&nlost,buff+TRACEB_HLEN,4);
+                fprintf(ofp,"*** %u trace records lost: thread=%d\n",nlost,thread);
+                break;
+        }
+    }
+    return nrec;
+}
+int main(int argc, char **argv)
+{
+    FILE *ifp,*ofp=stdout;
+    char *ifile=NULL,*ofile=NULL;
+    int i,topt=0,nrec;
+    
+    for (i=1;i<argc;i++) {
+        if      (!strcmp(argv[i],"-t")) topt=1;
+        else if (!strcmp(argv[i],"-o")&&i+1<argc) ofile=argv[++i];
+        else ifile=argv[i];
+    }
+    if (!ifile) {
+        fprintf(stderr,"usage: convtrace [-t] [-o outfile] file\n");
+        return -1;
+    }
+    if (!(ifp=fopen(ifile,"rb"))) {
+        fprintf(stderr,"file open error: %s\n",ifile);
+        return -1;
+    }
+    if (ofile&&!(ofp=fopen(ofile,"w"))) {
+        fprintf(stderr,"file open error: %s\n",ofile);
+        fclose(ifp);
+        return -1;
+    }
+    nrec=convtrace(ifp,ofp,topt);
+    
+    fclose(ifp);
+    if (ofp!=stdout) fclose(ofp);
+    for (i=0;i<MAXFMT;i++) free(fmts[i]);
+    return nrec<0?-1:0;
+}